@@ -27,7 +27,13 @@
 #   define SL_SOCK_API_WINSOCK
 #endif
 
+/* C.Api binds the plugin through unmanaged function pointers, which need C# 9 (unity 2021.2) */
+#if UNITY_2021_2_OR_NEWER || !UNITY_5_3_OR_NEWER
+#   define SL_API_TABLE_ENABLED
+#endif
+
 using System.Security;
+using System.Threading;
 using System.Runtime.InteropServices;
 using System.Runtime.CompilerServices;
 
@@ -43,20 +49,25 @@ namespace SL
         const MethodImplOptions INLINE = MethodImplOptions.AggressiveInlining;
 
         public const string SL_DSO_NAME = "socklynxDSO";
+        public const int SL_ERR = -1;
         public const int SL_OK = 0;
+        public const uint SL_API_VERSION = 1;
         public const int SL_IP4_SIZE = sizeof(uint);
         public const int SL_IP6_SIZE = 16;
         public const int SL_ENDPOINT4_SIZE = 16;
         public const int SL_ENDPOINT6_SIZE = 28;
         public const int SL_SOCK_SIZE_UNALIGNED_BASE = 32;
+        public const int SL_SOCK_STATS_SIZE = 112;
+        // the native endpoint is always the ipv6 sized union, so the stats block sits at the same offset either way
+        public const int SL_SOCK_STATS_OFFSET = ((SL_SOCK_SIZE_UNALIGNED_BASE + SL_ENDPOINT6_SIZE) & ~(sizeof(ulong) - 1)) + sizeof(ulong);
+        public const int SL_SOCK_IMPAIR_OFFSET = SL_SOCK_STATS_OFFSET + SL_SOCK_STATS_SIZE;
+        // room for the impairment and capture pointers behind the stats, sized for 64 bit and only set through SocketImpair and SocketCapture
+        public const int SL_SOCK_SIZE = SL_SOCK_IMPAIR_OFFSET + 3 * sizeof(ulong);
 #if SL_IPV6_ENABLED
         public const int SL_ENDPOINT_SIZE = SL_ENDPOINT6_SIZE;
-        public const int SL_SOCK_SIZE_UNALIGNED = SL_SOCK_SIZE_UNALIGNED_BASE + SL_ENDPOINT_SIZE;
-        public const int SL_SOCK_SIZE = (SL_SOCK_SIZE_UNALIGNED & ~(sizeof(ulong) - 1)) + sizeof(ulong);
         public const bool SL_IPV6_ENABLED = true;
 #else
         public const int SL_ENDPOINT_SIZE = SL_ENDPOINT4_SIZE;
-        public const int SL_SOCK_SIZE = SL_SOCK_SIZE_UNALIGNED_BASE + SL_ENDPOINT_SIZE;
         public const bool SL_IPV6_ENABLED = false;
 #endif
 
@@ -225,6 +236,12 @@ namespace SL
             WouldBlockOnWrite = (1 << 2),
             IPv4Disabled = (1 << 3),
             IPv6Disabled = (1 << 4),
+            SegmentationOffload = (1 << 5),
+            ReceiveCoalescing = (1 << 6),
+            ReusePort = (1 << 7),
+            ReceiveTimestamps = (1 << 8),
+            ReceiveDrops = (1 << 9),
+            LaunchTimes = (1 << 10),
         }
 
         public enum SocketState : uint
@@ -248,6 +265,7 @@ namespace SL
             [FieldOffset(24)] public uint error;
             [FieldOffset(28)] public SocketFlags flags;
             [FieldOffset(32)] public Endpoint endpoint;
+            [FieldOffset(SL_SOCK_STATS_OFFSET)] public SocketStats stats;
 
             [MethodImpl(INLINE)]
             public static Socket NewUDP(Context* ctx, Endpoint endpoint = default)
@@ -266,6 +284,555 @@ namespace SL
             }
         }
 
+        [StructLayout(LayoutKind.Sequential, Size = SL_SOCK_STATS_SIZE)]
+        public struct SocketStats
+        {
+            public ulong tx_packets;
+            public ulong tx_bytes;
+            public ulong rx_packets;
+            public ulong rx_bytes;
+            public ulong tx_wouldblock;
+            public ulong rx_wouldblock;
+            public ulong tx_partial;
+            public ulong err_transient;
+            public ulong err_unreachable;
+            public ulong err_msgsize;
+            public ulong err_other;
+            public uint tx_max;
+            public uint rx_max;
+            public ulong rx_dropped;
+            public uint rx_dropped_kernel;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Message
+        {
+            public Buffer* buf;
+            public Endpoint* endpoint;
+            public int bufcount;
+            public int len;
+            public int segsize;
+            public ulong timestamp_ns;
+
+            [MethodImpl(INLINE)]
+            public static int SegmentCount(Message* msg)
+            {
+                if (msg->len <= 0 || msg->segsize <= 0) return 0;
+                return (msg->len + msg->segsize - 1) / msg->segsize;
+            }
+
+            [MethodImpl(INLINE)]
+            public static Message New(Buffer* buf, int bufcount, Endpoint* endpoint)
+            {
+                Message msg = default;
+                msg.buf = buf;
+                msg.bufcount = bufcount;
+                msg.endpoint = endpoint;
+                return msg;
+            }
+        }
+
+        public const int SL_BUFCACHE_SIZE = 32;
+        public const int SL_SPSC_SIZE = 192;
+        public const uint SL_PEERTABLE_HANDLE_NONE = 0;
+        public const int SL_COALESCE_FRAME_DEFAULT = 1200;
+        public const int SL_COALESCE_MSG_MAX = 0x3fff;
+        public const int SL_FRAG_HEADER_SIZE = 6;
+        public const int SL_FRAG_DATAGRAM_DEFAULT = 1200;
+        public const int SL_CHANNEL_HEADER_SIZE = 9;
+        public const int SL_CHANNEL_WINDOW = 32;
+        public const int SL_CHANSLOT_SIZE = 16;
+        public const int SL_PACER_OVERHEAD = 28;
+        public const int SL_PACER_BURST_DEFAULT = 4 * 1200;
+        public const int SL_TIMERWHEEL_LEVELS = 4;
+        public const ulong SL_TIMERWHEEL_TICK_NS_DEFAULT = 1000000;
+        public const int SL_IMPAIR_PPM = 1000000;
+        public const long SL_CAPTURE_SIZE_DEFAULT = 64 * 1024 * 1024;
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Autotune
+        {
+            public Socket* sock;
+            public int rcvbuf_min;
+            public int rcvbuf_max;
+            public int sndbuf_min;
+            public int sndbuf_max;
+            public uint interval_ms;
+            public uint state;
+            public uint error;
+            public int rcvbuf;
+            public int sndbuf;
+            public int rcvbuf_request;
+            public int sndbuf_request;
+            public uint rcvbuf_quiet;
+            public uint sndbuf_quiet;
+            public uint adjustments;
+            public ulong last_ns;
+            public ulong rx_dropped;
+            public ulong tx_wouldblock;
+
+            [MethodImpl(INLINE)]
+            public static Autotune New(Socket* sock, int bufferMin = 0, int bufferMax = 0, int intervalMs = 0)
+            {
+                Autotune tune = default;
+                tune.sock = sock;
+                tune.rcvbuf_min = bufferMin;
+                tune.rcvbuf_max = bufferMax;
+                tune.sndbuf_min = bufferMin;
+                tune.sndbuf_max = bufferMax;
+                tune.interval_ms = (uint)intervalMs;
+                return tune;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct BufferPool
+        {
+            public uint slotsize;
+            public uint slotcount;
+            public uint state;
+            public uint error;
+            public byte* arena;
+            public uint* free;
+            public uint free_count;
+            public uint spinlock;
+
+            [MethodImpl(INLINE)]
+            public static BufferPool New(int slotCount, int slotSize = 0)
+            {
+                BufferPool pool = default;
+                pool.slotcount = (uint)slotCount;
+                pool.slotsize = (uint)slotSize;
+                return pool;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct BufferCache
+        {
+            public BufferPool* pool;
+            public uint count;
+            public fixed uint slots[SL_BUFCACHE_SIZE];
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct PeerTable
+        {
+            public uint capacity;
+            public uint slotsize;
+            public uint state;
+            public uint error;
+            public uint count;
+            public uint mask;
+            public void* index;
+            public Endpoint* endpoints;
+            public byte* gens;
+            public byte* slots;
+            public uint* free;
+            public uint free_count;
+
+            [MethodImpl(INLINE)]
+            public static PeerTable New(int capacity, int slotSize = 0)
+            {
+                PeerTable table = default;
+                table.capacity = (uint)capacity;
+                table.slotsize = (uint)slotSize;
+                return table;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Coalescer
+        {
+            public Buffer frame;
+            public Endpoint* endpoint;
+            public int len;
+            public int count;
+
+            /* mirrors sl_coalesce_next so splitting a received frame never enters the plugin */
+            [MethodImpl(INLINE)]
+            public static int Next(byte* frame, int len, int* offset, Buffer* msg)
+            {
+                int pos = *offset;
+                if (pos >= len) return 0;
+
+                int msglen = frame[pos++];
+                if ((msglen & 0x80) != 0)
+                {
+                    if (pos >= len) return SL_ERR;
+                    msglen = (msglen & 0x7f) | (frame[pos++] << 7);
+                }
+                if (msglen > len - pos) return SL_ERR;
+
+                *msg = Buffer.New(frame + pos, msglen);
+                *offset = pos + msglen;
+                return 1;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct FragmentSend
+        {
+            public byte* data;
+            public Endpoint* endpoint;
+            public int len;
+            public int fragsize;
+            public ushort msg_id;
+            public ushort count;
+            public ushort next;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct FragmentTable
+        {
+            public BufferPool* pool;
+            public uint capacity;
+            public uint timeout_ms;
+            public uint state;
+            public uint error;
+            public uint mask;
+            public uint active;
+            public ulong dropped;
+            public ulong expired;
+            public void* entries;
+
+            [MethodImpl(INLINE)]
+            public static FragmentTable New(BufferPool* pool, int capacity, int timeoutMs = 0)
+            {
+                FragmentTable table = default;
+                table.pool = pool;
+                table.capacity = (uint)capacity;
+                table.timeout_ms = (uint)timeoutMs;
+                return table;
+            }
+        }
+
+        public enum ChannelMode : int
+        {
+            Unreliable,
+            Sequenced,
+            Reliable,
+            Ack,
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Channel
+        {
+            public Endpoint* endpoint;
+            public uint slotsize;
+            public uint state;
+            public uint error;
+            public ushort send_seq;
+            public ushort send_base;
+            public ushort seq_next;
+            public ushort recv_ack;
+            public ushort recv_next;
+            public ushort seq_latest;
+            public uint flags;
+            public uint send_pending;
+            public uint recv_present;
+            public uint recv_bits;
+            public ulong srtt_ns;
+            public ulong rttvar_ns;
+            public ulong rto_ns;
+            public ulong resends;
+            public fixed byte send_slots[SL_CHANNEL_WINDOW * SL_CHANSLOT_SIZE];
+            public fixed int recv_len[SL_CHANNEL_WINDOW];
+            public byte* send_mem;
+            public byte* recv_mem;
+
+            [MethodImpl(INLINE)]
+            public static Channel New(Endpoint* endpoint, int slotSize = 0)
+            {
+                Channel ch = default;
+                ch.endpoint = endpoint;
+                ch.slotsize = (uint)slotSize;
+                return ch;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Packet
+        {
+            public Buffer buf;
+            public Endpoint endpoint;
+            public int len;
+        }
+
+        /* mirrors sl_spsc_t, head belongs to the consumer and tail to the producer */
+        [StructLayout(LayoutKind.Explicit, Size = SL_SPSC_SIZE)]
+        public struct PacketRing
+        {
+            [FieldOffset(0)] public uint head;
+            [FieldOffset(64)] public uint tail;
+            [FieldOffset(128)] public uint mask;
+            [FieldOffset(136)] public Packet* entries;
+
+            [MethodImpl(INLINE)]
+            public static bool TryPush(PacketRing* ring, Packet* packet)
+            {
+                uint tail = ring->tail;
+                if (tail - Volatile.Read(ref ring->head) > ring->mask) return false;
+                ring->entries[tail & ring->mask] = *packet;
+                Volatile.Write(ref ring->tail, tail + 1);
+                return true;
+            }
+
+            [MethodImpl(INLINE)]
+            public static bool TryPop(PacketRing* ring, Packet* packet)
+            {
+                uint head = ring->head;
+                if (Volatile.Read(ref ring->tail) == head) return false;
+                *packet = ring->entries[head & ring->mask];
+                Volatile.Write(ref ring->head, head + 1);
+                return true;
+            }
+        }
+
+        /* only the rings at the front of sl_iothread_t, the plugin allocates and owns the rest */
+        [StructLayout(LayoutKind.Sequential)]
+        public struct IOThread
+        {
+            public PacketRing rx;
+            public PacketRing done;
+            public PacketRing free;
+            public PacketRing tx;
+        }
+
+        public enum PollEvents : uint
+        {
+            None,
+            Read = (1 << 0),
+            Write = (1 << 1),
+            Error = (1 << 2),
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct PollEvent
+        {
+            public Socket* sock;
+            public PollEvents events;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Pacer
+        {
+            public ulong rate;
+            public ulong burst_ns;
+            public ulong next_ns;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct FileMap
+        {
+            public byte* data;
+            public ulong size;
+            public byte writable;
+#if SL_SOCK_API_WINSOCK
+            public void* file;
+            public void* mapping;
+#else
+            public int fd;
+#endif
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Capture
+        {
+            public ulong size;
+            public uint state;
+            public uint error;
+            public ulong offset;
+            public ulong limit;
+            public ulong dropped;
+            public FileMap map;
+
+            [MethodImpl(INLINE)]
+            public static Capture New(long size = SL_CAPTURE_SIZE_DEFAULT)
+            {
+                Capture capture = default;
+                capture.size = (ulong)size;
+                return capture;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Impair
+        {
+            public ulong seed;
+            public uint capacity;
+            public uint slotsize;
+            public uint latency_us;
+            public uint jitter_us;
+            public uint loss_ppm;
+            public uint duplicate_ppm;
+            public uint reorder_ppm;
+            public uint state;
+            public uint error;
+            public uint count;
+            public uint seq;
+            public ulong rng;
+            public ulong lost;
+            public ulong duplicated;
+            public ulong reordered;
+            public ulong overflowed;
+            public byte* arena;
+            public uint* free;
+            public void* heap;
+
+            [MethodImpl(INLINE)]
+            public static Impair New(ulong seed, int capacity = 0, int slotSize = 0)
+            {
+                Impair impair = default;
+                impair.seed = seed;
+                impair.capacity = (uint)capacity;
+                impair.slotsize = (uint)slotSize;
+                return impair;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Timer
+        {
+            public Timer* next;
+            public Timer* prev;
+            public ulong expires;
+            public ulong data;
+            public uint slot;
+
+            public bool Pending => next != null;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct TimerWheel
+        {
+            public ulong tick_ns;
+            public uint state;
+            public uint error;
+            public ulong base_ns;
+            public ulong now;
+            public ulong count;
+            public fixed ulong occupied[SL_TIMERWHEEL_LEVELS];
+            public Timer* slots;
+
+            [MethodImpl(INLINE)]
+            public static TimerWheel New(ulong tickNs = SL_TIMERWHEEL_TICK_NS_DEFAULT)
+            {
+                TimerWheel wheel = default;
+                wheel.tick_ns = tickNs;
+                return wheel;
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Poller
+        {
+            public long fd;
+            public uint state;
+            public uint error;
+            public uint capacity;
+            public uint count;
+            public void* pollfds;
+            public Socket** socks;
+            public uint* interests;
+
+            [MethodImpl(INLINE)]
+            public static Poller New(int capacity)
+            {
+                Poller poller = default;
+                poller.capacity = (uint)capacity;
+                return poller;
+            }
+        }
+
+#if SL_API_TABLE_ENABLED
+        // mirrors sl_api_t, string arguments are passed as null terminated ansi bytes
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Api
+        {
+            public uint version;
+            public uint size;
+            public delegate* unmanaged[Cdecl]<Context*, int> setup;
+            public delegate* unmanaged[Cdecl]<Context*, int> cleanup;
+            public delegate* unmanaged[Cdecl]<Socket*, int, int> socket_nonblocking;
+            public delegate* unmanaged[Cdecl]<Socket*, int, int> socket_gso;
+            public delegate* unmanaged[Cdecl]<Socket*, int, int> socket_gro;
+            public delegate* unmanaged[Cdecl]<Socket*, int, int> socket_timestamp;
+            public delegate* unmanaged[Cdecl]<Socket*, int, int> socket_rxq_ovfl;
+            public delegate* unmanaged[Cdecl]<Socket*, uint, int> socket_pacing_rate;
+            public delegate* unmanaged[Cdecl]<Socket*, int, int> socket_txtime;
+            public delegate* unmanaged[Cdecl]<Socket*, Impair*, Impair*, int> socket_impair;
+            public delegate* unmanaged[Cdecl]<Socket*, Capture*, int> socket_capture;
+            public delegate* unmanaged[Cdecl]<Socket*, int> socket_open;
+            public delegate* unmanaged[Cdecl]<Socket*, int> socket_close;
+            public delegate* unmanaged[Cdecl]<Socket*, Endpoint*, int> socket_connect;
+            public delegate* unmanaged[Cdecl]<Socket*, Buffer*, int, int> socket_send_connected;
+            public delegate* unmanaged[Cdecl]<Socket*, Buffer*, int, int> socket_recv_connected;
+            public delegate* unmanaged[Cdecl]<Socket*, Buffer*, int, Endpoint*, int> socket_send;
+            public delegate* unmanaged[Cdecl]<Socket*, Buffer*, int, Endpoint*, int> socket_recv;
+            public delegate* unmanaged[Cdecl]<Socket*, Buffer*, int, Endpoint*, ulong*, int> socket_recv_timestamped;
+            public delegate* unmanaged[Cdecl]<Socket*, Buffer*, uint, Endpoint*, int> socket_send_gso;
+            public delegate* unmanaged[Cdecl]<Socket*, Message*, int, int> socket_send_batch;
+            public delegate* unmanaged[Cdecl]<Socket*, Message*, int, int> socket_recv_batch;
+            public delegate* unmanaged[Cdecl]<Socket*, SocketStats*, int> socket_stats;
+            public delegate* unmanaged[Cdecl]<Socket*, int*, int*, int> socket_bufsize;
+            public delegate* unmanaged[Cdecl]<Autotune*, int> autotune_setup;
+            public delegate* unmanaged[Cdecl]<Autotune*, int> autotune_cleanup;
+            public delegate* unmanaged[Cdecl]<Autotune*, int> autotune_update;
+            public delegate* unmanaged[Cdecl]<Poller*, int> poller_setup;
+            public delegate* unmanaged[Cdecl]<Poller*, int> poller_cleanup;
+            public delegate* unmanaged[Cdecl]<Poller*, Socket*, PollEvents, int> poller_add;
+            public delegate* unmanaged[Cdecl]<Poller*, Socket*, int> poller_remove;
+            public delegate* unmanaged[Cdecl]<Poller*, PollEvent*, int, int, int> poller_wait;
+            public delegate* unmanaged[Cdecl]<BufferPool*, int> bufpool_setup;
+            public delegate* unmanaged[Cdecl]<BufferPool*, int> bufpool_cleanup;
+            public delegate* unmanaged[Cdecl]<BufferCache*, BufferPool*, int> bufcache_init;
+            public delegate* unmanaged[Cdecl]<BufferCache*, int> bufcache_flush;
+            public delegate* unmanaged[Cdecl]<BufferCache*, Buffer*, int> bufcache_acquire;
+            public delegate* unmanaged[Cdecl]<BufferCache*, Buffer*, int> bufcache_release;
+            public delegate* unmanaged[Cdecl]<Channel*, int> channel_setup;
+            public delegate* unmanaged[Cdecl]<Channel*, int> channel_cleanup;
+            public delegate* unmanaged[Cdecl]<Channel*, Socket*, ChannelMode, void*, int, int> channel_send;
+            public delegate* unmanaged[Cdecl]<Channel*, byte*, int, Buffer*, ChannelMode*, int> channel_recv;
+            public delegate* unmanaged[Cdecl]<Channel*, Buffer*, int> channel_next;
+            public delegate* unmanaged[Cdecl]<Channel*, Socket*, int> channel_update;
+            public delegate* unmanaged[Cdecl]<Coalescer*, byte*, int, Endpoint*, int> coalesce_init;
+            public delegate* unmanaged[Cdecl]<Coalescer*, Socket*, int, byte*> coalesce_reserve;
+            public delegate* unmanaged[Cdecl]<Coalescer*, Socket*, void*, int, int> coalesce_append;
+            public delegate* unmanaged[Cdecl]<Coalescer*, Socket*, int> coalesce_flush;
+            public delegate* unmanaged[Cdecl]<Socket*, Coalescer**, int, int> coalesce_flush_batch;
+            public delegate* unmanaged[Cdecl]<byte*, int, int*, Buffer*, int> coalesce_next;
+            public delegate* unmanaged[Cdecl]<FragmentSend*, byte*, int, Endpoint*, ushort, int, int> fragsend_init;
+            public delegate* unmanaged[Cdecl]<FragmentSend*, Socket*, int> fragsend_send;
+            public delegate* unmanaged[Cdecl]<FragmentTable*, int> fragtable_setup;
+            public delegate* unmanaged[Cdecl]<FragmentTable*, int> fragtable_cleanup;
+            public delegate* unmanaged[Cdecl]<FragmentTable*, Endpoint*, byte*, int, Buffer*, int> fragtable_recv;
+            public delegate* unmanaged[Cdecl]<FragmentTable*, int> fragtable_expire;
+            public delegate* unmanaged[Cdecl]<Capture*, byte*, int> capture_setup;
+            public delegate* unmanaged[Cdecl]<Capture*, int> capture_cleanup;
+            public delegate* unmanaged[Cdecl]<Impair*, int> impair_setup;
+            public delegate* unmanaged[Cdecl]<Impair*, int> impair_cleanup;
+            public delegate* unmanaged[Cdecl]<Impair*, Socket*, int> impair_flush;
+            public delegate* unmanaged[Cdecl]<Pacer*, ulong, uint, int> pacer_init;
+            public delegate* unmanaged[Cdecl]<Pacer*, Socket*, Message*, int, int> pacer_send_batch;
+            public delegate* unmanaged[Cdecl]<PeerTable*, int> peertable_setup;
+            public delegate* unmanaged[Cdecl]<PeerTable*, int> peertable_cleanup;
+            public delegate* unmanaged[Cdecl]<PeerTable*, Endpoint*, uint*, int> peertable_insert;
+            public delegate* unmanaged[Cdecl]<PeerTable*, uint, int> peertable_remove;
+            public delegate* unmanaged[Cdecl]<PeerTable*, Endpoint*, uint> peertable_find;
+            public delegate* unmanaged[Cdecl]<PeerTable*, Message*, int, uint*, int> peertable_find_batch;
+            public delegate* unmanaged[Cdecl]<PeerTable*, uint, void*> peertable_slot;
+            public delegate* unmanaged[Cdecl]<TimerWheel*, int> timerwheel_setup;
+            public delegate* unmanaged[Cdecl]<TimerWheel*, int> timerwheel_cleanup;
+            public delegate* unmanaged[Cdecl]<TimerWheel*, Timer*, uint, int> timerwheel_schedule;
+            public delegate* unmanaged[Cdecl]<TimerWheel*, Timer*, int> timerwheel_cancel;
+            public delegate* unmanaged[Cdecl]<TimerWheel*, Timer**, int, int> timerwheel_advance;
+            public delegate* unmanaged[Cdecl]<TimerWheel*, Poller*, PollEvent*, int, int, int> timerwheel_poll;
+            public delegate* unmanaged[Cdecl]<Socket*, BufferPool*, uint, int, IOThread*> iothread_start;
+            public delegate* unmanaged[Cdecl]<IOThread*, int> iothread_stop;
+        }
+#endif
+
         [DllImport(SL_DSO_NAME, CallingConvention = CallingConvention.Cdecl)]
         internal static extern int socklynx_setup(Context* ctx);
 
@@ -275,16 +842,231 @@ namespace SL
         [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern int socklynx_socket_nonblocking(Socket* sock, int enabled);
 
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_gso(Socket* sock, int enabled);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_gro(Socket* sock, int enabled);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_timestamp(Socket* sock, int enabled);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_rxq_ovfl(Socket* sock, int enabled);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_pacing_rate(Socket* sock, uint bytesPerSec);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_txtime(Socket* sock, int enabled);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_impair(Socket* sock, Impair* tx, Impair* rx);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_capture(Socket* sock, Capture* capture);
+
         [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern int socklynx_socket_open(Socket* sock);
 
         [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern int socklynx_socket_close(Socket* sock);
 
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_connect(Socket* sock, Endpoint* endpoint);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_send_connected(Socket* sock, Buffer* buf, int bufcount);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_recv_connected(Socket* sock, Buffer* buf, int bufcount);
+
         [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern int socklynx_socket_send(Socket* sock, Buffer* buf, int bufcount, Endpoint* endpoint);
 
         [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
         internal static extern int socklynx_socket_recv(Socket* sock, Buffer* buf, int bufcount, Endpoint* endpoint);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_recv_timestamped(Socket* sock, Buffer* buf, int bufcount, Endpoint* endpoint, ulong* timestamp_ns);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_send_gso(Socket* sock, Buffer* buf, uint segsize, Endpoint* endpoint);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_send_batch(Socket* sock, Message* msgs, int msgcount);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_recv_batch(Socket* sock, Message* msgs, int msgcount);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_stats(Socket* sock, SocketStats* stats);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_socket_bufsize(Socket* sock, int* rcvbuf, int* sndbuf);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_autotune_setup(Autotune* tune);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_autotune_cleanup(Autotune* tune);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_autotune_update(Autotune* tune);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_poller_setup(Poller* poller);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_poller_cleanup(Poller* poller);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_poller_add(Poller* poller, Socket* sock, PollEvents events);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_poller_remove(Poller* poller, Socket* sock);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_poller_wait(Poller* poller, PollEvent* events, int count, int timeoutMs);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_bufpool_setup(BufferPool* pool);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_bufpool_cleanup(BufferPool* pool);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_bufcache_init(BufferCache* cache, BufferPool* pool);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_bufcache_flush(BufferCache* cache);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_bufcache_acquire(BufferCache* cache, Buffer* buf);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_bufcache_release(BufferCache* cache, Buffer* buf);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_channel_setup(Channel* ch);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_channel_cleanup(Channel* ch);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_channel_send(Channel* ch, Socket* sock, ChannelMode mode, void* data, int len);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_channel_recv(Channel* ch, byte* data, int len, Buffer* msg, ChannelMode* mode);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_channel_next(Channel* ch, Buffer* msg);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_channel_update(Channel* ch, Socket* sock);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_coalesce_init(Coalescer* co, byte* frame, int capacity, Endpoint* endpoint);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern byte* socklynx_coalesce_reserve(Coalescer* co, Socket* sock, int len);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_coalesce_append(Coalescer* co, Socket* sock, void* data, int len);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_coalesce_flush(Coalescer* co, Socket* sock);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_coalesce_flush_batch(Socket* sock, Coalescer** cos, int count);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_fragsend_init(FragmentSend* fs, byte* data, int len, Endpoint* endpoint, ushort msgId, int datagram);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_fragsend_send(FragmentSend* fs, Socket* sock);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_fragtable_setup(FragmentTable* table);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_fragtable_cleanup(FragmentTable* table);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_fragtable_recv(FragmentTable* table, Endpoint* endpoint, byte* data, int len, Buffer* msg);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_fragtable_expire(FragmentTable* table);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_capture_setup(Capture* capture, string path);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_capture_cleanup(Capture* capture);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_impair_setup(Impair* impair);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_impair_cleanup(Impair* impair);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_impair_flush(Impair* impair, Socket* sock);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_pacer_init(Pacer* pacer, ulong rate, uint burst);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_pacer_send_batch(Pacer* pacer, Socket* sock, Message* msgs, int count);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_peertable_setup(PeerTable* table);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_peertable_cleanup(PeerTable* table);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_peertable_insert(PeerTable* table, Endpoint* endpoint, uint* handle);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_peertable_remove(PeerTable* table, uint handle);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern uint socklynx_peertable_find(PeerTable* table, Endpoint* endpoint);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_peertable_find_batch(PeerTable* table, Message* msgs, int count, uint* handles);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void* socklynx_peertable_slot(PeerTable* table, uint handle);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_timerwheel_setup(TimerWheel* wheel);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_timerwheel_cleanup(TimerWheel* wheel);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_timerwheel_schedule(TimerWheel* wheel, Timer* timer, uint delayMs);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_timerwheel_cancel(TimerWheel* wheel, Timer* timer);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_timerwheel_advance(TimerWheel* wheel, Timer** expired, int count);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_timerwheel_poll(TimerWheel* wheel, Poller* poller, PollEvent* events, int count, int maxMs);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern IOThread* socklynx_iothread_start(Socket* sock, BufferPool* pool, uint capacity, int waitMs);
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int socklynx_iothread_stop(IOThread* io);
+#if SL_API_TABLE_ENABLED
+
+        [DllImport(SL_DSO_NAME, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern Api* socklynx_get_api(uint version);
+#endif
     }
 }
@@ -20,6 +20,10 @@
  * SOFTWARE.
  */
 
+#if UNITY_2021_2_OR_NEWER || !UNITY_5_3_OR_NEWER
+#   define SL_API_TABLE_ENABLED
+#endif
+
 using System;
 using System.Runtime.InteropServices;
 using System.Runtime.CompilerServices;
@@ -46,6 +50,15 @@ namespace SL
             return (C.socklynx_cleanup(ctx) == C.SL_OK);
         }
 
+#if SL_API_TABLE_ENABLED
+        /* null when the plugin predates version, the members of the table skip the DllImport stubs */
+        [MethodImpl(INLINE)]
+        public static C.Api* GetApi(uint version = C.SL_API_VERSION)
+        {
+            return C.socklynx_get_api(version);
+        }
+#endif
+
         [MethodImpl(INLINE)]
         public static bool SocketOpen(C.Socket* sock)
         {
@@ -64,6 +77,84 @@ namespace SL
             return (C.socklynx_socket_nonblocking(sock, enabled ? 1 : 0) == C.SL_OK);
         }
 
+        [MethodImpl(INLINE)]
+        public static bool SocketGSO(C.Socket* sock, bool enabled)
+        {
+            return (C.socklynx_socket_gso(sock, enabled ? 1 : 0) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketGRO(C.Socket* sock, bool enabled)
+        {
+            return (C.socklynx_socket_gro(sock, enabled ? 1 : 0) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketTimestamp(C.Socket* sock, bool enabled)
+        {
+            return (C.socklynx_socket_timestamp(sock, enabled ? 1 : 0) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketDropCounting(C.Socket* sock, bool enabled)
+        {
+            return (C.socklynx_socket_rxq_ovfl(sock, enabled ? 1 : 0) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketPacingRate(C.Socket* sock, int bytesPerSec)
+        {
+            return (C.socklynx_socket_pacing_rate(sock, (uint)bytesPerSec) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketLaunchTimes(C.Socket* sock, bool enabled)
+        {
+            return (C.socklynx_socket_txtime(sock, enabled ? 1 : 0) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketImpair(C.Socket* sock, C.Impair* tx, C.Impair* rx)
+        {
+            return (C.socklynx_socket_impair(sock, tx, rx) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketCapture(C.Socket* sock, C.Capture* capture)
+        {
+            return (C.socklynx_socket_capture(sock, capture) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static ulong SocketDrops(C.Socket* sock)
+        {
+            return sock->stats.rx_dropped;
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketConnect(C.Socket* sock, C.Endpoint* endpoint)
+        {
+            return (C.socklynx_socket_connect(sock, endpoint) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketDisconnect(C.Socket* sock)
+        {
+            return (C.socklynx_socket_connect(sock, null) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int SocketSend(C.Socket* sock, C.Buffer* bufferArray, int bufferCount)
+        {
+            return C.socklynx_socket_send_connected(sock, bufferArray, bufferCount);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int SocketRecv(C.Socket* sock, C.Buffer* bufferArray, int bufferCount)
+        {
+            return C.socklynx_socket_recv_connected(sock, bufferArray, bufferCount);
+        }
+
         [MethodImpl(INLINE)]
         public static int SocketSend(C.Socket* sock, C.Buffer* bufferArray, int bufferCount, C.Endpoint* endpoint)
         {
@@ -75,5 +166,390 @@ namespace SL
         {
             return C.socklynx_socket_recv(sock, bufferArray, bufferCount, endpoint);
         }
+
+        [MethodImpl(INLINE)]
+        public static int SocketRecvTimestamped(C.Socket* sock, C.Buffer* bufferArray, int bufferCount, C.Endpoint* endpoint, ulong* timestampNs)
+        {
+            return C.socklynx_socket_recv_timestamped(sock, bufferArray, bufferCount, endpoint, timestampNs);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int SocketSendGSO(C.Socket* sock, C.Buffer* buffer, int segmentSize, C.Endpoint* endpoint)
+        {
+            return C.socklynx_socket_send_gso(sock, buffer, (uint)segmentSize, endpoint);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int SocketSendBatch(C.Socket* sock, C.Message* messageArray, int messageCount)
+        {
+            return C.socklynx_socket_send_batch(sock, messageArray, messageCount);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int SocketRecvBatch(C.Socket* sock, C.Message* messageArray, int messageCount)
+        {
+            return C.socklynx_socket_recv_batch(sock, messageArray, messageCount);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketStats(C.Socket* sock, C.SocketStats* stats)
+        {
+            return (C.socklynx_socket_stats(sock, stats) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool SocketBufferSize(C.Socket* sock, int* receiveBytes, int* sendBytes)
+        {
+            return (C.socklynx_socket_bufsize(sock, receiveBytes, sendBytes) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool AutotuneSetup(C.Autotune* tune)
+        {
+            return (C.socklynx_autotune_setup(tune) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool AutotuneCleanup(C.Autotune* tune)
+        {
+            return (C.socklynx_autotune_cleanup(tune) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int AutotuneUpdate(C.Autotune* tune)
+        {
+            return C.socklynx_autotune_update(tune);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PollerSetup(C.Poller* poller)
+        {
+            return (C.socklynx_poller_setup(poller) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PollerCleanup(C.Poller* poller)
+        {
+            return (C.socklynx_poller_cleanup(poller) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PollerAdd(C.Poller* poller, C.Socket* sock, C.PollEvents events)
+        {
+            return (C.socklynx_poller_add(poller, sock, events) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PollerRemove(C.Poller* poller, C.Socket* sock)
+        {
+            return (C.socklynx_poller_remove(poller, sock) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int PollerWait(C.Poller* poller, C.PollEvent* eventArray, int eventCount, int timeoutMs)
+        {
+            return C.socklynx_poller_wait(poller, eventArray, eventCount, timeoutMs);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool BufferPoolSetup(C.BufferPool* pool)
+        {
+            return (C.socklynx_bufpool_setup(pool) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool BufferPoolCleanup(C.BufferPool* pool)
+        {
+            return (C.socklynx_bufpool_cleanup(pool) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool BufferCacheInit(C.BufferCache* cache, C.BufferPool* pool)
+        {
+            return (C.socklynx_bufcache_init(cache, pool) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool BufferCacheFlush(C.BufferCache* cache)
+        {
+            return (C.socklynx_bufcache_flush(cache) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool BufferRent(C.BufferCache* cache, C.Buffer* buffer)
+        {
+            return (C.socklynx_bufcache_acquire(cache, buffer) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool BufferReturn(C.BufferCache* cache, C.Buffer* buffer)
+        {
+            return (C.socklynx_bufcache_release(cache, buffer) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool ChannelSetup(C.Channel* ch)
+        {
+            return (C.socklynx_channel_setup(ch) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool ChannelCleanup(C.Channel* ch)
+        {
+            return (C.socklynx_channel_cleanup(ch) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool ChannelSend(C.Channel* ch, C.Socket* sock, C.ChannelMode mode, void* data, int len)
+        {
+            return (C.socklynx_channel_send(ch, sock, mode, data, len) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int ChannelRecv(C.Channel* ch, byte* data, int len, C.Buffer* msg, C.ChannelMode* mode = null)
+        {
+            return C.socklynx_channel_recv(ch, data, len, msg, mode);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int ChannelNext(C.Channel* ch, C.Buffer* msg)
+        {
+            return C.socklynx_channel_next(ch, msg);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int ChannelUpdate(C.Channel* ch, C.Socket* sock)
+        {
+            return C.socklynx_channel_update(ch, sock);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool CoalesceInit(C.Coalescer* co, byte* frame, int capacity, C.Endpoint* endpoint = null)
+        {
+            return (C.socklynx_coalesce_init(co, frame, capacity, endpoint) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static byte* CoalesceReserve(C.Coalescer* co, C.Socket* sock, int len)
+        {
+            return C.socklynx_coalesce_reserve(co, sock, len);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool CoalesceAppend(C.Coalescer* co, C.Socket* sock, void* data, int len)
+        {
+            return (C.socklynx_coalesce_append(co, sock, data, len) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int CoalesceFlush(C.Coalescer* co, C.Socket* sock)
+        {
+            return C.socklynx_coalesce_flush(co, sock);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int CoalesceFlushBatch(C.Socket* sock, C.Coalescer** cos, int count)
+        {
+            return C.socklynx_coalesce_flush_batch(sock, cos, count);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int CoalesceNext(byte* frame, int len, int* offset, C.Buffer* msg)
+        {
+            return C.Coalescer.Next(frame, len, offset, msg);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool FragmentInit(C.FragmentSend* fs, byte* data, int len, C.Endpoint* endpoint, ushort msgId, int datagram = 0)
+        {
+            return (C.socklynx_fragsend_init(fs, data, len, endpoint, msgId, datagram) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int FragmentSend(C.FragmentSend* fs, C.Socket* sock)
+        {
+            return C.socklynx_fragsend_send(fs, sock);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool FragmentTableSetup(C.FragmentTable* table)
+        {
+            return (C.socklynx_fragtable_setup(table) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool FragmentTableCleanup(C.FragmentTable* table)
+        {
+            return (C.socklynx_fragtable_cleanup(table) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int FragmentRecv(C.FragmentTable* table, C.Endpoint* endpoint, byte* data, int len, C.Buffer* msg)
+        {
+            return C.socklynx_fragtable_recv(table, endpoint, data, len, msg);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int FragmentExpire(C.FragmentTable* table)
+        {
+            return C.socklynx_fragtable_expire(table);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool CaptureSetup(C.Capture* capture, string path)
+        {
+            return (C.socklynx_capture_setup(capture, path) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool CaptureCleanup(C.Capture* capture)
+        {
+            return (C.socklynx_capture_cleanup(capture) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool ImpairSetup(C.Impair* impair)
+        {
+            return (C.socklynx_impair_setup(impair) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool ImpairCleanup(C.Impair* impair)
+        {
+            return (C.socklynx_impair_cleanup(impair) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int ImpairFlush(C.Impair* impair, C.Socket* sock)
+        {
+            return C.socklynx_impair_flush(impair, sock);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PacerInit(C.Pacer* pacer, long bytesPerSec, int burst = 0)
+        {
+            return (C.socklynx_pacer_init(pacer, (ulong)bytesPerSec, (uint)burst) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int PacerSendBatch(C.Pacer* pacer, C.Socket* sock, C.Message* messageArray, int messageCount)
+        {
+            return C.socklynx_pacer_send_batch(pacer, sock, messageArray, messageCount);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PeerTableSetup(C.PeerTable* table)
+        {
+            return (C.socklynx_peertable_setup(table) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PeerTableCleanup(C.PeerTable* table)
+        {
+            return (C.socklynx_peertable_cleanup(table) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PeerInsert(C.PeerTable* table, C.Endpoint* endpoint, uint* handle)
+        {
+            return (C.socklynx_peertable_insert(table, endpoint, handle) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool PeerRemove(C.PeerTable* table, uint handle)
+        {
+            return (C.socklynx_peertable_remove(table, handle) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static uint PeerFind(C.PeerTable* table, C.Endpoint* endpoint)
+        {
+            return C.socklynx_peertable_find(table, endpoint);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int PeerFindBatch(C.PeerTable* table, C.Message* msgs, int count, uint* handles)
+        {
+            return C.socklynx_peertable_find_batch(table, msgs, count, handles);
+        }
+
+        [MethodImpl(INLINE)]
+        public static void* PeerSlot(C.PeerTable* table, uint handle)
+        {
+            return C.socklynx_peertable_slot(table, handle);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool TimerWheelSetup(C.TimerWheel* wheel)
+        {
+            return (C.socklynx_timerwheel_setup(wheel) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool TimerWheelCleanup(C.TimerWheel* wheel)
+        {
+            return (C.socklynx_timerwheel_cleanup(wheel) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool TimerSchedule(C.TimerWheel* wheel, C.Timer* timer, int delayMs)
+        {
+            return (C.socklynx_timerwheel_schedule(wheel, timer, (uint)delayMs) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool TimerCancel(C.TimerWheel* wheel, C.Timer* timer)
+        {
+            return (C.socklynx_timerwheel_cancel(wheel, timer) == C.SL_OK);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int TimerAdvance(C.TimerWheel* wheel, C.Timer** expired, int count)
+        {
+            return C.socklynx_timerwheel_advance(wheel, expired, count);
+        }
+
+        [MethodImpl(INLINE)]
+        public static int TimerPoll(C.TimerWheel* wheel, C.Poller* poller, C.PollEvent* eventArray, int eventCount, int maxMs)
+        {
+            return C.socklynx_timerwheel_poll(wheel, poller, eventArray, eventCount, maxMs);
+        }
+
+        [MethodImpl(INLINE)]
+        public static C.IOThread* IOThreadStart(C.Socket* sock, C.BufferPool* pool, int capacity = 0, int waitMs = 0)
+        {
+            return C.socklynx_iothread_start(sock, pool, (uint)capacity, waitMs);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool IOThreadStop(C.IOThread* io)
+        {
+            return (C.socklynx_iothread_stop(io) == C.SL_OK);
+        }
+
+        /* the calls below only touch shared memory, they never enter the plugin */
+        [MethodImpl(INLINE)]
+        public static bool IOThreadRecv(C.IOThread* io, C.Packet* packet)
+        {
+            return C.PacketRing.TryPop(&io->rx, packet);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool IOThreadRecycle(C.IOThread* io, C.Packet* packet)
+        {
+            return C.PacketRing.TryPush(&io->done, packet);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool IOThreadRent(C.IOThread* io, C.Packet* packet)
+        {
+            return C.PacketRing.TryPop(&io->free, packet);
+        }
+
+        [MethodImpl(INLINE)]
+        public static bool IOThreadSend(C.IOThread* io, C.Packet* packet)
+        {
+            return C.PacketRing.TryPush(&io->tx, packet);
+        }
     }
 }
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if UNITY_2021_2_OR_NEWER || !UNITY_5_3_OR_NEWER
+
+using NUnit.Framework;
+using System.Diagnostics;
+
+namespace SL
+{
+    /* the same calls through the DllImport stubs and through C.Api, timings come back in the pass message */
+    public unsafe class SLBenchmark
+    {
+        const int CALLS = 1000000;
+        const int PEERS = 1024;
+
+        static string Report(string name, long stubTicks, long tableTicks)
+        {
+            double stubNs = stubTicks * 1e9 / Stopwatch.Frequency / CALLS;
+            double tableNs = tableTicks * 1e9 / Stopwatch.Frequency / CALLS;
+            return string.Format("{0}: DllImport {1:F2} ns/call, function pointer {2:F2} ns/call ({3:F2}x)", name, stubNs, tableNs, stubNs / tableNs);
+        }
+
+        [Test]
+        public void Bench_Dispatch()
+        {
+            C.Api* api = API.GetApi();
+            Assert.True(api != null);
+
+            /* a null socket fails the first guard, what is left is the cost of getting into the plugin */
+            long sum = 0;
+            for (int i = 0; i < CALLS / 10; i++)
+            {
+                sum += C.socklynx_socket_stats(null, null) + api->socket_stats(null, null);
+            }
+
+            var watch = Stopwatch.StartNew();
+            for (int i = 0; i < CALLS; i++)
+            {
+                sum += C.socklynx_socket_stats(null, null);
+            }
+            long stubTicks = watch.ElapsedTicks;
+
+            watch.Restart();
+            for (int i = 0; i < CALLS; i++)
+            {
+                sum += api->socket_stats(null, null);
+            }
+            long tableTicks = watch.ElapsedTicks;
+
+            Assert.AreEqual(-(CALLS / 5 + 2L * CALLS), sum);
+            Assert.Pass(Report("socket_stats(null)", stubTicks, tableTicks));
+        }
+
+        [Test]
+        public void Bench_PeerFind()
+        {
+            C.Api* api = API.GetApi();
+            Assert.True(api != null);
+
+            SL.C.Context ctx = default;
+            C.PeerTable table = C.PeerTable.New(PEERS);
+            try
+            {
+                Assert.True(API.Setup(&ctx));
+                Assert.True(API.PeerTableSetup(&table));
+                C.Endpoint* endpoints = stackalloc C.Endpoint[PEERS];
+                for (int i = 0; i < PEERS; i++)
+                {
+                    uint handle;
+                    endpoints[i] = C.Endpoint.NewV4(&ctx, 1000 + i, C.IPv4.New(10, 0, (byte)(i >> 8), (byte)i));
+                    Assert.True(API.PeerInsert(&table, &endpoints[i], &handle));
+                }
+
+                /* a lookup per received datagram is the hottest call a server makes */
+                ulong stubSum = 0, tableSum = 0;
+                var watch = Stopwatch.StartNew();
+                for (int i = 0; i < CALLS; i++)
+                {
+                    stubSum += C.socklynx_peertable_find(&table, &endpoints[i & (PEERS - 1)]);
+                }
+                long stubTicks = watch.ElapsedTicks;
+
+                watch.Restart();
+                for (int i = 0; i < CALLS; i++)
+                {
+                    tableSum += api->peertable_find(&table, &endpoints[i & (PEERS - 1)]);
+                }
+                long tableTicks = watch.ElapsedTicks;
+
+                Assert.AreEqual(stubSum, tableSum);
+                Assert.True(API.PeerTableCleanup(&table));
+                Assert.True(API.Cleanup(&ctx));
+                Assert.Pass(Report("peertable_find", stubTicks, tableTicks));
+            }
+            finally
+            {
+                API.PeerTableCleanup(&table);
+                API.Cleanup(&ctx);
+            }
+        }
+    }
+}
+#endif
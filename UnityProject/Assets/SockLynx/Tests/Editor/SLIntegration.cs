@@ -112,4 +112,742 @@ public unsafe class SLIntegration
             API.Cleanup(&ctx);
         }
     }
+
+    [Test]
+    public void UDP_SocketRecvTimestamped_Blocking()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            byte[] pl_client = new byte[256];
+            byte[] mem_server = new byte[1408];
+            new Random().NextBytes(pl_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+
+            fixed (byte* plptr = pl_client)
+            fixed (byte* memptr = mem_server)
+            {
+                C.Buffer buf_client_send = C.Buffer.New(plptr, pl_client.Length);
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+                ulong timestamp_ns = 0;
+
+                /* the kernel receive time is on the wall clock */
+                Assert.True(API.SocketTimestamp(&sock_server, true));
+                Assert.AreEqual(pl_client.Length, API.SocketSend(&sock_client, &buf_client_send, 1, &ep_server));
+                Assert.AreEqual(pl_client.Length, API.SocketRecvTimestamped(&sock_server, &buf_server_recv, 1, &ep_server_recv, &timestamp_ns));
+                ulong now_ns = (ulong)(DateTime.UtcNow - new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc)).Ticks * 100;
+                Assert.AreNotEqual(0UL, timestamp_ns);
+                Assert.Less(now_ns - timestamp_ns, 60UL * 1000000000UL);
+                Assert.True(Util.MemCmp(plptr, 0, buf_server_recv.buf, 0, pl_client.Length));
+                Assert.True(Util.MemCmp((byte*)&ep_client, 2, (byte*)&ep_server_recv, 2, sizeof(C.Endpoint) - 2));
+
+                /* and reads as 0 once it is turned off again */
+                Assert.True(API.SocketTimestamp(&sock_server, false));
+                Assert.AreEqual(pl_client.Length, API.SocketSend(&sock_client, &buf_client_send, 1, &ep_server));
+                Assert.AreEqual(pl_client.Length, API.SocketRecvTimestamped(&sock_server, &buf_server_recv, 1, &ep_server_recv, &timestamp_ns));
+                Assert.AreEqual(0UL, timestamp_ns);
+            }
+
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_SocketRecvBatch_Blocking()
+    {
+        Random rand = new Random();
+
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            byte[] pl_client = new byte[256];
+            byte[] mem_server = new byte[4 * 1408];
+            rand.NextBytes(pl_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+
+            fixed (byte* plptr = pl_client)
+            fixed (byte* memptr = mem_server)
+            {
+                C.Buffer* buf_server_recv = stackalloc C.Buffer[4];
+                C.Endpoint* ep_server_recv = stackalloc C.Endpoint[4];
+                C.Message* msg_server_recv = stackalloc C.Message[4];
+                for (int i = 0; i < 4; i++)
+                {
+                    buf_server_recv[i] = C.Buffer.New(memptr + i * 1408, 1408);
+                    msg_server_recv[i] = C.Message.New(&buf_server_recv[i], 1, &ep_server_recv[i]);
+                }
+
+                for (int i = 1; i <= 3; i++)
+                {
+                    C.Buffer buf_client_send = C.Buffer.New(plptr, pl_client.Length / i);
+                    Assert.AreEqual(pl_client.Length / i, API.SocketSend(&sock_client, &buf_client_send, 1, &ep_server));
+                }
+
+                Assert.AreEqual(3, API.SocketRecvBatch(&sock_server, msg_server_recv, 4));
+                for (int i = 0; i < 3; i++)
+                {
+                    Assert.AreEqual(pl_client.Length / (i + 1), msg_server_recv[i].len);
+                    Assert.True(Util.MemCmp(plptr, 0, buf_server_recv[i].buf, 0, msg_server_recv[i].len));
+                    Assert.True(Util.MemCmp((byte*)&ep_client, 2, (byte*)&ep_server_recv[i], 2, sizeof(C.Endpoint) - 2));
+                }
+                Assert.AreEqual(0, msg_server_recv[3].len);
+            }
+
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_SocketConnect()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            byte[] pl_client = new byte[256];
+            byte[] mem_server = new byte[1408];
+            byte[] mem_client = new byte[1408];
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.SocketConnect(&sock_client, &ep_server));
+            Assert.AreEqual(C.SocketState.Open, sock_client.state);
+
+            fixed (byte* plptr = pl_client)
+            fixed (byte* memptr = mem_server)
+            fixed (byte* mem_client_ptr = mem_client)
+            {
+                C.Buffer buf_client_send = C.Buffer.New(plptr, pl_client.Length);
+                C.Buffer buf_client_recv = C.Buffer.New(mem_client_ptr, mem_client.Length);
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+
+                Assert.AreEqual(pl_client.Length, API.SocketSend(&sock_client, &buf_client_send, 1));
+                Assert.AreEqual(pl_client.Length, API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv));
+                Assert.AreEqual(pl_client.Length, API.SocketSend(&sock_server, &buf_client_send, 1, &ep_client));
+                Assert.AreEqual(pl_client.Length, API.SocketRecv(&sock_client, &buf_client_recv, 1));
+            }
+
+            Assert.True(API.SocketDisconnect(&sock_client));
+            Assert.AreEqual(C.SocketState.Bound, sock_client.state);
+            Assert.False(API.SocketDisconnect(&sock_client));
+
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_Channel()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+        C.Channel ch_server = default;
+        C.Channel ch_client = default;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+            ch_server = C.Channel.New(&ep_client);
+            ch_client = C.Channel.New(null);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.SocketConnect(&sock_client, &ep_server));
+            Assert.True(API.ChannelSetup(&ch_server));
+            Assert.True(API.ChannelSetup(&ch_client));
+
+            byte* pl = stackalloc byte[32];
+            byte[] mem = new byte[1408];
+            fixed (byte* memptr = mem)
+            {
+                C.Buffer buf_recv = C.Buffer.New(memptr, mem.Length);
+                C.Endpoint ep_recv = default;
+                C.Buffer msg = default;
+                C.ChannelMode mode;
+
+                for (int i = 0; i < 3; i++)
+                {
+                    pl[0] = (byte)i;
+                    Assert.True(API.ChannelSend(&ch_client, &sock_client, C.ChannelMode.Reliable, pl, 32));
+                }
+                Assert.AreEqual(3, ch_client.send_seq);
+                for (int i = 0; i < 3; i++)
+                {
+                    int len = API.SocketRecv(&sock_server, &buf_recv, 1, &ep_recv);
+                    Assert.AreEqual(C.SL_CHANNEL_HEADER_SIZE + 32, len);
+                    Assert.AreEqual(1, API.ChannelRecv(&ch_server, memptr, len, &msg, &mode));
+                    Assert.AreEqual(C.ChannelMode.Reliable, mode);
+                    Assert.AreEqual((byte)i, msg.buf[0]);
+                    Assert.AreEqual(0, API.ChannelNext(&ch_server, &msg));
+                }
+
+                Assert.AreEqual(1, API.ChannelUpdate(&ch_server, &sock_server));
+                int acklen = API.SocketRecv(&sock_client, &buf_recv, 1);
+                Assert.AreEqual(C.SL_CHANNEL_HEADER_SIZE, acklen);
+                Assert.AreEqual(0, API.ChannelRecv(&ch_client, memptr, acklen, &msg, &mode));
+                Assert.AreEqual(C.ChannelMode.Ack, mode);
+                Assert.AreEqual(0u, ch_client.send_pending);
+                Assert.AreEqual(0, API.ChannelUpdate(&ch_client, &sock_client));
+            }
+
+            Assert.True(API.ChannelCleanup(&ch_server));
+            Assert.True(API.ChannelCleanup(&ch_client));
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.ChannelCleanup(&ch_server);
+            API.ChannelCleanup(&ch_client);
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_Coalesce()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.SocketConnect(&sock_client, &ep_server));
+
+            byte* frame = stackalloc byte[C.SL_COALESCE_FRAME_DEFAULT];
+            byte* pl = stackalloc byte[64];
+            byte[] mem_server = new byte[1408];
+            C.Coalescer co = default;
+            Assert.True(API.CoalesceInit(&co, frame, C.SL_COALESCE_FRAME_DEFAULT));
+
+            for (int i = 0; i < 10; i++)
+            {
+                pl[0] = (byte)i;
+                Assert.True(API.CoalesceAppend(&co, &sock_client, pl, 20 + i));
+            }
+            byte* reserved = API.CoalesceReserve(&co, &sock_client, 3);
+            Assert.True(reserved != null);
+            reserved[0] = 10;
+            Assert.AreEqual(11, co.count);
+            Assert.True(API.CoalesceReserve(&co, &sock_client, C.SL_COALESCE_FRAME_DEFAULT) == null);
+
+            int framelen = co.len;
+            Assert.AreEqual(framelen, API.CoalesceFlush(&co, &sock_client));
+            Assert.AreEqual(0, API.CoalesceFlush(&co, &sock_client));
+
+            fixed (byte* memptr = mem_server)
+            {
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+                Assert.AreEqual(framelen, API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv));
+
+                C.Buffer msg = default;
+                int offset = 0, count = 0;
+                while (API.CoalesceNext(memptr, framelen, &offset, &msg) == 1)
+                {
+                    Assert.AreEqual((byte)count, msg.buf[0]);
+                    Assert.True(msg.buf > memptr && msg.buf < memptr + framelen);
+                    count++;
+                }
+                Assert.AreEqual(11, count);
+                Assert.AreEqual(framelen, offset);
+            }
+
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_Paced()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.SocketPacingRate(&sock_client, 125000));
+            Assert.True(API.SocketPacingRate(&sock_client, 0));
+
+            /* 20 datagrams of 1000 bytes on the wire at 1 MB/s, the first few as a burst */
+            const int count = 20;
+            byte* pl = stackalloc byte[1000 - C.SL_PACER_OVERHEAD];
+            C.Buffer* bufs = stackalloc C.Buffer[count];
+            C.Message* msgs = stackalloc C.Message[count];
+            for (int i = 0; i < count; i++)
+            {
+                bufs[i] = C.Buffer.New(pl, 1000 - C.SL_PACER_OVERHEAD);
+                msgs[i] = default;
+                msgs[i].buf = &bufs[i];
+                msgs[i].bufcount = 1;
+                msgs[i].endpoint = &ep_server;
+            }
+
+            C.Pacer pacer = default;
+            Assert.True(API.PacerInit(&pacer, 1000000));
+            var watch = System.Diagnostics.Stopwatch.StartNew();
+            int sent = 0;
+            while (sent < count)
+            {
+                int rv = API.PacerSendBatch(&pacer, &sock_client, msgs + sent, count - sent);
+                Assert.GreaterOrEqual(rv, 0);
+                if (rv == 0) System.Threading.Thread.Sleep(1);
+                sent += rv;
+            }
+            Assert.GreaterOrEqual(watch.ElapsedMilliseconds, count - 6);
+
+            byte[] mem_server = new byte[1408];
+            fixed (byte* memptr = mem_server)
+            {
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+                for (int i = 0; i < count; i++)
+                {
+                    Assert.AreEqual(1000 - C.SL_PACER_OVERHEAD, API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv));
+                }
+            }
+
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_Impaired()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+        C.Impair tx = C.Impair.New(7);
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+
+            /* every datagram held 20 ms and copied once */
+            tx.latency_us = 20000;
+            tx.duplicate_ppm = C.SL_IMPAIR_PPM;
+            Assert.True(API.ImpairSetup(&tx));
+            Assert.True(API.SocketImpair(&sock_client, &tx, null));
+
+            const int count = 5;
+            byte* pl = stackalloc byte[64];
+            C.Buffer buf_client = C.Buffer.New(pl, 64);
+            for (int i = 0; i < count; i++)
+            {
+                Assert.AreEqual(64, API.SocketSend(&sock_client, &buf_client, 1, &ep_server));
+            }
+            Assert.AreEqual((ulong)count, tx.duplicated);
+            Assert.AreEqual(0, API.ImpairFlush(&tx, &sock_client));
+
+            int flushed = 0;
+            var watch = System.Diagnostics.Stopwatch.StartNew();
+            while (flushed < 2 * count && watch.ElapsedMilliseconds < 1000)
+            {
+                System.Threading.Thread.Sleep(1);
+                flushed += API.ImpairFlush(&tx, &sock_client);
+            }
+            Assert.AreEqual(2 * count, flushed);
+            Assert.GreaterOrEqual(watch.ElapsedMilliseconds, 19);
+
+            byte[] mem_server = new byte[1408];
+            fixed (byte* memptr = mem_server)
+            {
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+                for (int i = 0; i < 2 * count; i++)
+                {
+                    Assert.AreEqual(64, API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv));
+                }
+            }
+
+            Assert.True(API.SocketImpair(&sock_client, null, null));
+            Assert.True(API.ImpairCleanup(&tx));
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.ImpairCleanup(&tx);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_Capture()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+        C.Capture capture = C.Capture.New(1024 * 1024);
+        string path = System.IO.Path.Combine(System.IO.Path.GetTempPath(), "sl_udp_capture.pcap");
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.CaptureSetup(&capture, path));
+            Assert.True(API.SocketCapture(&sock_client, &capture));
+
+            const int count = 3;
+            byte* pl = stackalloc byte[64];
+            C.Buffer buf_client = C.Buffer.New(pl, 64);
+            for (int i = 0; i < count; i++)
+            {
+                Assert.AreEqual(64, API.SocketSend(&sock_client, &buf_client, 1, &ep_server));
+            }
+            Assert.True(API.SocketCapture(&sock_client, null));
+            Assert.True(API.CaptureCleanup(&capture));
+            Assert.AreEqual(0UL, capture.dropped);
+
+            /* the file header, then a record header, ipv4 and udp headers and the payload per datagram */
+            Assert.AreEqual(24 + count * (16 + 20 + 8 + 64), new System.IO.FileInfo(path).Length);
+
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.CaptureCleanup(&capture);
+            API.Cleanup(&ctx);
+            System.IO.File.Delete(path);
+        }
+    }
+
+    [Test]
+    public void UDP_Fragment()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+        C.BufferPool pool = C.BufferPool.New(2, 16 * 1024);
+        C.FragmentTable table = C.FragmentTable.New(&pool, 16);
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.BufferPoolSetup(&pool));
+            Assert.True(API.FragmentTableSetup(&table));
+
+            byte[] pl = new byte[5000];
+            for (int i = 0; i < pl.Length; i++) pl[i] = (byte)(i * 7);
+            byte[] mem_server = new byte[1408];
+
+            fixed (byte* plptr = pl)
+            fixed (byte* memptr = mem_server)
+            {
+                C.FragmentSend fs = default;
+                Assert.True(API.FragmentInit(&fs, plptr, pl.Length, &ep_server, 42));
+                Assert.AreEqual(5, fs.count);
+                Assert.AreEqual(0, API.FragmentSend(&fs, &sock_client));
+
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+                C.Buffer msg = default;
+                int rv = 0;
+                for (int i = 0; i < fs.count; i++)
+                {
+                    int len = API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv);
+                    Assert.Greater(len, C.SL_FRAG_HEADER_SIZE);
+                    rv = API.FragmentRecv(&table, &ep_server_recv, memptr, len, &msg);
+                }
+                Assert.AreEqual(1, rv);
+                for (int i = 0; i < pl.Length; i++) Assert.AreEqual(pl[i], msg.buf[i]);
+                Assert.AreEqual(0, API.FragmentExpire(&table));
+            }
+
+            Assert.True(API.FragmentTableCleanup(&table));
+            Assert.True(API.BufferPoolCleanup(&pool));
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.FragmentTableCleanup(&table);
+            API.BufferPoolCleanup(&pool);
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_PollerWait()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+        C.Poller poller = C.Poller.New(4);
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            byte[] pl_client = new byte[256];
+            byte[] mem_server = new byte[1408];
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.SocketNonBlocking(&sock_server, true));
+            Assert.True(API.PollerSetup(&poller));
+            Assert.True(API.PollerAdd(&poller, &sock_server, C.PollEvents.Read));
+
+            fixed (byte* plptr = pl_client)
+            fixed (byte* memptr = mem_server)
+            {
+                C.Buffer buf_server_recv = C.Buffer.New(memptr, mem_server.Length);
+                C.Endpoint ep_server_recv = default;
+                C.PollEvent* events = stackalloc C.PollEvent[4];
+
+                Assert.AreEqual(C.SL_ERR, API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv));
+                Assert.True(C.Socket.HasFlag(&sock_server, C.SocketFlags.WouldBlockOnRead));
+                Assert.AreEqual(0, API.PollerWait(&poller, events, 4, 0));
+
+                C.Buffer buf_client_send = C.Buffer.New(plptr, pl_client.Length);
+                Assert.AreEqual(pl_client.Length, API.SocketSend(&sock_client, &buf_client_send, 1, &ep_server));
+
+                Assert.AreEqual(1, API.PollerWait(&poller, events, 4, 1000));
+                Assert.True(&sock_server == events[0].sock);
+                Assert.True(events[0].events.HasFlag(C.PollEvents.Read));
+                Assert.False(C.Socket.HasFlag(&sock_server, C.SocketFlags.WouldBlockOnRead));
+                Assert.AreEqual(pl_client.Length, API.SocketRecv(&sock_server, &buf_server_recv, 1, &ep_server_recv));
+
+                C.SocketStats stats = default;
+                Assert.True(API.SocketStats(&sock_server, &stats));
+                Assert.AreEqual(1UL, stats.rx_packets);
+                Assert.AreEqual((ulong)pl_client.Length, stats.rx_bytes);
+                Assert.AreEqual((uint)pl_client.Length, stats.rx_max);
+                Assert.AreEqual(1UL, stats.rx_wouldblock);
+                Assert.AreEqual(stats.rx_bytes, sock_server.stats.rx_bytes);
+                Assert.True(API.SocketStats(&sock_client, &stats));
+                Assert.AreEqual(1UL, stats.tx_packets);
+                Assert.AreEqual(0UL, stats.rx_packets);
+            }
+
+            Assert.True(API.PollerRemove(&poller, &sock_server));
+            Assert.True(API.PollerCleanup(&poller));
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            API.PollerCleanup(&poller);
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
+
+    [Test]
+    public void UDP_IOThread()
+    {
+        C.Socket sock_server = default;
+        C.Socket sock_client = default;
+        C.BufferPool pool = C.BufferPool.New(256);
+        C.IOThread* io = null;
+
+        SL.C.Context ctx = default;
+        Assert.True(API.Setup(&ctx));
+        try
+        {
+            C.IPv4 loopback = C.IPv4.New(127, 0, 0, 1);
+            C.Endpoint ep_server = C.Endpoint.NewV4(&ctx, _port, loopback);
+            C.Endpoint ep_client = C.Endpoint.NewV4(&ctx, _port + 1, loopback);
+            sock_server = C.Socket.NewUDP(&ctx, ep_server);
+            sock_client = C.Socket.NewUDP(&ctx, ep_client);
+
+            Assert.True(API.SocketOpen(&sock_server));
+            Assert.True(API.SocketOpen(&sock_client));
+            Assert.True(API.BufferPoolSetup(&pool));
+            io = API.IOThreadStart(&sock_server, &pool, 64);
+            Assert.True(io != null);
+
+            byte* pl_client = stackalloc byte[256];
+            C.Buffer buf_client_send = C.Buffer.New(pl_client, 256);
+            for (int i = 0; i < 50; i++)
+            {
+                pl_client[0] = (byte)i;
+                Assert.AreEqual(256, API.SocketSend(&sock_client, &buf_client_send, 1, &ep_server));
+            }
+
+            C.Packet packet = default;
+            int recvd = 0;
+            for (int tries = 0; tries < 2000 && recvd < 50; tries++)
+            {
+                while (recvd < 50 && API.IOThreadRecv(io, &packet))
+                {
+                    Assert.AreEqual(256, packet.len);
+                    Assert.AreEqual((byte)recvd, packet.buf.buf[0]);
+                    Assert.True(API.IOThreadRecycle(io, &packet));
+                    recvd++;
+                }
+                System.Threading.Thread.Sleep(1);
+            }
+            Assert.AreEqual(50, recvd);
+
+            for (int tries = 0; tries < 1000 && !API.IOThreadRent(io, &packet); tries++) System.Threading.Thread.Sleep(1);
+            packet.buf.buf[0] = 0x5a;
+            packet.len = 256;
+            packet.endpoint = ep_client;
+            Assert.True(API.IOThreadSend(io, &packet));
+
+            byte* mem_client = stackalloc byte[1408];
+            C.Buffer buf_client_recv = C.Buffer.New(mem_client, 1408);
+            C.Endpoint ep_client_recv = default;
+            Assert.AreEqual(256, API.SocketRecv(&sock_client, &buf_client_recv, 1, &ep_client_recv));
+            Assert.AreEqual(0x5a, mem_client[0]);
+
+            Assert.True(API.IOThreadStop(io));
+            io = null;
+            Assert.AreEqual(256u, pool.free_count);
+            Assert.True(API.BufferPoolCleanup(&pool));
+            Assert.True(API.SocketClose(&sock_server));
+            Assert.True(API.SocketClose(&sock_client));
+            Assert.True(API.Cleanup(&ctx));
+        }
+        finally
+        {
+            if (io != null) API.IOThreadStop(io);
+            API.BufferPoolCleanup(&pool);
+            API.SocketClose(&sock_server);
+            API.SocketClose(&sock_client);
+            API.Cleanup(&ctx);
+        }
+    }
 }
@@ -235,6 +235,14 @@ public unsafe class SLManagedUnit
         }
     }
 
+    [Test]
+    public void C_PacketRing_Size()
+    {
+        Assert.AreEqual(C.SL_SPSC_SIZE, sizeof(C.PacketRing));
+        if (IntPtr.Size == 8) Assert.AreEqual(48, sizeof(C.Packet));
+        Assert.AreEqual(4 * C.SL_SPSC_SIZE, sizeof(C.IOThread));
+    }
+
     [Test]
     public void C_Buffer_New()
     {
@@ -260,6 +268,7 @@ public unsafe class SLManagedUnit
     public void C_Socket_sizeof()
     {
         Assert.AreEqual(C.SL_SOCK_SIZE, sizeof(C.Socket));
+        Assert.AreEqual(C.SL_SOCK_STATS_SIZE, sizeof(C.SocketStats));
     }
 }
 
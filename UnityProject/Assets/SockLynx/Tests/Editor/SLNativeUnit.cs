@@ -272,6 +272,228 @@ namespace SL
                 API.Cleanup(&ctx);
             }
         }
+
+        [Test]
+        public void UDP_SocketBufferSize()
+        {
+            SL.C.Context ctx = default;
+            Assert.True(API.Setup(&ctx));
+
+            C.Socket sock = C.Socket.NewUDP(&ctx, C.Endpoint.NewV4(&ctx, _port));
+            C.Autotune tune = C.Autotune.New(&sock, 16 * 1024, 64 * 1024);
+            try
+            {
+                Assert.True(API.SocketOpen(&sock));
+
+                int rcvbuf = 48 * 1024, sndbuf = 0;
+                Assert.True(API.SocketBufferSize(&sock, &rcvbuf, &sndbuf));
+                Assert.GreaterOrEqual(rcvbuf, 48 * 1024);
+                Assert.Greater(sndbuf, 0);
+
+                Assert.True(API.AutotuneSetup(&tune));
+                Assert.True(C.Socket.HasFlag(&sock, C.SocketFlags.ReceiveDrops));
+                Assert.AreEqual(16 * 1024, tune.rcvbuf_request);
+                Assert.Less(tune.rcvbuf, rcvbuf);
+                Assert.AreEqual(0, API.AutotuneUpdate(&tune));
+                Assert.True(API.AutotuneCleanup(&tune));
+
+                Assert.True(API.SocketClose(&sock));
+                Assert.True(API.Cleanup(&ctx));
+            }
+            finally
+            {
+                API.AutotuneCleanup(&tune);
+                API.SocketClose(&sock);
+                API.Cleanup(&ctx);
+            }
+        }
+
+        [Test]
+        public void BufferPool_RentReturn()
+        {
+            C.BufferPool pool = C.BufferPool.New(64);
+            C.BufferCache cache = default;
+            try
+            {
+                Assert.True(API.BufferPoolSetup(&pool));
+                Assert.AreEqual(1536, pool.slotsize);
+                Assert.True(API.BufferCacheInit(&cache, &pool));
+
+                C.Buffer* buffers = stackalloc C.Buffer[64];
+                for (int i = 0; i < 64; i++)
+                {
+                    Assert.True(API.BufferRent(&cache, &buffers[i]));
+                    Assert.AreEqual(0, (long)buffers[i].buf % 64);
+                    buffers[i].buf[0] = (byte)i;
+                }
+                C.Buffer extra = default;
+                Assert.False(API.BufferRent(&cache, &extra));
+
+                for (int i = 0; i < 64; i++)
+                {
+                    Assert.AreEqual((byte)i, buffers[i].buf[0]);
+                    Assert.True(API.BufferReturn(&cache, &buffers[i]));
+                }
+
+                byte* foreign = stackalloc byte[16];
+                C.Buffer stranger = C.Buffer.New(foreign, 16);
+                Assert.False(API.BufferReturn(&cache, &stranger));
+
+                Assert.True(API.BufferCacheFlush(&cache));
+                Assert.AreEqual(64u, pool.free_count);
+                Assert.True(API.BufferPoolCleanup(&pool));
+            }
+            finally
+            {
+                API.BufferPoolCleanup(&pool);
+            }
+        }
+
+        [Test]
+        public void PeerTable_InsertFind()
+        {
+            SL.C.Context ctx = default;
+            Assert.True(API.Setup(&ctx));
+
+            C.PeerTable table = C.PeerTable.New(1024, 16);
+            try
+            {
+                Assert.True(API.PeerTableSetup(&table));
+                Assert.AreEqual(64u, table.slotsize);
+
+                C.Endpoint* endpoints = stackalloc C.Endpoint[1024];
+                uint* handles = stackalloc uint[1024];
+                for (int i = 0; i < 1024; i++)
+                {
+                    endpoints[i] = C.Endpoint.NewV4(&ctx, 1000 + i, C.IPv4.New(10, 0, (byte)(i >> 8), (byte)i));
+                    Assert.True(API.PeerInsert(&table, &endpoints[i], &handles[i]));
+                    *(int*)API.PeerSlot(&table, handles[i]) = i;
+                }
+                uint handle;
+                C.Endpoint stranger = C.Endpoint.NewV4(&ctx, _port, C.IPv4.New(192, 0, 2, 1));
+                Assert.False(API.PeerInsert(&table, &stranger, &handle));
+                Assert.AreEqual(C.SL_PEERTABLE_HANDLE_NONE, API.PeerFind(&table, &stranger));
+
+                for (int i = 0; i < 1024; i++)
+                {
+                    Assert.AreEqual(handles[i], API.PeerFind(&table, &endpoints[i]));
+                    Assert.AreEqual(i, *(int*)API.PeerSlot(&table, handles[i]));
+                }
+
+                Assert.True(API.PeerRemove(&table, handles[3]));
+                Assert.False(API.PeerRemove(&table, handles[3]));
+                Assert.True(API.PeerSlot(&table, handles[3]) == null);
+
+                C.Message* msgs = stackalloc C.Message[4];
+                uint* found = stackalloc uint[4];
+                for (int i = 0; i < 4; i++)
+                {
+                    msgs[i] = default;
+                    msgs[i].endpoint = &endpoints[i + 1];
+                }
+                Assert.AreEqual(3, API.PeerFindBatch(&table, msgs, 4, found));
+                Assert.AreEqual(handles[2], found[1]);
+                Assert.AreEqual(C.SL_PEERTABLE_HANDLE_NONE, found[2]);
+
+                Assert.True(API.PeerTableCleanup(&table));
+                Assert.True(API.Cleanup(&ctx));
+            }
+            finally
+            {
+                API.PeerTableCleanup(&table);
+                API.Cleanup(&ctx);
+            }
+        }
+
+        [Test]
+        public void TimerWheel_ScheduleExpire()
+        {
+            SL.C.Context ctx = default;
+            Assert.True(API.Setup(&ctx));
+
+            C.TimerWheel wheel = C.TimerWheel.New();
+            C.Poller poller = C.Poller.New(1);
+            try
+            {
+                Assert.True(API.TimerWheelSetup(&wheel));
+                Assert.True(API.PollerSetup(&poller));
+
+                C.Timer* timers = stackalloc C.Timer[3];
+                for (int i = 0; i < 3; i++)
+                {
+                    timers[i] = default;
+                    timers[i].data = (ulong)i;
+                }
+                Assert.True(API.TimerSchedule(&wheel, &timers[0], 20));
+                Assert.True(API.TimerSchedule(&wheel, &timers[1], 60000));
+                Assert.True(API.TimerSchedule(&wheel, &timers[2], 5));
+                Assert.True(API.TimerCancel(&wheel, &timers[2]));
+                Assert.False(timers[2].Pending);
+                Assert.AreEqual(2ul, wheel.count);
+
+                /* the wait ends at the 20ms timer, well short of the cap */
+                C.PollEvent* events = stackalloc C.PollEvent[1];
+                C.Timer** expired = stackalloc C.Timer*[4];
+                var watch = System.Diagnostics.Stopwatch.StartNew();
+                int fired = 0;
+                while (fired == 0 && watch.ElapsedMilliseconds < 2000)
+                {
+                    Assert.AreEqual(0, API.TimerPoll(&wheel, &poller, events, 1, 5000));
+                    fired = API.TimerAdvance(&wheel, expired, 4);
+                }
+                Assert.AreEqual(1, fired);
+                Assert.True(expired[0] == &timers[0]);
+                Assert.GreaterOrEqual(watch.ElapsedMilliseconds, 19);
+                Assert.Less(watch.ElapsedMilliseconds, 2000);
+                Assert.True(timers[1].Pending);
+
+                Assert.True(API.PollerCleanup(&poller));
+                Assert.True(API.TimerWheelCleanup(&wheel));
+                Assert.False(timers[1].Pending);
+                Assert.True(API.Cleanup(&ctx));
+            }
+            finally
+            {
+                API.PollerCleanup(&poller);
+                API.TimerWheelCleanup(&wheel);
+                API.Cleanup(&ctx);
+            }
+        }
+#if UNITY_2021_2_OR_NEWER || !UNITY_5_3_OR_NEWER
+
+        [Test]
+        public void Api_Table()
+        {
+            C.Api* api = API.GetApi();
+            Assert.True(api != null);
+            Assert.AreEqual(C.SL_API_VERSION, api->version);
+            Assert.AreEqual((uint)sizeof(C.Api), api->size);
+            Assert.True(API.GetApi(C.SL_API_VERSION + 1) == null);
+            Assert.True(API.GetApi(0) == null);
+
+            /* the table and the DllImport stubs land in the same functions */
+            SL.C.Context ctx = default;
+            C.PeerTable table = C.PeerTable.New(16);
+            try
+            {
+                Assert.AreEqual(C.SL_OK, api->setup(&ctx));
+                Assert.AreEqual(C.SL_OK, api->peertable_setup(&table));
+                C.Endpoint endpoint = C.Endpoint.NewV4(&ctx, _port, C.IPv4.New(127, 0, 0, 1));
+                uint handle;
+                Assert.AreEqual(C.SL_OK, api->peertable_insert(&table, &endpoint, &handle));
+                Assert.AreEqual(handle, API.PeerFind(&table, &endpoint));
+                Assert.AreEqual(handle, api->peertable_find(&table, &endpoint));
+                Assert.AreEqual(C.SL_ERR, api->socket_stats(null, null));
+                Assert.AreEqual(C.SL_OK, api->peertable_cleanup(&table));
+                Assert.AreEqual(C.SL_OK, api->cleanup(&ctx));
+            }
+            finally
+            {
+                API.PeerTableCleanup(&table);
+                API.Cleanup(&ctx);
+            }
+        }
+#endif
     }
 }
 #pragma warning disable CS0162
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_AUTOTUNE_H
+#define SL_AUTOTUNE_H
+
+#include "socklynx/common.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_autotune_t sizes one socket's kernel buffers from what the socket is seeing. Receive
+ * queue drops double the receive buffer and send would blocks double the send buffer, each
+ * capped at its max. A buffer which has seen no pressure for SL_AUTOTUNE_QUIET_INTERVALS
+ * intervals gives back a quarter, down to its min. Call sl_autotune_update from the thread
+ * driving the socket, it does nothing until interval_ms has passed since the last look.
+ * Drops come from SO_RXQ_OVFL, which setup turns on. Would blocks come from the socket
+ * stats, so with SL_SOCK_STATS off the send buffer stays at sndbuf_min.
+ */
+
+#define SL_AUTOTUNE_BUF_MIN_DEFAULT (256 * 1024)
+#define SL_AUTOTUNE_BUF_MAX_DEFAULT (16 * 1024 * 1024)
+#define SL_AUTOTUNE_INTERVAL_MS_DEFAULT 250
+#define SL_AUTOTUNE_QUIET_INTERVALS 40
+
+typedef enum sl_autotune_state_e {
+    SL_AUTOTUNE_STATE_NEW,
+    SL_AUTOTUNE_STATE_STARTED,
+    SL_AUTOTUNE_STATE_STOPPED,
+} sl_autotune_state_t;
+
+/*
+ * set sock, and optionally the bounds and interval, before sl_autotune_setup. bounds are
+ * requested sizes, rcvbuf and sndbuf are the effective sizes the kernel reports back
+ */
+typedef struct sl_autotune_s {
+    sl_sock_t *sock;
+    int32_t rcvbuf_min;
+    int32_t rcvbuf_max;
+    int32_t sndbuf_min;
+    int32_t sndbuf_max;
+    uint32_t interval_ms;
+    uint32_t state;
+    uint32_t error;
+    int32_t rcvbuf;
+    int32_t sndbuf;
+    int32_t rcvbuf_request;
+    int32_t sndbuf_request;
+    uint32_t rcvbuf_quiet;
+    uint32_t sndbuf_quiet;
+    uint32_t adjustments;
+    uint64_t last_ns;
+    uint64_t rx_dropped;
+    uint64_t tx_wouldblock;
+} sl_autotune_t;
+
+/* next requested size given whether the last interval saw pressure */
+SL_INLINE_IMPL int32_t sl_autotune_next(int32_t size, bool pressure, uint32_t *quiet, int32_t min, int32_t max)
+{
+    if (pressure) {
+        *quiet = 0;
+        return ((int64_t)size * 2 > max) ? max : size * 2;
+    }
+    if (++*quiet < SL_AUTOTUNE_QUIET_INTERVALS || size <= min) return size;
+
+    *quiet = 0;
+    return (size - size / 4 < min) ? min : size - size / 4;
+}
+
+SL_INLINE_IMPL int sl_autotune_apply(sl_autotune_t *tune)
+{
+    sl_sock_t *sock = tune->sock;
+
+    if (sl_sock_rcvbuf_set(sock, tune->rcvbuf_request) || sl_sock_sndbuf_set(sock, tune->sndbuf_request) ||
+        sl_sock_rcvbuf_get(sock, &tune->rcvbuf) || sl_sock_sndbuf_get(sock, &tune->sndbuf)) {
+        tune->error = sock->error;
+        return SL_ERR;
+    }
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_autotune_setup(sl_autotune_t *tune)
+{
+    SL_ASSERT(tune);
+    SL_ASSERT(tune->state != SL_AUTOTUNE_STATE_STARTED);
+    SL_GUARD_NULL(tune->sock);
+
+    if (tune->rcvbuf_min <= 0) tune->rcvbuf_min = SL_AUTOTUNE_BUF_MIN_DEFAULT;
+    if (tune->rcvbuf_max <= 0) tune->rcvbuf_max = SL_AUTOTUNE_BUF_MAX_DEFAULT;
+    if (tune->sndbuf_min <= 0) tune->sndbuf_min = SL_AUTOTUNE_BUF_MIN_DEFAULT;
+    if (tune->sndbuf_max <= 0) tune->sndbuf_max = SL_AUTOTUNE_BUF_MAX_DEFAULT;
+    if (!tune->interval_ms) tune->interval_ms = SL_AUTOTUNE_INTERVAL_MS_DEFAULT;
+    if (tune->rcvbuf_min > tune->rcvbuf_max || tune->sndbuf_min > tune->sndbuf_max) {
+        tune->error = EINVAL;
+        return SL_ERR;
+    }
+
+    if (!(tune->sock->flags & SL_SOCK_FLAG_RXQ_OVFL) && sl_sock_rxq_ovfl_enable(tune->sock)) {
+        tune->error = tune->sock->error;
+        return SL_ERR;
+    }
+
+    tune->rcvbuf_request = tune->rcvbuf_min;
+    tune->sndbuf_request = tune->sndbuf_min;
+    SL_GUARD(sl_autotune_apply(tune));
+
+    tune->rcvbuf_quiet = 0;
+    tune->sndbuf_quiet = 0;
+    tune->adjustments = 0;
+    tune->last_ns = sl_sys_time_ns();
+    tune->rx_dropped = tune->sock->stats.rx_dropped;
+    tune->tx_wouldblock = tune->sock->stats.tx_wouldblock;
+    tune->error = 0;
+    tune->state = SL_AUTOTUNE_STATE_STARTED;
+
+    return SL_OK;
+}
+
+/* leaves the buffers at their last size */
+SL_INLINE_IMPL int sl_autotune_cleanup(sl_autotune_t *tune)
+{
+    SL_ASSERT(tune);
+    if (tune->state != SL_AUTOTUNE_STATE_STARTED) return SL_OK;
+    tune->state = SL_AUTOTUNE_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+/* returns 1 when the buffers were resized, 0 when left alone */
+SL_INLINE_IMPL int sl_autotune_update(sl_autotune_t *tune, uint64_t now_ns)
+{
+    SL_ASSERT(tune && tune->state == SL_AUTOTUNE_STATE_STARTED);
+
+    if (now_ns - tune->last_ns < (uint64_t)tune->interval_ms * 1000000ULL) return 0;
+    tune->last_ns = now_ns;
+
+    const sl_sock_stats_t *stats = &tune->sock->stats;
+    const bool dropped = (stats->rx_dropped != tune->rx_dropped);
+    const bool wouldblock = (stats->tx_wouldblock != tune->tx_wouldblock);
+    tune->rx_dropped = stats->rx_dropped;
+    tune->tx_wouldblock = stats->tx_wouldblock;
+
+    const int32_t rcvbuf = sl_autotune_next(tune->rcvbuf_request, dropped, &tune->rcvbuf_quiet, tune->rcvbuf_min, tune->rcvbuf_max);
+    const int32_t sndbuf = sl_autotune_next(tune->sndbuf_request, wouldblock, &tune->sndbuf_quiet, tune->sndbuf_min, tune->sndbuf_max);
+    if (rcvbuf == tune->rcvbuf_request && sndbuf == tune->sndbuf_request) return 0;
+
+    tune->rcvbuf_request = rcvbuf;
+    tune->sndbuf_request = sndbuf;
+    SL_GUARD(sl_autotune_apply(tune));
+    tune->adjustments++;
+
+    return 1;
+}
+
+#endif
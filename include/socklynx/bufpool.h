@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_BUFPOOL_H
+#define SL_BUFPOOL_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/error.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_bufpool_t is one cache line aligned slab of fixed size slots, every slot a cache line
+ * multiple so no two slots share a line. Free slots are an index stack behind a spinlock.
+ * Each thread should front the pool with its own sl_bufcache_t, which moves slots to and from
+ * the shared stack half a cache at a time, so the lock is only touched once per many packets.
+ * Slots are handed out as sl_buf_t with len set to the slot size.
+ */
+
+#define SL_BUFPOOL_SLOT_SIZE_DEFAULT 1500
+#define SL_BUFCACHE_SIZE 32
+
+typedef enum sl_bufpool_state_e {
+    SL_BUFPOOL_STATE_NEW,
+    SL_BUFPOOL_STATE_STARTED,
+    SL_BUFPOOL_STATE_STOPPED,
+} sl_bufpool_state_t;
+
+/* set slotcount, and optionally slotsize, before sl_bufpool_setup */
+typedef struct sl_bufpool_s {
+    uint32_t slotsize;
+    uint32_t slotcount;
+    uint32_t state;
+    uint32_t error;
+    char *arena;
+    uint32_t *free;
+    uint32_t free_count;
+    volatile uint32_t lock;
+} sl_bufpool_t;
+
+/* owned by a single thread, holds slot indices taken from or headed back to the pool */
+typedef struct sl_bufcache_s {
+    sl_bufpool_t *pool;
+    uint32_t count;
+    uint32_t slots[SL_BUFCACHE_SIZE];
+} sl_bufcache_t;
+
+SL_INLINE_IMPL void sl_bufpool_lock(sl_bufpool_t *pool)
+{
+    while (!sl_sys_atomic_cas32(&pool->lock, 0, 1)) {
+        while (sl_sys_atomic_load32(&pool->lock)) sl_sys_cpu_relax();
+    }
+}
+
+SL_INLINE_IMPL void sl_bufpool_unlock(sl_bufpool_t *pool)
+{
+    sl_sys_atomic_store32(&pool->lock, 0);
+}
+
+SL_INLINE_IMPL int sl_bufpool_cleanup(sl_bufpool_t *pool)
+{
+    SL_ASSERT(pool);
+    if (pool->state != SL_BUFPOOL_STATE_STARTED) return SL_OK;
+
+    sl_sys_aligned_free(pool->arena);
+    free(pool->free);
+    pool->arena = NULL;
+    pool->free = NULL;
+    pool->free_count = 0;
+    pool->state = SL_BUFPOOL_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_bufpool_setup(sl_bufpool_t *pool)
+{
+    SL_ASSERT(pool);
+    SL_ASSERT(pool->state != SL_BUFPOOL_STATE_STARTED);
+    SL_GUARD(!pool->slotcount);
+
+    if (!pool->slotsize) pool->slotsize = SL_BUFPOOL_SLOT_SIZE_DEFAULT;
+    pool->slotsize = (pool->slotsize + SL_SYS_CACHELINE - 1) & ~(uint32_t)(SL_SYS_CACHELINE - 1);
+
+    pool->arena = (char *)sl_sys_aligned_alloc((size_t)pool->slotsize * pool->slotcount, SL_SYS_CACHELINE);
+    pool->free = (uint32_t *)malloc(pool->slotcount * sizeof(*pool->free));
+    if (!pool->arena || !pool->free) {
+        sl_sys_aligned_free(pool->arena);
+        free(pool->free);
+        pool->arena = NULL;
+        pool->free = NULL;
+        pool->error = ENOMEM;
+        return SL_ERR;
+    }
+
+    /* lowest slots on top so a lightly used pool stays in the fewest pages */
+    for (uint32_t i = 0; i < pool->slotcount; i++) {
+        pool->free[i] = pool->slotcount - 1 - i;
+    }
+    pool->free_count = pool->slotcount;
+    pool->lock = 0;
+    pool->error = 0;
+    pool->state = SL_BUFPOOL_STATE_STARTED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_bufpool_slot_buf(sl_bufpool_t *pool, uint32_t slot, sl_buf_t *buf)
+{
+    buf->base = pool->arena + (size_t)slot * pool->slotsize;
+    buf->len = pool->slotsize;
+}
+
+SL_INLINE_IMPL uint32_t sl_bufpool_buf_slot(sl_bufpool_t *pool, sl_buf_t *buf)
+{
+    SL_ASSERT(buf->base >= pool->arena && buf->base < pool->arena + (size_t)pool->slotsize * pool->slotcount);
+    SL_ASSERT(!((size_t)(buf->base - pool->arena) % pool->slotsize));
+    return (uint32_t)((size_t)(buf->base - pool->arena) / pool->slotsize);
+}
+
+/* moves up to count slot indices off the shared stack, returns how many were taken */
+SL_INLINE_IMPL uint32_t sl_bufpool_take(sl_bufpool_t *pool, uint32_t *slots, uint32_t count)
+{
+    sl_bufpool_lock(pool);
+    if (count > pool->free_count) count = pool->free_count;
+    pool->free_count -= count;
+    memcpy(slots, pool->free + pool->free_count, count * sizeof(*slots));
+    sl_bufpool_unlock(pool);
+
+    return count;
+}
+
+SL_INLINE_IMPL void sl_bufpool_give(sl_bufpool_t *pool, uint32_t *slots, uint32_t count)
+{
+    sl_bufpool_lock(pool);
+    SL_ASSERT(pool->free_count + count <= pool->slotcount);
+    memcpy(pool->free + pool->free_count, slots, count * sizeof(*slots));
+    pool->free_count += count;
+    sl_bufpool_unlock(pool);
+}
+
+/* uncached acquire straight from the shared stack, prefer a sl_bufcache_t on hot paths */
+SL_INLINE_IMPL int sl_bufpool_acquire(sl_bufpool_t *pool, sl_buf_t *buf)
+{
+    SL_ASSERT(pool && pool->state == SL_BUFPOOL_STATE_STARTED);
+    SL_ASSERT(buf);
+
+    uint32_t slot;
+    SL_GUARD(!sl_bufpool_take(pool, &slot, 1));
+    sl_bufpool_slot_buf(pool, slot, buf);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_bufpool_release(sl_bufpool_t *pool, sl_buf_t *buf)
+{
+    SL_ASSERT(pool && pool->state == SL_BUFPOOL_STATE_STARTED);
+    SL_ASSERT(buf);
+
+    uint32_t slot = sl_bufpool_buf_slot(pool, buf);
+    sl_bufpool_give(pool, &slot, 1);
+}
+
+SL_INLINE_IMPL void sl_bufcache_init(sl_bufcache_t *cache, sl_bufpool_t *pool)
+{
+    SL_ASSERT(cache && pool);
+    cache->pool = pool;
+    cache->count = 0;
+}
+
+/* hands every cached slot back to the pool, call before the owning thread exits */
+SL_INLINE_IMPL void sl_bufcache_flush(sl_bufcache_t *cache)
+{
+    SL_ASSERT(cache && cache->pool);
+    if (!cache->count) return;
+    sl_bufpool_give(cache->pool, cache->slots, cache->count);
+    cache->count = 0;
+}
+
+SL_INLINE_IMPL int sl_bufcache_acquire(sl_bufcache_t *cache, sl_buf_t *buf)
+{
+    SL_ASSERT(cache && cache->pool);
+    SL_ASSERT(buf);
+
+    if (!cache->count) {
+        cache->count = sl_bufpool_take(cache->pool, cache->slots, SL_BUFCACHE_SIZE / 2);
+        SL_GUARD(!cache->count);
+    }
+    sl_bufpool_slot_buf(cache->pool, cache->slots[--cache->count], buf);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_bufcache_release(sl_bufcache_t *cache, sl_buf_t *buf)
+{
+    SL_ASSERT(cache && cache->pool);
+    SL_ASSERT(buf);
+
+    /* spill the older half so the most recently used, still warm slots stay local */
+    if (cache->count == SL_BUFCACHE_SIZE) {
+        sl_bufpool_give(cache->pool, cache->slots, SL_BUFCACHE_SIZE / 2);
+        memmove(cache->slots, cache->slots + SL_BUFCACHE_SIZE / 2, (SL_BUFCACHE_SIZE / 2) * sizeof(*cache->slots));
+        cache->count = SL_BUFCACHE_SIZE / 2;
+    }
+    cache->slots[cache->count++] = sl_bufpool_buf_slot(cache->pool, buf);
+}
+
+#endif
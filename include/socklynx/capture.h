@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_CAPTURE_H
+#define SL_CAPTURE_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_capture_t taps a socket's datagrams into a memory mapped pcap file which wireshark and
+ * tcpdump read as is, and which sl_capture_reader_t and socklynx_loadgen -m replay play back.
+ * Attach it with sl_sock_capture_set, one capture may serve any number of sockets on any number
+ * of threads. Each datagram costs an atomic add to claim its room and one copy into the mapping,
+ * the kernel writes the pages back on its own time. Datagrams are written as they cross the
+ * kernel boundary, below any sl_impair_t, with IP and UDP headers made up from the socket's
+ * bound address and the peer. A connected socket's peer is not known and is written as the
+ * unspecified address, and the UDP checksum is left 0. Once the file is full further datagrams
+ * are counted in dropped, sl_capture_cleanup cuts the file down to what was written.
+ *
+ * sl_capture_reader_t maps a pcap or pcapng file read only and walks the UDP datagrams in it,
+ * over ethernet, linux cooked, loopback or raw IP links. Fragments and anything that is not
+ * UDP are skipped, payloads point into the mapping and are never copied.
+ */
+
+#define SL_CAPTURE_SIZE_DEFAULT (64 * 1024 * 1024)
+#define SL_CAPTURE_SNAPLEN 262144
+#define SL_CAPTURE_IFACES_MAX 16
+
+#define SL_CAPTURE_PCAP_MAGIC_US 0xa1b2c3d4
+#define SL_CAPTURE_PCAP_MAGIC_NS 0xa1b23c4d
+#define SL_CAPTURE_PCAPNG_SHB 0x0a0d0d0a
+#define SL_CAPTURE_PCAPNG_IDB 1
+#define SL_CAPTURE_PCAPNG_SPB 3
+#define SL_CAPTURE_PCAPNG_EPB 6
+#define SL_CAPTURE_PCAPNG_BOM 0x1a2b3c4d
+#define SL_CAPTURE_PCAPNG_TSRESOL 9
+
+#define SL_CAPTURE_LINKTYPE_NULL 0
+#define SL_CAPTURE_LINKTYPE_ETHERNET 1
+#define SL_CAPTURE_LINKTYPE_RAW 101
+#define SL_CAPTURE_LINKTYPE_LOOP 108
+#define SL_CAPTURE_LINKTYPE_LINUX_SLL 113
+#define SL_CAPTURE_LINKTYPE_IPV4 228
+#define SL_CAPTURE_LINKTYPE_IPV6 229
+#define SL_CAPTURE_LINKTYPE_LINUX_SLL2 276
+
+#define SL_CAPTURE_IP4_HEADER 20
+#define SL_CAPTURE_IP6_HEADER 40
+#define SL_CAPTURE_UDP_HEADER 8
+
+typedef enum sl_capture_state_e {
+    SL_CAPTURE_STATE_NEW,
+    SL_CAPTURE_STATE_STARTED,
+    SL_CAPTURE_STATE_STOPPED,
+} sl_capture_state_t;
+
+typedef struct sl_capture_file_header_s {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+} sl_capture_file_header_t;
+
+typedef struct sl_capture_record_header_s {
+    uint32_t ts_sec;
+    uint32_t ts_frac;
+    uint32_t caplen;
+    uint32_t len;
+} sl_capture_record_header_t;
+
+/* set size before sl_capture_setup, it is the most the file will hold */
+typedef struct sl_capture_s {
+    uint64_t size;
+    uint32_t state;
+    uint32_t error;
+    volatile uint64_t offset; /* next free byte, runs past size once the file is full */
+    volatile uint64_t limit;  /* start of the first record which did not fit */
+    volatile uint64_t dropped;
+    sl_sys_map_t map;
+} sl_capture_t;
+
+/* one UDP datagram from a capture, payload points into the mapping */
+typedef struct sl_capture_packet_s {
+    const char *payload;
+    int32_t len;     /* bytes captured, short of wirelen when the capture was cut at its snaplen */
+    int32_t wirelen; /* payload bytes the datagram carried */
+    uint64_t timestamp_ns;
+    sl_endpoint_t src;
+    sl_endpoint_t dst;
+} sl_capture_packet_t;
+
+typedef struct sl_capture_iface_s {
+    uint32_t linktype;
+    uint32_t tsresol; /* pcapng if_tsresol, power of 10 or with the top bit set power of 2 */
+} sl_capture_iface_t;
+
+typedef struct sl_capture_reader_s {
+    uint32_t state;
+    uint32_t error;
+    sl_sys_map_t map;
+    size_t start;
+    size_t offset;
+    uint64_t timestamp_ns; /* last seen, simple packet blocks carry none of their own */
+    uint64_t skipped;
+    bool pcapng;
+    bool swapped;
+    uint32_t iface_count;
+    sl_capture_iface_t ifaces[SL_CAPTURE_IFACES_MAX];
+} sl_capture_reader_t;
+
+SL_INLINE_IMPL uint16_t sl_capture_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+SL_INLINE_IMPL uint16_t sl_capture_swap16(uint16_t v, bool swapped)
+{
+    return swapped ? (uint16_t)((v >> 8) | (v << 8)) : v;
+}
+
+SL_INLINE_IMPL uint32_t sl_capture_swap32(uint32_t v, bool swapped)
+{
+    return swapped ? ((v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24)) : v;
+}
+
+SL_INLINE_IMPL uint32_t sl_capture_read32(sl_capture_reader_t *reader, size_t offset)
+{
+    uint32_t v;
+    memcpy(&v, reader->map.base + offset, sizeof(v));
+    return sl_capture_swap32(v, reader->swapped);
+}
+
+SL_INLINE_IMPL uint16_t sl_capture_read16(sl_capture_reader_t *reader, size_t offset)
+{
+    uint16_t v;
+    memcpy(&v, reader->map.base + offset, sizeof(v));
+    return sl_capture_swap16(v, reader->swapped);
+}
+
+SL_INLINE_IMPL int sl_capture_cleanup(sl_capture_t *capture)
+{
+    SL_ASSERT(capture);
+    if (capture->state != SL_CAPTURE_STATE_STARTED) return SL_OK;
+
+    uint64_t len = capture->offset;
+    if (capture->limit < len) len = capture->limit;
+    if (len > capture->size) len = capture->size;
+    capture->state = SL_CAPTURE_STATE_STOPPED;
+    if (sl_sys_map_close(&capture->map, (size_t)len)) {
+        capture->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_capture_setup(sl_capture_t *capture, const char *path)
+{
+    SL_ASSERT(capture && path);
+    SL_ASSERT(capture->state != SL_CAPTURE_STATE_STARTED);
+
+    if (!capture->size) capture->size = SL_CAPTURE_SIZE_DEFAULT;
+    if (capture->size < sizeof(sl_capture_file_header_t)) {
+        capture->error = EINVAL;
+        return SL_ERR;
+    }
+    if (sl_sys_map_open(&capture->map, path, (size_t)capture->size, true)) {
+        capture->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+
+    /* raw IP with nanosecond timestamps, in host byte order as the magic tells readers */
+    sl_capture_file_header_t header;
+    header.magic = SL_CAPTURE_PCAP_MAGIC_NS;
+    header.version_major = 2;
+    header.version_minor = 4;
+    header.thiszone = 0;
+    header.sigfigs = 0;
+    header.snaplen = SL_CAPTURE_SNAPLEN;
+    header.linktype = SL_CAPTURE_LINKTYPE_RAW;
+    memcpy(capture->map.base, &header, sizeof(header));
+
+    capture->offset = sizeof(header);
+    capture->limit = UINT64_MAX;
+    capture->dropped = 0;
+    capture->error = 0;
+    capture->state = SL_CAPTURE_STATE_STARTED;
+
+    return SL_OK;
+}
+
+/* writes the IP and UDP headers for a datagram of len bytes from src to dst, returns their size */
+SL_INLINE_IMPL size_t sl_capture_headers(char *dst, sl_endpoint_t *from, sl_endpoint_t *to, size_t len)
+{
+    uint8_t *p = (uint8_t *)dst;
+    size_t ip_len;
+
+    if (sl_endpoint_is_ipv6(from)) {
+        ip_len = SL_CAPTURE_IP6_HEADER;
+        const uint16_t payload = (uint16_t)(SL_CAPTURE_UDP_HEADER + len);
+        memset(p, 0, SL_CAPTURE_IP6_HEADER);
+        p[0] = 0x60;
+        p[4] = (uint8_t)(payload >> 8);
+        p[5] = (uint8_t)payload;
+        p[6] = IPPROTO_UDP;
+        p[7] = 64;
+        memcpy(p + 8, from->addr6.addr, 16);
+        memcpy(p + 24, to->addr6.addr, 16);
+    } else {
+        ip_len = SL_CAPTURE_IP4_HEADER;
+        const uint16_t total = (uint16_t)(SL_CAPTURE_IP4_HEADER + SL_CAPTURE_UDP_HEADER + len);
+        memset(p, 0, SL_CAPTURE_IP4_HEADER);
+        p[0] = 0x45;
+        p[2] = (uint8_t)(total >> 8);
+        p[3] = (uint8_t)total;
+        p[6] = 0x40; /* don't fragment */
+        p[8] = 64;
+        p[9] = IPPROTO_UDP;
+        memcpy(p + 12, &from->addr4.addr, 4);
+        memcpy(p + 16, &to->addr4.addr, 4);
+        uint32_t sum = 0;
+        for (int i = 0; i < SL_CAPTURE_IP4_HEADER; i += 2) sum += sl_capture_be16(p + i);
+        while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+        p[10] = (uint8_t)(~sum >> 8);
+        p[11] = (uint8_t)~sum;
+    }
+
+    /* ports are already in network order in the endpoint */
+    uint8_t *udp = p + ip_len;
+    const uint16_t udp_len = (uint16_t)(SL_CAPTURE_UDP_HEADER + len);
+    memcpy(udp, &from->addr4.port, 2);
+    memcpy(udp + 2, &to->addr4.port, 2);
+    udp[4] = (uint8_t)(udp_len >> 8);
+    udp[5] = (uint8_t)udp_len;
+    udp[6] = 0;
+    udp[7] = 0;
+
+    return ip_len + SL_CAPTURE_UDP_HEADER;
+}
+
+/*
+ * writes len bytes gathered from buf as one record, or as a record per segsize bytes for a
+ * segmentation offload send or a coalesced receive. peer NULL is the connected peer, and a
+ * timestamp_ns of 0 is now on the sl_sys_time_real_ns clock
+ */
+SL_INLINE_IMPL void sl_capture_write(sl_capture_t *capture, sl_sock_t *sock, bool incoming, sl_buf_t *buf, int32_t bufcount, size_t len, size_t segsize, sl_endpoint_t *peer, uint64_t timestamp_ns)
+{
+    SL_ASSERT(capture && capture->state == SL_CAPTURE_STATE_STARTED);
+    SL_ASSERT(sock && buf);
+
+    sl_endpoint_t unspecified;
+    if (!peer) {
+        memset(&unspecified, 0, sizeof(unspecified));
+        unspecified.addr4.af = sock->endpoint.addr4.af;
+        peer = &unspecified;
+    }
+    sl_endpoint_t *from = incoming ? peer : &sock->endpoint;
+    sl_endpoint_t *to = incoming ? &sock->endpoint : peer;
+    const size_t headers = sl_endpoint_is_ipv6(from) ? SL_CAPTURE_IP6_HEADER + SL_CAPTURE_UDP_HEADER : SL_CAPTURE_IP4_HEADER + SL_CAPTURE_UDP_HEADER;
+    if (!timestamp_ns) timestamp_ns = sl_sys_time_real_ns();
+    if (!segsize || segsize > len) segsize = len;
+
+    int32_t index = 0;
+    size_t consumed = 0, remaining = len;
+    do {
+        const size_t seglen = remaining < segsize ? remaining : segsize;
+        const uint64_t need = sizeof(sl_capture_record_header_t) + headers + seglen;
+        const uint64_t start = sl_sys_atomic_add64(&capture->offset, need);
+        if (start + need > capture->size) {
+            /* every later claim starts further on, so the lowest failed start ends the file */
+            uint64_t limit = capture->limit;
+            while (start < limit && !sl_sys_atomic_cas64(&capture->limit, limit, start)) limit = capture->limit;
+            sl_sys_atomic_add64(&capture->dropped, 1);
+            return;
+        }
+
+        char *dst = capture->map.base + start;
+        sl_capture_record_header_t record;
+        record.ts_sec = (uint32_t)(timestamp_ns / 1000000000ULL);
+        record.ts_frac = (uint32_t)(timestamp_ns % 1000000000ULL);
+        record.caplen = (uint32_t)(headers + seglen);
+        record.len = record.caplen;
+        memcpy(dst, &record, sizeof(record));
+        dst += sizeof(record);
+        dst += sl_capture_headers(dst, from, to, seglen);
+
+        for (size_t copied = 0; copied < seglen;) {
+            size_t chunk = (size_t)buf[index].len - consumed;
+            if (chunk > seglen - copied) chunk = seglen - copied;
+            memcpy(dst + copied, buf[index].base + consumed, chunk);
+            copied += chunk;
+            consumed += chunk;
+            if (consumed == (size_t)buf[index].len && index + 1 < bufcount) {
+                index++;
+                consumed = 0;
+            }
+        }
+        remaining -= seglen;
+    } while (remaining);
+}
+
+SL_INLINE_IMPL int sl_capture_reader_close(sl_capture_reader_t *reader)
+{
+    SL_ASSERT(reader);
+    if (reader->state != SL_CAPTURE_STATE_STARTED) return SL_OK;
+
+    sl_sys_map_close(&reader->map, reader->map.size);
+    reader->state = SL_CAPTURE_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_capture_reader_open(sl_capture_reader_t *reader, const char *path)
+{
+    SL_ASSERT(reader && path);
+    SL_ASSERT(reader->state != SL_CAPTURE_STATE_STARTED);
+
+    reader->iface_count = 0;
+    reader->skipped = 0;
+    reader->timestamp_ns = 0;
+    if (sl_sys_map_open(&reader->map, path, 0, false)) {
+        reader->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+    if (reader->map.size < sizeof(sl_capture_file_header_t)) goto invalid;
+
+    uint32_t magic;
+    memcpy(&magic, reader->map.base, sizeof(magic));
+    reader->pcapng = (magic == SL_CAPTURE_PCAPNG_SHB);
+    if (reader->pcapng) {
+        /* the section header's byte order mark decides, the block type reads the same both ways */
+        uint32_t bom;
+        memcpy(&bom, reader->map.base + 8, sizeof(bom));
+        reader->swapped = (bom != SL_CAPTURE_PCAPNG_BOM);
+        if (reader->swapped && sl_capture_swap32(bom, true) != SL_CAPTURE_PCAPNG_BOM) goto invalid;
+        reader->start = 0;
+    } else {
+        reader->swapped = (magic != SL_CAPTURE_PCAP_MAGIC_US && magic != SL_CAPTURE_PCAP_MAGIC_NS);
+        magic = sl_capture_swap32(magic, reader->swapped);
+        if (magic != SL_CAPTURE_PCAP_MAGIC_US && magic != SL_CAPTURE_PCAP_MAGIC_NS) goto invalid;
+        /* a classic file is a single interface, if_tsresol 6 or 9 says the same as its magic */
+        reader->iface_count = 1;
+        reader->ifaces[0].linktype = sl_capture_read32(reader, 20) & 0xffff;
+        reader->ifaces[0].tsresol = (magic == SL_CAPTURE_PCAP_MAGIC_NS) ? 9 : 6;
+        reader->start = sizeof(sl_capture_file_header_t);
+    }
+    reader->offset = reader->start;
+    reader->error = 0;
+    reader->state = SL_CAPTURE_STATE_STARTED;
+
+    return SL_OK;
+
+invalid:
+    sl_sys_map_close(&reader->map, reader->map.size);
+    reader->error = EINVAL;
+    return SL_ERR;
+}
+
+/* back to the first datagram, for playing a capture in a loop */
+SL_INLINE_IMPL void sl_capture_reader_rewind(sl_capture_reader_t *reader)
+{
+    SL_ASSERT(reader && reader->state == SL_CAPTURE_STATE_STARTED);
+    reader->offset = reader->start;
+    reader->timestamp_ns = 0;
+    if (reader->pcapng) reader->iface_count = 0;
+}
+
+SL_INLINE_IMPL uint64_t sl_capture_ts_ns(uint64_t ts, uint32_t tsresol)
+{
+    if (tsresol & 0x80) {
+        const uint32_t shift = tsresol & 0x7f;
+        if (shift >= 64) return 0;
+        const uint64_t whole = ts >> shift;
+        const uint64_t frac = ts & ((1ULL << shift) - 1);
+        return whole * 1000000000ULL + (uint64_t)(((double)frac * 1e9) / (double)(1ULL << shift));
+    }
+
+    uint64_t ns = ts;
+    for (uint32_t i = tsresol; i < 9; i++) ns *= 10;
+    for (uint32_t i = 9; i < tsresol; i++) ns /= 10;
+    return ns;
+}
+
+/* finds the UDP datagram in a captured frame of the given link type */
+SL_INLINE_IMPL int sl_capture_udp_parse(uint32_t linktype, const uint8_t *p, size_t caplen, sl_capture_packet_t *packet)
+{
+    uint32_t version = 0;
+
+    switch (linktype) {
+    case SL_CAPTURE_LINKTYPE_ETHERNET: {
+        size_t at = 12;
+        uint16_t ethertype;
+        for (;;) {
+            if (caplen < at + 2) return SL_ERR;
+            ethertype = sl_capture_be16(p + at);
+            /* step over 802.1Q and 802.1ad tags */
+            if (ethertype != 0x8100 && ethertype != 0x88a8) break;
+            at += 4;
+        }
+        p += at + 2;
+        caplen -= at + 2;
+        if (ethertype == 0x0800) version = 4;
+        if (ethertype == 0x86dd) version = 6;
+        break;
+    }
+    case SL_CAPTURE_LINKTYPE_LINUX_SLL:
+    case SL_CAPTURE_LINKTYPE_LINUX_SLL2: {
+        const size_t header = (linktype == SL_CAPTURE_LINKTYPE_LINUX_SLL) ? 16 : 20;
+        if (caplen < header) return SL_ERR;
+        const uint16_t protocol = sl_capture_be16(p + ((linktype == SL_CAPTURE_LINKTYPE_LINUX_SLL) ? 14 : 0));
+        p += header;
+        caplen -= header;
+        if (protocol == 0x0800) version = 4;
+        if (protocol == 0x86dd) version = 6;
+        break;
+    }
+    case SL_CAPTURE_LINKTYPE_NULL:
+    case SL_CAPTURE_LINKTYPE_LOOP:
+        /* the 4 byte family is in the capturing host's order, the version nibble is simpler */
+        if (caplen < 4) return SL_ERR;
+        p += 4;
+        caplen -= 4;
+        /* fall through */
+    case SL_CAPTURE_LINKTYPE_RAW:
+    case SL_CAPTURE_LINKTYPE_IPV4:
+    case SL_CAPTURE_LINKTYPE_IPV6:
+        if (!caplen) return SL_ERR;
+        version = p[0] >> 4;
+        break;
+    default:
+        return SL_ERR;
+    }
+
+    memset(&packet->src, 0, sizeof(packet->src));
+    memset(&packet->dst, 0, sizeof(packet->dst));
+    if (version == 4) {
+        if (caplen < SL_CAPTURE_IP4_HEADER || (p[0] >> 4) != 4) return SL_ERR;
+        const size_t ihl = (size_t)(p[0] & 0x0f) * 4;
+        /* more fragments or a fragment offset, either way not a whole datagram */
+        if (ihl < SL_CAPTURE_IP4_HEADER || caplen < ihl || p[9] != IPPROTO_UDP || (sl_capture_be16(p + 6) & 0x3fff)) return SL_ERR;
+        sl_endpoint_af_set(&packet->src, SL_SOCK_AF_IPV4);
+        sl_endpoint_af_set(&packet->dst, SL_SOCK_AF_IPV4);
+        memcpy(&packet->src.addr4.addr, p + 12, 4);
+        memcpy(&packet->dst.addr4.addr, p + 16, 4);
+        p += ihl;
+        caplen -= ihl;
+    } else if (version == 6) {
+        if (caplen < SL_CAPTURE_IP6_HEADER || (p[0] >> 4) != 6) return SL_ERR;
+        sl_endpoint_af_set(&packet->src, SL_SOCK_AF_IPV6);
+        sl_endpoint_af_set(&packet->dst, SL_SOCK_AF_IPV6);
+        memcpy(packet->src.addr6.addr, p + 8, 16);
+        memcpy(packet->dst.addr6.addr, p + 24, 16);
+        uint8_t next = p[6];
+        size_t at = SL_CAPTURE_IP6_HEADER;
+        /* hop by hop, routing and destination options may sit before the UDP header, a fragment may not */
+        while (next == 0 || next == 43 || next == 60) {
+            if (caplen < at + 8) return SL_ERR;
+            next = p[at];
+            at += ((size_t)p[at + 1] + 1) * 8;
+        }
+        if (next != IPPROTO_UDP || caplen < at) return SL_ERR;
+        p += at;
+        caplen -= at;
+    } else {
+        return SL_ERR;
+    }
+
+    if (caplen < SL_CAPTURE_UDP_HEADER) return SL_ERR;
+    const uint16_t udp_len = sl_capture_be16(p + 4);
+    if (udp_len < SL_CAPTURE_UDP_HEADER) return SL_ERR;
+    memcpy(&packet->src.addr4.port, p, 2);
+    memcpy(&packet->dst.addr4.port, p + 2, 2);
+    packet->payload = (const char *)p + SL_CAPTURE_UDP_HEADER;
+    packet->wirelen = udp_len - SL_CAPTURE_UDP_HEADER;
+    caplen -= SL_CAPTURE_UDP_HEADER;
+    packet->len = (caplen < (size_t)packet->wirelen) ? (int32_t)caplen : packet->wirelen;
+
+    return SL_OK;
+}
+
+/*
+ * fills packet with the next UDP datagram in the capture, SL_ERR once there are no more. a
+ * truncated or malformed file ends there, as far as it could be read
+ */
+SL_INLINE_IMPL int sl_capture_reader_next(sl_capture_reader_t *reader, sl_capture_packet_t *packet)
+{
+    SL_ASSERT(reader && reader->state == SL_CAPTURE_STATE_STARTED);
+    SL_ASSERT(packet);
+
+    const size_t size = reader->map.size;
+    while (reader->offset < size) {
+        const size_t at = reader->offset;
+        uint32_t iface = 0, caplen;
+        size_t data;
+
+        if (!reader->pcapng) {
+            if (size - at < sizeof(sl_capture_record_header_t)) break;
+            caplen = sl_capture_read32(reader, at + 8);
+            data = at + sizeof(sl_capture_record_header_t);
+            if (caplen > size - data) break;
+            reader->offset = data + caplen;
+            const uint64_t sec = sl_capture_read32(reader, at);
+            const uint64_t frac = sl_capture_read32(reader, at + 4);
+            reader->timestamp_ns = sec * 1000000000ULL + sl_capture_ts_ns(frac, reader->ifaces[0].tsresol);
+        } else {
+            if (size - at < 12) break;
+            const uint32_t type = sl_capture_read32(reader, at);
+            uint32_t block_len = sl_capture_read32(reader, at + 4);
+            if (type == SL_CAPTURE_PCAPNG_SHB) {
+                /* a new section may change the byte order and starts its interfaces over */
+                uint32_t bom;
+                memcpy(&bom, reader->map.base + at + 8, sizeof(bom));
+                reader->swapped = (bom != SL_CAPTURE_PCAPNG_BOM);
+                block_len = sl_capture_read32(reader, at + 4);
+                reader->iface_count = 0;
+            }
+            if (block_len < 12 || (block_len & 3) || block_len > size - at) break;
+            reader->offset = at + block_len;
+
+            if (type == SL_CAPTURE_PCAPNG_IDB) {
+                if (block_len < 20 || reader->iface_count == SL_CAPTURE_IFACES_MAX) continue;
+                sl_capture_iface_t *idb = &reader->ifaces[reader->iface_count++];
+                idb->linktype = sl_capture_read16(reader, at + 8);
+                idb->tsresol = 6;
+                for (size_t opt = at + 16; opt + 4 <= at + block_len - 4;) {
+                    const uint16_t code = sl_capture_read16(reader, opt);
+                    const uint16_t len = sl_capture_read16(reader, opt + 2);
+                    if (!code) break;
+                    if (code == SL_CAPTURE_PCAPNG_TSRESOL && len == 1) idb->tsresol = (uint8_t)reader->map.base[opt + 4];
+                    opt += 4 + (((size_t)len + 3) & ~(size_t)3);
+                }
+                continue;
+            } else if (type == SL_CAPTURE_PCAPNG_EPB) {
+                if (block_len < 32) continue;
+                iface = sl_capture_read32(reader, at + 8);
+                caplen = sl_capture_read32(reader, at + 20);
+                data = at + 28;
+                if (iface >= reader->iface_count || caplen > block_len - 32) continue;
+                const uint64_t ts = ((uint64_t)sl_capture_read32(reader, at + 12) << 32) | sl_capture_read32(reader, at + 16);
+                reader->timestamp_ns = sl_capture_ts_ns(ts, reader->ifaces[iface].tsresol);
+            } else if (type == SL_CAPTURE_PCAPNG_SPB) {
+                if (block_len < 16 || !reader->iface_count) continue;
+                caplen = sl_capture_read32(reader, at + 8);
+                data = at + 12;
+                if (caplen > block_len - 16) caplen = block_len - 16;
+            } else {
+                continue;
+            }
+        }
+
+        if (sl_capture_udp_parse(reader->ifaces[iface].linktype, (const uint8_t *)reader->map.base + data, caplen, packet)) {
+            reader->skipped++;
+            continue;
+        }
+        packet->timestamp_ns = reader->timestamp_ns;
+        return SL_OK;
+    }
+
+    return SL_ERR;
+}
+
+#endif
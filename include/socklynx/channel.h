@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_CHANNEL_H
+#define SL_CHANNEL_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_channel_t is the per peer state for three delivery modes over one sl_sock_t:
+ * unreliable, unreliable sequenced, where anything older than the newest message seen is
+ * dropped, and reliable ordered.
+ *
+ * Every datagram starts with a 9 byte header: the mode, a 16 bit sequence number, and the
+ * newest reliable sequence received from the peer with a 32 bit field acking the 32 before it.
+ * Acks ride on all outgoing traffic, and sl_channel_update only sends a bare ack when there
+ * was nothing else to carry it.
+ *
+ * Reliable messages are copied into a fixed ring of SL_CHANNEL_WINDOW send slots until acked,
+ * and resent once the retransmit timeout passes; the timeout comes from smoothed rtt samples
+ * as in RFC 6298. A full ring refuses sends with ENOBUFS. The window matches the ack field, so
+ * every message in flight can always be acked. Messages arriving ahead of a gap wait in a
+ * matching receive ring. All memory is allocated at setup; nothing is allocated per message.
+ */
+
+#define SL_CHANNEL_HEADER_SIZE 9
+#define SL_CHANNEL_WINDOW 32
+#define SL_CHANNEL_SLOT_SIZE_DEFAULT (1200 - SL_CHANNEL_HEADER_SIZE)
+#define SL_CHANNEL_RTO_INITIAL_NS 200000000ULL
+#define SL_CHANNEL_RTO_MIN_NS 10000000ULL
+#define SL_CHANNEL_RTO_MAX_NS 2000000000ULL
+
+typedef enum sl_channel_mode_e {
+    SL_CHANNEL_UNRELIABLE = 0,
+    SL_CHANNEL_SEQUENCED = 1,
+    SL_CHANNEL_RELIABLE = 2,
+    SL_CHANNEL_ACK = 3,
+} sl_channel_mode_t;
+
+typedef enum sl_channel_state_e {
+    SL_CHANNEL_STATE_NEW,
+    SL_CHANNEL_STATE_STARTED,
+    SL_CHANNEL_STATE_STOPPED,
+} sl_channel_state_t;
+
+typedef enum sl_channel_flag_e {
+    SL_CHANNEL_FLAG_ACK_VALID = (1 << 0),
+    SL_CHANNEL_FLAG_ACK_PENDING = (1 << 1),
+    SL_CHANNEL_FLAG_SEQ_VALID = (1 << 2),
+    SL_CHANNEL_FLAG_RTT_VALID = (1 << 3),
+} sl_channel_flag_t;
+
+/* the header mode byte, set when the ack fields hold something */
+#define SL_CHANNEL_HEADER_ACK 0x80
+
+typedef struct sl_chanslot_s {
+    uint64_t sent_ns;
+    uint16_t seq;
+    uint16_t sends;
+    int32_t len;
+} sl_chanslot_t;
+
+/* set endpoint, or leave it NULL on a connected socket, and optionally slotsize, before sl_channel_setup */
+typedef struct sl_channel_s {
+    sl_endpoint_t *endpoint;
+    uint32_t slotsize;
+    uint32_t state;
+    uint32_t error;
+    uint16_t send_seq;
+    uint16_t send_base;
+    uint16_t seq_next;
+    uint16_t recv_ack;
+    uint16_t recv_next;
+    uint16_t seq_latest;
+    uint32_t flags;
+    uint32_t send_pending;
+    uint32_t recv_present;
+    uint32_t recv_bits;
+    uint64_t srtt_ns;
+    uint64_t rttvar_ns;
+    uint64_t rto_ns;
+    uint64_t resends;
+    sl_chanslot_t send_slots[SL_CHANNEL_WINDOW];
+    int32_t recv_len[SL_CHANNEL_WINDOW];
+    char *send_mem;
+    char *recv_mem;
+} sl_channel_t;
+
+/* true when sequence a comes after b, across the 16 bit wrap */
+SL_INLINE_IMPL bool sl_channel_seq_newer(uint16_t a, uint16_t b)
+{
+    return (int16_t)(a - b) > 0;
+}
+
+SL_INLINE_IMPL int sl_channel_cleanup(sl_channel_t *ch)
+{
+    SL_ASSERT(ch);
+    if (ch->state != SL_CHANNEL_STATE_STARTED) return SL_OK;
+
+    free(ch->send_mem);
+    free(ch->recv_mem);
+    ch->send_mem = NULL;
+    ch->recv_mem = NULL;
+    ch->state = SL_CHANNEL_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_channel_setup(sl_channel_t *ch)
+{
+    SL_ASSERT(ch);
+    SL_ASSERT(ch->state != SL_CHANNEL_STATE_STARTED);
+
+    if (!ch->slotsize) ch->slotsize = SL_CHANNEL_SLOT_SIZE_DEFAULT;
+    ch->send_mem = (char *)malloc((size_t)ch->slotsize * SL_CHANNEL_WINDOW);
+    ch->recv_mem = (char *)malloc((size_t)ch->slotsize * SL_CHANNEL_WINDOW);
+    if (!ch->send_mem || !ch->recv_mem) {
+        free(ch->send_mem);
+        free(ch->recv_mem);
+        ch->send_mem = NULL;
+        ch->recv_mem = NULL;
+        ch->error = ENOMEM;
+        return SL_ERR;
+    }
+
+    ch->send_seq = 0;
+    ch->send_base = 0;
+    ch->seq_next = 0;
+    ch->recv_ack = 0;
+    ch->recv_next = 0;
+    ch->seq_latest = 0;
+    ch->flags = 0;
+    ch->send_pending = 0;
+    ch->recv_present = 0;
+    ch->recv_bits = 0;
+    ch->srtt_ns = 0;
+    ch->rttvar_ns = 0;
+    ch->rto_ns = SL_CHANNEL_RTO_INITIAL_NS;
+    ch->resends = 0;
+    memset(ch->send_slots, 0, sizeof(ch->send_slots));
+    ch->error = 0;
+    ch->state = SL_CHANNEL_STATE_STARTED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_channel_header_write(sl_channel_t *ch, char *dst, sl_channel_mode_t mode, uint16_t seq)
+{
+    uint8_t type = (uint8_t)mode;
+    if (ch->flags & SL_CHANNEL_FLAG_ACK_VALID) type |= SL_CHANNEL_HEADER_ACK;
+    dst[0] = (char)type;
+    dst[1] = (char)(seq >> 8);
+    dst[2] = (char)seq;
+    dst[3] = (char)(ch->recv_ack >> 8);
+    dst[4] = (char)ch->recv_ack;
+    dst[5] = (char)(ch->recv_bits >> 24);
+    dst[6] = (char)(ch->recv_bits >> 16);
+    dst[7] = (char)(ch->recv_bits >> 8);
+    dst[8] = (char)ch->recv_bits;
+}
+
+SL_INLINE_IMPL int sl_channel_transmit(sl_channel_t *ch, sl_sock_t *sock, sl_channel_mode_t mode, uint16_t seq, char *data, int32_t len)
+{
+    char header[SL_CHANNEL_HEADER_SIZE];
+    sl_channel_header_write(ch, header, mode, seq);
+
+    sl_buf_t bufs[2];
+    bufs[0].base = header;
+    bufs[0].len = SL_CHANNEL_HEADER_SIZE;
+    bufs[1].base = data;
+    bufs[1].len = (uint32_t)len;
+    SL_GUARD(sl_sock_send(sock, bufs, len ? 2 : 1, ch->endpoint) < 0);
+    ch->flags &= ~(uint32_t)SL_CHANNEL_FLAG_ACK_PENDING;
+
+    return SL_OK;
+}
+
+/*
+ * sends len bytes in the given mode. unreliable and sequenced sends go straight out from data.
+ * a reliable send is copied into the send ring first, so once queued it returns SL_OK even
+ * if the socket could not take it right away, and sl_channel_update sends it again later.
+ * SL_ERR with ENOBUFS when the ring is full, EMSGSIZE past slotsize
+ */
+SL_INLINE_IMPL int sl_channel_send(sl_channel_t *ch, sl_sock_t *sock, sl_channel_mode_t mode, const void *data, int32_t len, uint64_t now_ns)
+{
+    SL_ASSERT(ch && ch->state == SL_CHANNEL_STATE_STARTED);
+    SL_ASSERT(sock);
+    SL_ASSERT(data || !len);
+
+    if (len < 0 || (mode == SL_CHANNEL_RELIABLE && (uint32_t)len > ch->slotsize)) {
+        ch->error = EMSGSIZE;
+        return SL_ERR;
+    }
+
+    if (mode == SL_CHANNEL_UNRELIABLE) return sl_channel_transmit(ch, sock, mode, 0, (char *)data, len);
+    if (mode == SL_CHANNEL_SEQUENCED) return sl_channel_transmit(ch, sock, mode, ch->seq_next++, (char *)data, len);
+    if (mode != SL_CHANNEL_RELIABLE) {
+        ch->error = EINVAL;
+        return SL_ERR;
+    }
+
+    if ((uint16_t)(ch->send_seq - ch->send_base) >= SL_CHANNEL_WINDOW) {
+        ch->error = ENOBUFS;
+        return SL_ERR;
+    }
+
+    const uint16_t seq = ch->send_seq++;
+    const uint32_t index = seq % SL_CHANNEL_WINDOW;
+    sl_chanslot_t *slot = &ch->send_slots[index];
+    char *mem = ch->send_mem + (size_t)index * ch->slotsize;
+    memcpy(mem, data, (size_t)len);
+    slot->seq = seq;
+    slot->len = len;
+    slot->sends = 1;
+    slot->sent_ns = now_ns;
+    ch->send_pending |= 1u << index;
+    sl_channel_transmit(ch, sock, SL_CHANNEL_RELIABLE, seq, mem, len);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_channel_rtt_sample(sl_channel_t *ch, uint64_t rtt_ns)
+{
+    if (!(ch->flags & SL_CHANNEL_FLAG_RTT_VALID)) {
+        ch->srtt_ns = rtt_ns;
+        ch->rttvar_ns = rtt_ns / 2;
+        ch->flags |= SL_CHANNEL_FLAG_RTT_VALID;
+    } else {
+        const uint64_t delta = ch->srtt_ns > rtt_ns ? ch->srtt_ns - rtt_ns : rtt_ns - ch->srtt_ns;
+        ch->rttvar_ns = (3 * ch->rttvar_ns + delta) / 4;
+        ch->srtt_ns = (7 * ch->srtt_ns + rtt_ns) / 8;
+    }
+
+    uint64_t rto = ch->srtt_ns + 4 * ch->rttvar_ns;
+    if (rto < SL_CHANNEL_RTO_MIN_NS) rto = SL_CHANNEL_RTO_MIN_NS;
+    if (rto > SL_CHANNEL_RTO_MAX_NS) rto = SL_CHANNEL_RTO_MAX_NS;
+    ch->rto_ns = rto;
+}
+
+SL_INLINE_IMPL void sl_channel_ack_one(sl_channel_t *ch, uint16_t seq, uint64_t now_ns)
+{
+    /* only sequences still in flight, anything else is stale or bogus */
+    if ((uint16_t)(seq - ch->send_base) >= (uint16_t)(ch->send_seq - ch->send_base)) return;
+
+    const uint32_t index = seq % SL_CHANNEL_WINDOW;
+    sl_chanslot_t *slot = &ch->send_slots[index];
+    if (!(ch->send_pending & (1u << index)) || slot->seq != seq) return;
+
+    /* a resent message's ack could be for any of its copies, so only first sends are timed */
+    if (slot->sends == 1 && now_ns >= slot->sent_ns) sl_channel_rtt_sample(ch, now_ns - slot->sent_ns);
+    ch->send_pending &= ~(1u << index);
+}
+
+SL_INLINE_IMPL void sl_channel_ack(sl_channel_t *ch, uint16_t ack, uint32_t bits, uint64_t now_ns)
+{
+    sl_channel_ack_one(ch, ack, now_ns);
+    for (uint32_t i = 0; bits && i < 32; i++, bits >>= 1) {
+        if (bits & 1) sl_channel_ack_one(ch, (uint16_t)(ack - 1 - i), now_ns);
+    }
+    while (ch->send_base != ch->send_seq && !(ch->send_pending & (1u << (ch->send_base % SL_CHANNEL_WINDOW)))) {
+        ch->send_base++;
+    }
+}
+
+/* folds a received reliable sequence into the ack fields we send back */
+SL_INLINE_IMPL void sl_channel_ack_record(sl_channel_t *ch, uint16_t seq)
+{
+    ch->flags |= SL_CHANNEL_FLAG_ACK_PENDING;
+    if (!(ch->flags & SL_CHANNEL_FLAG_ACK_VALID)) {
+        ch->recv_ack = seq;
+        ch->recv_bits = 0;
+        ch->flags |= SL_CHANNEL_FLAG_ACK_VALID;
+        return;
+    }
+
+    const int32_t d = (int16_t)(seq - ch->recv_ack);
+    if (d > 0) {
+        ch->recv_bits = d > 32 ? 0 : ((d == 32 ? 0 : ch->recv_bits << d) | (1u << (d - 1)));
+        ch->recv_ack = seq;
+    } else if (d < 0 && d >= -32) {
+        ch->recv_bits |= 1u << (-d - 1);
+    }
+}
+
+/*
+ * handles one received datagram of len bytes from the peer. returns 1 with msg set and mode,
+ * when given, set to how it was sent, 0 when there is nothing to hand over, which is the case
+ * for bare acks, stale sequenced messages, duplicates, and reliable messages that arrived
+ * ahead of a gap. msg points into data, except for reliable messages that had to wait, which
+ * sl_channel_next hands out of the receive ring. SL_ERR with EINVAL for a malformed datagram
+ */
+SL_INLINE_IMPL int sl_channel_recv(sl_channel_t *ch, char *data, int32_t len, uint64_t now_ns, sl_buf_t *msg, sl_channel_mode_t *mode)
+{
+    SL_ASSERT(ch && ch->state == SL_CHANNEL_STATE_STARTED);
+    SL_ASSERT(data && msg);
+
+    if (len < SL_CHANNEL_HEADER_SIZE) goto malformed;
+
+    const uint8_t *header = (const uint8_t *)data;
+    const sl_channel_mode_t type = (sl_channel_mode_t)(header[0] & 0x3);
+    if (header[0] & ~(SL_CHANNEL_HEADER_ACK | 0x3)) goto malformed;
+    const uint16_t seq = (uint16_t)((header[1] << 8) | header[2]);
+    if (header[0] & SL_CHANNEL_HEADER_ACK) {
+        const uint16_t ack = (uint16_t)((header[3] << 8) | header[4]);
+        const uint32_t bits = ((uint32_t)header[5] << 24) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 8) | header[8];
+        sl_channel_ack(ch, ack, bits, now_ns);
+    }
+
+    char *payload = data + SL_CHANNEL_HEADER_SIZE;
+    const int32_t plen = len - SL_CHANNEL_HEADER_SIZE;
+    if (mode) *mode = type;
+
+    switch (type) {
+    case SL_CHANNEL_UNRELIABLE:
+        break;
+    case SL_CHANNEL_SEQUENCED:
+        if ((ch->flags & SL_CHANNEL_FLAG_SEQ_VALID) && !sl_channel_seq_newer(seq, ch->seq_latest)) return 0;
+        ch->seq_latest = seq;
+        ch->flags |= SL_CHANNEL_FLAG_SEQ_VALID;
+        break;
+    case SL_CHANNEL_RELIABLE: {
+        if ((uint32_t)plen > ch->slotsize) goto malformed;
+        const uint16_t ahead = (uint16_t)(seq - ch->recv_next);
+        if (ahead >= SL_CHANNEL_WINDOW) {
+            /* behind recv_next it is a resend of something delivered and still needs an ack */
+            if ((int16_t)ahead < 0) sl_channel_ack_record(ch, seq);
+            return 0;
+        }
+        sl_channel_ack_record(ch, seq);
+        if (ahead) {
+            const uint32_t index = seq % SL_CHANNEL_WINDOW;
+            if (!(ch->recv_present & (1u << index))) {
+                memcpy(ch->recv_mem + (size_t)index * ch->slotsize, payload, (size_t)plen);
+                ch->recv_len[index] = plen;
+                ch->recv_present |= 1u << index;
+            }
+            return 0;
+        }
+        /* a copy of it may already be waiting, this one goes out instead */
+        ch->recv_present &= ~(1u << (seq % SL_CHANNEL_WINDOW));
+        ch->recv_next++;
+        break;
+    }
+    default:
+        return 0;
+    }
+
+    msg->base = payload;
+    msg->len = (uint32_t)plen;
+
+    return 1;
+
+malformed:
+    ch->error = EINVAL;
+    return SL_ERR;
+}
+
+/*
+ * hands over the next reliable message that was waiting in the receive ring, call it until it
+ * returns 0 after every sl_channel_recv. msg stays valid until the next sl_channel_recv
+ */
+SL_INLINE_IMPL int sl_channel_next(sl_channel_t *ch, sl_buf_t *msg)
+{
+    SL_ASSERT(ch && ch->state == SL_CHANNEL_STATE_STARTED);
+    SL_ASSERT(msg);
+
+    const uint32_t index = ch->recv_next % SL_CHANNEL_WINDOW;
+    if (!(ch->recv_present & (1u << index))) return 0;
+
+    ch->recv_present &= ~(1u << index);
+    ch->recv_next++;
+    msg->base = ch->recv_mem + (size_t)index * ch->slotsize;
+    msg->len = (uint32_t)ch->recv_len[index];
+
+    return 1;
+}
+
+/* the earliest time sl_channel_update has a resend to do, UINT64_MAX when nothing is in flight */
+SL_INLINE_IMPL uint64_t sl_channel_deadline(sl_channel_t *ch)
+{
+    SL_ASSERT(ch && ch->state == SL_CHANNEL_STATE_STARTED);
+
+    uint64_t deadline = UINT64_MAX;
+    for (uint32_t pending = ch->send_pending; pending; pending &= pending - 1) {
+        const sl_chanslot_t *slot = &ch->send_slots[sl_sys_ctz32(pending)];
+        if (slot->sent_ns + ch->rto_ns < deadline) deadline = slot->sent_ns + ch->rto_ns;
+    }
+
+    return deadline;
+}
+
+/*
+ * resends every reliable message whose timeout has passed, doubling the timeout for the next
+ * round, and sends a bare ack if the peer is owed one that no outgoing message carried.
+ * call once per tick. returns the datagrams sent, SL_ERR when the socket refused one
+ */
+SL_INLINE_IMPL int sl_channel_update(sl_channel_t *ch, sl_sock_t *sock, uint64_t now_ns)
+{
+    SL_ASSERT(ch && ch->state == SL_CHANNEL_STATE_STARTED);
+    SL_ASSERT(sock);
+
+    int sent = 0;
+    bool timedout = false;
+    for (uint32_t pending = ch->send_pending; pending; pending &= pending - 1) {
+        const uint32_t index = sl_sys_ctz32(pending);
+        sl_chanslot_t *slot = &ch->send_slots[index];
+        if (slot->sent_ns + ch->rto_ns > now_ns) continue;
+
+        SL_GUARD(sl_channel_transmit(ch, sock, SL_CHANNEL_RELIABLE, slot->seq, ch->send_mem + (size_t)index * ch->slotsize, slot->len));
+        slot->sent_ns = now_ns;
+        if (slot->sends < UINT16_MAX) slot->sends++;
+        ch->resends++;
+        timedout = true;
+        sent++;
+    }
+    if (timedout) {
+        ch->rto_ns = ch->rto_ns * 2 > SL_CHANNEL_RTO_MAX_NS ? SL_CHANNEL_RTO_MAX_NS : ch->rto_ns * 2;
+    }
+
+    if (ch->flags & SL_CHANNEL_FLAG_ACK_PENDING) {
+        SL_GUARD(sl_channel_transmit(ch, sock, SL_CHANNEL_ACK, 0, NULL, 0));
+        sent++;
+    }
+
+    return sent;
+}
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_COALESCE_H
+#define SL_COALESCE_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+
+/*
+ * sl_coalesce_t packs many small messages bound for one peer into a single datagram. Each
+ * message is written behind a one byte length prefix, or two bytes from 128 bytes up, and the
+ * frame goes out when the next message would not fit or on an explicit flush, normally once
+ * per tick. The frame memory is the caller's, one per peer, sized to the path MTU.
+ * The receiving side walks a frame with sl_coalesce_next, which hands back each message as a
+ * view into the received buffer.
+ */
+
+#define SL_COALESCE_FRAME_DEFAULT 1200
+#define SL_COALESCE_MSG_MAX 0x3fff
+
+typedef struct sl_coalesce_s {
+    sl_buf_t frame;
+    sl_endpoint_t *endpoint;
+    int32_t len;
+    int32_t count;
+} sl_coalesce_t;
+
+/* frame is the backing memory and its capacity, endpoint is NULL on a connected socket */
+SL_INLINE_IMPL void sl_coalesce_init(sl_coalesce_t *co, char *base, int32_t capacity, sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(co && base && capacity > 0);
+    co->frame.base = base;
+    co->frame.len = (uint32_t)capacity;
+    co->endpoint = endpoint;
+    co->len = 0;
+    co->count = 0;
+}
+
+SL_INLINE_IMPL int32_t sl_coalesce_prefix_size(int32_t len)
+{
+    return len < 0x80 ? 1 : 2;
+}
+
+SL_INLINE_IMPL bool sl_coalesce_fits(sl_coalesce_t *co, int32_t len)
+{
+    return co->len + sl_coalesce_prefix_size(len) + len <= (int32_t)co->frame.len;
+}
+
+/* sends the pending frame, returns the bytes sent and 0 when nothing was pending. a failed send keeps the frame */
+SL_INLINE_IMPL int sl_coalesce_flush(sl_coalesce_t *co, sl_sock_t *sock)
+{
+    SL_ASSERT(co && sock);
+    if (!co->len) return 0;
+
+    sl_buf_t buf = {0};
+    buf.base = co->frame.base;
+    buf.len = (uint32_t)co->len;
+    int rv = sl_sock_send(sock, &buf, 1, co->endpoint);
+    SL_GUARD(rv < 0);
+    co->len = 0;
+    co->count = 0;
+
+    return rv;
+}
+
+/*
+ * room for a len byte message at the end of the frame, flushing first when it would not fit.
+ * NULL when len can never fit, with EMSGSIZE on the socket, or when that flush failed
+ */
+SL_INLINE_IMPL char *sl_coalesce_reserve(sl_coalesce_t *co, sl_sock_t *sock, int32_t len)
+{
+    SL_ASSERT(co && sock);
+
+    const int32_t prefix = sl_coalesce_prefix_size(len);
+    if (len < 0 || len > SL_COALESCE_MSG_MAX || prefix + len > (int32_t)co->frame.len) {
+        sl_sock_error_set(sock, EMSGSIZE);
+        return NULL;
+    }
+    if (!sl_coalesce_fits(co, len) && sl_coalesce_flush(co, sock) < 0) return NULL;
+
+    char *dst = co->frame.base + co->len;
+    if (prefix == 1) {
+        dst[0] = (char)len;
+    } else {
+        dst[0] = (char)(0x80 | (len & 0x7f));
+        dst[1] = (char)(len >> 7);
+    }
+    co->len += prefix + len;
+    co->count++;
+
+    return dst + prefix;
+}
+
+SL_INLINE_IMPL int sl_coalesce_append(sl_coalesce_t *co, sl_sock_t *sock, const void *data, int32_t len)
+{
+    char *dst = sl_coalesce_reserve(co, sock, len);
+    SL_GUARD_NULL(dst);
+    memcpy(dst, data, (size_t)len);
+
+    return SL_OK;
+}
+
+/*
+ * flushes every pending frame in cos through sl_sock_send_batch, so a tick's worth of peers
+ * costs one syscall per SL_SOCK_BATCH_MAX frames. empty ones are skipped and flushed ones
+ * reset, so after a partial send calling again with the same array carries on where it
+ * stopped. returns the frames sent, SL_ERR only when none could be
+ */
+SL_INLINE_IMPL int sl_coalesce_flush_batch(sl_sock_t *sock, sl_coalesce_t **cos, int32_t count)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(cos && count >= 0);
+
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+    sl_coalesce_t *pending[SL_SOCK_BATCH_MAX];
+    int32_t frames = 0;
+    int32_t i = 0;
+    while (i < count) {
+        int32_t n = 0;
+        for (; i < count && n < SL_SOCK_BATCH_MAX; i++) {
+            sl_coalesce_t *co = cos[i];
+            if (!co->len) continue;
+            bufs[n].base = co->frame.base;
+            bufs[n].len = (uint32_t)co->len;
+            msgs[n].buf = &bufs[n];
+            msgs[n].bufcount = 1;
+            msgs[n].endpoint = co->endpoint;
+            pending[n++] = co;
+        }
+        if (!n) break;
+
+        int sent = sl_sock_send_batch(sock, msgs, n);
+        if (sent < 0) return frames ? frames : SL_ERR;
+        for (int32_t j = 0; j < sent; j++) {
+            pending[j]->len = 0;
+            pending[j]->count = 0;
+        }
+        frames += sent;
+        if (sent < n) break;
+    }
+
+    return frames;
+}
+
+/*
+ * steps through a received frame of len bytes from *offset, which starts at 0. msg points into
+ * the frame, nothing is copied. returns 1 with msg set, 0 at the end of the frame, SL_ERR when
+ * a length prefix runs past the end
+ */
+SL_INLINE_IMPL int sl_coalesce_next(char *frame, int32_t len, int32_t *offset, sl_buf_t *msg)
+{
+    SL_ASSERT(frame && offset && msg);
+
+    int32_t pos = *offset;
+    if (pos >= len) return 0;
+
+    int32_t msglen = (uint8_t)frame[pos++];
+    if (msglen & 0x80) {
+        if (pos >= len) return SL_ERR;
+        msglen = (msglen & 0x7f) | ((int32_t)(uint8_t)frame[pos++] << 7);
+    }
+    if (msglen > len - pos) return SL_ERR;
+
+    msg->base = frame + pos;
+    msg->len = (uint32_t)msglen;
+    *offset = pos + msglen;
+
+    return 1;
+}
+
+#endif
@@ -70,6 +70,7 @@
 #    define SL_PLATFORM_ANDROID 1
 #elif __linux__
 #    define SL_PLATFORM_POSIX 1
+#    define SL_PLATFORM_LINUX 1
 #elif __unix__
 #    define SL_PLATFORM_POSIX 1
 #elif defined(_POSIX_VERSION)
@@ -143,6 +144,7 @@
 #ifndef SL_C_MISSING_STDINT
 #    include <stdint.h>
 #    include <stdlib.h>
+#    include <string.h>
 #    ifdef SL_PLATFORM_ANDROID
 #        include <limits.h>
 #    endif
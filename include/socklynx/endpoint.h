@@ -26,6 +26,12 @@
 #include "socklynx/common.h"
 #include "socklynx/error.h"
 
+#if SL_SOCK_API_WINSOCK
+#    include <ws2tcpip.h>
+#else
+#    include <arpa/inet.h>
+#endif
+
 #if SL_PLATFORM_OSX
 #    define SL_AF_TYPE uint8_t
 #else
@@ -93,6 +99,72 @@ SL_INLINE_IMPL bool sl_endpoint_is_ipv6(sl_endpoint_t *endpoint)
     return (sl_endpoint_af_get(endpoint) == (uint16_t)SL_SOCK_AF_IPV6);
 }
 
+/*
+ * hashes the address and port only, so v4 padding and the v6 flowinfo, which can differ per
+ * datagram from the same peer, never split one peer into two keys
+ */
+SL_INLINE_IMPL uint32_t sl_endpoint_hash(sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(endpoint);
+
+    uint64_t h;
+    if (sl_endpoint_is_ipv6(endpoint)) {
+        uint64_t lo, hi;
+        memcpy(&lo, endpoint->addr6.addr, sizeof(lo));
+        memcpy(&hi, endpoint->addr6.addr + sizeof(lo), sizeof(hi));
+        h = lo ^ (hi * 0x9e3779b97f4a7c15ULL) ^ (((uint64_t)endpoint->addr6.port << 32) | endpoint->addr6.scope_id);
+    } else {
+        h = ((uint64_t)endpoint->addr4.addr << 16) | endpoint->addr4.port;
+    }
+
+    /* murmur3 finalizer */
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return (uint32_t)h;
+}
+
+/* same fields as sl_endpoint_hash */
+SL_INLINE_IMPL bool sl_endpoint_equal(sl_endpoint_t *a, sl_endpoint_t *b)
+{
+    SL_ASSERT(a && b);
+    if (sl_endpoint_af_get(a) != sl_endpoint_af_get(b)) return false;
+    if (sl_endpoint_is_ipv6(a)) {
+        return a->addr6.port == b->addr6.port && a->addr6.scope_id == b->addr6.scope_id &&
+               !memcmp(a->addr6.addr, b->addr6.addr, sizeof(a->addr6.addr));
+    }
+    return a->addr4.port == b->addr4.port && a->addr4.addr == b->addr4.addr;
+}
+
+/* fills endpoint from a numeric ipv4 or ipv6 address string, port is host order */
+SL_INLINE_IMPL int sl_endpoint_parse(sl_endpoint_t *endpoint, const char *addr, uint16_t port)
+{
+    SL_ASSERT(endpoint && addr);
+
+    memset(endpoint, 0, sizeof(*endpoint));
+    if (inet_pton(AF_INET, addr, &endpoint->addr4.addr) == 1) {
+        sl_endpoint_af_set(endpoint, SL_SOCK_AF_IPV4);
+        endpoint->addr4.port = htons(port);
+#if SL_PLATFORM_OSX
+        endpoint->addr4.len = sizeof(sl_sockaddr4_t);
+#endif
+        return SL_OK;
+    }
+    if (inet_pton(AF_INET6, addr, endpoint->addr6.addr) == 1) {
+        sl_endpoint_af_set(endpoint, SL_SOCK_AF_IPV6);
+        endpoint->addr6.port = htons(port);
+#if SL_PLATFORM_OSX
+        endpoint->addr6.len = sizeof(sl_sockaddr6_t);
+#endif
+        return SL_OK;
+    }
+
+    return SL_ERR;
+}
+
 SL_INLINE_IMPL int sl_endpoint_size(sl_endpoint_t *endpoint)
 {
     SL_ASSERT(endpoint);
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_FRAGMENT_H
+#define SL_FRAGMENT_H
+
+#include "socklynx/buf.h"
+#include "socklynx/bufpool.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * Messages larger than one datagram are cut into fragments that each fit the path MTU, so
+ * IP fragmentation never happens. Every fragment carries a 6 byte header: the sender's 16 bit
+ * message id, the fragment index and count, and the payload size of every fragment but the
+ * last, all big endian. The sender uses sl_fragsend_t, which sends the header and a slice of
+ * the caller's payload as two iovecs per datagram, so nothing is copied.
+ *
+ * The receiver uses sl_fragtable_t. It reassembles into slots of a sl_bufpool_t, whose slot
+ * size is the largest message accepted. The table has a fixed number of entries, and a
+ * message only ever probes SL_FRAG_PROBE of them, so every datagram costs bounded work.
+ * A partial message holds its slot until it completes or its timeout passes. A flood of
+ * bogus fragments can therefore only ever occupy the table and the pool; it never causes
+ * heap allocation or unbounded scanning. Refused fragments are counted in dropped.
+ */
+
+#define SL_FRAG_HEADER_SIZE 6
+#define SL_FRAG_COUNT_MAX 255
+#define SL_FRAG_DATAGRAM_DEFAULT 1200
+#define SL_FRAG_TIMEOUT_MS_DEFAULT 1000
+#define SL_FRAG_PROBE 8
+
+typedef enum sl_fragtable_state_e {
+    SL_FRAGTABLE_STATE_NEW,
+    SL_FRAGTABLE_STATE_STARTED,
+    SL_FRAGTABLE_STATE_STOPPED,
+} sl_fragtable_state_t;
+
+/* one outgoing message, resumable after a partial send */
+typedef struct sl_fragsend_s {
+    char *data;
+    sl_endpoint_t *endpoint;
+    int32_t len;
+    int32_t fragsize;
+    uint16_t msg_id;
+    uint16_t count;
+    uint16_t next;
+} sl_fragsend_t;
+
+/* a message being reassembled, free when buf.base is NULL */
+typedef struct sl_fragentry_s {
+    sl_endpoint_t endpoint;
+    sl_buf_t buf;
+    uint64_t deadline_ns;
+    uint64_t received[4];
+    uint32_t hash;
+    int32_t len;
+    uint16_t msg_id;
+    uint16_t count;
+    uint16_t remaining;
+    uint16_t fragsize;
+} sl_fragentry_t;
+
+/* set pool and capacity, and optionally timeout_ms, before sl_fragtable_setup */
+typedef struct sl_fragtable_s {
+    sl_bufpool_t *pool;
+    uint32_t capacity;
+    uint32_t timeout_ms;
+    uint32_t state;
+    uint32_t error;
+    uint32_t mask;
+    uint32_t active;
+    uint64_t dropped;
+    uint64_t expired;
+    sl_fragentry_t *entries;
+} sl_fragtable_t;
+
+SL_INLINE_IMPL void sl_frag_header_write(char *dst, uint16_t msg_id, uint16_t index, uint16_t count, int32_t fragsize)
+{
+    dst[0] = (char)(msg_id >> 8);
+    dst[1] = (char)msg_id;
+    dst[2] = (char)index;
+    dst[3] = (char)count;
+    dst[4] = (char)(fragsize >> 8);
+    dst[5] = (char)fragsize;
+}
+
+/*
+ * prepares len bytes of data, which must stay untouched until every fragment is sent, as
+ * fragments of at most datagram bytes each. endpoint is NULL on a connected socket.
+ * SL_ERR when the message would take more than SL_FRAG_COUNT_MAX fragments
+ */
+SL_INLINE_IMPL int sl_fragsend_init(sl_fragsend_t *fs, char *data, int32_t len, sl_endpoint_t *endpoint, uint16_t msg_id, int32_t datagram)
+{
+    SL_ASSERT(fs);
+    SL_ASSERT(data || !len);
+
+    if (!datagram) datagram = SL_FRAG_DATAGRAM_DEFAULT;
+    const int32_t fragsize = datagram - SL_FRAG_HEADER_SIZE;
+    SL_GUARD(len < 0 || fragsize <= 0 || fragsize > UINT16_MAX);
+    const int32_t count = len ? (len + fragsize - 1) / fragsize : 1;
+    SL_GUARD(count > SL_FRAG_COUNT_MAX);
+
+    fs->data = data;
+    fs->endpoint = endpoint;
+    fs->len = len;
+    fs->fragsize = fragsize;
+    fs->msg_id = msg_id;
+    fs->count = (uint16_t)count;
+    fs->next = 0;
+
+    return SL_OK;
+}
+
+/*
+ * sends the fragments not yet sent, up to SL_SOCK_BATCH_MAX per syscall. returns how many are
+ * still left, 0 once the whole message is out, SL_ERR when not one more could be sent
+ */
+SL_INLINE_IMPL int sl_fragsend_send(sl_fragsend_t *fs, sl_sock_t *sock)
+{
+    SL_ASSERT(fs && sock);
+
+    char headers[SL_SOCK_BATCH_MAX][SL_FRAG_HEADER_SIZE];
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX][2];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+    while (fs->next < fs->count) {
+        int32_t n = 0;
+        for (; n < SL_SOCK_BATCH_MAX && fs->next + n < fs->count; n++) {
+            const uint16_t index = (uint16_t)(fs->next + n);
+            const int32_t offset = index * fs->fragsize;
+            const int32_t len = fs->len - offset < fs->fragsize ? fs->len - offset : fs->fragsize;
+            sl_frag_header_write(headers[n], fs->msg_id, index, fs->count, fs->fragsize);
+            bufs[n][0].base = headers[n];
+            bufs[n][0].len = SL_FRAG_HEADER_SIZE;
+            bufs[n][1].base = fs->data + offset;
+            bufs[n][1].len = (uint32_t)len;
+            msgs[n].buf = bufs[n];
+            msgs[n].bufcount = 2;
+            msgs[n].endpoint = fs->endpoint;
+        }
+
+        int sent = sl_sock_send_batch(sock, msgs, n);
+        SL_GUARD(sent < 0);
+        fs->next = (uint16_t)(fs->next + sent);
+        if (sent < n) break;
+    }
+
+    return fs->count - fs->next;
+}
+
+SL_INLINE_IMPL void sl_fragtable_release(sl_fragtable_t *table, sl_fragentry_t *entry)
+{
+    sl_bufpool_release(table->pool, &entry->buf);
+    entry->buf.base = NULL;
+    table->active--;
+}
+
+SL_INLINE_IMPL int sl_fragtable_cleanup(sl_fragtable_t *table)
+{
+    SL_ASSERT(table);
+    if (table->state != SL_FRAGTABLE_STATE_STARTED) return SL_OK;
+
+    for (uint32_t i = 0; i <= table->mask; i++) {
+        if (table->entries[i].buf.base) sl_fragtable_release(table, &table->entries[i]);
+    }
+    free(table->entries);
+    table->entries = NULL;
+    table->state = SL_FRAGTABLE_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_fragtable_setup(sl_fragtable_t *table)
+{
+    SL_ASSERT(table);
+    SL_ASSERT(table->state != SL_FRAGTABLE_STATE_STARTED);
+    SL_GUARD(!table->pool || table->pool->state != SL_BUFPOOL_STATE_STARTED);
+    SL_GUARD(!table->capacity || table->capacity > (1u << 24));
+
+    if (!table->timeout_ms) table->timeout_ms = SL_FRAG_TIMEOUT_MS_DEFAULT;
+
+    uint32_t size = SL_FRAG_PROBE;
+    while (size < table->capacity) size <<= 1;
+    table->mask = size - 1;
+
+    table->entries = (sl_fragentry_t *)calloc(size, sizeof(*table->entries));
+    if (!table->entries) {
+        table->error = ENOMEM;
+        return SL_ERR;
+    }
+    table->active = 0;
+    table->dropped = 0;
+    table->expired = 0;
+    table->error = 0;
+    table->state = SL_FRAGTABLE_STATE_STARTED;
+
+    return SL_OK;
+}
+
+/* gives up on every partial message whose timeout has passed, returns how many */
+SL_INLINE_IMPL uint32_t sl_fragtable_expire(sl_fragtable_t *table, uint64_t now_ns)
+{
+    SL_ASSERT(table && table->state == SL_FRAGTABLE_STATE_STARTED);
+
+    uint32_t expired = 0;
+    for (uint32_t i = 0; i <= table->mask && table->active; i++) {
+        sl_fragentry_t *entry = &table->entries[i];
+        if (entry->buf.base && entry->deadline_ns <= now_ns) {
+            sl_fragtable_release(table, entry);
+            expired++;
+        }
+    }
+    table->expired += expired;
+
+    return expired;
+}
+
+/*
+ * feeds one received datagram of len bytes from endpoint. returns 1 with msg set to a pool
+ * slot holding the whole message, which the caller hands back with sl_bufpool_release, and
+ * 0 while more fragments are needed or when the fragment was refused. SL_ERR with EINVAL
+ * for a malformed fragment
+ */
+SL_INLINE_IMPL int sl_fragtable_recv(sl_fragtable_t *table, sl_endpoint_t *endpoint, const char *data, int32_t len, uint64_t now_ns, sl_buf_t *msg)
+{
+    SL_ASSERT(table && table->state == SL_FRAGTABLE_STATE_STARTED);
+    SL_ASSERT(endpoint && data && msg);
+
+    if (len < SL_FRAG_HEADER_SIZE) goto malformed;
+
+    const uint8_t *header = (const uint8_t *)data;
+    const uint16_t msg_id = (uint16_t)((header[0] << 8) | header[1]);
+    const uint16_t index = header[2];
+    const uint16_t count = header[3];
+    const uint16_t fragsize = (uint16_t)((header[4] << 8) | header[5]);
+    const int32_t plen = len - SL_FRAG_HEADER_SIZE;
+    const int32_t offset = index * fragsize;
+
+    if (!count || index >= count || !fragsize) goto malformed;
+    if (index < count - 1 ? plen != fragsize : plen > fragsize) goto malformed;
+    if ((size_t)offset + (size_t)plen > table->pool->slotsize) goto malformed;
+    if ((size_t)(count - 1) * fragsize >= table->pool->slotsize) goto malformed;
+
+    /* a whole message in one datagram skips the table */
+    if (count == 1) {
+        if (sl_bufpool_acquire(table->pool, msg)) {
+            table->dropped++;
+            return 0;
+        }
+        memcpy(msg->base, data + SL_FRAG_HEADER_SIZE, (size_t)plen);
+        msg->len = (uint32_t)plen;
+        return 1;
+    }
+
+    const uint32_t hash = sl_endpoint_hash(endpoint) ^ ((uint32_t)msg_id * 0x9e3779b1u);
+    sl_fragentry_t *entry = NULL;
+    sl_fragentry_t *empty = NULL;
+    sl_fragentry_t *stale = NULL;
+    for (uint32_t i = 0; i < SL_FRAG_PROBE; i++) {
+        sl_fragentry_t *e = &table->entries[(hash + i) & table->mask];
+        if (!e->buf.base) {
+            if (!empty) empty = e;
+            continue;
+        }
+        if (e->hash == hash && e->msg_id == msg_id && sl_endpoint_equal(&e->endpoint, endpoint)) {
+            entry = e;
+            break;
+        }
+        if (!stale && e->deadline_ns <= now_ns) stale = e;
+    }
+
+    if (!entry) {
+        /* a timed out message in the window gives up its slot before the pool is asked for one */
+        if (stale) {
+            entry = stale;
+            table->expired++;
+        } else if (empty && !sl_bufpool_acquire(table->pool, &empty->buf)) {
+            entry = empty;
+            table->active++;
+        } else {
+            table->dropped++;
+            return 0;
+        }
+        entry->endpoint = *endpoint;
+        entry->deadline_ns = now_ns + (uint64_t)table->timeout_ms * 1000000ULL;
+        memset(entry->received, 0, sizeof(entry->received));
+        entry->hash = hash;
+        entry->len = 0;
+        entry->msg_id = msg_id;
+        entry->count = count;
+        entry->remaining = count;
+        entry->fragsize = fragsize;
+    } else if (entry->count != count || entry->fragsize != fragsize) {
+        goto malformed;
+    }
+
+    const uint64_t bit = 1ULL << (index & 63);
+    if (entry->received[index >> 6] & bit) return 0;
+    entry->received[index >> 6] |= bit;
+
+    memcpy(entry->buf.base + offset, data + SL_FRAG_HEADER_SIZE, (size_t)plen);
+    if (index == count - 1) entry->len = offset + plen;
+    if (--entry->remaining) return 0;
+
+    *msg = entry->buf;
+    msg->len = (uint32_t)entry->len;
+    entry->buf.base = NULL;
+    table->active--;
+
+    return 1;
+
+malformed:
+    table->dropped++;
+    table->error = EINVAL;
+    return SL_ERR;
+}
+
+#endif
@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_IMPAIR_H
+#define SL_IMPAIR_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_impair_t is a seeded, deterministic stand in for a bad network, so protocol behaviour under
+ * latency, jitter, loss, duplication and reordering can be measured without root or tc netem.
+ * Attach one to a socket's sends, receives or both with sl_sock_impair_set, and everything
+ * through the sl_sock_send and sl_sock_recv families goes by way of its delay queue. The same
+ * seed and the same datagrams give the same fate to every datagram, run after run.
+ *
+ * Each datagram is copied into a slot of the queue. It may be lost outright, copied once more,
+ * or let past the datagrams ahead of it, and otherwise waits latency plus up to jitter. Held
+ * datagrams go out, or become readable, on the next send or receive at or after their time, or
+ * on sl_impair_flush. A caller with nothing else to do waits until sl_impair_deadline. An
+ * impaired receive never blocks: it answers would block until something is due, even on a
+ * blocking socket. Leave UDP_GRO off for an impaired receive, a coalesced read counts as one.
+ * Launch times given to sl_sock_send_batch_txtime are kept: a datagram enters the queue at its
+ * launch time rather than at the send, so pacing survives and the latency is counted from there.
+ * An sl_ring_t honours the same impairments on either backend, see ring.h.
+ */
+
+#define SL_IMPAIR_CAPACITY_DEFAULT 1024
+#define SL_IMPAIR_SLOTSIZE_DEFAULT 2048
+#define SL_IMPAIR_PPM 1000000
+
+#if SL_SOCK_API_WINSOCK
+#    define SL_IMPAIR_WOULDBLOCK WSAEWOULDBLOCK
+#else
+#    define SL_IMPAIR_WOULDBLOCK EAGAIN
+#endif
+
+typedef enum sl_impair_state_e {
+    SL_IMPAIR_STATE_NEW,
+    SL_IMPAIR_STATE_STARTED,
+    SL_IMPAIR_STATE_STOPPED,
+} sl_impair_state_t;
+
+typedef struct sl_impair_entry_s {
+    uint64_t due_ns;
+    uint64_t arrival_ns;
+    uint64_t timestamp_ns; /* kernel receive time of an incoming datagram */
+    uint32_t seq;          /* arrival order, equal due times leave in it */
+    uint32_t slot;
+    uint32_t len;
+    uint32_t connected; /* no endpoint, goes to the connected peer */
+    sl_endpoint_t endpoint;
+} sl_impair_entry_t;
+
+/*
+ * set seed, capacity and slotsize before sl_impair_setup. the impairments may change at any time
+ * and apply from the next datagram. chances are in parts per million
+ */
+typedef struct sl_impair_s {
+    uint64_t seed;
+    uint32_t capacity;
+    uint32_t slotsize;
+    uint32_t latency_us;
+    uint32_t jitter_us;
+    uint32_t loss_ppm;
+    uint32_t duplicate_ppm;
+    uint32_t reorder_ppm;
+    uint32_t state;
+    uint32_t error;
+    uint32_t count;
+    uint32_t seq;
+    uint64_t rng;
+    uint64_t lost;
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t overflowed;
+    char *arena;
+    uint32_t *free;
+    sl_impair_entry_t *heap;
+} sl_impair_t;
+
+SL_INLINE_IMPL int sl_impair_cleanup(sl_impair_t *impair)
+{
+    SL_ASSERT(impair);
+    if (impair->state != SL_IMPAIR_STATE_STARTED) return SL_OK;
+
+    sl_sys_aligned_free(impair->arena);
+    free(impair->free);
+    free(impair->heap);
+    impair->arena = NULL;
+    impair->free = NULL;
+    impair->heap = NULL;
+    impair->count = 0;
+    impair->state = SL_IMPAIR_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_impair_setup(sl_impair_t *impair)
+{
+    SL_ASSERT(impair);
+    SL_ASSERT(impair->state != SL_IMPAIR_STATE_STARTED);
+
+    if (!impair->capacity) impair->capacity = SL_IMPAIR_CAPACITY_DEFAULT;
+    if (!impair->slotsize) impair->slotsize = SL_IMPAIR_SLOTSIZE_DEFAULT;
+
+    impair->arena = (char *)sl_sys_aligned_alloc((size_t)impair->capacity * impair->slotsize, SL_SYS_CACHELINE);
+    impair->free = (uint32_t *)malloc(impair->capacity * sizeof(*impair->free));
+    impair->heap = (sl_impair_entry_t *)malloc(impair->capacity * sizeof(*impair->heap));
+    if (!impair->arena || !impair->free || !impair->heap) {
+        sl_sys_aligned_free(impair->arena);
+        free(impair->free);
+        free(impair->heap);
+        impair->arena = NULL;
+        impair->free = NULL;
+        impair->heap = NULL;
+        impair->error = ENOMEM;
+        return SL_ERR;
+    }
+    for (uint32_t i = 0; i < impair->capacity; i++) {
+        impair->free[i] = impair->capacity - 1 - i;
+    }
+    impair->rng = impair->seed;
+    impair->count = 0;
+    impair->seq = 0;
+    impair->lost = impair->duplicated = impair->reordered = impair->overflowed = 0;
+    impair->error = 0;
+    impair->state = SL_IMPAIR_STATE_STARTED;
+
+    return SL_OK;
+}
+
+/* splitmix64, so any seed including 0 gives a full period */
+SL_INLINE_IMPL uint64_t sl_impair_rand(sl_impair_t *impair)
+{
+    uint64_t z = (impair->rng += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+SL_INLINE_IMPL bool sl_impair_roll(sl_impair_t *impair, uint32_t ppm)
+{
+    return ppm && sl_impair_rand(impair) % SL_IMPAIR_PPM < ppm;
+}
+
+SL_INLINE_IMPL char *sl_impair_slot(sl_impair_t *impair, uint32_t slot)
+{
+    return impair->arena + (size_t)slot * impair->slotsize;
+}
+
+SL_INLINE_IMPL bool sl_impair_before(sl_impair_entry_t *a, sl_impair_entry_t *b)
+{
+    /* seq wraps, so compare it by distance */
+    return a->due_ns < b->due_ns || (a->due_ns == b->due_ns && (int32_t)(a->seq - b->seq) < 0);
+}
+
+SL_INLINE_IMPL void sl_impair_push(sl_impair_t *impair, sl_impair_entry_t *entry)
+{
+    uint32_t i = impair->count++;
+    while (i) {
+        uint32_t parent = (i - 1) / 2;
+        if (!sl_impair_before(entry, &impair->heap[parent])) break;
+        impair->heap[i] = impair->heap[parent];
+        i = parent;
+    }
+    impair->heap[i] = *entry;
+}
+
+SL_INLINE_IMPL void sl_impair_pop(sl_impair_t *impair)
+{
+    SL_ASSERT(impair->count);
+    impair->free[impair->capacity - impair->count] = impair->heap[0].slot;
+    sl_impair_entry_t *last = &impair->heap[--impair->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= impair->count) break;
+        if (child + 1 < impair->count && sl_impair_before(&impair->heap[child + 1], &impair->heap[child])) child++;
+        if (!sl_impair_before(&impair->heap[child], last)) break;
+        impair->heap[i] = impair->heap[child];
+        i = child;
+    }
+    impair->heap[i] = *last;
+}
+
+/* a free slot, or UINT32_MAX with the queue full */
+SL_INLINE_IMPL uint32_t sl_impair_acquire(sl_impair_t *impair)
+{
+    if (impair->count == impair->capacity) return UINT32_MAX;
+    return impair->free[impair->capacity - 1 - impair->count];
+}
+
+/* the time a datagram is due, now_ns plus its latency, or now_ns when it jumps the queue */
+SL_INLINE_IMPL uint64_t sl_impair_due(sl_impair_t *impair, uint64_t now_ns)
+{
+    if (sl_impair_roll(impair, impair->reorder_ppm)) {
+        impair->reordered++;
+        return now_ns;
+    }
+    uint64_t delay_ns = (uint64_t)impair->latency_us * 1000ULL;
+    if (impair->jitter_us) delay_ns += sl_impair_rand(impair) % ((uint64_t)impair->jitter_us * 1000ULL + 1);
+    return now_ns + delay_ns;
+}
+
+/*
+ * decides the fate of the datagram filling slot, which sl_impair_acquire handed out. a copy is
+ * made only when the queue has room for it, a lost datagram just leaves the slot free
+ */
+SL_INLINE_IMPL void sl_impair_admit(sl_impair_t *impair, sl_impair_entry_t *entry, uint64_t now_ns)
+{
+    if (sl_impair_roll(impair, impair->loss_ppm)) {
+        impair->lost++;
+        return;
+    }
+
+    const bool duplicate = sl_impair_roll(impair, impair->duplicate_ppm);
+    entry->arrival_ns = now_ns;
+    entry->seq = impair->seq++;
+    entry->due_ns = sl_impair_due(impair, now_ns);
+    sl_impair_push(impair, entry);
+
+    uint32_t slot;
+    if (duplicate && (slot = sl_impair_acquire(impair)) != UINT32_MAX) {
+        memcpy(sl_impair_slot(impair, slot), sl_impair_slot(impair, entry->slot), entry->len);
+        entry->slot = slot;
+        entry->seq = impair->seq++;
+        entry->due_ns = sl_impair_due(impair, now_ns);
+        sl_impair_push(impair, entry);
+        impair->duplicated++;
+    }
+}
+
+/* when the next held datagram is due, UINT64_MAX with none held */
+SL_INLINE_IMPL uint64_t sl_impair_deadline(sl_impair_t *impair)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    return impair->count ? impair->heap[0].due_ns : UINT64_MAX;
+}
+
+/*
+ * sends every held datagram due by now_ns and returns how many went. one the socket would not
+ * take stays for the next call, one it refused outright is dropped
+ */
+SL_INLINE_IMPL int sl_impair_flush(sl_impair_t *impair, sl_sock_t *sock, uint64_t now_ns)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    SL_ASSERT(sock);
+
+    int sent = 0;
+    while (impair->count && impair->heap[0].due_ns <= now_ns) {
+        sl_impair_entry_t *entry = &impair->heap[0];
+        sl_buf_t buf;
+        buf.base = sl_impair_slot(impair, entry->slot);
+        buf.len = entry->len;
+        if (sl_sock_send_direct(sock, &buf, 1, entry->connected ? NULL : &entry->endpoint) < 0) {
+            if (sock->flags & SL_SOCK_FLAG_WOULDBLOCK_WRITE) break;
+        } else {
+            sent++;
+        }
+        sl_impair_pop(impair);
+    }
+
+    return sent;
+}
+
+SL_INLINE_IMPL int sl_impair_enqueue(sl_impair_t *impair, sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t now_ns)
+{
+    size_t len = 0;
+    for (int32_t i = 0; i < bufcount; i++) len += buf[i].len;
+    if (len > impair->slotsize) {
+        sl_sock_error_set(sock, EMSGSIZE);
+        return SL_ERR;
+    }
+
+    /* a full queue is a full router buffer, the datagram is gone but the send went through */
+    sl_impair_entry_t entry;
+    if ((entry.slot = sl_impair_acquire(impair)) == UINT32_MAX) {
+        impair->overflowed++;
+        return (int)len;
+    }
+    char *dst = sl_impair_slot(impair, entry.slot);
+    for (int32_t i = 0; i < bufcount; i++) {
+        memcpy(dst, buf[i].base, buf[i].len);
+        dst += buf[i].len;
+    }
+    entry.len = (uint32_t)len;
+    entry.timestamp_ns = 0;
+    entry.connected = endpoint == NULL;
+    if (endpoint) {
+        entry.endpoint = *endpoint;
+    } else {
+        memset(&entry.endpoint, 0, sizeof(entry.endpoint));
+    }
+    sl_impair_admit(impair, &entry, now_ns);
+
+    return (int)len;
+}
+
+SL_INLINE_IMPL int sl_impair_send(sl_impair_t *impair, sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    SL_ASSERT(sock);
+    SL_ASSERT(buf && bufcount > 0);
+
+    const uint64_t now_ns = sl_sys_time_ns();
+    int len = sl_impair_enqueue(impair, sock, buf, bufcount, endpoint, now_ns);
+    sl_impair_flush(impair, sock, now_ns);
+
+    return len;
+}
+
+/* txtimes are launch times as for sl_sock_send_batch_txtime, ignored without SL_SOCK_FLAG_TXTIME */
+SL_INLINE_IMPL int sl_impair_send_batch(sl_impair_t *impair, sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount, const uint64_t *txtimes)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    SL_ASSERT(sock);
+    SL_ASSERT(msgs && msgcount > 0);
+
+    if (msgcount > SL_SOCK_BATCH_MAX) msgcount = SL_SOCK_BATCH_MAX;
+
+    const uint64_t now_ns = sl_sys_time_ns();
+    if (!(sock->flags & SL_SOCK_FLAG_TXTIME)) txtimes = NULL;
+    int32_t queued = 0;
+    while (queued < msgcount) {
+        const uint64_t start_ns = (txtimes && txtimes[queued] > now_ns) ? txtimes[queued] : now_ns;
+        int len = sl_impair_enqueue(impair, sock, msgs[queued].buf, msgs[queued].bufcount, msgs[queued].endpoint, start_ns);
+        if (len < 0) break;
+        msgs[queued++].len = len;
+    }
+    sl_impair_flush(impair, sock, now_ns);
+    if (!queued) return SL_ERR;
+
+    return (int)queued;
+}
+
+/* moves whatever the kernel holds into the queue, as far as there is room */
+SL_INLINE_IMPL void sl_impair_ingest(sl_impair_t *impair, sl_sock_t *sock, uint64_t now_ns)
+{
+#if SL_SOCK_API_WINSOCK
+    const int flags = 0;
+    /* PLATFORM TODO: winsock can't skip blocking per call, only a non-blocking socket is drained */
+    if (!(sock->flags & SL_SOCK_FLAG_NONBLOCKING)) return;
+#else
+    const int flags = MSG_DONTWAIT;
+#endif
+    sl_impair_entry_t entry;
+    while ((entry.slot = sl_impair_acquire(impair)) != UINT32_MAX) {
+        sl_buf_t buf;
+        buf.base = sl_impair_slot(impair, entry.slot);
+        buf.len = impair->slotsize;
+        int len = sl_sock_recv_direct(sock, &buf, 1, sock->state == SL_SOCK_STATE_OPEN ? NULL : &entry.endpoint, &entry.timestamp_ns, flags);
+        if (len < 0) break;
+        entry.len = (uint32_t)len;
+        entry.connected = sock->state == SL_SOCK_STATE_OPEN;
+        sl_impair_admit(impair, &entry, now_ns);
+    }
+}
+
+/* admits a datagram the caller already took off the socket, cut to slotsize. a full queue drops it */
+SL_INLINE_IMPL void sl_impair_ingest_buf(sl_impair_t *impair, sl_sock_t *sock, sl_buf_t *buf, sl_endpoint_t *endpoint, uint64_t timestamp_ns, uint64_t now_ns)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    SL_ASSERT(sock && buf);
+
+    sl_impair_entry_t entry;
+    if ((entry.slot = sl_impair_acquire(impair)) == UINT32_MAX) {
+        impair->overflowed++;
+        return;
+    }
+    entry.len = buf->len < impair->slotsize ? (uint32_t)buf->len : impair->slotsize;
+    memcpy(sl_impair_slot(impair, entry.slot), buf->base, entry.len);
+    entry.timestamp_ns = timestamp_ns;
+    entry.connected = sock->state == SL_SOCK_STATE_OPEN;
+    if (endpoint && !entry.connected) {
+        entry.endpoint = *endpoint;
+    } else {
+        memset(&entry.endpoint, 0, sizeof(entry.endpoint));
+    }
+    sl_impair_admit(impair, &entry, now_ns);
+}
+
+/* hands over the first held datagram if it is due by now_ns, SL_ERR when none is */
+SL_INLINE_IMPL int sl_impair_pop_due(sl_impair_t *impair, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns, uint64_t now_ns)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    SL_ASSERT(buf && bufcount > 0);
+
+    if (!impair->count || impair->heap[0].due_ns > now_ns) return SL_ERR;
+
+    /* scatter like recvmsg, anything past the caller's buffers is cut off */
+    sl_impair_entry_t *entry = &impair->heap[0];
+    const char *src = sl_impair_slot(impair, entry->slot);
+    size_t remaining = entry->len;
+    for (int32_t i = 0; i < bufcount && remaining; i++) {
+        size_t len = remaining < buf[i].len ? remaining : buf[i].len;
+        memcpy(buf[i].base, src, len);
+        src += len;
+        remaining -= len;
+    }
+    if (endpoint && !entry->connected) *endpoint = entry->endpoint;
+    if (timestamp_ns) *timestamp_ns = entry->timestamp_ns ? entry->timestamp_ns + (now_ns - entry->arrival_ns) : 0;
+    const int len = (int)(entry->len - remaining);
+    sl_impair_pop(impair);
+
+    return len;
+}
+
+SL_INLINE_IMPL int sl_impair_recv(sl_impair_t *impair, sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns)
+{
+    SL_ASSERT(impair && impair->state == SL_IMPAIR_STATE_STARTED);
+    SL_ASSERT(sock);
+    SL_ASSERT(buf && bufcount > 0);
+
+    const uint64_t now_ns = sl_sys_time_ns();
+    sl_impair_ingest(impair, sock, now_ns);
+
+    int len = sl_impair_pop_due(impair, buf, bufcount, endpoint, timestamp_ns, now_ns);
+    if (len < 0) {
+        sl_sock_error_set(sock, SL_IMPAIR_WOULDBLOCK);
+        sl_sock_stats_error(sock, SL_IMPAIR_WOULDBLOCK, SL_SOCK_FLAG_WOULDBLOCK_READ);
+        sl_sock_flags_set(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+        return SL_ERR;
+    }
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    return len;
+}
+
+SL_INLINE_IMPL int sl_impair_recv_batch(sl_impair_t *impair, sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount)
+{
+    SL_ASSERT(msgs && msgcount > 0);
+
+    if (msgcount > SL_SOCK_BATCH_MAX) msgcount = SL_SOCK_BATCH_MAX;
+
+    int32_t msgs_recv = 0;
+    while (msgs_recv < msgcount) {
+        sl_msg_t *msg = &msgs[msgs_recv];
+        int len = sl_impair_recv(impair, sock, msg->buf, msg->bufcount, msg->endpoint, &msg->timestamp_ns);
+        if (len < 0) break;
+        msg->len = len;
+        msg->segsize = len;
+        msgs_recv++;
+    }
+    if (!msgs_recv) return SL_ERR;
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    return (int)msgs_recv;
+}
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_IOTHREAD_H
+#define SL_IOTHREAD_H
+
+#include "socklynx/bufpool.h"
+#include "socklynx/common.h"
+#include "socklynx/error.h"
+#include "socklynx/poller.h"
+#include "socklynx/sock.h"
+#include "socklynx/spsc.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_iothread_t moves one socket's syscalls onto a background thread. The thread drains the
+ * socket into the rx ring and the tx ring out to the socket, so the owning (game) thread only
+ * ever touches shared memory. Every packet buffer is a slot from the pool:
+ *
+ *   rx   io -> owner  received datagrams, hand each buffer back through done once read
+ *   done owner -> io  consumed buffers for the io thread to recycle
+ *   free io -> owner  empty buffers kept topped up for the owner to fill and send
+ *   tx   owner -> io  datagrams to send, the io thread recycles each buffer once sent
+ *
+ * The rings come first so managed code can map them without mirroring the rest of the struct.
+ * Buffers the owner still holds when the thread stops are not returned to the pool.
+ */
+
+#define SL_IOTHREAD_CAPACITY_DEFAULT 256
+#define SL_IOTHREAD_WAIT_MS_DEFAULT 1
+
+typedef enum sl_iothread_state_e {
+    SL_IOTHREAD_STATE_NEW,
+    SL_IOTHREAD_STATE_STARTED,
+    SL_IOTHREAD_STATE_STOPPED,
+} sl_iothread_state_t;
+
+/* set sock (bound), pool (started) and optionally capacity and wait_ms before sl_iothread_start */
+typedef struct sl_iothread_s {
+    sl_spsc_t rx;
+    sl_spsc_t done;
+    sl_spsc_t free;
+    sl_spsc_t tx;
+    sl_sock_t *sock;
+    sl_bufpool_t *pool;
+    uint32_t capacity;
+    int32_t wait_ms;
+    uint32_t state;
+    uint32_t error;
+    volatile uint32_t running;
+    uint32_t reserved;
+    volatile uint64_t rx_packets;
+    volatile uint64_t tx_packets;
+    volatile uint64_t rx_stalls;
+    volatile uint64_t tx_errors;
+    sl_packet_t *entries;
+    sl_bufcache_t cache;
+    sl_poller_t poller;
+    sl_sys_thread_t thread;
+} sl_iothread_t;
+
+SL_INLINE_IMPL void sl_iothread_recycle_ring(sl_iothread_t *io, sl_spsc_t *ring)
+{
+    sl_packet_t packet;
+    while (!sl_spsc_pop(ring, &packet)) {
+        sl_bufcache_release(&io->cache, &packet.buf);
+    }
+}
+
+/* returns true when any datagram went out */
+SL_INLINE_IMPL bool sl_iothread_pump_tx(sl_iothread_t *io)
+{
+    sl_packet_t *packets[SL_SOCK_BATCH_MAX];
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+
+    uint32_t count = sl_spsc_peek(&io->tx, packets, SL_SOCK_BATCH_MAX);
+    if (!count) return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        bufs[i].base = packets[i]->buf.base;
+        bufs[i].len = (packets[i]->len > 0) ? (size_t)packets[i]->len : 0;
+        msgs[i].buf = &bufs[i];
+        msgs[i].bufcount = 1;
+        msgs[i].endpoint = &packets[i]->endpoint;
+        msgs[i].len = 0;
+        msgs[i].segsize = 0;
+    }
+
+    int sent = sl_sock_send_batch(io->sock, msgs, (int32_t)count);
+    if (sent < 0) {
+        if (io->sock->flags & SL_SOCK_FLAG_WOULDBLOCK_WRITE) return false;
+        /* an unsendable datagram at the head would wedge the ring, drop it */
+        io->tx_errors++;
+        sent = 1;
+    } else {
+        io->tx_packets += (uint64_t)sent;
+    }
+
+    for (int i = 0; i < sent; i++) {
+        sl_bufcache_release(&io->cache, &packets[i]->buf);
+    }
+    sl_spsc_consume(&io->tx, (uint32_t)sent);
+
+    return true;
+}
+
+/* returns true when any datagram was queued to the owner */
+SL_INLINE_IMPL bool sl_iothread_pump_rx(sl_iothread_t *io)
+{
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_endpoint_t endpoints[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+
+    uint32_t space = sl_spsc_space(&io->rx);
+    if (!space) {
+        /* the owner has fallen behind, leave datagrams queued in the kernel */
+        io->rx_stalls++;
+        return false;
+    }
+    if (space > SL_SOCK_BATCH_MAX) space = SL_SOCK_BATCH_MAX;
+
+    int32_t count = 0;
+    for (; count < (int32_t)space; count++) {
+        if (sl_bufcache_acquire(&io->cache, &bufs[count])) break;
+        msgs[count].buf = &bufs[count];
+        msgs[count].bufcount = 1;
+        msgs[count].endpoint = &endpoints[count];
+        msgs[count].len = 0;
+        msgs[count].segsize = 0;
+    }
+    if (!count) return false;
+
+    int recvd = sl_sock_recv_batch(io->sock, msgs, count);
+    for (int32_t i = 0; i < count; i++) {
+        if (i >= recvd) {
+            sl_bufcache_release(&io->cache, &bufs[i]);
+            continue;
+        }
+        sl_packet_t packet;
+        packet.buf = bufs[i];
+        packet.endpoint = endpoints[i];
+        packet.len = msgs[i].len;
+        sl_spsc_push(&io->rx, &packet);
+    }
+    if (recvd <= 0) return false;
+    io->rx_packets += (uint64_t)recvd;
+
+    return true;
+}
+
+SL_INLINE_IMPL void sl_iothread_run(void *arg)
+{
+    sl_iothread_t *io = (sl_iothread_t *)arg;
+    sl_poll_event_t event;
+
+    while (sl_sys_atomic_load32(&io->running)) {
+        sl_iothread_recycle_ring(io, &io->done);
+
+        uint32_t space = sl_spsc_space(&io->free);
+        while (space--) {
+            sl_packet_t packet = {0};
+            if (sl_bufcache_acquire(&io->cache, &packet.buf)) break;
+            sl_spsc_push(&io->free, &packet);
+        }
+
+        bool busy = false;
+        if (!(io->sock->flags & SL_SOCK_FLAG_WOULDBLOCK_WRITE)) busy |= sl_iothread_pump_tx(io);
+        busy |= sl_iothread_pump_rx(io);
+
+        /* when busy only peek for readiness, a blocked write has no other way to be cleared */
+        if (!busy || (io->sock->flags & SL_SOCK_FLAG_WOULDBLOCK_WRITE)) {
+            if (sl_poller_wait(&io->poller, &event, 1, busy ? 0 : io->wait_ms) < 0) {
+                io->error = io->poller.error;
+                break;
+            }
+        }
+    }
+}
+
+SL_INLINE_IMPL int sl_iothread_stop(sl_iothread_t *io)
+{
+    SL_ASSERT(io);
+    if (io->state != SL_IOTHREAD_STATE_STARTED) return SL_OK;
+
+    sl_sys_atomic_store32(&io->running, 0);
+    SL_GUARD(sl_sys_thread_join(&io->thread));
+
+    /* the thread is gone, so this side may act as consumer of every ring */
+    sl_iothread_recycle_ring(io, &io->rx);
+    sl_iothread_recycle_ring(io, &io->done);
+    sl_iothread_recycle_ring(io, &io->free);
+    sl_iothread_recycle_ring(io, &io->tx);
+    sl_bufcache_flush(&io->cache);
+
+    sl_poller_cleanup(&io->poller);
+    free(io->entries);
+    io->entries = NULL;
+    io->state = SL_IOTHREAD_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_iothread_start(sl_iothread_t *io)
+{
+    SL_ASSERT(io);
+    SL_ASSERT(io->state != SL_IOTHREAD_STATE_STARTED);
+    SL_ASSERT(io->sock && sl_sock_is_ready(io->sock));
+    SL_ASSERT(io->pool && io->pool->state == SL_BUFPOOL_STATE_STARTED);
+
+    if (!io->capacity) io->capacity = SL_IOTHREAD_CAPACITY_DEFAULT;
+    if (!io->wait_ms) io->wait_ms = SL_IOTHREAD_WAIT_MS_DEFAULT;
+    SL_GUARD(io->capacity & (io->capacity - 1));
+
+    io->entries = (sl_packet_t *)calloc(4 * (size_t)io->capacity, sizeof(*io->entries));
+    SL_GUARD_NULL(io->entries);
+    sl_spsc_init(&io->rx, io->entries, io->capacity);
+    sl_spsc_init(&io->done, io->entries + io->capacity, io->capacity);
+    sl_spsc_init(&io->free, io->entries + 2 * (size_t)io->capacity, io->capacity);
+    sl_spsc_init(&io->tx, io->entries + 3 * (size_t)io->capacity, io->capacity);
+    sl_bufcache_init(&io->cache, io->pool);
+    io->rx_packets = 0;
+    io->tx_packets = 0;
+    io->rx_stalls = 0;
+    io->tx_errors = 0;
+    io->error = 0;
+
+    memset(&io->poller, 0, sizeof(io->poller));
+    io->poller.capacity = 1;
+    if (sl_sock_nonblocking_set(io->sock) || sl_poller_setup(&io->poller)) goto cleanup;
+    if (sl_poller_add(&io->poller, io->sock, SL_POLL_EVENT_READ | SL_POLL_EVENT_WRITE)) goto cleanup;
+
+    io->running = 1;
+    if (sl_sys_thread_start(&io->thread, sl_iothread_run, io)) goto cleanup;
+    io->state = SL_IOTHREAD_STATE_STARTED;
+
+    return SL_OK;
+
+cleanup:
+    io->error = io->sock->error ? io->sock->error : io->poller.error;
+    sl_poller_cleanup(&io->poller);
+    free(io->entries);
+    io->entries = NULL;
+    return SL_ERR;
+}
+
+/* owner side: next received datagram, hand its buffer back with sl_iothread_recycle */
+SL_INLINE_IMPL int sl_iothread_recv(sl_iothread_t *io, sl_packet_t *packet)
+{
+    return sl_spsc_pop(&io->rx, packet);
+}
+
+SL_INLINE_IMPL int sl_iothread_recycle(sl_iothread_t *io, sl_packet_t *packet)
+{
+    return sl_spsc_push(&io->done, packet);
+}
+
+/* owner side: an empty buffer to fill, then set len and endpoint and pass to sl_iothread_send */
+SL_INLINE_IMPL int sl_iothread_buf_get(sl_iothread_t *io, sl_packet_t *packet)
+{
+    return sl_spsc_pop(&io->free, packet);
+}
+
+SL_INLINE_IMPL int sl_iothread_send(sl_iothread_t *io, sl_packet_t *packet)
+{
+    SL_ASSERT(packet->len >= 0 && (size_t)packet->len <= (size_t)packet->buf.len);
+    return sl_spsc_push(&io->tx, packet);
+}
+
+#endif
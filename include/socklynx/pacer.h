@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_PACER_H
+#define SL_PACER_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_pacer_t spreads one peer's datagrams out to a target rate so a snapshot fan out leaves as
+ * a steady stream rather than a burst. It is a token bucket kept as a departure clock: each
+ * datagram moves the clock on by its time on the wire, and after a quiet spell the clock may
+ * trail now by up to a burst's worth, which is the bucket depth.
+ *
+ * On a socket with SL_SOCK_FLAG_TXTIME, sl_pacer_send_batch stamps each datagram with its
+ * departure time and the qdisc releases it then. Otherwise it sends only what is due and leaves
+ * the rest with the caller, who retries at sl_pacer_deadline, for example from a sl_timer_t.
+ * For a socket per peer, sl_sock_pacing_rate_set gets the same from the fq qdisc instead.
+ */
+
+#define SL_PACER_BURST_DEFAULT (4 * 1200)
+/* ipv4 and udp headers, counted against the rate with each datagram */
+#define SL_PACER_OVERHEAD 28
+/* how far ahead launch times may run on a SL_SOCK_FLAG_TXTIME socket, beyond it datagrams wait for a later call */
+#define SL_PACER_HORIZON_NS 100000000ULL
+
+typedef struct sl_pacer_s {
+    uint64_t rate; /* bytes per second, 0 sends unpaced */
+    uint64_t burst_ns;
+    uint64_t next_ns;
+} sl_pacer_t;
+
+/* burst is in bytes, 0 for SL_PACER_BURST_DEFAULT */
+SL_INLINE_IMPL void sl_pacer_init(sl_pacer_t *pacer, uint64_t rate, uint32_t burst)
+{
+    SL_ASSERT(pacer);
+    if (!burst) burst = SL_PACER_BURST_DEFAULT;
+    pacer->rate = rate;
+    pacer->burst_ns = rate ? (uint64_t)burst * 1000000000ULL / rate : 0;
+    pacer->next_ns = 0;
+}
+
+SL_INLINE_IMPL uint64_t sl_pacer_msg_bytes(sl_msg_t *msg)
+{
+    uint64_t bytes = SL_PACER_OVERHEAD;
+    for (int32_t i = 0; i < msg->bufcount; i++) bytes += msg->buf[i].len;
+    return bytes;
+}
+
+/* the time a datagram of bytes leaves, moving the departure clock past it */
+SL_INLINE_IMPL uint64_t sl_pacer_launch(sl_pacer_t *pacer, uint64_t bytes, uint64_t now_ns)
+{
+    SL_ASSERT(pacer);
+    if (!pacer->rate) return now_ns;
+
+    if (pacer->next_ns + pacer->burst_ns < now_ns) pacer->next_ns = now_ns - pacer->burst_ns;
+    const uint64_t launch_ns = pacer->next_ns > now_ns ? pacer->next_ns : now_ns;
+    pacer->next_ns += bytes * 1000000000ULL / pacer->rate;
+
+    return launch_ns;
+}
+
+/* when the next datagram may leave, at or before now_ns when one may leave straight away */
+SL_INLINE_IMPL uint64_t sl_pacer_deadline(sl_pacer_t *pacer)
+{
+    SL_ASSERT(pacer);
+    return pacer->next_ns;
+}
+
+/*
+ * sends from the front of msgs what the pacer allows at now_ns and returns how many went, 0 when
+ * none are due yet. a short count is not an error, the caller resumes from msgs + count later
+ */
+SL_INLINE_IMPL int sl_pacer_send_batch(sl_pacer_t *pacer, sl_sock_t *sock, sl_msg_t *msgs, int32_t count, uint64_t now_ns)
+{
+    SL_ASSERT(pacer);
+    SL_ASSERT(sock);
+    SL_ASSERT(msgs && count > 0);
+
+    if (count > SL_SOCK_BATCH_MAX) count = SL_SOCK_BATCH_MAX;
+
+    uint64_t launches[SL_SOCK_BATCH_MAX];
+    uint64_t clocks[SL_SOCK_BATCH_MAX];
+    const uint64_t horizon_ns = now_ns + ((sock->flags & SL_SOCK_FLAG_TXTIME) ? SL_PACER_HORIZON_NS : 0);
+    int32_t due = 0;
+    while (due < count && (!pacer->rate || pacer->next_ns <= horizon_ns)) {
+        clocks[due] = pacer->next_ns;
+        launches[due] = sl_pacer_launch(pacer, sl_pacer_msg_bytes(&msgs[due]), now_ns);
+        due++;
+    }
+    if (!due) return 0;
+
+    /* whatever the socket did not take gives its time back */
+    int sent = sl_sock_send_batch_txtime(sock, msgs, due, launches);
+    if (sent < due) pacer->next_ns = clocks[sent < 0 ? 0 : sent];
+
+    return sent;
+}
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_PEERTABLE_H
+#define SL_PEERTABLE_H
+
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_peertable_t maps a remote sl_endpoint_t to a fixed size per peer slot. The index is a
+ * dense open addressing array of {hash, slot} pairs, linear probed and kept at most half
+ * full, so a miss or a hit usually costs one cache line and only a matching hash touches the
+ * stored endpoint. Removal shifts the probe run back instead of leaving tombstones.
+ * Peer slots live in their own cache line aligned arena and never move, so a handle stays
+ * valid until that peer is removed. A handle carries the slot index in its low 24 bits and a
+ * generation in its high 8, so a handle kept past removal is rejected rather than aliasing
+ * the next peer to land in the slot, at least until the generation wraps.
+ */
+
+#define SL_PEERTABLE_HANDLE_NONE 0
+#define SL_PEERTABLE_INDEX_BITS 24
+#define SL_PEERTABLE_INDEX_MASK ((1u << SL_PEERTABLE_INDEX_BITS) - 1)
+#define SL_PEERTABLE_CAPACITY_MAX SL_PEERTABLE_INDEX_MASK
+#define SL_PEERTABLE_EMPTY UINT32_MAX
+
+typedef enum sl_peertable_state_e {
+    SL_PEERTABLE_STATE_NEW,
+    SL_PEERTABLE_STATE_STARTED,
+    SL_PEERTABLE_STATE_STOPPED,
+} sl_peertable_state_t;
+
+typedef struct sl_peertable_entry_s {
+    uint32_t hash;
+    uint32_t slot;
+} sl_peertable_entry_t;
+
+/* set capacity, and optionally slotsize, before sl_peertable_setup */
+typedef struct sl_peertable_s {
+    uint32_t capacity;
+    uint32_t slotsize;
+    uint32_t state;
+    uint32_t error;
+    uint32_t count;
+    uint32_t mask;
+    sl_peertable_entry_t *index;
+    sl_endpoint_t *endpoints;
+    uint8_t *gens;
+    char *slots;
+    uint32_t *free;
+    uint32_t free_count;
+} sl_peertable_t;
+
+SL_INLINE_IMPL void sl_peertable_free(sl_peertable_t *table)
+{
+    sl_sys_aligned_free(table->index);
+    sl_sys_aligned_free(table->slots);
+    free(table->endpoints);
+    free(table->gens);
+    free(table->free);
+    table->index = NULL;
+    table->slots = NULL;
+    table->endpoints = NULL;
+    table->gens = NULL;
+    table->free = NULL;
+}
+
+SL_INLINE_IMPL int sl_peertable_cleanup(sl_peertable_t *table)
+{
+    SL_ASSERT(table);
+    if (table->state != SL_PEERTABLE_STATE_STARTED) return SL_OK;
+
+    sl_peertable_free(table);
+    table->count = 0;
+    table->free_count = 0;
+    table->state = SL_PEERTABLE_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_peertable_setup(sl_peertable_t *table)
+{
+    SL_ASSERT(table);
+    SL_ASSERT(table->state != SL_PEERTABLE_STATE_STARTED);
+    SL_GUARD(!table->capacity || table->capacity > SL_PEERTABLE_CAPACITY_MAX);
+
+    table->slotsize = (table->slotsize + SL_SYS_CACHELINE - 1) & ~(uint32_t)(SL_SYS_CACHELINE - 1);
+
+    uint32_t size = 16;
+    while (size < table->capacity * 2) size <<= 1;
+    table->mask = size - 1;
+
+    table->index = (sl_peertable_entry_t *)sl_sys_aligned_alloc(size * sizeof(*table->index), SL_SYS_CACHELINE);
+    table->endpoints = (sl_endpoint_t *)malloc(table->capacity * sizeof(*table->endpoints));
+    table->gens = (uint8_t *)malloc(table->capacity * sizeof(*table->gens));
+    table->free = (uint32_t *)malloc(table->capacity * sizeof(*table->free));
+    table->slots = NULL;
+    if (table->slotsize) {
+        table->slots = (char *)sl_sys_aligned_alloc((size_t)table->slotsize * table->capacity, SL_SYS_CACHELINE);
+    }
+    if (!table->index || !table->endpoints || !table->gens || !table->free || (table->slotsize && !table->slots)) {
+        sl_peertable_free(table);
+        table->error = ENOMEM;
+        return SL_ERR;
+    }
+
+    /* an all ones entry is SL_PEERTABLE_EMPTY in both fields */
+    memset(table->index, 0xff, size * sizeof(*table->index));
+    memset(table->gens, 1, table->capacity * sizeof(*table->gens));
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        table->free[i] = table->capacity - 1 - i;
+    }
+    table->free_count = table->capacity;
+    table->count = 0;
+    table->error = 0;
+    table->state = SL_PEERTABLE_STATE_STARTED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL uint32_t sl_peertable_handle(sl_peertable_t *table, uint32_t slot)
+{
+    return ((uint32_t)table->gens[slot] << SL_PEERTABLE_INDEX_BITS) | slot;
+}
+
+/* slot index of a live handle, SL_PEERTABLE_EMPTY for a stale or invalid one */
+SL_INLINE_IMPL uint32_t sl_peertable_handle_slot(sl_peertable_t *table, uint32_t handle)
+{
+    uint32_t slot = handle & SL_PEERTABLE_INDEX_MASK;
+    if (slot >= table->capacity || table->gens[slot] != (uint8_t)(handle >> SL_PEERTABLE_INDEX_BITS)) {
+        return SL_PEERTABLE_EMPTY;
+    }
+    return slot;
+}
+
+/* index position holding endpoint, or the empty position that ends its probe run */
+SL_INLINE_IMPL uint32_t sl_peertable_probe(sl_peertable_t *table, sl_endpoint_t *endpoint, uint32_t hash)
+{
+    uint32_t i = hash & table->mask;
+    for (;;) {
+        sl_peertable_entry_t *entry = &table->index[i];
+        if (entry->slot == SL_PEERTABLE_EMPTY) return i;
+        if (entry->hash == hash && sl_endpoint_equal(&table->endpoints[entry->slot], endpoint)) return i;
+        i = (i + 1) & table->mask;
+    }
+}
+
+SL_INLINE_IMPL uint32_t sl_peertable_find_hashed(sl_peertable_t *table, sl_endpoint_t *endpoint, uint32_t hash)
+{
+    uint32_t slot = table->index[sl_peertable_probe(table, endpoint, hash)].slot;
+    if (slot == SL_PEERTABLE_EMPTY) return SL_PEERTABLE_HANDLE_NONE;
+    return sl_peertable_handle(table, slot);
+}
+
+/* handle of the peer at endpoint, SL_PEERTABLE_HANDLE_NONE when it is not in the table */
+SL_INLINE_IMPL uint32_t sl_peertable_find(sl_peertable_t *table, sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(table && table->state == SL_PEERTABLE_STATE_STARTED);
+    SL_ASSERT(endpoint);
+
+    return sl_peertable_find_hashed(table, endpoint, sl_endpoint_hash(endpoint));
+}
+
+/*
+ * adds the peer at endpoint with a zeroed slot. when the peer is already present the error is
+ * EEXIST and handle is still set to it, so this doubles as a find or add. ENOSPC when full
+ */
+SL_INLINE_IMPL int sl_peertable_insert(sl_peertable_t *table, sl_endpoint_t *endpoint, uint32_t *handle)
+{
+    SL_ASSERT(table && table->state == SL_PEERTABLE_STATE_STARTED);
+    SL_ASSERT(endpoint && handle);
+
+    uint32_t hash = sl_endpoint_hash(endpoint);
+    uint32_t i = sl_peertable_probe(table, endpoint, hash);
+    sl_peertable_entry_t *entry = &table->index[i];
+    if (entry->slot != SL_PEERTABLE_EMPTY) {
+        *handle = sl_peertable_handle(table, entry->slot);
+        table->error = EEXIST;
+        return SL_ERR;
+    }
+    if (!table->free_count) {
+        *handle = SL_PEERTABLE_HANDLE_NONE;
+        table->error = ENOSPC;
+        return SL_ERR;
+    }
+
+    uint32_t slot = table->free[--table->free_count];
+    table->endpoints[slot] = *endpoint;
+    if (table->slotsize) memset(table->slots + (size_t)slot * table->slotsize, 0, table->slotsize);
+    entry->hash = hash;
+    entry->slot = slot;
+    table->count++;
+    *handle = sl_peertable_handle(table, slot);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_peertable_remove(sl_peertable_t *table, uint32_t handle)
+{
+    SL_ASSERT(table && table->state == SL_PEERTABLE_STATE_STARTED);
+
+    uint32_t slot = sl_peertable_handle_slot(table, handle);
+    if (slot == SL_PEERTABLE_EMPTY) {
+        table->error = ENOENT;
+        return SL_ERR;
+    }
+
+    sl_endpoint_t *endpoint = &table->endpoints[slot];
+    uint32_t i = sl_peertable_probe(table, endpoint, sl_endpoint_hash(endpoint));
+    SL_ASSERT(table->index[i].slot == slot);
+
+    /* pull later entries of the run back over the hole unless that would put them before their home */
+    for (uint32_t j = i;;) {
+        j = (j + 1) & table->mask;
+        if (table->index[j].slot == SL_PEERTABLE_EMPTY) break;
+        uint32_t home = table->index[j].hash & table->mask;
+        if (((j - home) & table->mask) >= ((j - i) & table->mask)) {
+            table->index[i] = table->index[j];
+            i = j;
+        }
+    }
+    table->index[i].slot = SL_PEERTABLE_EMPTY;
+    table->index[i].hash = SL_PEERTABLE_EMPTY;
+
+    if (!++table->gens[slot]) table->gens[slot] = 1;
+    table->free[table->free_count++] = slot;
+    table->count--;
+
+    return SL_OK;
+}
+
+/* the peer's slotsize bytes, NULL for a stale handle or a table without slots */
+SL_INLINE_IMPL void *sl_peertable_slot(sl_peertable_t *table, uint32_t handle)
+{
+    SL_ASSERT(table && table->state == SL_PEERTABLE_STATE_STARTED);
+
+    uint32_t slot = sl_peertable_handle_slot(table, handle);
+    if (slot == SL_PEERTABLE_EMPTY || !table->slotsize) return NULL;
+    return table->slots + (size_t)slot * table->slotsize;
+}
+
+SL_INLINE_IMPL sl_endpoint_t *sl_peertable_endpoint(sl_peertable_t *table, uint32_t handle)
+{
+    SL_ASSERT(table && table->state == SL_PEERTABLE_STATE_STARTED);
+
+    uint32_t slot = sl_peertable_handle_slot(table, handle);
+    if (slot == SL_PEERTABLE_EMPTY) return NULL;
+    return &table->endpoints[slot];
+}
+
+/*
+ * finds the sender of each message of a recv batch, handles[i] is SL_PEERTABLE_HANDLE_NONE
+ * for unknown senders. every hash is taken and its index line prefetched before the first
+ * probe, so the misses of a large table overlap instead of stalling one after another.
+ * returns how many were found
+ */
+SL_INLINE_IMPL int32_t sl_peertable_find_batch(sl_peertable_t *table, sl_msg_t *msgs, int32_t count, uint32_t *handles)
+{
+    SL_ASSERT(table && table->state == SL_PEERTABLE_STATE_STARTED);
+    SL_ASSERT(msgs && handles);
+
+    uint32_t hashes[SL_SOCK_BATCH_MAX];
+    int32_t found = 0;
+    for (int32_t base = 0; base < count; base += SL_SOCK_BATCH_MAX) {
+        int32_t n = count - base < SL_SOCK_BATCH_MAX ? count - base : SL_SOCK_BATCH_MAX;
+        for (int32_t i = 0; i < n; i++) {
+            hashes[i] = sl_endpoint_hash(msgs[base + i].endpoint);
+            sl_sys_prefetch(&table->index[hashes[i] & table->mask]);
+        }
+        for (int32_t i = 0; i < n; i++) {
+            handles[base + i] = sl_peertable_find_hashed(table, msgs[base + i].endpoint, hashes[i]);
+            if (handles[base + i] != SL_PEERTABLE_HANDLE_NONE) found++;
+        }
+    }
+
+    return found;
+}
+
+#endif
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_POLLER_H
+#define SL_POLLER_H
+
+#include "socklynx/common.h"
+#include "socklynx/error.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+#if SL_PLATFORM_LINUX
+#    include <sys/epoll.h>
+#endif
+
+/*
+ * sl_poller_t waits on any number of sockets at once. On Linux it is edge triggered
+ * epoll: a readiness event clears the matching SL_SOCK_FLAG_WOULDBLOCK_* flag and is
+ * not repeated until the socket has been drained to would block again. Other platforms
+ * poll level triggered and only ask for writability while a socket is flagged as
+ * blocked on write, which gives callers the same drain-until-flagged loop
+ */
+
+typedef enum sl_poller_state_e {
+    SL_POLLER_STATE_NEW,
+    SL_POLLER_STATE_STARTED,
+    SL_POLLER_STATE_STOPPED,
+} sl_poller_state_t;
+
+typedef enum sl_poll_event_flag_e {
+    SL_POLL_EVENT_READ = (1 << 0),
+    SL_POLL_EVENT_WRITE = (1 << 1),
+    SL_POLL_EVENT_ERROR = (1 << 2),
+} sl_poll_event_flag_t;
+
+typedef struct sl_poll_event_s {
+    sl_sock_t *sock;
+    uint32_t events;
+} sl_poll_event_t;
+
+/* set capacity (max registered sockets) before sl_poller_setup */
+typedef struct sl_poller_s {
+    int64_t fd;
+    uint32_t state;
+    uint32_t error;
+    uint32_t capacity;
+    uint32_t count;
+    SL_SYS_POLLFD *pollfds;
+    sl_sock_t **socks;
+    uint32_t *interests;
+} sl_poller_t;
+
+SL_INLINE_IMPL int sl_poller_cleanup(sl_poller_t *poller)
+{
+    SL_ASSERT(poller);
+    if (poller->state != SL_POLLER_STATE_STARTED) return SL_OK;
+
+#if SL_PLATFORM_LINUX
+    if (close((int)poller->fd)) {
+        poller->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+#endif
+    free(poller->pollfds);
+    free(poller->socks);
+    free(poller->interests);
+    poller->pollfds = NULL;
+    poller->socks = NULL;
+    poller->interests = NULL;
+    poller->fd = 0;
+    poller->count = 0;
+    poller->state = SL_POLLER_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_poller_setup(sl_poller_t *poller)
+{
+    SL_ASSERT(poller);
+    SL_ASSERT(poller->state != SL_POLLER_STATE_STARTED);
+    SL_GUARD(!poller->capacity);
+
+    poller->count = 0;
+    poller->fd = 0;
+    poller->socks = (sl_sock_t **)calloc(poller->capacity, sizeof(*poller->socks));
+    poller->pollfds = (SL_SYS_POLLFD *)calloc(poller->capacity, sizeof(*poller->pollfds));
+    poller->interests = (uint32_t *)calloc(poller->capacity, sizeof(*poller->interests));
+    poller->error = ENOMEM;
+    SL_GUARD_CLEANUP(!poller->socks || !poller->pollfds || !poller->interests);
+
+#if SL_PLATFORM_LINUX
+    int fd;
+    if ((fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        poller->error = (uint32_t)sl_sys_errno();
+        goto cleanup;
+    }
+    poller->fd = fd;
+#endif
+    poller->error = 0;
+    poller->state = SL_POLLER_STATE_STARTED;
+
+    return SL_OK;
+
+cleanup:
+    free(poller->socks);
+    free(poller->pollfds);
+    free(poller->interests);
+    poller->socks = NULL;
+    poller->pollfds = NULL;
+    poller->interests = NULL;
+    return SL_ERR;
+}
+
+SL_INLINE_IMPL int sl_poller_add(sl_poller_t *poller, sl_sock_t *sock, uint32_t events)
+{
+    SL_ASSERT(poller && poller->state == SL_POLLER_STATE_STARTED);
+    SL_ASSERT(sock);
+
+    if (poller->count == poller->capacity) {
+        poller->error = ENOSPC;
+        return SL_ERR;
+    }
+
+#if SL_PLATFORM_LINUX
+    struct epoll_event ev;
+    ev.events = EPOLLET;
+    if (events & SL_POLL_EVENT_READ) ev.events |= EPOLLIN;
+    if (events & SL_POLL_EVENT_WRITE) ev.events |= EPOLLOUT;
+    ev.data.ptr = sock;
+    if (epoll_ctl((int)poller->fd, EPOLL_CTL_ADD, sl_sock_fd_get(sock), &ev)) {
+        poller->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+#endif
+
+    SL_SYS_POLLFD *pfd = &poller->pollfds[poller->count];
+    pfd->fd = sl_sock_fd_get(sock);
+    pfd->events = (events & SL_POLL_EVENT_READ) ? POLLIN : 0;
+    pfd->revents = 0;
+    poller->interests[poller->count] = events;
+    poller->socks[poller->count++] = sock;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_poller_remove(sl_poller_t *poller, sl_sock_t *sock)
+{
+    SL_ASSERT(poller && poller->state == SL_POLLER_STATE_STARTED);
+    SL_ASSERT(sock);
+
+    uint32_t idx;
+    for (idx = 0; idx < poller->count; idx++) {
+        if (poller->socks[idx] == sock) break;
+    }
+    if (idx == poller->count) {
+        poller->error = ENOENT;
+        return SL_ERR;
+    }
+
+#if SL_PLATFORM_LINUX
+    struct epoll_event ev = {0};
+    if (epoll_ctl((int)poller->fd, EPOLL_CTL_DEL, sl_sock_fd_get(sock), &ev)) {
+        poller->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+#endif
+
+    poller->count--;
+    poller->socks[idx] = poller->socks[poller->count];
+    poller->pollfds[idx] = poller->pollfds[poller->count];
+    poller->interests[idx] = poller->interests[poller->count];
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL uint32_t sl_poller_ready(sl_sock_t *sock, bool readable, bool writable, bool error)
+{
+    uint32_t events = 0;
+    if (readable) {
+        sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+        events |= SL_POLL_EVENT_READ;
+    }
+    if (writable) {
+        sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+        events |= SL_POLL_EVENT_WRITE;
+    }
+    if (error) events |= SL_POLL_EVENT_ERROR;
+
+    return events;
+}
+
+/* waits up to timeout_ms (0 to poll, -1 forever) and fills up to count ready sockets, returns how many */
+SL_INLINE_IMPL int sl_poller_wait(sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t timeout_ms)
+{
+    SL_ASSERT(poller && poller->state == SL_POLLER_STATE_STARTED);
+    SL_ASSERT(events && count > 0);
+
+    int rv;
+#if SL_PLATFORM_LINUX
+    struct epoll_event evs[SL_SOCK_BATCH_MAX];
+    if (count > SL_SOCK_BATCH_MAX) count = SL_SOCK_BATCH_MAX;
+
+    if ((rv = epoll_wait((int)poller->fd, evs, count, timeout_ms)) < 0) {
+        poller->error = (uint32_t)sl_sys_errno();
+        if (poller->error == EINTR) return 0;
+        return SL_ERR;
+    }
+
+    for (int i = 0; i < rv; i++) {
+        sl_sock_t *sock = (sl_sock_t *)evs[i].data.ptr;
+        events[i].sock = sock;
+        events[i].events = sl_poller_ready(sock, evs[i].events & (EPOLLIN | EPOLLHUP), evs[i].events & EPOLLOUT, evs[i].events & EPOLLERR);
+    }
+#else
+    for (uint32_t i = 0; i < poller->count; i++) {
+        bool blocked = (poller->interests[i] & SL_POLL_EVENT_WRITE) && (poller->socks[i]->flags & SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+        poller->pollfds[i].events = (short)(((poller->interests[i] & SL_POLL_EVENT_READ) ? POLLIN : 0) | (blocked ? POLLOUT : 0));
+        poller->pollfds[i].revents = 0;
+    }
+
+    int nready;
+    if ((nready = sl_sys_poll(poller->pollfds, poller->count, timeout_ms)) < 0) {
+        poller->error = (uint32_t)sl_sys_errno();
+        if (poller->error == EINTR) return 0;
+        return SL_ERR;
+    }
+
+    rv = 0;
+    for (uint32_t i = 0; i < poller->count && nready > 0 && rv < count; i++) {
+        short revents = poller->pollfds[i].revents;
+        if (!revents) continue;
+        nready--;
+        events[rv].sock = poller->socks[i];
+        events[rv++].events = sl_poller_ready(poller->socks[i], revents & (POLLIN | POLLHUP), revents & POLLOUT, revents & POLLERR);
+    }
+#endif
+
+    return rv;
+}
+
+#endif
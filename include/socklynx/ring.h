@@ -0,0 +1,987 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_RING_H
+#define SL_RING_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/impair.h"
+#include "socklynx/sock.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_ring_t queues sends and receives for any number of sockets and hands back
+ * completions in batches. On Linux it is backed by io_uring: sends go out of a
+ * registered buffer arena and each socket gets one multishot recvmsg which pulls
+ * from a provided buffer ring. Everywhere else, or when the running kernel is too
+ * old, the same calls are serviced synchronously with sl_sock_send/sl_sock_recv
+ * and poll, so callers never need two code paths.
+ *
+ * Either way the socket's counters move, including rx_dropped and coalesced GRO
+ * segments, and an attached capture sees every datagram. An impaired send is made
+ * synchronously through its queue on both backends. An impaired receive on io_uring
+ * moves each datagram into its queue as it lands and holds a receive buffer back for
+ * it, and either backend stops waiting when a held datagram falls due.
+ */
+
+#if SL_PLATFORM_LINUX && defined(__has_include)
+#    if __has_include(<linux/io_uring.h>)
+#        include <linux/io_uring.h>
+#        if defined(IORING_RECV_MULTISHOT) && defined(IORING_RECVSEND_FIXED_BUF)
+#            define SL_RING_API_URING 1
+#        endif
+#    endif
+#endif
+
+#if SL_RING_API_URING
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <time.h>
+#endif
+
+typedef enum sl_ring_flag_e {
+    SL_RING_FLAG_FALLBACK = (1 << 0),
+    SL_RING_FLAG_SEND_ZC = (1 << 1),
+} sl_ring_flag_t;
+
+typedef enum sl_ring_state_e {
+    SL_RING_STATE_NEW,
+    SL_RING_STATE_STARTED,
+    SL_RING_STATE_STOPPED,
+} sl_ring_state_t;
+
+typedef enum sl_ring_op_e {
+    SL_RING_OP_NONE,
+    SL_RING_OP_SEND,
+    SL_RING_OP_RECV,
+    SL_RING_OP_CANCEL,
+} sl_ring_op_t;
+
+typedef enum sl_ring_entry_state_e {
+    SL_RING_ENTRY_FREE,
+    SL_RING_ENTRY_RESERVED,
+    SL_RING_ENTRY_QUEUED,
+    SL_RING_ENTRY_INFLIGHT,
+    SL_RING_ENTRY_NOTIFY,
+    SL_RING_ENTRY_REARM,
+    SL_RING_ENTRY_CANCELLING,
+} sl_ring_entry_state_t;
+
+/* one completed send or received datagram, recv buffers belong to the ring until sl_ring_buf_release */
+typedef struct sl_ring_cqe_s {
+    uint64_t user_data;
+    sl_sock_t *sock;
+    sl_buf_t buf;
+    sl_endpoint_t endpoint;
+    int32_t res;
+    uint32_t error;
+    uint32_t op;
+    uint32_t bufid;
+} sl_ring_cqe_t;
+
+typedef struct sl_ring_send_s {
+    sl_sock_t *sock;
+    uint64_t user_data;
+    sl_endpoint_t endpoint;
+    sl_buf_t buf;
+    int32_t res;
+    uint32_t error;
+    uint32_t state;
+#if SL_RING_API_URING
+    struct msghdr mhdr;
+#endif
+} sl_ring_send_t;
+
+typedef struct sl_ring_recv_s {
+    sl_sock_t *sock;
+    uint64_t user_data;
+    uint32_t state;
+#if SL_RING_API_URING
+    struct msghdr mhdr;
+#endif
+} sl_ring_recv_t;
+
+/*
+ * set entries (max sends in flight and sockets receiving), bufcount (receive buffers,
+ * rounded up to a power of two) and bufsize (bytes per send or receive buffer) before sl_ring_setup.
+ * on io_uring a receive buffer holds the source address and any control messages ahead of the
+ * datagram, so leave 160 bytes over the largest one expected
+ */
+typedef struct sl_ring_s {
+    uint32_t entries;
+    uint32_t bufcount;
+    uint32_t bufsize;
+    uint32_t flags;
+    uint32_t state;
+    uint32_t error;
+    char *arena;
+    sl_ring_send_t *sends;
+    sl_ring_recv_t *recvs;
+    uint32_t *send_free;
+    uint32_t send_free_count;
+    uint32_t buf_avail;
+    /* synchronous fallback state */
+    sl_ring_cqe_t *cq;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t *buf_free;
+    SL_SYS_POLLFD *pollfds;
+    uint32_t *pollidx;
+#if SL_RING_API_URING
+    int fd;
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t *sq_mask;
+    uint32_t *sq_array;
+    struct io_uring_sqe *sqes;
+    uint32_t sq_entries;
+    uint32_t *cq_head_k;
+    uint32_t *cq_tail_k;
+    uint32_t *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_map;
+    size_t sq_map_len;
+    void *cq_map;
+    size_t cq_map_len;
+    size_t sqes_map_len;
+    struct io_uring_buf_ring *br;
+    size_t br_map_len;
+    uint16_t br_tail;
+    uint32_t buf_spare;   /* receive buffers held back from the kernel on buf_free, for impaired datagrams */
+    uint32_t impair_held; /* datagrams impaired receives held at the last completion */
+#endif
+} sl_ring_t;
+
+#define SL_RING_USER_DATA(op, idx) (((uint64_t)(op) << 32) | (uint64_t)(idx))
+#define SL_RING_USER_DATA_OP(ud) ((uint32_t)((ud) >> 32))
+#define SL_RING_USER_DATA_IDX(ud) ((uint32_t)((ud)&0xffffffff))
+
+SL_INLINE_IMPL bool sl_ring_is_fallback(sl_ring_t *ring)
+{
+    SL_ASSERT(ring);
+    return (ring->flags & SL_RING_FLAG_FALLBACK);
+}
+
+SL_INLINE_IMPL char *sl_ring_send_base(sl_ring_t *ring, uint32_t slot)
+{
+    SL_ASSERT(ring && slot < ring->entries);
+    return ring->arena + (size_t)slot * ring->bufsize;
+}
+
+SL_INLINE_IMPL char *sl_ring_recv_base(sl_ring_t *ring, uint32_t bufid)
+{
+    SL_ASSERT(ring && bufid < ring->bufcount);
+    return ring->arena + ((size_t)ring->entries + bufid) * ring->bufsize;
+}
+
+/* an impaired send has to go through its queue, so either backend makes it synchronously */
+SL_INLINE_IMPL bool sl_ring_send_is_sync(sl_ring_t *ring, sl_sock_t *sock)
+{
+#if SL_SOCK_IMPAIR
+    if (sock->impair_tx) return true;
+#else
+    (void)sock;
+#endif
+    return sl_ring_is_fallback(ring);
+}
+
+#if SL_RING_API_URING
+SL_INLINE_IMPL int sl_ring_uring_enter(sl_ring_t *ring, uint32_t to_submit, uint32_t min_complete, int32_t timeout_ms)
+{
+    uint32_t flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    struct io_uring_getevents_arg arg = {0};
+    struct timespec ts;
+    void *argp = NULL;
+    size_t argsz = 0;
+
+    if (min_complete && timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+        argp = &arg;
+        argsz = sizeof(arg);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+
+    int rv = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, argp, argsz);
+    if (rv < 0) {
+        ring->error = (uint32_t)sl_sys_errno();
+        /* running out of time or being interrupted while waiting is not a failure */
+        if (ring->error == ETIME || ring->error == EINTR || ring->error == EAGAIN || ring->error == EBUSY) return SL_OK;
+        return SL_ERR;
+    }
+
+    return rv;
+}
+
+SL_INLINE_IMPL struct io_uring_sqe *sl_ring_uring_sqe_get(sl_ring_t *ring)
+{
+    uint32_t head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = *ring->sq_tail;
+    if (tail - head >= ring->sq_entries) {
+        /* flush what is queued to make room, the kernel consumes sqes synchronously */
+        if (sl_ring_uring_enter(ring, tail - head, 0, 0) < 0) return NULL;
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head >= ring->sq_entries) return NULL;
+    }
+
+    struct io_uring_sqe *sqe = &ring->sqes[tail & *ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[tail & *ring->sq_mask] = tail & *ring->sq_mask;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    return sqe;
+}
+
+SL_INLINE_IMPL void sl_ring_uring_buf_add(sl_ring_t *ring, uint32_t bufid)
+{
+    uint32_t mask = ring->bufcount - 1;
+    struct io_uring_buf *buf = &ring->br->bufs[ring->br_tail & mask];
+    buf->addr = (uint64_t)(uintptr_t)sl_ring_recv_base(ring, bufid);
+    buf->len = ring->bufsize;
+    buf->bid = (uint16_t)bufid;
+    ring->br_tail++;
+}
+
+SL_INLINE_IMPL void sl_ring_uring_buf_commit(sl_ring_t *ring)
+{
+    __atomic_store_n(&ring->br->tail, ring->br_tail, __ATOMIC_RELEASE);
+}
+
+SL_INLINE_IMPL int sl_ring_uring_recv_arm(sl_ring_t *ring, uint32_t idx)
+{
+    sl_ring_recv_t *recv = &ring->recvs[idx];
+    struct io_uring_sqe *sqe;
+    SL_GUARD_NULL(sqe = sl_ring_uring_sqe_get(ring));
+
+    /* the name is padded so the control messages which follow it in the buffer stay aligned */
+    memset(&recv->mhdr, 0, sizeof(recv->mhdr));
+    recv->mhdr.msg_namelen = (socklen_t)((sizeof(sl_endpoint_t) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1));
+    if (recv->sock->flags & (SL_SOCK_FLAG_GRO | SL_SOCK_FLAG_TIMESTAMP | SL_SOCK_FLAG_RXQ_OVFL)) recv->mhdr.msg_controllen = SL_SOCK_CMSG_SPACE;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = (int32_t)sl_sock_fd_get(recv->sock);
+    sqe->addr = (uint64_t)(uintptr_t)&recv->mhdr;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = SL_RING_USER_DATA(SL_RING_OP_RECV, idx);
+    recv->state = SL_RING_ENTRY_INFLIGHT;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_ring_uring_cleanup(sl_ring_t *ring)
+{
+    if (ring->br) munmap(ring->br, ring->br_map_len);
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_map_len);
+    if (ring->cq_map && ring->cq_map != ring->sq_map) munmap(ring->cq_map, ring->cq_map_len);
+    if (ring->sq_map) munmap(ring->sq_map, ring->sq_map_len);
+    if (ring->fd >= 0) close(ring->fd);
+    ring->br = NULL;
+    ring->sqes = NULL;
+    ring->cq_map = NULL;
+    ring->sq_map = NULL;
+    ring->fd = -1;
+}
+
+SL_INLINE_IMPL int sl_ring_uring_setup(sl_ring_t *ring)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = 2 * (ring->entries + ring->bufcount);
+
+    int fd = (int)syscall(__NR_io_uring_setup, ring->entries, &params);
+    if (fd < 0) {
+        ring->error = (uint32_t)sl_sys_errno();
+        return SL_ERR;
+    }
+    ring->fd = fd;
+
+    /* multishot recvmsg and zero copy send arrived in the same kernel, so one probe covers both */
+    if (!(params.features & IORING_FEAT_EXT_ARG)) goto cleanup;
+    struct {
+        struct io_uring_probe probe;
+        struct io_uring_probe_op ops[IORING_OP_SEND_ZC + 1];
+    } probe;
+    memset(&probe, 0, sizeof(probe));
+    SL_GUARD_CLEANUP(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, &probe, IORING_OP_SEND_ZC + 1) < 0);
+    SL_GUARD_CLEANUP(probe.probe.last_op < IORING_OP_SEND_ZC);
+    SL_GUARD_CLEANUP(!(probe.ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED));
+
+    ring->sq_map_len = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cq_map_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_len > ring->sq_map_len) ring->sq_map_len = ring->cq_map_len;
+        ring->cq_map_len = ring->sq_map_len;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) ring->sq_map = NULL;
+    SL_GUARD_NULL_CLEANUP(ring->sq_map);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_map = ring->sq_map;
+    } else {
+        ring->cq_map = mmap(NULL, ring->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) ring->cq_map = NULL;
+        SL_GUARD_NULL_CLEANUP(ring->cq_map);
+    }
+
+    ring->sqes_map_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) ring->sqes = NULL;
+    SL_GUARD_NULL_CLEANUP(ring->sqes);
+
+    char *sq = (char *)ring->sq_map;
+    char *cq = (char *)ring->cq_map;
+    ring->sq_head = (uint32_t *)(sq + params.sq_off.head);
+    ring->sq_tail = (uint32_t *)(sq + params.sq_off.tail);
+    ring->sq_mask = (uint32_t *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (uint32_t *)(sq + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->cq_head_k = (uint32_t *)(cq + params.cq_off.head);
+    ring->cq_tail_k = (uint32_t *)(cq + params.cq_off.tail);
+    ring->cq_mask = (uint32_t *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    /* the whole arena is one fixed buffer, sends address into it by slot */
+    struct iovec iov;
+    iov.iov_base = ring->arena;
+    iov.iov_len = ((size_t)ring->entries + ring->bufcount) * ring->bufsize;
+    SL_GUARD_CLEANUP(syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0);
+
+    /* receive buffers are handed to the kernel through a provided buffer ring in group 0 */
+    ring->br_map_len = ring->bufcount * sizeof(struct io_uring_buf);
+    ring->br = mmap(NULL, ring->br_map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->br == MAP_FAILED) ring->br = NULL;
+    SL_GUARD_NULL_CLEANUP(ring->br);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring->br;
+    reg.ring_entries = ring->bufcount;
+    reg.bgid = 0;
+    SL_GUARD_CLEANUP(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0);
+
+    ring->br_tail = 0;
+    for (uint32_t i = 0; i < ring->bufcount; i++) {
+        sl_ring_uring_buf_add(ring, i);
+    }
+    sl_ring_uring_buf_commit(ring);
+
+    return SL_OK;
+
+cleanup:
+    ring->error = (uint32_t)sl_sys_errno();
+    sl_ring_uring_cleanup(ring);
+    return SL_ERR;
+}
+#endif
+
+SL_INLINE_IMPL int sl_ring_cleanup(sl_ring_t *ring)
+{
+    SL_ASSERT(ring);
+    if (ring->state != SL_RING_STATE_STARTED) return SL_OK;
+
+#if SL_RING_API_URING
+    /* closing the ring tears down every multishot receive still armed on it */
+    if (!sl_ring_is_fallback(ring)) sl_ring_uring_cleanup(ring);
+#endif
+
+    free(ring->arena);
+    free(ring->sends);
+    free(ring->recvs);
+    free(ring->send_free);
+    free(ring->cq);
+    free(ring->buf_free);
+    free(ring->pollfds);
+    free(ring->pollidx);
+    ring->arena = NULL;
+    ring->sends = NULL;
+    ring->recvs = NULL;
+    ring->send_free = NULL;
+    ring->cq = NULL;
+    ring->buf_free = NULL;
+    ring->pollfds = NULL;
+    ring->pollidx = NULL;
+    ring->state = SL_RING_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_ring_setup(sl_ring_t *ring)
+{
+    SL_ASSERT(ring);
+    SL_ASSERT(ring->state != SL_RING_STATE_STARTED);
+    SL_GUARD(!ring->entries || !ring->bufcount || !ring->bufsize);
+    SL_GUARD(ring->bufcount > (1 << 15));
+
+    uint32_t bufcount = 1;
+    while (bufcount < ring->bufcount) bufcount <<= 1;
+    ring->bufcount = bufcount;
+
+    ring->arena = (char *)malloc(((size_t)ring->entries + ring->bufcount) * ring->bufsize);
+    ring->sends = (sl_ring_send_t *)calloc(ring->entries, sizeof(*ring->sends));
+    ring->recvs = (sl_ring_recv_t *)calloc(ring->entries, sizeof(*ring->recvs));
+    ring->send_free = (uint32_t *)malloc(ring->entries * sizeof(*ring->send_free));
+    ring->cq = (sl_ring_cqe_t *)calloc(ring->entries, sizeof(*ring->cq));
+    ring->buf_free = (uint32_t *)malloc(ring->bufcount * sizeof(*ring->buf_free));
+    ring->pollfds = (SL_SYS_POLLFD *)calloc(ring->entries, sizeof(*ring->pollfds));
+    ring->pollidx = (uint32_t *)calloc(ring->entries, sizeof(*ring->pollidx));
+    ring->state = SL_RING_STATE_STARTED;
+    if (!ring->arena || !ring->sends || !ring->recvs || !ring->send_free || !ring->cq || !ring->buf_free || !ring->pollfds || !ring->pollidx) {
+        ring->error = ENOMEM;
+        sl_ring_cleanup(ring);
+        return SL_ERR;
+    }
+
+    for (uint32_t i = 0; i < ring->entries; i++) {
+        ring->send_free[i] = ring->entries - 1 - i;
+    }
+    ring->send_free_count = ring->entries;
+    for (uint32_t i = 0; i < ring->bufcount; i++) {
+        ring->buf_free[i] = ring->bufcount - 1 - i;
+    }
+    ring->buf_avail = ring->bufcount;
+    ring->cq_head = 0;
+    ring->cq_tail = 0;
+
+#if SL_RING_API_URING
+    ring->fd = -1;
+    ring->buf_spare = 0;
+    ring->impair_held = 0;
+    if (!sl_ring_is_fallback(ring) && sl_ring_uring_setup(ring)) ring->flags |= SL_RING_FLAG_FALLBACK;
+#else
+    /* PLATFORM TODO: extend completion based io for your platform, until then everything runs through the fallback */
+    ring->flags |= SL_RING_FLAG_FALLBACK;
+#endif
+
+    return SL_OK;
+}
+
+/* reserve a send slot in the registered arena, fill up to bufsize bytes at buf->base then pass it to sl_ring_send */
+SL_INLINE_IMPL int sl_ring_send_buf_get(sl_ring_t *ring, sl_buf_t *buf)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+    SL_ASSERT(buf);
+
+    if (!ring->send_free_count) {
+        ring->error = ENOBUFS;
+        return SL_ERR;
+    }
+
+    uint32_t slot = ring->send_free[--ring->send_free_count];
+    ring->sends[slot].state = SL_RING_ENTRY_RESERVED;
+    buf->base = sl_ring_send_base(ring, slot);
+    buf->len = ring->bufsize;
+
+    return (int)slot;
+}
+
+SL_INLINE_IMPL void sl_ring_send_buf_put(sl_ring_t *ring, uint32_t slot)
+{
+    SL_ASSERT(ring && slot < ring->entries);
+    ring->sends[slot].state = SL_RING_ENTRY_FREE;
+    ring->send_free[ring->send_free_count++] = slot;
+}
+
+SL_INLINE_IMPL int sl_ring_send(sl_ring_t *ring, sl_sock_t *sock, int32_t slot, uint32_t len, sl_endpoint_t *endpoint, uint64_t user_data)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+    SL_ASSERT(sock && sl_sock_is_ready(sock));
+    SL_ASSERT(endpoint);
+    SL_ASSERT(slot >= 0 && (uint32_t)slot < ring->entries);
+    SL_ASSERT(ring->sends[slot].state == SL_RING_ENTRY_RESERVED);
+    SL_ASSERT(len <= ring->bufsize);
+
+    sl_ring_send_t *send = &ring->sends[slot];
+    send->sock = sock;
+    send->user_data = user_data;
+    send->endpoint = *endpoint;
+    send->buf.base = sl_ring_send_base(ring, (uint32_t)slot);
+    send->buf.len = len;
+    send->res = 0;
+    send->error = 0;
+
+    if (sl_ring_send_is_sync(ring, sock)) {
+        /* the slot is held until its completion is reaped, so the local queue never holds more than entries */
+        sl_ring_cqe_t *cqe = &ring->cq[ring->cq_tail++ % ring->entries];
+        memset(cqe, 0, sizeof(*cqe));
+        cqe->op = SL_RING_OP_SEND;
+        cqe->sock = sock;
+        cqe->user_data = user_data;
+        cqe->buf = send->buf;
+        cqe->endpoint = send->endpoint;
+        cqe->bufid = (uint32_t)slot;
+        if ((cqe->res = sl_sock_send(sock, &send->buf, 1, &send->endpoint)) < 0) cqe->error = sock->error;
+        send->state = SL_RING_ENTRY_INFLIGHT;
+        return SL_OK;
+    }
+
+#if SL_RING_API_URING
+    struct io_uring_sqe *sqe;
+    if (!(sqe = sl_ring_uring_sqe_get(ring))) {
+        ring->error = EBUSY;
+        return SL_ERR;
+    }
+
+    sqe->fd = (int32_t)sl_sock_fd_get(sock);
+    sqe->user_data = SL_RING_USER_DATA(SL_RING_OP_SEND, slot);
+    if (ring->flags & SL_RING_FLAG_SEND_ZC) {
+        /* zero copy out of the registered arena, the slot stays busy until the kernel's notification */
+        sqe->opcode = IORING_OP_SEND_ZC;
+        sqe->addr = (uint64_t)(uintptr_t)send->buf.base;
+        sqe->len = len;
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = 0;
+        sqe->addr2 = (uint64_t)(uintptr_t)sl_endpoint_addr_get(&send->endpoint);
+        sqe->addr_len = (uint16_t)sl_endpoint_size(&send->endpoint);
+    } else {
+        memset(&send->mhdr, 0, sizeof(send->mhdr));
+        send->mhdr.msg_name = sl_endpoint_addr_get(&send->endpoint);
+        send->mhdr.msg_namelen = (socklen_t)sl_endpoint_size(&send->endpoint);
+        send->mhdr.msg_iov = (struct iovec *)&send->buf;
+        send->mhdr.msg_iovlen = 1;
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->addr = (uint64_t)(uintptr_t)&send->mhdr;
+        sqe->len = 1;
+    }
+    send->state = SL_RING_ENTRY_INFLIGHT;
+#endif
+
+    return SL_OK;
+}
+
+/* start receiving on sock until sl_ring_recv_cancel, returns a handle for cancellation */
+SL_INLINE_IMPL int sl_ring_recv(sl_ring_t *ring, sl_sock_t *sock, uint64_t user_data)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+    SL_ASSERT(sock && sl_sock_is_ready(sock));
+
+    uint32_t idx;
+    for (idx = 0; idx < ring->entries; idx++) {
+        if (ring->recvs[idx].state == SL_RING_ENTRY_FREE) break;
+    }
+    if (idx == ring->entries) {
+        ring->error = ENOBUFS;
+        return SL_ERR;
+    }
+
+    sl_ring_recv_t *recv = &ring->recvs[idx];
+    recv->sock = sock;
+    recv->user_data = user_data;
+    recv->state = SL_RING_ENTRY_QUEUED;
+
+#if SL_RING_API_URING
+    if (!sl_ring_is_fallback(ring) && sl_ring_uring_recv_arm(ring, idx)) {
+        recv->state = SL_RING_ENTRY_FREE;
+        ring->error = EBUSY;
+        return SL_ERR;
+    }
+#endif
+
+    return (int)idx;
+}
+
+SL_INLINE_IMPL int sl_ring_recv_cancel(sl_ring_t *ring, int32_t handle)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+    SL_ASSERT(handle >= 0 && (uint32_t)handle < ring->entries);
+
+    sl_ring_recv_t *recv = &ring->recvs[handle];
+    if (recv->state == SL_RING_ENTRY_FREE || recv->state == SL_RING_ENTRY_CANCELLING) return SL_OK;
+
+#if SL_RING_API_URING
+    if (!sl_ring_is_fallback(ring) && recv->state == SL_RING_ENTRY_INFLIGHT) {
+        /* the slot is recycled when the multishot posts its final completion */
+        struct io_uring_sqe *sqe;
+        if (!(sqe = sl_ring_uring_sqe_get(ring))) {
+            ring->error = EBUSY;
+            return SL_ERR;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = SL_RING_USER_DATA(SL_RING_OP_RECV, handle);
+        sqe->user_data = SL_RING_USER_DATA(SL_RING_OP_CANCEL, handle);
+        recv->state = SL_RING_ENTRY_CANCELLING;
+        return SL_OK;
+    }
+#endif
+    recv->state = SL_RING_ENTRY_FREE;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_ring_buf_release(sl_ring_t *ring, uint32_t bufid)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+    SL_ASSERT(bufid < ring->bufcount);
+
+    ring->buf_avail++;
+#if SL_RING_API_URING
+    if (!sl_ring_is_fallback(ring)) {
+        /* a duplicated impaired datagram needs a buffer which no arrival brought along */
+        if (ring->buf_spare < ring->impair_held) {
+            ring->buf_free[ring->buf_spare++] = bufid;
+            return;
+        }
+        sl_ring_uring_buf_add(ring, bufid);
+        sl_ring_uring_buf_commit(ring);
+        return;
+    }
+#endif
+    ring->buf_free[ring->buf_avail - 1] = bufid;
+}
+
+SL_INLINE_IMPL int sl_ring_submit(sl_ring_t *ring)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+
+    if (sl_ring_is_fallback(ring)) return SL_OK;
+
+#if SL_RING_API_URING
+    /* multishots stopped by buffer exhaustion resume once the caller has released some */
+    if (ring->buf_avail > ring->buf_spare) {
+        for (uint32_t i = 0; i < ring->entries; i++) {
+            if (ring->recvs[i].state == SL_RING_ENTRY_REARM) SL_GUARD(sl_ring_uring_recv_arm(ring, i));
+        }
+    }
+
+    uint32_t pending = *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (pending) SL_GUARD(sl_ring_uring_enter(ring, pending, 0, 0) < 0);
+#endif
+
+    return SL_OK;
+}
+
+/* completions of synchronous sends, queued locally until reaped */
+SL_INLINE_IMPL int32_t sl_ring_local_complete(sl_ring_t *ring, sl_ring_cqe_t *cqes, int32_t count)
+{
+    int32_t completed = 0;
+    for (; ring->cq_head != ring->cq_tail && completed < count; completed++) {
+        cqes[completed] = ring->cq[ring->cq_head++ % ring->entries];
+        sl_ring_send_buf_put(ring, cqes[completed].bufid);
+    }
+
+    return completed;
+}
+
+#if SL_SOCK_IMPAIR
+SL_INLINE_IMPL sl_impair_t *sl_ring_recv_impair(sl_ring_recv_t *recv)
+{
+    if (recv->state != SL_RING_ENTRY_QUEUED && recv->state != SL_RING_ENTRY_INFLIGHT && recv->state != SL_RING_ENTRY_REARM) return NULL;
+    return recv->sock->impair_rx;
+}
+
+/* a wait ends by the time the next datagram an impaired receive holds falls due */
+SL_INLINE_IMPL int32_t sl_ring_impair_timeout(sl_ring_t *ring, int32_t timeout_ms)
+{
+    uint64_t deadline = UINT64_MAX;
+    for (uint32_t i = 0; i < ring->entries; i++) {
+        sl_impair_t *impair = sl_ring_recv_impair(&ring->recvs[i]);
+        if (impair && sl_impair_deadline(impair) < deadline) deadline = sl_impair_deadline(impair);
+    }
+    if (deadline == UINT64_MAX) return timeout_ms;
+
+    const uint64_t now_ns = sl_sys_time_ns();
+    if (deadline <= now_ns) return 0;
+    const uint64_t wait_ms = (deadline - now_ns + 999999) / 1000000;
+    return (timeout_ms < 0 || (uint64_t)timeout_ms > wait_ms) ? (int32_t)wait_ms : timeout_ms;
+}
+#endif
+
+#if SL_RING_API_URING
+#    if SL_SOCK_IMPAIR
+/*
+ * hands out impaired datagrams as they fall due, each in a receive buffer held back when one
+ * was ingested. spares past what the queues still hold go back to the kernel
+ */
+SL_INLINE_IMPL int32_t sl_ring_uring_impair_complete(sl_ring_t *ring, sl_ring_cqe_t *cqes, int32_t count)
+{
+    const uint64_t now_ns = sl_sys_time_ns();
+    int32_t completed = 0;
+    uint32_t held = 0;
+    for (uint32_t i = 0; i < ring->entries; i++) {
+        sl_ring_recv_t *recv = &ring->recvs[i];
+        sl_impair_t *impair = sl_ring_recv_impair(recv);
+        if (!impair) continue;
+
+        while (completed < count && ring->buf_spare) {
+            sl_ring_cqe_t *cqe = &cqes[completed];
+            uint32_t bufid = ring->buf_free[ring->buf_spare - 1];
+            memset(cqe, 0, sizeof(*cqe));
+            cqe->buf.base = sl_ring_recv_base(ring, bufid);
+            cqe->buf.len = ring->bufsize;
+            int len = sl_impair_pop_due(impair, &cqe->buf, 1, &cqe->endpoint, NULL, now_ns);
+            if (len < 0) break;
+
+            cqe->op = SL_RING_OP_RECV;
+            cqe->sock = recv->sock;
+            cqe->user_data = recv->user_data;
+            cqe->res = len;
+            cqe->buf.len = (size_t)len;
+            cqe->bufid = bufid;
+            ring->buf_spare--;
+            ring->buf_avail--;
+            completed++;
+        }
+        held += impair->count;
+    }
+
+    ring->impair_held = held;
+    if (ring->buf_spare > held) {
+        while (ring->buf_spare > held) sl_ring_uring_buf_add(ring, ring->buf_free[--ring->buf_spare]);
+        sl_ring_uring_buf_commit(ring);
+    }
+
+    return completed;
+}
+#    endif
+
+SL_INLINE_IMPL int sl_ring_uring_complete(sl_ring_t *ring, sl_ring_cqe_t *cqes, int32_t count, int32_t timeout_ms)
+{
+    int32_t completed = sl_ring_local_complete(ring, cqes, count);
+    if (completed == count) return (int)completed;
+
+    uint32_t head = *ring->cq_head_k;
+    uint32_t tail = __atomic_load_n(ring->cq_tail_k, __ATOMIC_ACQUIRE);
+#    if SL_SOCK_IMPAIR
+    if (head == tail && !completed && timeout_ms && ring->impair_held) timeout_ms = sl_ring_impair_timeout(ring, timeout_ms);
+#    endif
+    if (head == tail && !completed && timeout_ms) {
+        SL_GUARD(sl_ring_uring_enter(ring, 0, 1, timeout_ms) < 0);
+        tail = __atomic_load_n(ring->cq_tail_k, __ATOMIC_ACQUIRE);
+    }
+
+    for (; head != tail && completed < count; head++) {
+        struct io_uring_cqe *kcqe = &ring->cqes[head & *ring->cq_mask];
+        uint32_t op = SL_RING_USER_DATA_OP(kcqe->user_data);
+        uint32_t idx = SL_RING_USER_DATA_IDX(kcqe->user_data);
+        sl_ring_cqe_t *cqe = &cqes[completed];
+
+        if (op == SL_RING_OP_SEND) {
+            sl_ring_send_t *send = &ring->sends[idx];
+            if (!(kcqe->flags & IORING_CQE_F_NOTIF)) {
+                send->res = kcqe->res >= 0 ? kcqe->res : SL_ERR;
+                send->error = kcqe->res >= 0 ? 0 : (uint32_t)-kcqe->res;
+                if (kcqe->res >= 0) {
+                    sl_sock_stats_tx(send->sock, 1, (uint64_t)kcqe->res, (uint32_t)kcqe->res);
+#    if SL_SOCK_CAPTURE
+                    if (send->sock->capture) sl_capture_write(send->sock->capture, send->sock, false, &send->buf, 1, (size_t)kcqe->res, 0, &send->endpoint, 0);
+#    endif
+                } else {
+                    sl_sock_error_set(send->sock, send->error);
+                    sl_sock_stats_error(send->sock, (int)send->error, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+                }
+                /* a zero copy send reports again once the arena slot may be reused */
+                if (kcqe->flags & IORING_CQE_F_MORE) {
+                    send->state = SL_RING_ENTRY_NOTIFY;
+                    continue;
+                }
+            }
+
+            memset(cqe, 0, sizeof(*cqe));
+            cqe->op = SL_RING_OP_SEND;
+            cqe->sock = send->sock;
+            cqe->user_data = send->user_data;
+            cqe->buf = send->buf;
+            cqe->endpoint = send->endpoint;
+            cqe->res = send->res;
+            cqe->error = send->error;
+            cqe->bufid = idx;
+            sl_ring_send_buf_put(ring, idx);
+            completed++;
+        } else if (op == SL_RING_OP_RECV) {
+            sl_ring_recv_t *recv = &ring->recvs[idx];
+            if (!(kcqe->flags & IORING_CQE_F_MORE)) {
+                /* the multishot has ended, either by request or because the kernel ran out of buffers */
+                if (recv->state == SL_RING_ENTRY_CANCELLING || kcqe->res == -ECANCELED) {
+                    recv->state = SL_RING_ENTRY_FREE;
+                } else {
+                    recv->state = SL_RING_ENTRY_REARM;
+                }
+            }
+            if (kcqe->res == -ENOBUFS || kcqe->res == -ECANCELED) continue;
+
+            memset(cqe, 0, sizeof(*cqe));
+            cqe->op = SL_RING_OP_RECV;
+            cqe->sock = recv->sock;
+            cqe->user_data = recv->user_data;
+            if (kcqe->res < 0) {
+                cqe->res = SL_ERR;
+                cqe->error = (uint32_t)-kcqe->res;
+                sl_sock_error_set(recv->sock, cqe->error);
+                sl_sock_stats_error(recv->sock, (int)cqe->error, SL_SOCK_FLAG_WOULDBLOCK_READ);
+                completed++;
+                continue;
+            }
+
+            /* the provided buffer holds a recvmsg_out header, the source address, control messages, then the datagram */
+            SL_ASSERT(kcqe->flags & IORING_CQE_F_BUFFER);
+            uint32_t bufid = kcqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            char *base = sl_ring_recv_base(ring, bufid);
+            struct io_uring_recvmsg_out *out = (struct io_uring_recvmsg_out *)base;
+            size_t offset = sizeof(*out) + recv->mhdr.msg_namelen + recv->mhdr.msg_controllen;
+            size_t namelen = out->namelen < sizeof(cqe->endpoint) ? out->namelen : sizeof(cqe->endpoint);
+            size_t payloadlen = (size_t)kcqe->res - offset;
+
+            memcpy(&cqe->endpoint, base + sizeof(*out), namelen);
+            cqe->buf.base = base + offset;
+            cqe->buf.len = payloadlen;
+            cqe->res = (int32_t)payloadlen;
+            cqe->bufid = bufid;
+
+            /* the same counters sl_sock_recv keeps, a coalesced run counts one packet per segment */
+            size_t segsize = payloadlen;
+            if (out->controllen) {
+                struct msghdr mhdr = {0};
+                struct cmsghdr *cmsg;
+                mhdr.msg_control = base + sizeof(*out) + recv->mhdr.msg_namelen;
+                mhdr.msg_controllen = out->controllen < recv->mhdr.msg_controllen ? out->controllen : recv->mhdr.msg_controllen;
+                for (cmsg = CMSG_FIRSTHDR(&mhdr); cmsg; cmsg = CMSG_NXTHDR(&mhdr, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                        int gro_size;
+                        memcpy(&gro_size, CMSG_DATA(cmsg), sizeof(gro_size));
+                        if (gro_size > 0 && (size_t)gro_size < payloadlen) segsize = (size_t)gro_size;
+                        continue;
+                    }
+                    sl_sock_cmsg_drops(recv->sock, cmsg);
+                }
+            }
+            sl_sock_stats_rx(recv->sock, (segsize < payloadlen) ? (uint64_t)((payloadlen + segsize - 1) / segsize) : 1, (uint64_t)payloadlen, (uint32_t)segsize);
+#    if SL_SOCK_CAPTURE
+            if (recv->sock->capture) sl_capture_write(recv->sock->capture, recv->sock, true, &cqe->buf, 1, payloadlen, segsize, &cqe->endpoint, 0);
+#    endif
+#    if SL_SOCK_IMPAIR
+            /* an impaired receive holds the datagram in its queue, and the buffer back for when it falls due */
+            if (recv->sock->impair_rx) {
+                sl_impair_ingest_buf(recv->sock->impair_rx, recv->sock, &cqe->buf, &cqe->endpoint, 0, sl_sys_time_ns());
+                ring->buf_free[ring->buf_spare++] = bufid;
+                continue;
+            }
+#    endif
+            ring->buf_avail--;
+            completed++;
+        }
+    }
+    __atomic_store_n(ring->cq_head_k, head, __ATOMIC_RELEASE);
+
+#    if SL_SOCK_IMPAIR
+    if ((ring->buf_spare || ring->impair_held) && completed < count) completed += sl_ring_uring_impair_complete(ring, cqes + completed, count - completed);
+#    endif
+
+    return (int)completed;
+}
+#endif
+
+SL_INLINE_IMPL int sl_ring_fallback_complete(sl_ring_t *ring, sl_ring_cqe_t *cqes, int32_t count, int32_t timeout_ms)
+{
+    int32_t completed = sl_ring_local_complete(ring, cqes, count);
+    if (completed == count) return (int)completed;
+
+    uint32_t nfds = 0;
+    for (uint32_t i = 0; i < ring->entries; i++) {
+        if (ring->recvs[i].state != SL_RING_ENTRY_QUEUED) continue;
+        ring->pollfds[nfds].fd = sl_sock_fd_get(ring->recvs[i].sock);
+        ring->pollfds[nfds].events = POLLIN;
+        ring->pollfds[nfds].revents = 0;
+        ring->pollidx[nfds++] = i;
+    }
+    if (!nfds || !ring->buf_avail) return (int)completed;
+
+    if (completed) timeout_ms = 0;
+#if SL_SOCK_IMPAIR
+    if (timeout_ms) timeout_ms = sl_ring_impair_timeout(ring, timeout_ms);
+#endif
+    int rv = sl_sys_poll(ring->pollfds, nfds, timeout_ms);
+    if (rv < 0) {
+        ring->error = (uint32_t)sl_sys_errno();
+        if (ring->error == EINTR) return (int)completed;
+        return completed ? (int)completed : SL_ERR;
+    }
+
+    /* one datagram per ready socket, readiness guarantees it won't block */
+    for (uint32_t i = 0; i < nfds && completed < count && ring->buf_avail; i++) {
+        sl_ring_recv_t *recv = &ring->recvs[ring->pollidx[i]];
+        if (!ring->pollfds[i].revents) {
+#if SL_SOCK_IMPAIR
+            /* an impaired receive is also ready once a datagram it holds falls due */
+            if (!recv->sock->impair_rx || sl_impair_deadline(recv->sock->impair_rx) > sl_sys_time_ns()) continue;
+#else
+            continue;
+#endif
+        }
+
+        uint32_t bufid = ring->buf_free[--ring->buf_avail];
+        sl_ring_cqe_t *cqe = &cqes[completed++];
+        memset(cqe, 0, sizeof(*cqe));
+        cqe->op = SL_RING_OP_RECV;
+        cqe->sock = recv->sock;
+        cqe->user_data = recv->user_data;
+        cqe->bufid = bufid;
+        cqe->buf.base = sl_ring_recv_base(ring, bufid);
+        cqe->buf.len = ring->bufsize;
+        if ((cqe->res = sl_sock_recv(recv->sock, &cqe->buf, 1, &cqe->endpoint)) < 0) {
+            ring->buf_free[ring->buf_avail++] = bufid;
+            /* an impaired receive which took the datagram into its queue has nothing to report yet */
+            if (sl_sys_wouldblock((int)recv->sock->error)) {
+                completed--;
+                continue;
+            }
+            cqe->error = recv->sock->error;
+            cqe->buf.base = NULL;
+            cqe->buf.len = 0;
+            continue;
+        }
+        cqe->buf.len = (size_t)cqe->res;
+    }
+
+    return (int)completed;
+}
+
+/*
+ * submits anything queued and reaps up to count completions, waiting up to timeout_ms
+ * (0 to poll, -1 forever) when none are ready. Every recv completion with res >= 0
+ * owns cqe->bufid until it is handed back with sl_ring_buf_release
+ */
+SL_INLINE_IMPL int sl_ring_complete(sl_ring_t *ring, sl_ring_cqe_t *cqes, int32_t count, int32_t timeout_ms)
+{
+    SL_ASSERT(ring && ring->state == SL_RING_STATE_STARTED);
+    SL_ASSERT(cqes && count > 0);
+
+    if (sl_ring_is_fallback(ring)) return sl_ring_fallback_complete(ring, cqes, count, timeout_ms);
+
+#if SL_RING_API_URING
+    SL_GUARD(sl_ring_submit(ring));
+    return sl_ring_uring_complete(ring, cqes, count, timeout_ms);
+#else
+    return SL_ERR;
+#endif
+}
+
+#endif
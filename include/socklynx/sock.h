@@ -31,6 +31,74 @@
 
 #include <memory.h>
 
+/* upper bound on messages moved per batched send/recv call, sizes the on-stack header array */
+#ifndef SL_SOCK_BATCH_MAX
+#    define SL_SOCK_BATCH_MAX 64
+#endif
+
+/* -DSL_SOCK_STATS=0 takes the counters off the hot path, the block stays in sl_sock_t so the layout never changes */
+#ifndef SL_SOCK_STATS
+#    define SL_SOCK_STATS 1
+#endif
+
+/* -DSL_SOCK_IMPAIR=0 compiles out the check for an attached sl_impair_t, the pointers stay in sl_sock_t */
+#ifndef SL_SOCK_IMPAIR
+#    define SL_SOCK_IMPAIR 1
+#endif
+
+/* -DSL_SOCK_CAPTURE=0 does the same for an attached sl_capture_t */
+#ifndef SL_SOCK_CAPTURE
+#    define SL_SOCK_CAPTURE 1
+#endif
+
+/* kernel limits on a single segmentation offload send: segment count and IPv4 UDP payload */
+#define SL_SOCK_GSO_SEGMENTS_MAX 64
+#define SL_SOCK_GSO_BYTES_MAX 65507
+
+#if SL_PLATFORM_LINUX
+#    ifndef SOL_UDP
+#        define SOL_UDP 17
+#    endif
+#    ifndef UDP_SEGMENT
+#        define UDP_SEGMENT 103
+#    endif
+#    ifndef UDP_GRO
+#        define UDP_GRO 104
+#    endif
+#    ifndef SO_TIMESTAMPNS
+#        define SO_TIMESTAMPNS 35
+#    endif
+#    ifndef SCM_TIMESTAMPNS
+#        define SCM_TIMESTAMPNS SO_TIMESTAMPNS
+#    endif
+#    ifndef SO_TIMESTAMPING
+#        define SO_TIMESTAMPING 37
+#    endif
+#    ifndef SCM_TIMESTAMPING
+#        define SCM_TIMESTAMPING SO_TIMESTAMPING
+#    endif
+#    ifndef SO_RXQ_OVFL
+#        define SO_RXQ_OVFL 40
+#    endif
+#    ifndef SO_MAX_PACING_RATE
+#        define SO_MAX_PACING_RATE 47
+#    endif
+#    ifndef SO_TXTIME
+#        define SO_TXTIME 61
+#    endif
+#    ifndef SCM_TXTIME
+#        define SCM_TXTIME SO_TXTIME
+#    endif
+#    ifndef SO_SNDBUFFORCE
+#        define SO_SNDBUFFORCE 32
+#    endif
+#    ifndef SO_RCVBUFFORCE
+#        define SO_RCVBUFFORCE 33
+#    endif
+/* room for a GRO segment size, the larger of the two timestamp forms and a drop count on one receive */
+#    define SL_SOCK_CMSG_SPACE (CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct timespec) * 3) + CMSG_SPACE(sizeof(uint32_t)))
+#endif
+
 typedef enum sl_sock_state_e {
     SL_SOCK_STATE_NEW,
     SL_SOCK_STATE_CREATED,
@@ -62,8 +130,42 @@ typedef enum sl_sock_flag_e {
     SL_SOCK_FLAG_WOULDBLOCK_WRITE = (1 << 2),
     SL_SOCK_FLAG_IPV4_DISABLED = (1 << 3),
     SL_SOCK_FLAG_IPV6_DISABLED = (1 << 4),
+    SL_SOCK_FLAG_GSO = (1 << 5),
+    SL_SOCK_FLAG_GRO = (1 << 6),
+    SL_SOCK_FLAG_REUSEPORT = (1 << 7),
+    SL_SOCK_FLAG_TIMESTAMP = (1 << 8),
+    SL_SOCK_FLAG_RXQ_OVFL = (1 << 9),
+    SL_SOCK_FLAG_TXTIME = (1 << 10),
 } sl_sock_flag_t;
 
+/*
+ * plain increments by whichever thread drives the socket, a reader on another thread
+ * sees a snapshot which may trail by a call. packets count datagrams, so a coalesced
+ * GRO receive or a GSO send adds one per segment
+ */
+typedef struct sl_sock_stats_s {
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t tx_wouldblock;
+    uint64_t rx_wouldblock;
+    uint64_t tx_partial;      /* batched sends which moved fewer datagrams than asked */
+    uint64_t err_transient;   /* interrupted or out of buffers, a retry may succeed */
+    uint64_t err_unreachable; /* refused or unreachable, usually an icmp error from an earlier send */
+    uint64_t err_msgsize;
+    uint64_t err_other;
+    uint32_t tx_max; /* largest datagram */
+    uint32_t rx_max;
+    /*
+     * datagrams the kernel dropped because the receive queue was full, kept with
+     * SL_SOCK_FLAG_RXQ_OVFL set regardless of SL_SOCK_STATS. it only moves when a
+     * later receive succeeds, the count rides along on the next queued datagram
+     */
+    uint64_t rx_dropped;
+    uint32_t rx_dropped_kernel; /* last wrapping counter seen, rx_dropped is the 64 bit total */
+} sl_sock_stats_t;
+
 typedef struct sl_sock_s {
     int64_t fd;
     uint32_t dir;
@@ -73,8 +175,35 @@ typedef struct sl_sock_s {
     uint32_t error;
     uint32_t flags;
     sl_endpoint_t endpoint;
+    sl_sock_stats_t stats;
+    struct sl_impair_s *impair_tx; /* see sl_sock_impair_set */
+    struct sl_impair_s *impair_rx;
+    struct sl_capture_s *capture; /* see sl_sock_capture_set */
 } sl_sock_t;
 
+/*
+ * segsize is filled on receive: len when the message holds a single datagram, or
+ * the size of each coalesced datagram when SL_SOCK_FLAG_GRO is set (see sl_msg_segment_count).
+ * timestamp_ns is the kernel receive time on the sl_sys_time_real_ns clock when
+ * SL_SOCK_FLAG_TIMESTAMP is set, 0 otherwise. coalesced datagrams share the first one's time
+ */
+typedef struct sl_msg_s {
+    sl_buf_t *buf;
+    sl_endpoint_t *endpoint;
+    int32_t bufcount;
+    int32_t len;
+    int32_t segsize;
+    uint64_t timestamp_ns;
+} sl_msg_t;
+
+struct sl_impair_s;
+SL_INLINE_IMPL int sl_impair_send(struct sl_impair_s *impair, sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint);
+SL_INLINE_IMPL int sl_impair_send_batch(struct sl_impair_s *impair, sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount, const uint64_t *txtimes);
+SL_INLINE_IMPL int sl_impair_recv(struct sl_impair_s *impair, sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns);
+SL_INLINE_IMPL int sl_impair_recv_batch(struct sl_impair_s *impair, sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount);
+struct sl_capture_s;
+SL_INLINE_IMPL void sl_capture_write(struct sl_capture_s *capture, sl_sock_t *sock, bool incoming, sl_buf_t *buf, int32_t bufcount, size_t len, size_t segsize, sl_endpoint_t *peer, uint64_t timestamp_ns);
+
 SL_INLINE_IMPL void sl_sock_error_set(sl_sock_t *sock, uint32_t error)
 {
     SL_ASSERT(sock);
@@ -137,6 +266,107 @@ SL_INLINE_IMPL void sl_sock_flags_clear(sl_sock_t *sock)
     sock->flags = 0;
 }
 
+SL_INLINE_IMPL void sl_sock_stats_tx(sl_sock_t *sock, uint64_t packets, uint64_t bytes, uint32_t maxlen)
+{
+    SL_ASSERT(sock);
+#if SL_SOCK_STATS
+    sock->stats.tx_packets += packets;
+    sock->stats.tx_bytes += bytes;
+    if (maxlen > sock->stats.tx_max) sock->stats.tx_max = maxlen;
+#else
+    (void)sock, (void)packets, (void)bytes, (void)maxlen;
+#endif
+}
+
+SL_INLINE_IMPL void sl_sock_stats_rx(sl_sock_t *sock, uint64_t packets, uint64_t bytes, uint32_t maxlen)
+{
+    SL_ASSERT(sock);
+#if SL_SOCK_STATS
+    sock->stats.rx_packets += packets;
+    sock->stats.rx_bytes += bytes;
+    if (maxlen > sock->stats.rx_max) sock->stats.rx_max = maxlen;
+#else
+    (void)sock, (void)packets, (void)bytes, (void)maxlen;
+#endif
+}
+
+SL_INLINE_IMPL void sl_sock_stats_partial(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+#if SL_SOCK_STATS
+    sock->stats.tx_partial++;
+#else
+    (void)sock;
+#endif
+}
+
+SL_INLINE_IMPL void sl_sock_stats_error(sl_sock_t *sock, int error, sl_sock_flag_t wouldblock)
+{
+    SL_ASSERT(sock);
+#if SL_SOCK_STATS
+    sl_sock_stats_t *stats = &sock->stats;
+    if (sl_sys_wouldblock(error)) {
+        if (wouldblock == SL_SOCK_FLAG_WOULDBLOCK_READ) {
+            stats->rx_wouldblock++;
+        } else {
+            stats->tx_wouldblock++;
+        }
+        return;
+    }
+
+    /* PLATFORM TODO: extend error classes for your console platform */
+    switch (error) {
+#    if SL_SOCK_API_WINSOCK
+    case WSAEINTR:
+    case WSAENOBUFS:
+#    else
+    case EINTR:
+    case ENOBUFS:
+    case ENOMEM:
+#    endif
+        stats->err_transient++;
+        break;
+#    if SL_SOCK_API_WINSOCK
+    case WSAECONNREFUSED:
+    case WSAECONNRESET:
+    case WSAEHOSTUNREACH:
+    case WSAENETUNREACH:
+    case WSAENETDOWN:
+#    else
+    case ECONNREFUSED:
+    case ECONNRESET:
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+    case ENETDOWN:
+#    endif
+        stats->err_unreachable++;
+        break;
+#    if SL_SOCK_API_WINSOCK
+    case WSAEMSGSIZE:
+#    else
+    case EMSGSIZE:
+#    endif
+        stats->err_msgsize++;
+        break;
+    default:
+        stats->err_other++;
+        break;
+    }
+#else
+    (void)sock, (void)error, (void)wouldblock;
+#endif
+}
+
+/* records the os error and flags the direction which would have blocked, the poller clears it on readiness */
+SL_INLINE_IMPL void sl_sock_io_error_set(sl_sock_t *sock, sl_sock_flag_t wouldblock)
+{
+    SL_ASSERT(sock);
+    int error = sl_sys_errno();
+    sl_sock_error_set(sock, (uint32_t)error);
+    sl_sock_stats_error(sock, error, wouldblock);
+    if (sl_sys_wouldblock(error)) sl_sock_flags_set(sock, wouldblock);
+}
+
 SL_INLINE_IMPL void sl_sock_type_set(sl_sock_t *sock, sl_sock_type_t type)
 {
     SL_ASSERT(sock);
@@ -156,6 +386,7 @@ SL_INLINE_IMPL int sl_sock_create(sl_sock_t *sock, sl_sock_type_t type, sl_sock_
 
     sl_sock_type_set(sock, type);
     sl_sock_proto_set(sock, proto);
+    memset(&sock->stats, 0, sizeof(sock->stats));
     SL_GUARD(sl_sock_fd_set(sock, socket(sl_endpoint_af_get(&sock->endpoint), type, proto)));
     if (sl_endpoint_is_ipv6(&sock->endpoint)) {
         int optval = 0;
@@ -199,11 +430,169 @@ SL_INLINE_IMPL int sl_sock_bind(sl_sock_t *sock)
         sl_sock_error_set(sock, sl_sys_errno());
         return SL_ERR;
     }
+
+    /* a port of 0 leaves the pick to the kernel, read it back so endpoint is the bound address */
+    const uint16_t port = sl_endpoint_is_ipv6(&sock->endpoint) ? sock->endpoint.addr6.port : sock->endpoint.addr4.port;
+    if (!port) {
+#if SL_SOCK_API_WINSOCK
+        int epsize = (int)sizeof(sock->endpoint);
+#else
+        socklen_t epsize = (socklen_t)sizeof(sock->endpoint);
+#endif
+        if (getsockname(sl_sock_fd_get(sock), sl_endpoint_addr_get(&sock->endpoint), &epsize)) {
+            sl_sock_error_set(sock, sl_sys_errno());
+            return SL_ERR;
+        }
+    }
+    sl_sock_state_set(sock, SL_SOCK_STATE_BOUND);
+
+    return SL_OK;
+}
+
+/*
+ * a bound socket sends to and receives from anyone. an open one is connected to a single peer,
+ * the kernel keeps its route and drops datagrams from anyone else, and endpoints may be NULL
+ */
+SL_INLINE_IMPL bool sl_sock_is_ready(sl_sock_t *sock)
+{
+    return (sock->state == SL_SOCK_STATE_BOUND || sock->state == SL_SOCK_STATE_OPEN);
+}
+
+SL_INLINE_IMPL int sl_sock_connect(sl_sock_t *sock, sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(endpoint);
+    SL_ASSERT(sl_sock_is_ready(sock));
+
+#if SL_SOCK_API_WINSOCK
+    if (connect(sl_sock_fd_get(sock), sl_endpoint_addr_get(endpoint), sl_endpoint_size(endpoint))) {
+#else
+    if (connect(sl_sock_fd_get(sock), sl_endpoint_addr_get(endpoint), (socklen_t)sl_endpoint_size(endpoint))) {
+#endif
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+    sl_sock_state_set(sock, SL_SOCK_STATE_OPEN);
+    sl_sock_dir_set(sock, SL_SOCK_DIR_OUTGOING);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_sock_disconnect(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(sock->state == SL_SOCK_STATE_OPEN);
+
+    /* PLATFORM TODO: winsock dissolves the association on a zeroed address, some stacks fail with EAFNOSUPPORT after doing so */
+    sl_endpoint_t unspec;
+    memset(&unspec, 0, sizeof(unspec));
+#if SL_SOCK_API_WINSOCK
+    unspec.addr4.af = AF_INET;
+    if (connect(sl_sock_fd_get(sock), sl_endpoint_addr_get(&unspec), sizeof(unspec.addr4))) {
+#else
+    unspec.addr4.af = AF_UNSPEC;
+    if (connect(sl_sock_fd_get(sock), sl_endpoint_addr_get(&unspec), (socklen_t)sizeof(unspec.addr4)) && sl_sys_errno() != EAFNOSUPPORT) {
+#endif
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
     sl_sock_state_set(sock, SL_SOCK_STATE_BOUND);
+    sl_sock_dir_set(sock, SL_SOCK_DIR_NONE);
+
+    return SL_OK;
+}
+
+/* call between create and bind, every socket bound to the endpoint with this set shares its datagrams by flow hash */
+SL_INLINE_IMPL int sl_sock_reuseport_set(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(sock->state == SL_SOCK_STATE_CREATED);
+
+    /* PLATFORM TODO: winsock SO_REUSEADDR does not load balance, extend for your platform */
+#if defined(SO_REUSEPORT)
+    int optval = 1;
+    if (setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_REUSEPORT, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+    sl_sock_flags_set(sock, SL_SOCK_FLAG_REUSEPORT);
+
+    return SL_OK;
+#else
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+}
+
+SL_INLINE_IMPL int sl_sock_bufsize_get(sl_sock_t *sock, int optname, int32_t *size)
+{
+    int optval = 0;
+    socklen_t optlen = sizeof(optval);
+    if (getsockopt(sl_sock_fd_get(sock), SOL_SOCKET, optname, (char *)&optval, &optlen)) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+    *size = (int32_t)optval;
+
+    return SL_OK;
+}
+
+/* the FORCE variant ignores the system wide cap but needs CAP_NET_ADMIN, without it the request is silently capped */
+SL_INLINE_IMPL int sl_sock_bufsize_set(sl_sock_t *sock, int optname, int forcename, int32_t size)
+{
+    int optval = (int)size;
+
+#if SL_PLATFORM_LINUX
+    if (!setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, forcename, (const char *)&optval, sizeof(optval))) return SL_OK;
+#else
+    (void)forcename;
+#endif
+    if (setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, optname, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
 
     return SL_OK;
 }
 
+/*
+ * effective sizes are what the kernel reports back, linux doubles the request to cover its
+ * own bookkeeping and clamps it to net.core.rmem_max / wmem_max unless the FORCE option is allowed
+ */
+SL_INLINE_IMPL int sl_sock_rcvbuf_get(sl_sock_t *sock, int32_t *size)
+{
+    SL_ASSERT(sock && size);
+    return sl_sock_bufsize_get(sock, SO_RCVBUF, size);
+}
+
+SL_INLINE_IMPL int sl_sock_sndbuf_get(sl_sock_t *sock, int32_t *size)
+{
+    SL_ASSERT(sock && size);
+    return sl_sock_bufsize_get(sock, SO_SNDBUF, size);
+}
+
+SL_INLINE_IMPL int sl_sock_rcvbuf_set(sl_sock_t *sock, int32_t size)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(size > 0);
+#if SL_PLATFORM_LINUX
+    return sl_sock_bufsize_set(sock, SO_RCVBUF, SO_RCVBUFFORCE, size);
+#else
+    return sl_sock_bufsize_set(sock, SO_RCVBUF, 0, size);
+#endif
+}
+
+SL_INLINE_IMPL int sl_sock_sndbuf_set(sl_sock_t *sock, int32_t size)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(size > 0);
+#if SL_PLATFORM_LINUX
+    return sl_sock_bufsize_set(sock, SO_SNDBUF, SO_SNDBUFFORCE, size);
+#else
+    return sl_sock_bufsize_set(sock, SO_SNDBUF, 0, size);
+#endif
+}
+
 SL_INLINE_IMPL int sl_sock_blocking_set(sl_sock_t *sock)
 {
     SL_ASSERT(sock);
@@ -240,16 +629,289 @@ SL_INLINE_IMPL int sl_sock_nonblocking_set(sl_sock_t *sock)
     return SL_OK;
 }
 
-SL_INLINE_IMPL int sl_sock_send(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
+SL_INLINE_IMPL int sl_sock_gso_enable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    /* probe only, the segment size is attached per send so plain sends are unaffected */
+    int optval = 0;
+    socklen_t optlen = sizeof(optval);
+    if (getsockopt(sl_sock_fd_get(sock), SOL_UDP, UDP_SEGMENT, (char *)&optval, &optlen)) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#else
+    /* PLATFORM TODO: extend segmentation offload for your platform, sl_sock_send_gso segments manually without it */
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+    sl_sock_flags_set(sock, SL_SOCK_FLAG_GSO);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_sock_gso_disable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_GSO);
+}
+
+/*
+ * once enabled, a single receive may return a run of same-flow datagrams laid end to end,
+ * so receive through sl_sock_recv_batch to keep the boundaries, into buffers of at least SL_SOCK_GSO_BYTES_MAX
+ */
+SL_INLINE_IMPL int sl_sock_gro_enable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    int optval = 1;
+    if (setsockopt(sl_sock_fd_get(sock), SOL_UDP, UDP_GRO, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#else
+    /* PLATFORM TODO: extend receive coalescing for your platform */
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+    sl_sock_flags_set(sock, SL_SOCK_FLAG_GRO);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_sock_gro_disable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    int optval = 0;
+    if ((sock->flags & SL_SOCK_FLAG_GRO) && setsockopt(sl_sock_fd_get(sock), SOL_UDP, UDP_GRO, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#endif
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_GRO);
+
+    return SL_OK;
+}
+
+/*
+ * the kernel stamps each datagram as it is queued, comparing against sl_sys_time_real_ns
+ * after the receive gives the time spent waiting in the socket buffer
+ */
+SL_INLINE_IMPL int sl_sock_timestamp_enable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    int optval = 1;
+    if (setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_TIMESTAMPNS, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#else
+    /* PLATFORM TODO: extend receive timestamps for your platform */
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+    sl_sock_flags_set(sock, SL_SOCK_FLAG_TIMESTAMP);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_sock_timestamp_disable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    int optval = 0;
+    if ((sock->flags & SL_SOCK_FLAG_TIMESTAMP) && setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_TIMESTAMPNS, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#endif
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_TIMESTAMP);
+
+    return SL_OK;
+}
+
+/* the kernel keeps counting whether or not this is set, so the first receive after enabling picks up earlier drops */
+SL_INLINE_IMPL int sl_sock_rxq_ovfl_enable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    int optval = 1;
+    if (setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_RXQ_OVFL, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#else
+    /* PLATFORM TODO: extend receive queue drop reporting for your platform */
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+    sl_sock_flags_set(sock, SL_SOCK_FLAG_RXQ_OVFL);
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_sock_rxq_ovfl_disable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    int optval = 0;
+    if ((sock->flags & SL_SOCK_FLAG_RXQ_OVFL) && setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_RXQ_OVFL, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#endif
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_RXQ_OVFL);
+
+    return SL_OK;
+}
+
+/*
+ * routes the socket's sends through tx and its receives through rx, NULL for either goes
+ * straight to the kernel again. see sl_impair_t, datagrams it still holds stay with it.
+ * launch times are applied by tx's queue, the kernel never sees them while it is set
+ */
+SL_INLINE_IMPL void sl_sock_impair_set(sl_sock_t *sock, struct sl_impair_s *tx, struct sl_impair_s *rx)
+{
+    SL_ASSERT(sock);
+    sock->impair_tx = tx;
+    sock->impair_rx = rx;
+}
+
+/* taps every datagram the socket sends or receives into capture, NULL stops. see sl_capture_t */
+SL_INLINE_IMPL void sl_sock_capture_set(sl_sock_t *sock, struct sl_capture_s *capture)
+{
+    SL_ASSERT(sock);
+    sock->capture = capture;
+}
+
+/*
+ * caps the socket at bytes_per_sec, 0 lifts the cap. the fq qdisc spreads datagrams out to
+ * the rate, other qdiscs ignore it, so this suits a socket per peer more than a shared one
+ */
+SL_INLINE_IMPL int sl_sock_pacing_rate_set(sl_sock_t *sock, uint32_t bytes_per_sec)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    uint32_t optval = bytes_per_sec ? bytes_per_sec : UINT32_MAX;
+    if (setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_MAX_PACING_RATE, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#else
+    /* PLATFORM TODO: extend kernel pacing for your platform */
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+
+    return SL_OK;
+}
+
+/*
+ * lets sl_sock_send_batch_txtime hand each datagram a launch time on the sl_sys_time_ns
+ * clock. the fq and etf qdiscs hold datagrams until then, others send them straight away
+ */
+SL_INLINE_IMPL int sl_sock_txtime_enable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+
+#if SL_PLATFORM_LINUX
+    struct {
+        clockid_t clockid;
+        uint32_t flags;
+    } optval = {CLOCK_MONOTONIC, 0};
+    if (setsockopt(sl_sock_fd_get(sock), SOL_SOCKET, SO_TXTIME, (const char *)&optval, sizeof(optval))) {
+        sl_sock_error_set(sock, sl_sys_errno());
+        return SL_ERR;
+    }
+#else
+    /* PLATFORM TODO: extend launch times for your platform */
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+    sl_sock_flags_set(sock, SL_SOCK_FLAG_TXTIME);
+
+    return SL_OK;
+}
+
+/* there is no way to switch SO_TXTIME off again, this only stops attaching launch times */
+SL_INLINE_IMPL void sl_sock_txtime_disable(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_TXTIME);
+}
+
+SL_INLINE_IMPL uint64_t sl_sock_rx_dropped(sl_sock_t *sock)
+{
+    SL_ASSERT(sock);
+    return sock->stats.rx_dropped;
+}
+
+#if SL_PLATFORM_LINUX
+/* the counter arrives as a wrapping uint32 on every datagram, stale copies from earlier in a batch are ignored */
+SL_INLINE_IMPL bool sl_sock_cmsg_drops(sl_sock_t *sock, struct cmsghdr *cmsg)
+{
+    uint32_t drops;
+
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL) return false;
+    memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+
+    const int32_t delta = (int32_t)(drops - sock->stats.rx_dropped_kernel);
+    if (delta > 0) {
+        sock->stats.rx_dropped += (uint64_t)delta;
+        sock->stats.rx_dropped_kernel = drops;
+    }
+
+    return true;
+}
+
+/* reads SO_TIMESTAMPNS, or SO_TIMESTAMPING when the caller has set that up, preferring the hardware stamp */
+SL_INLINE_IMPL bool sl_sock_cmsg_timestamp(struct cmsghdr *cmsg, uint64_t *timestamp_ns)
+{
+    struct timespec ts[3];
+
+    if (cmsg->cmsg_level != SOL_SOCKET) return false;
+    if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+        memcpy(&ts[0], CMSG_DATA(cmsg), sizeof(ts[0]));
+    } else if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+        memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+        if (ts[2].tv_sec || ts[2].tv_nsec) ts[0] = ts[2];
+    } else {
+        return false;
+    }
+    *timestamp_ns = (uint64_t)ts[0].tv_sec * 1000000000ULL + (uint64_t)ts[0].tv_nsec;
+
+    return true;
+}
+#endif
+
+SL_INLINE_IMPL int32_t sl_msg_segment_count(sl_msg_t *msg)
+{
+    SL_ASSERT(msg);
+    if (msg->len <= 0 || msg->segsize <= 0) return 0;
+    return (msg->len + msg->segsize - 1) / msg->segsize;
+}
+
+/* straight to the kernel, past any attached sl_impair_t */
+SL_INLINE_IMPL int sl_sock_send_direct(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
 {
     SL_ASSERT(sock);
     SL_ASSERT(buf && bufcount > 0);
-    SL_ASSERT(endpoint);
-    SL_ASSERT(sock->state == SL_SOCK_STATE_BOUND);
+    SL_ASSERT(endpoint || sock->state == SL_SOCK_STATE_OPEN);
+    SL_ASSERT(sl_sock_is_ready(sock));
 
     int64_t bytes_sent;
-    struct sockaddr *sa = sl_endpoint_addr_get(endpoint);
-    const int sa_len = sl_endpoint_size(endpoint);
+    struct sockaddr *sa = endpoint ? sl_endpoint_addr_get(endpoint) : NULL;
+    const int sa_len = endpoint ? sl_endpoint_size(endpoint) : 0;
 #if SL_SOCK_API_WINSOCK
     if (WSASendTo(sl_sock_fd_get(sock), (LPWSABUF)buf, (DWORD)bufcount, (LPDWORD)&bytes_sent, 0, sa, sa_len, NULL, NULL))
     {
@@ -261,38 +923,423 @@ SL_INLINE_IMPL int sl_sock_send(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount
     mhdr.msg_iovlen = (size_t)bufcount;
     if ((bytes_sent = (ssize_t)sendmsg(sl_sock_fd_get(sock), &mhdr, 0)) < 0) {
 #endif
-        sl_sock_error_set(sock, sl_sys_errno());
+        sl_sock_io_error_set(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
         return SL_ERR;
     }
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+    sl_sock_stats_tx(sock, 1, (uint64_t)bytes_sent, (uint32_t)bytes_sent);
+#if SL_SOCK_CAPTURE
+    if (sock->capture) sl_capture_write(sock->capture, sock, false, buf, bufcount, (size_t)bytes_sent, 0, endpoint, 0);
+#endif
 
     return (int)bytes_sent;
 }
 
-SL_INLINE_IMPL int sl_sock_recv(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
+SL_INLINE_IMPL int sl_sock_send(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
+{
+#if SL_SOCK_IMPAIR
+    if (sock->impair_tx) return sl_impair_send(sock->impair_tx, sock, buf, bufcount, endpoint);
+#endif
+    return sl_sock_send_direct(sock, buf, bufcount, endpoint);
+}
+
+/* straight from the kernel, past any attached sl_impair_t. flags go to recvmsg, e.g. MSG_DONTWAIT */
+SL_INLINE_IMPL int sl_sock_recv_direct(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns, int flags)
 {
     SL_ASSERT(sock);
     SL_ASSERT(buf && bufcount);
-    SL_ASSERT(endpoint);
-    SL_ASSERT(sock->state == SL_SOCK_STATE_BOUND);
+    SL_ASSERT(endpoint || sock->state == SL_SOCK_STATE_OPEN);
+    SL_ASSERT(sl_sock_is_ready(sock));
 
     int64_t bytes_recv;
-    int32_t epsize = sizeof(*endpoint);
+    int32_t epsize = endpoint ? sizeof(*endpoint) : 0;
+    if (timestamp_ns) *timestamp_ns = 0;
 #if SL_SOCK_API_WINSOCK
-    DWORD flags = 0;
-    if (WSARecvFrom(sl_sock_fd_get(sock), (LPWSABUF)buf, (DWORD)bufcount, (LPDWORD)&bytes_recv, (LPDWORD)&flags, sl_endpoint_addr_get(endpoint), &epsize, NULL, NULL)) {
+    /* PLATFORM TODO: winsock has no per call non-blocking receive, flags are ignored */
+    DWORD wsaflags = 0;
+    (void)flags;
+    if (WSARecvFrom(sl_sock_fd_get(sock), (LPWSABUF)buf, (DWORD)bufcount, (LPDWORD)&bytes_recv, (LPDWORD)&wsaflags, endpoint ? sl_endpoint_addr_get(endpoint) : NULL, endpoint ? &epsize : NULL, NULL, NULL)) {
 #else
+    union {
+        char buf[SL_SOCK_CMSG_SPACE];
+        struct cmsghdr align;
+    } control;
+    const bool gro = (sock->flags & SL_SOCK_FLAG_GRO);
+    const bool timestamp = timestamp_ns && (sock->flags & SL_SOCK_FLAG_TIMESTAMP);
+    const bool drops = (sock->flags & SL_SOCK_FLAG_RXQ_OVFL);
+
     struct msghdr mhdr = {0};
     mhdr.msg_name = endpoint;
     mhdr.msg_namelen = (socklen_t)epsize;
     mhdr.msg_iov = (struct iovec *)buf;
     mhdr.msg_iovlen = (size_t)bufcount;
-    if ((bytes_recv = (int64_t)recvmsg(sl_sock_fd_get(sock), &mhdr, 0)) < 0) {
+    if (gro || timestamp || drops) {
+        mhdr.msg_control = control.buf;
+        mhdr.msg_controllen = sizeof(control.buf);
+    }
+    if ((bytes_recv = (int64_t)recvmsg(sl_sock_fd_get(sock), &mhdr, flags)) < 0) {
 #endif
-        sl_sock_error_set(sock, sl_sys_errno());
+        sl_sock_io_error_set(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
         return SL_ERR;
     }
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    /* a coalesced run still counts one packet per segment, though the boundaries are lost to the caller */
+    int64_t segsize = bytes_recv;
+#if !SL_SOCK_API_WINSOCK
+    if (gro || timestamp || drops) {
+        struct cmsghdr *cmsg;
+        for (cmsg = CMSG_FIRSTHDR(&mhdr); cmsg; cmsg = CMSG_NXTHDR(&mhdr, cmsg)) {
+#    if SL_PLATFORM_LINUX
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int gro_size;
+                memcpy(&gro_size, CMSG_DATA(cmsg), sizeof(gro_size));
+                if (gro_size > 0 && gro_size < bytes_recv) segsize = gro_size;
+                continue;
+            }
+#    endif
+            if (timestamp && sl_sock_cmsg_timestamp(cmsg, timestamp_ns)) continue;
+            sl_sock_cmsg_drops(sock, cmsg);
+        }
+    }
+#endif
+    sl_sock_stats_rx(sock, (segsize < bytes_recv) ? (uint64_t)((bytes_recv + segsize - 1) / segsize) : 1, (uint64_t)bytes_recv, (uint32_t)segsize);
+#if SL_SOCK_CAPTURE
+    if (sock->capture) sl_capture_write(sock->capture, sock, true, buf, bufcount, (size_t)bytes_recv, (size_t)segsize, endpoint, timestamp_ns ? *timestamp_ns : 0);
+#endif
 
     return (int)bytes_recv;
 }
 
+/* timestamp_ns is set as for sl_msg_t, pass NULL to skip reading it */
+SL_INLINE_IMPL int sl_sock_recv_timestamped(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns)
+{
+#if SL_SOCK_IMPAIR
+    if (sock->impair_rx) return sl_impair_recv(sock->impair_rx, sock, buf, bufcount, endpoint, timestamp_ns);
+#endif
+    return sl_sock_recv_direct(sock, buf, bufcount, endpoint, timestamp_ns, 0);
+}
+
+SL_INLINE_IMPL int sl_sock_recv(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
+{
+    return sl_sock_recv_timestamped(sock, buf, bufcount, endpoint, NULL);
+}
+
+/* send and receive on an open socket without naming the peer, the kernel skips the address lookup and copy */
+SL_INLINE_IMPL int sl_sock_send_connected(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount)
+{
+    SL_ASSERT(sock && sock->state == SL_SOCK_STATE_OPEN);
+    return sl_sock_send(sock, buf, bufcount, NULL);
+}
+
+SL_INLINE_IMPL int sl_sock_recv_connected(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount)
+{
+    SL_ASSERT(sock && sock->state == SL_SOCK_STATE_OPEN);
+    return sl_sock_recv_timestamped(sock, buf, bufcount, NULL, NULL);
+}
+
+/*
+ * txtimes, when given, holds a launch time per message for a socket with SL_SOCK_FLAG_TXTIME
+ * set (see sl_sock_txtime_enable). without the flag they are ignored. an impaired send holds
+ * each datagram in the impairment's queue until its launch time plus the impaired latency
+ */
+SL_INLINE_IMPL int sl_sock_send_batch_txtime(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount, const uint64_t *txtimes)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(msgs && msgcount > 0);
+    SL_ASSERT(sl_sock_is_ready(sock));
+
+#if SL_SOCK_IMPAIR
+    if (sock->impair_tx) return sl_impair_send_batch(sock->impair_tx, sock, msgs, msgcount, txtimes);
+#endif
+
+    /* a short count is a partial send, the caller resumes from msgs + count */
+    if (msgcount > SL_SOCK_BATCH_MAX) msgcount = SL_SOCK_BATCH_MAX;
+
+    int32_t msgs_sent = 0;
+#if SL_PLATFORM_LINUX
+    union {
+        char buf[CMSG_SPACE(sizeof(uint64_t))];
+        struct cmsghdr align;
+    } control[SL_SOCK_BATCH_MAX];
+    struct mmsghdr mhdrs[SL_SOCK_BATCH_MAX];
+    memset(mhdrs, 0, sizeof(*mhdrs) * (size_t)msgcount);
+    if (!(sock->flags & SL_SOCK_FLAG_TXTIME)) txtimes = NULL;
+    for (int32_t i = 0; i < msgcount; i++) {
+        SL_ASSERT(msgs[i].buf && msgs[i].bufcount > 0);
+        SL_ASSERT(msgs[i].endpoint || sock->state == SL_SOCK_STATE_OPEN);
+        if (msgs[i].endpoint) {
+            mhdrs[i].msg_hdr.msg_name = sl_endpoint_addr_get(msgs[i].endpoint);
+            mhdrs[i].msg_hdr.msg_namelen = (socklen_t)sl_endpoint_size(msgs[i].endpoint);
+        }
+        mhdrs[i].msg_hdr.msg_iov = (struct iovec *)msgs[i].buf;
+        mhdrs[i].msg_hdr.msg_iovlen = (size_t)msgs[i].bufcount;
+        if (txtimes) {
+            memset(&control[i], 0, sizeof(control[i]));
+            mhdrs[i].msg_hdr.msg_control = control[i].buf;
+            mhdrs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mhdrs[i].msg_hdr);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+            memcpy(CMSG_DATA(cmsg), &txtimes[i], sizeof(uint64_t));
+        }
+    }
+
+    /* the kernel only reports an error when nothing at all was sent */
+    if ((msgs_sent = (int32_t)sendmmsg(sl_sock_fd_get(sock), mhdrs, (unsigned int)msgcount, 0)) < 0) {
+        sl_sock_io_error_set(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+        return SL_ERR;
+    }
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+
+    uint64_t bytes_sent = 0;
+    uint32_t maxlen = 0;
+    for (int32_t i = 0; i < msgs_sent; i++) {
+        msgs[i].len = (int32_t)mhdrs[i].msg_len;
+        bytes_sent += mhdrs[i].msg_len;
+        if (mhdrs[i].msg_len > maxlen) maxlen = mhdrs[i].msg_len;
+    }
+    sl_sock_stats_tx(sock, (uint64_t)msgs_sent, bytes_sent, maxlen);
+#    if SL_SOCK_CAPTURE
+    for (int32_t i = 0; sock->capture && i < msgs_sent; i++) {
+        sl_capture_write(sock->capture, sock, false, msgs[i].buf, msgs[i].bufcount, (size_t)msgs[i].len, 0, msgs[i].endpoint, 0);
+    }
+#    endif
+#else
+    /* PLATFORM TODO: extend batched send for your platform, this falls back to one syscall per datagram */
+    (void)txtimes;
+    int bytes_sent;
+    while (msgs_sent < msgcount) {
+        if ((bytes_sent = sl_sock_send(sock, msgs[msgs_sent].buf, msgs[msgs_sent].bufcount, msgs[msgs_sent].endpoint)) < 0) break;
+        msgs[msgs_sent++].len = bytes_sent;
+    }
+    if (!msgs_sent) return SL_ERR;
+#endif
+    if (msgs_sent < msgcount) sl_sock_stats_partial(sock);
+
+    return (int)msgs_sent;
+}
+
+SL_INLINE_IMPL int sl_sock_send_batch(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount)
+{
+    return sl_sock_send_batch_txtime(sock, msgs, msgcount, NULL);
+}
+
+SL_INLINE_IMPL int sl_sock_recv_batch(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(msgs && msgcount > 0);
+    SL_ASSERT(sl_sock_is_ready(sock));
+
+#if SL_SOCK_IMPAIR
+    if (sock->impair_rx) return sl_impair_recv_batch(sock->impair_rx, sock, msgs, msgcount);
+#endif
+
+    if (msgcount > SL_SOCK_BATCH_MAX) msgcount = SL_SOCK_BATCH_MAX;
+
+    int32_t msgs_recv = 0;
+#if SL_PLATFORM_LINUX
+    struct mmsghdr mhdrs[SL_SOCK_BATCH_MAX];
+    union {
+        char buf[SL_SOCK_CMSG_SPACE];
+        struct cmsghdr align;
+    } control[SL_SOCK_BATCH_MAX];
+    const bool gro = (sock->flags & SL_SOCK_FLAG_GRO);
+    const bool timestamp = (sock->flags & SL_SOCK_FLAG_TIMESTAMP);
+    const bool drops = (sock->flags & SL_SOCK_FLAG_RXQ_OVFL);
+
+    memset(mhdrs, 0, sizeof(*mhdrs) * (size_t)msgcount);
+    for (int32_t i = 0; i < msgcount; i++) {
+        SL_ASSERT(msgs[i].buf && msgs[i].bufcount > 0);
+        SL_ASSERT(msgs[i].endpoint || sock->state == SL_SOCK_STATE_OPEN);
+        if (msgs[i].endpoint) {
+            mhdrs[i].msg_hdr.msg_name = msgs[i].endpoint;
+            mhdrs[i].msg_hdr.msg_namelen = (socklen_t)sizeof(*msgs[i].endpoint);
+        }
+        mhdrs[i].msg_hdr.msg_iov = (struct iovec *)msgs[i].buf;
+        mhdrs[i].msg_hdr.msg_iovlen = (size_t)msgs[i].bufcount;
+        if (gro || timestamp || drops) {
+            mhdrs[i].msg_hdr.msg_control = control[i].buf;
+            mhdrs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+        }
+    }
+
+    /* block for at most the first datagram, then take whatever else is already queued */
+    if ((msgs_recv = (int32_t)recvmmsg(sl_sock_fd_get(sock), mhdrs, (unsigned int)msgcount, MSG_WAITFORONE, NULL)) < 0) {
+        sl_sock_io_error_set(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+        return SL_ERR;
+    }
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    uint64_t packets_recv = 0, bytes_recv = 0;
+    uint32_t maxlen = 0;
+    for (int32_t i = 0; i < msgs_recv; i++) {
+        msgs[i].len = (int32_t)mhdrs[i].msg_len;
+        msgs[i].segsize = msgs[i].len;
+        msgs[i].timestamp_ns = 0;
+        bytes_recv += mhdrs[i].msg_len;
+        if (!gro && !timestamp && !drops) {
+            packets_recv++;
+            if (mhdrs[i].msg_len > maxlen) maxlen = mhdrs[i].msg_len;
+            continue;
+        }
+
+        struct cmsghdr *cmsg;
+        for (cmsg = CMSG_FIRSTHDR(&mhdrs[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&mhdrs[i].msg_hdr, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int segsize;
+                memcpy(&segsize, CMSG_DATA(cmsg), sizeof(segsize));
+                if (segsize > 0 && segsize < msgs[i].len) msgs[i].segsize = segsize;
+            } else if (!sl_sock_cmsg_timestamp(cmsg, &msgs[i].timestamp_ns)) {
+                sl_sock_cmsg_drops(sock, cmsg);
+            }
+        }
+        packets_recv += (msgs[i].segsize < msgs[i].len) ? (uint64_t)sl_msg_segment_count(&msgs[i]) : 1;
+        if ((uint32_t)msgs[i].segsize > maxlen) maxlen = (uint32_t)msgs[i].segsize;
+    }
+    sl_sock_stats_rx(sock, packets_recv, bytes_recv, maxlen);
+#    if SL_SOCK_CAPTURE
+    for (int32_t i = 0; sock->capture && i < msgs_recv; i++) {
+        sl_capture_write(sock->capture, sock, true, msgs[i].buf, msgs[i].bufcount, (size_t)msgs[i].len, (size_t)msgs[i].segsize, msgs[i].endpoint, msgs[i].timestamp_ns);
+    }
+#    endif
+#else
+    /* PLATFORM TODO: extend batched receive for your platform, this falls back to one syscall per datagram */
+    int bytes_recv;
+    while (msgs_recv < msgcount) {
+        if ((bytes_recv = sl_sock_recv_timestamped(sock, msgs[msgs_recv].buf, msgs[msgs_recv].bufcount, msgs[msgs_recv].endpoint, &msgs[msgs_recv].timestamp_ns)) < 0) break;
+        msgs[msgs_recv].segsize = bytes_recv;
+        msgs[msgs_recv++].len = bytes_recv;
+
+        /* a blocking socket would stall here waiting on a datagram which may never come */
+        if (!(sock->flags & SL_SOCK_FLAG_NONBLOCKING)) break;
+    }
+    if (!msgs_recv) return SL_ERR;
+#endif
+
+    return (int)msgs_recv;
+}
+
+#if SL_PLATFORM_LINUX
+SL_INLINE_IMPL int sl_sock_send_gso_segments(sl_sock_t *sock, char *base, size_t len, uint16_t segsize, sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(base && len <= SL_SOCK_GSO_BYTES_MAX);
+    SL_ASSERT(endpoint || sock->state == SL_SOCK_STATE_OPEN);
+
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov;
+    iov.iov_base = base;
+    iov.iov_len = len;
+
+    struct msghdr mhdr = {0};
+    if (endpoint) {
+        mhdr.msg_name = sl_endpoint_addr_get(endpoint);
+        mhdr.msg_namelen = (socklen_t)sl_endpoint_size(endpoint);
+    }
+    mhdr.msg_iov = &iov;
+    mhdr.msg_iovlen = 1;
+    mhdr.msg_control = control.buf;
+    mhdr.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mhdr);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cmsg), &segsize, sizeof(segsize));
+
+    int64_t bytes_sent;
+    if ((bytes_sent = (int64_t)sendmsg(sl_sock_fd_get(sock), &mhdr, 0)) < 0) {
+        sl_sock_io_error_set(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+        return SL_ERR;
+    }
+    sl_sock_flags_unset(sock, SL_SOCK_FLAG_WOULDBLOCK_WRITE);
+    sl_sock_stats_tx(sock, ((uint64_t)bytes_sent + segsize - 1) / segsize, (uint64_t)bytes_sent, (bytes_sent < segsize) ? (uint32_t)bytes_sent : segsize);
+#    if SL_SOCK_CAPTURE
+    if (sock->capture) sl_capture_write(sock->capture, sock, false, (sl_buf_t *)&iov, 1, (size_t)bytes_sent, segsize, endpoint, 0);
+#    endif
+
+    return (int)bytes_sent;
+}
+#endif
+
+SL_INLINE_IMPL int sl_sock_send_gso(sl_sock_t *sock, sl_buf_t *buf, uint16_t segsize, sl_endpoint_t *endpoint)
+{
+    SL_ASSERT(sock);
+    SL_ASSERT(buf && buf->base);
+    SL_ASSERT(segsize > 0);
+    SL_ASSERT(endpoint || sock->state == SL_SOCK_STATE_OPEN);
+    SL_ASSERT(sl_sock_is_ready(sock));
+
+    /* no single UDP datagram can carry a larger segment, and no run of them could be sized from it */
+    if (segsize > SL_SOCK_GSO_BYTES_MAX) {
+        sl_sock_error_set(sock, EMSGSIZE);
+        return SL_ERR;
+    }
+
+    char *base = buf->base;
+    size_t remaining = (size_t)buf->len;
+    int64_t bytes_total = 0;
+    int bytes_sent;
+
+    while (remaining) {
+#if SL_PLATFORM_LINUX
+        /* an impaired socket segments by hand so each datagram meets the impairment on its own */
+        if ((sock->flags & SL_SOCK_FLAG_GSO) && !(SL_SOCK_IMPAIR && sock->impair_tx)) {
+            size_t segcount = SL_SOCK_GSO_BYTES_MAX / segsize;
+            if (segcount > SL_SOCK_GSO_SEGMENTS_MAX) segcount = SL_SOCK_GSO_SEGMENTS_MAX;
+            size_t len = segcount * segsize;
+            if (!len || len > remaining) len = remaining;
+
+            if ((bytes_sent = sl_sock_send_gso_segments(sock, base, len, segsize, endpoint)) < 0) {
+                /* the route or device can't segment for us, drop to manual segmentation for good */
+                if (sock->error == EIO || sock->error == EINVAL || sock->error == EOPNOTSUPP || sock->error == ENOPROTOOPT) {
+                    sl_sock_gso_disable(sock);
+                    continue;
+                }
+                break;
+            }
+
+            base += bytes_sent;
+            remaining -= (size_t)bytes_sent;
+            bytes_total += bytes_sent;
+            continue;
+        }
+#endif
+        sl_buf_t segbufs[SL_SOCK_BATCH_MAX];
+        sl_msg_t segmsgs[SL_SOCK_BATCH_MAX];
+        int32_t segcount = 0;
+        for (size_t offset = 0; offset < remaining && segcount < SL_SOCK_BATCH_MAX; offset += segsize, segcount++) {
+            segbufs[segcount].base = base + offset;
+            segbufs[segcount].len = (remaining - offset < segsize) ? (remaining - offset) : segsize;
+            segmsgs[segcount].buf = &segbufs[segcount];
+            segmsgs[segcount].bufcount = 1;
+            segmsgs[segcount].endpoint = endpoint;
+        }
+
+        int msgs_sent;
+        if ((msgs_sent = sl_sock_send_batch(sock, segmsgs, segcount)) < 0) break;
+        for (int i = 0; i < msgs_sent; i++) {
+            base += segmsgs[i].len;
+            remaining -= (size_t)segmsgs[i].len;
+            bytes_total += segmsgs[i].len;
+        }
+    }
+
+    /* a short count is a partial send, the caller resumes from buf->base + count */
+    if (remaining && !bytes_total) return SL_ERR;
+
+    return (int)bytes_total;
+}
+
+/* the impairment and capture hooks above are defined against the finished sl_sock_t */
+#include "socklynx/capture.h"
+#include "socklynx/impair.h"
+
 #endif
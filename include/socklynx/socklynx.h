@@ -23,11 +23,25 @@
 #ifndef SL_SOCKLYNX_H
 #define SL_SOCKLYNX_H
 
+#include "socklynx/autotune.h"
 #include "socklynx/buf.h"
+#include "socklynx/bufpool.h"
+#include "socklynx/capture.h"
+#include "socklynx/channel.h"
+#include "socklynx/coalesce.h"
 #include "socklynx/common.h"
 #include "socklynx/endpoint.h"
 #include "socklynx/error.h"
+#include "socklynx/fragment.h"
+#include "socklynx/impair.h"
+#include "socklynx/iothread.h"
+#include "socklynx/pacer.h"
+#include "socklynx/peertable.h"
+#include "socklynx/poller.h"
+#include "socklynx/ring.h"
 #include "socklynx/sock.h"
+#include "socklynx/spsc.h"
 #include "socklynx/sys.h"
+#include "socklynx/timerwheel.h"
 
 #endif
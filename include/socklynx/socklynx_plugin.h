@@ -23,19 +23,197 @@
 #ifndef SL_SOCKLYNX_PLUGIN_H
 #define SL_SOCKLYNX_PLUGIN_H
 
+#include "socklynx/autotune.h"
 #include "socklynx/buf.h"
+#include "socklynx/bufpool.h"
+#include "socklynx/capture.h"
+#include "socklynx/channel.h"
+#include "socklynx/coalesce.h"
 #include "socklynx/common.h"
 #include "socklynx/endpoint.h"
 #include "socklynx/error.h"
+#include "socklynx/fragment.h"
+#include "socklynx/impair.h"
+#include "socklynx/iothread.h"
+#include "socklynx/pacer.h"
+#include "socklynx/peertable.h"
+#include "socklynx/poller.h"
 #include "socklynx/sock.h"
 #include "socklynx/sys.h"
+#include "socklynx/timerwheel.h"
 
 SL_API int32_t SL_CALL socklynx_setup(sl_sys_t *sys);
 SL_API int32_t SL_CALL socklynx_cleanup(sl_sys_t *sys);
 SL_API int32_t SL_CALL socklynx_socket_nonblocking(sl_sock_t *sock, uint32_t enabled);
+SL_API int32_t SL_CALL socklynx_socket_gso(sl_sock_t *sock, uint32_t enabled);
+SL_API int32_t SL_CALL socklynx_socket_gro(sl_sock_t *sock, uint32_t enabled);
+SL_API int32_t SL_CALL socklynx_socket_timestamp(sl_sock_t *sock, uint32_t enabled);
+SL_API int32_t SL_CALL socklynx_socket_rxq_ovfl(sl_sock_t *sock, uint32_t enabled);
+SL_API int32_t SL_CALL socklynx_socket_pacing_rate(sl_sock_t *sock, uint32_t bytes_per_sec);
+SL_API int32_t SL_CALL socklynx_socket_txtime(sl_sock_t *sock, uint32_t enabled);
+SL_API int32_t SL_CALL socklynx_socket_impair(sl_sock_t *sock, sl_impair_t *tx, sl_impair_t *rx);
+SL_API int32_t SL_CALL socklynx_socket_capture(sl_sock_t *sock, sl_capture_t *capture);
 SL_API int32_t SL_CALL socklynx_socket_open(sl_sock_t *sock);
 SL_API int32_t SL_CALL socklynx_socket_close(sl_sock_t *sock);
+SL_API int32_t SL_CALL socklynx_socket_connect(sl_sock_t *sock, sl_endpoint_t *endpoint);
+SL_API int32_t SL_CALL socklynx_socket_send_connected(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount);
+SL_API int32_t SL_CALL socklynx_socket_recv_connected(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount);
 SL_API int32_t SL_CALL socklynx_socket_send(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint);
 SL_API int32_t SL_CALL socklynx_socket_recv(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint);
+SL_API int32_t SL_CALL socklynx_socket_recv_timestamped(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns);
+SL_API int32_t SL_CALL socklynx_socket_send_gso(sl_sock_t *sock, sl_buf_t *buf, uint32_t segsize, sl_endpoint_t *endpoint);
+SL_API int32_t SL_CALL socklynx_socket_send_batch(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount);
+SL_API int32_t SL_CALL socklynx_socket_recv_batch(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount);
+SL_API int32_t SL_CALL socklynx_socket_stats(sl_sock_t *sock, sl_sock_stats_t *stats);
+SL_API int32_t SL_CALL socklynx_socket_bufsize(sl_sock_t *sock, int32_t *rcvbuf, int32_t *sndbuf);
+SL_API int32_t SL_CALL socklynx_autotune_setup(sl_autotune_t *tune);
+SL_API int32_t SL_CALL socklynx_autotune_cleanup(sl_autotune_t *tune);
+SL_API int32_t SL_CALL socklynx_autotune_update(sl_autotune_t *tune);
+SL_API int32_t SL_CALL socklynx_poller_setup(sl_poller_t *poller);
+SL_API int32_t SL_CALL socklynx_poller_cleanup(sl_poller_t *poller);
+SL_API int32_t SL_CALL socklynx_poller_add(sl_poller_t *poller, sl_sock_t *sock, uint32_t events);
+SL_API int32_t SL_CALL socklynx_poller_remove(sl_poller_t *poller, sl_sock_t *sock);
+SL_API int32_t SL_CALL socklynx_poller_wait(sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t timeout_ms);
+SL_API int32_t SL_CALL socklynx_bufpool_setup(sl_bufpool_t *pool);
+SL_API int32_t SL_CALL socklynx_bufpool_cleanup(sl_bufpool_t *pool);
+SL_API int32_t SL_CALL socklynx_bufcache_init(sl_bufcache_t *cache, sl_bufpool_t *pool);
+SL_API int32_t SL_CALL socklynx_bufcache_flush(sl_bufcache_t *cache);
+SL_API int32_t SL_CALL socklynx_bufcache_acquire(sl_bufcache_t *cache, sl_buf_t *buf);
+SL_API int32_t SL_CALL socklynx_bufcache_release(sl_bufcache_t *cache, sl_buf_t *buf);
+SL_API int32_t SL_CALL socklynx_channel_setup(sl_channel_t *ch);
+SL_API int32_t SL_CALL socklynx_channel_cleanup(sl_channel_t *ch);
+SL_API int32_t SL_CALL socklynx_channel_send(sl_channel_t *ch, sl_sock_t *sock, int32_t mode, const void *data, int32_t len);
+SL_API int32_t SL_CALL socklynx_channel_recv(sl_channel_t *ch, char *data, int32_t len, sl_buf_t *msg, int32_t *mode);
+SL_API int32_t SL_CALL socklynx_channel_next(sl_channel_t *ch, sl_buf_t *msg);
+SL_API int32_t SL_CALL socklynx_channel_update(sl_channel_t *ch, sl_sock_t *sock);
+SL_API int32_t SL_CALL socklynx_coalesce_init(sl_coalesce_t *co, char *base, int32_t capacity, sl_endpoint_t *endpoint);
+SL_API char *SL_CALL socklynx_coalesce_reserve(sl_coalesce_t *co, sl_sock_t *sock, int32_t len);
+SL_API int32_t SL_CALL socklynx_coalesce_append(sl_coalesce_t *co, sl_sock_t *sock, const void *data, int32_t len);
+SL_API int32_t SL_CALL socklynx_coalesce_flush(sl_coalesce_t *co, sl_sock_t *sock);
+SL_API int32_t SL_CALL socklynx_coalesce_flush_batch(sl_sock_t *sock, sl_coalesce_t **cos, int32_t count);
+SL_API int32_t SL_CALL socklynx_coalesce_next(char *frame, int32_t len, int32_t *offset, sl_buf_t *msg);
+SL_API int32_t SL_CALL socklynx_fragsend_init(sl_fragsend_t *fs, char *data, int32_t len, sl_endpoint_t *endpoint, uint16_t msg_id, int32_t datagram);
+SL_API int32_t SL_CALL socklynx_fragsend_send(sl_fragsend_t *fs, sl_sock_t *sock);
+SL_API int32_t SL_CALL socklynx_fragtable_setup(sl_fragtable_t *table);
+SL_API int32_t SL_CALL socklynx_fragtable_cleanup(sl_fragtable_t *table);
+SL_API int32_t SL_CALL socklynx_fragtable_recv(sl_fragtable_t *table, sl_endpoint_t *endpoint, const char *data, int32_t len, sl_buf_t *msg);
+SL_API int32_t SL_CALL socklynx_fragtable_expire(sl_fragtable_t *table);
+SL_API int32_t SL_CALL socklynx_capture_setup(sl_capture_t *capture, const char *path);
+SL_API int32_t SL_CALL socklynx_capture_cleanup(sl_capture_t *capture);
+SL_API int32_t SL_CALL socklynx_impair_setup(sl_impair_t *impair);
+SL_API int32_t SL_CALL socklynx_impair_cleanup(sl_impair_t *impair);
+SL_API int32_t SL_CALL socklynx_impair_flush(sl_impair_t *impair, sl_sock_t *sock);
+SL_API int32_t SL_CALL socklynx_pacer_init(sl_pacer_t *pacer, uint64_t rate, uint32_t burst);
+SL_API int32_t SL_CALL socklynx_pacer_send_batch(sl_pacer_t *pacer, sl_sock_t *sock, sl_msg_t *msgs, int32_t count);
+SL_API int32_t SL_CALL socklynx_peertable_setup(sl_peertable_t *table);
+SL_API int32_t SL_CALL socklynx_peertable_cleanup(sl_peertable_t *table);
+SL_API int32_t SL_CALL socklynx_peertable_insert(sl_peertable_t *table, sl_endpoint_t *endpoint, uint32_t *handle);
+SL_API int32_t SL_CALL socklynx_peertable_remove(sl_peertable_t *table, uint32_t handle);
+SL_API uint32_t SL_CALL socklynx_peertable_find(sl_peertable_t *table, sl_endpoint_t *endpoint);
+SL_API int32_t SL_CALL socklynx_peertable_find_batch(sl_peertable_t *table, sl_msg_t *msgs, int32_t count, uint32_t *handles);
+SL_API void *SL_CALL socklynx_peertable_slot(sl_peertable_t *table, uint32_t handle);
+SL_API int32_t SL_CALL socklynx_timerwheel_setup(sl_timerwheel_t *wheel);
+SL_API int32_t SL_CALL socklynx_timerwheel_cleanup(sl_timerwheel_t *wheel);
+SL_API int32_t SL_CALL socklynx_timerwheel_schedule(sl_timerwheel_t *wheel, sl_timer_t *timer, uint32_t delay_ms);
+SL_API int32_t SL_CALL socklynx_timerwheel_cancel(sl_timerwheel_t *wheel, sl_timer_t *timer);
+SL_API int32_t SL_CALL socklynx_timerwheel_advance(sl_timerwheel_t *wheel, sl_timer_t **expired, int32_t count);
+SL_API int32_t SL_CALL socklynx_timerwheel_poll(sl_timerwheel_t *wheel, sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t max_ms);
+SL_API sl_iothread_t *SL_CALL socklynx_iothread_start(sl_sock_t *sock, sl_bufpool_t *pool, uint32_t capacity, int32_t wait_ms);
+SL_API int32_t SL_CALL socklynx_iothread_stop(sl_iothread_t *io);
+
+#define SL_API_VERSION 1
+
+/*
+ * every export above as a function pointer, so managed code can bind them once and call through
+ * delegate* unmanaged[Cdecl] (calli) instead of going through a DllImport stub on each call.
+ * members are only ever appended, each addition bumps SL_API_VERSION, so the table for any
+ * older version is a prefix of this one. every argument and result is a pointer or a fixed
+ * size integer and blittable as it is, nothing may be marshalled on the way through
+ */
+typedef struct sl_api_s {
+    uint32_t version; /* SL_API_VERSION of the plugin */
+    uint32_t size;    /* sizeof(sl_api_t) of the plugin */
+    int32_t (SL_CALL *setup)(sl_sys_t *sys);
+    int32_t (SL_CALL *cleanup)(sl_sys_t *sys);
+    int32_t (SL_CALL *socket_nonblocking)(sl_sock_t *sock, uint32_t enabled);
+    int32_t (SL_CALL *socket_gso)(sl_sock_t *sock, uint32_t enabled);
+    int32_t (SL_CALL *socket_gro)(sl_sock_t *sock, uint32_t enabled);
+    int32_t (SL_CALL *socket_timestamp)(sl_sock_t *sock, uint32_t enabled);
+    int32_t (SL_CALL *socket_rxq_ovfl)(sl_sock_t *sock, uint32_t enabled);
+    int32_t (SL_CALL *socket_pacing_rate)(sl_sock_t *sock, uint32_t bytes_per_sec);
+    int32_t (SL_CALL *socket_txtime)(sl_sock_t *sock, uint32_t enabled);
+    int32_t (SL_CALL *socket_impair)(sl_sock_t *sock, sl_impair_t *tx, sl_impair_t *rx);
+    int32_t (SL_CALL *socket_capture)(sl_sock_t *sock, sl_capture_t *capture);
+    int32_t (SL_CALL *socket_open)(sl_sock_t *sock);
+    int32_t (SL_CALL *socket_close)(sl_sock_t *sock);
+    int32_t (SL_CALL *socket_connect)(sl_sock_t *sock, sl_endpoint_t *endpoint);
+    int32_t (SL_CALL *socket_send_connected)(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount);
+    int32_t (SL_CALL *socket_recv_connected)(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount);
+    int32_t (SL_CALL *socket_send)(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint);
+    int32_t (SL_CALL *socket_recv)(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint);
+    int32_t (SL_CALL *socket_recv_timestamped)(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns);
+    int32_t (SL_CALL *socket_send_gso)(sl_sock_t *sock, sl_buf_t *buf, uint32_t segsize, sl_endpoint_t *endpoint);
+    int32_t (SL_CALL *socket_send_batch)(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount);
+    int32_t (SL_CALL *socket_recv_batch)(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount);
+    int32_t (SL_CALL *socket_stats)(sl_sock_t *sock, sl_sock_stats_t *stats);
+    int32_t (SL_CALL *socket_bufsize)(sl_sock_t *sock, int32_t *rcvbuf, int32_t *sndbuf);
+    int32_t (SL_CALL *autotune_setup)(sl_autotune_t *tune);
+    int32_t (SL_CALL *autotune_cleanup)(sl_autotune_t *tune);
+    int32_t (SL_CALL *autotune_update)(sl_autotune_t *tune);
+    int32_t (SL_CALL *poller_setup)(sl_poller_t *poller);
+    int32_t (SL_CALL *poller_cleanup)(sl_poller_t *poller);
+    int32_t (SL_CALL *poller_add)(sl_poller_t *poller, sl_sock_t *sock, uint32_t events);
+    int32_t (SL_CALL *poller_remove)(sl_poller_t *poller, sl_sock_t *sock);
+    int32_t (SL_CALL *poller_wait)(sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t timeout_ms);
+    int32_t (SL_CALL *bufpool_setup)(sl_bufpool_t *pool);
+    int32_t (SL_CALL *bufpool_cleanup)(sl_bufpool_t *pool);
+    int32_t (SL_CALL *bufcache_init)(sl_bufcache_t *cache, sl_bufpool_t *pool);
+    int32_t (SL_CALL *bufcache_flush)(sl_bufcache_t *cache);
+    int32_t (SL_CALL *bufcache_acquire)(sl_bufcache_t *cache, sl_buf_t *buf);
+    int32_t (SL_CALL *bufcache_release)(sl_bufcache_t *cache, sl_buf_t *buf);
+    int32_t (SL_CALL *channel_setup)(sl_channel_t *ch);
+    int32_t (SL_CALL *channel_cleanup)(sl_channel_t *ch);
+    int32_t (SL_CALL *channel_send)(sl_channel_t *ch, sl_sock_t *sock, int32_t mode, const void *data, int32_t len);
+    int32_t (SL_CALL *channel_recv)(sl_channel_t *ch, char *data, int32_t len, sl_buf_t *msg, int32_t *mode);
+    int32_t (SL_CALL *channel_next)(sl_channel_t *ch, sl_buf_t *msg);
+    int32_t (SL_CALL *channel_update)(sl_channel_t *ch, sl_sock_t *sock);
+    int32_t (SL_CALL *coalesce_init)(sl_coalesce_t *co, char *base, int32_t capacity, sl_endpoint_t *endpoint);
+    char *(SL_CALL *coalesce_reserve)(sl_coalesce_t *co, sl_sock_t *sock, int32_t len);
+    int32_t (SL_CALL *coalesce_append)(sl_coalesce_t *co, sl_sock_t *sock, const void *data, int32_t len);
+    int32_t (SL_CALL *coalesce_flush)(sl_coalesce_t *co, sl_sock_t *sock);
+    int32_t (SL_CALL *coalesce_flush_batch)(sl_sock_t *sock, sl_coalesce_t **cos, int32_t count);
+    int32_t (SL_CALL *coalesce_next)(char *frame, int32_t len, int32_t *offset, sl_buf_t *msg);
+    int32_t (SL_CALL *fragsend_init)(sl_fragsend_t *fs, char *data, int32_t len, sl_endpoint_t *endpoint, uint16_t msg_id, int32_t datagram);
+    int32_t (SL_CALL *fragsend_send)(sl_fragsend_t *fs, sl_sock_t *sock);
+    int32_t (SL_CALL *fragtable_setup)(sl_fragtable_t *table);
+    int32_t (SL_CALL *fragtable_cleanup)(sl_fragtable_t *table);
+    int32_t (SL_CALL *fragtable_recv)(sl_fragtable_t *table, sl_endpoint_t *endpoint, const char *data, int32_t len, sl_buf_t *msg);
+    int32_t (SL_CALL *fragtable_expire)(sl_fragtable_t *table);
+    int32_t (SL_CALL *capture_setup)(sl_capture_t *capture, const char *path);
+    int32_t (SL_CALL *capture_cleanup)(sl_capture_t *capture);
+    int32_t (SL_CALL *impair_setup)(sl_impair_t *impair);
+    int32_t (SL_CALL *impair_cleanup)(sl_impair_t *impair);
+    int32_t (SL_CALL *impair_flush)(sl_impair_t *impair, sl_sock_t *sock);
+    int32_t (SL_CALL *pacer_init)(sl_pacer_t *pacer, uint64_t rate, uint32_t burst);
+    int32_t (SL_CALL *pacer_send_batch)(sl_pacer_t *pacer, sl_sock_t *sock, sl_msg_t *msgs, int32_t count);
+    int32_t (SL_CALL *peertable_setup)(sl_peertable_t *table);
+    int32_t (SL_CALL *peertable_cleanup)(sl_peertable_t *table);
+    int32_t (SL_CALL *peertable_insert)(sl_peertable_t *table, sl_endpoint_t *endpoint, uint32_t *handle);
+    int32_t (SL_CALL *peertable_remove)(sl_peertable_t *table, uint32_t handle);
+    uint32_t (SL_CALL *peertable_find)(sl_peertable_t *table, sl_endpoint_t *endpoint);
+    int32_t (SL_CALL *peertable_find_batch)(sl_peertable_t *table, sl_msg_t *msgs, int32_t count, uint32_t *handles);
+    void *(SL_CALL *peertable_slot)(sl_peertable_t *table, uint32_t handle);
+    int32_t (SL_CALL *timerwheel_setup)(sl_timerwheel_t *wheel);
+    int32_t (SL_CALL *timerwheel_cleanup)(sl_timerwheel_t *wheel);
+    int32_t (SL_CALL *timerwheel_schedule)(sl_timerwheel_t *wheel, sl_timer_t *timer, uint32_t delay_ms);
+    int32_t (SL_CALL *timerwheel_cancel)(sl_timerwheel_t *wheel, sl_timer_t *timer);
+    int32_t (SL_CALL *timerwheel_advance)(sl_timerwheel_t *wheel, sl_timer_t **expired, int32_t count);
+    int32_t (SL_CALL *timerwheel_poll)(sl_timerwheel_t *wheel, sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t max_ms);
+    sl_iothread_t *(SL_CALL *iothread_start)(sl_sock_t *sock, sl_bufpool_t *pool, uint32_t capacity, int32_t wait_ms);
+    int32_t (SL_CALL *iothread_stop)(sl_iothread_t *io);
+} sl_api_t;
+
+/* returns the table, or NULL for a version newer than the plugin's. the table is static, never free it */
+SL_API const sl_api_t *SL_CALL socklynx_get_api(uint32_t version);
 
 #endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_SPSC_H
+#define SL_SPSC_H
+
+#include "socklynx/buf.h"
+#include "socklynx/common.h"
+#include "socklynx/endpoint.h"
+#include "socklynx/error.h"
+#include "socklynx/sys.h"
+
+/*
+ * Lock-free single producer, single consumer ring of packets. head is written only by the
+ * consumer and tail only by the producer, each on its own cache line, with acquire/release
+ * ordering on the index the other side owns. Indices run free and wrap, the entry count is
+ * tail - head. The layout is fixed so managed code can push and pop on the shared memory
+ * without calling into the plugin.
+ */
+
+typedef struct sl_packet_s {
+    sl_buf_t buf;
+    sl_endpoint_t endpoint;
+    int32_t len;
+} sl_packet_t;
+
+typedef struct sl_spsc_s {
+    volatile uint32_t head;
+    char pad0[SL_SYS_CACHELINE - sizeof(uint32_t)];
+    volatile uint32_t tail;
+    char pad1[SL_SYS_CACHELINE - sizeof(uint32_t)];
+    uint32_t mask;
+    uint32_t reserved;
+    sl_packet_t *entries;
+    char pad2[SL_SYS_CACHELINE - sizeof(uint64_t) - sizeof(sl_packet_t *)];
+} sl_spsc_t;
+
+#if SL_64
+SL_STATIC_ASSERT(sizeof(sl_packet_t) == 48);
+SL_STATIC_ASSERT(sizeof(sl_spsc_t) == 3 * SL_SYS_CACHELINE);
+#endif
+
+/* capacity must be a power of two, entries must hold capacity packets */
+SL_INLINE_IMPL void sl_spsc_init(sl_spsc_t *ring, sl_packet_t *entries, uint32_t capacity)
+{
+    SL_ASSERT(ring && entries);
+    SL_ASSERT(capacity && !(capacity & (capacity - 1)));
+    memset(ring, 0, sizeof(*ring));
+    ring->mask = capacity - 1;
+    ring->entries = entries;
+}
+
+SL_INLINE_IMPL uint32_t sl_spsc_capacity(sl_spsc_t *ring)
+{
+    return ring->mask + 1;
+}
+
+/* either side may call these, the answer is only a snapshot */
+SL_INLINE_IMPL uint32_t sl_spsc_count(sl_spsc_t *ring)
+{
+    return sl_sys_atomic_load32(&ring->tail) - sl_sys_atomic_load32(&ring->head);
+}
+
+SL_INLINE_IMPL uint32_t sl_spsc_space(sl_spsc_t *ring)
+{
+    return sl_spsc_capacity(ring) - sl_spsc_count(ring);
+}
+
+/* producer side */
+SL_INLINE_IMPL int sl_spsc_push(sl_spsc_t *ring, sl_packet_t *packet)
+{
+    const uint32_t tail = ring->tail;
+    if (tail - sl_sys_atomic_load32(&ring->head) > ring->mask) return SL_ERR;
+
+    ring->entries[tail & ring->mask] = *packet;
+    sl_sys_atomic_store32(&ring->tail, tail + 1);
+
+    return SL_OK;
+}
+
+/* consumer side */
+SL_INLINE_IMPL int sl_spsc_pop(sl_spsc_t *ring, sl_packet_t *packet)
+{
+    const uint32_t head = ring->head;
+    if (sl_sys_atomic_load32(&ring->tail) == head) return SL_ERR;
+
+    *packet = ring->entries[head & ring->mask];
+    sl_sys_atomic_store32(&ring->head, head + 1);
+
+    return SL_OK;
+}
+
+/* consumer side, points at up to max queued packets without taking them, valid until consumed */
+SL_INLINE_IMPL uint32_t sl_spsc_peek(sl_spsc_t *ring, sl_packet_t **packets, uint32_t max)
+{
+    const uint32_t head = ring->head;
+    uint32_t count = sl_sys_atomic_load32(&ring->tail) - head;
+    if (count > max) count = max;
+    for (uint32_t i = 0; i < count; i++) {
+        packets[i] = &ring->entries[(head + i) & ring->mask];
+    }
+
+    return count;
+}
+
+SL_INLINE_IMPL void sl_spsc_consume(sl_spsc_t *ring, uint32_t count)
+{
+    SL_ASSERT(count <= ring->tail - ring->head);
+    sl_sys_atomic_store32(&ring->head, ring->head + count);
+}
+
+#endif
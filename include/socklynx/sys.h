@@ -26,6 +26,27 @@
 #include "socklynx/common.h"
 #include "socklynx/error.h"
 
+#if SL_SOCK_API_WINSOCK
+#    define SL_SYS_POLLFD WSAPOLLFD
+#else
+#    include <poll.h>
+#    include <pthread.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <time.h>
+#    define SL_SYS_POLLFD struct pollfd
+#endif
+
+#if SL_PLATFORM_LINUX
+#    include <sched.h>
+#endif
+
+#if SL_C_MSC
+#    include <intrin.h>
+#endif
+
+#define SL_SYS_CACHELINE 64
+
 enum sl_sys_state {
     SL_SYS_STATE_STOPPED,
     SL_SYS_STATE_STARTED,
@@ -37,6 +58,31 @@ typedef struct sl_sys_s {
     uint16_t af_inet6;
 } sl_sys_t;
 
+/* a whole file mapped into memory, see sl_sys_map_open */
+typedef struct sl_sys_map_s {
+    char *base;
+    size_t size;
+    bool writable;
+#if SL_SOCK_API_WINSOCK
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} sl_sys_map_t;
+
+typedef void (*sl_sys_thread_fn)(void *arg);
+
+typedef struct sl_sys_thread_s {
+#if SL_SOCK_API_WINSOCK
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    sl_sys_thread_fn fn;
+    void *arg;
+} sl_sys_thread_t;
+
 SL_INLINE_IMPL int sl_sys_errno(void)
 {
     /* PLATFORM TODO: extend OS error retrieval for your console platform */
@@ -48,6 +94,372 @@ SL_INLINE_IMPL int sl_sys_errno(void)
     return SL_OK;
 }
 
+SL_INLINE_IMPL bool sl_sys_wouldblock(int error)
+{
+    /* PLATFORM TODO: extend would block detection for your console platform */
+#if SL_SOCK_API_WINSOCK
+    return (error == WSAEWOULDBLOCK);
+#else
+    return (error == EAGAIN || error == EWOULDBLOCK);
+#endif
+}
+
+/* an icmp error from an earlier send to a peer which is gone, the socket itself is fine */
+SL_INLINE_IMPL bool sl_sys_unreachable(int error)
+{
+    /* PLATFORM TODO: extend unreachable detection for your console platform */
+#if SL_SOCK_API_WINSOCK
+    return (error == WSAECONNRESET || error == WSAECONNREFUSED || error == WSAEHOSTUNREACH || error == WSAENETUNREACH);
+#else
+    return (error == ECONNREFUSED || error == EHOSTUNREACH || error == ENETUNREACH);
+#endif
+}
+
+SL_INLINE_IMPL int sl_sys_poll(SL_SYS_POLLFD *fds, uint32_t nfds, int32_t timeout_ms)
+{
+    /* PLATFORM TODO: extend readiness polling for your console platform */
+#if SL_SOCK_API_WINSOCK
+    return WSAPoll(fds, (ULONG)nfds, timeout_ms);
+#else
+    return poll(fds, (nfds_t)nfds, timeout_ms);
+#endif
+}
+
+/* PLATFORM TODO: the atomics below assume a gcc compatible compiler or msvc, extend for your toolchain */
+SL_INLINE_IMPL uint32_t sl_sys_atomic_load32(volatile uint32_t *ptr)
+{
+#if SL_C_MSC
+    uint32_t value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+SL_INLINE_IMPL void sl_sys_atomic_store32(volatile uint32_t *ptr, uint32_t value)
+{
+#if SL_C_MSC
+    _ReadWriteBarrier();
+    *ptr = value;
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+SL_INLINE_IMPL bool sl_sys_atomic_cas32(volatile uint32_t *ptr, uint32_t expected, uint32_t desired)
+{
+#if SL_C_MSC
+    return ((uint32_t)_InterlockedCompareExchange((volatile long *)ptr, (long)desired, (long)expected) == expected);
+#else
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+#endif
+}
+
+/* returns the value before the add */
+SL_INLINE_IMPL uint64_t sl_sys_atomic_add64(volatile uint64_t *ptr, uint64_t value)
+{
+#if SL_C_MSC
+    return (uint64_t)_InterlockedExchangeAdd64((volatile __int64 *)ptr, (__int64)value);
+#else
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+SL_INLINE_IMPL bool sl_sys_atomic_cas64(volatile uint64_t *ptr, uint64_t expected, uint64_t desired)
+{
+#if SL_C_MSC
+    return ((uint64_t)_InterlockedCompareExchange64((volatile __int64 *)ptr, (__int64)desired, (__int64)expected) == expected);
+#else
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+SL_INLINE_IMPL void sl_sys_cpu_relax(void)
+{
+#if SL_C_MSC
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/* read prefetch hint, a no-op where the compiler has no intrinsic */
+SL_INLINE_IMPL void sl_sys_prefetch(const void *ptr)
+{
+#if SL_C_MSC
+    _mm_prefetch((const char *)ptr, _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, 0, 3);
+#else
+    (void)ptr;
+#endif
+}
+
+/* index of the lowest set bit, v must not be 0 */
+SL_INLINE_IMPL uint32_t sl_sys_ctz32(uint32_t v)
+{
+#if SL_C_MSC
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(v);
+#endif
+}
+
+SL_INLINE_IMPL uint32_t sl_sys_ctz64(uint64_t v)
+{
+#if SL_C_MSC
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(v);
+#endif
+}
+
+SL_INLINE_IMPL void *sl_sys_aligned_alloc(size_t size, size_t align)
+{
+#if SL_C_MSC
+    return _aligned_malloc(size, align);
+#else
+    void *ptr;
+    if (posix_memalign(&ptr, align, size)) return NULL;
+    return ptr;
+#endif
+}
+
+SL_INLINE_IMPL void sl_sys_aligned_free(void *ptr)
+{
+#if SL_C_MSC
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/* monotonic clock for measuring intervals, not wall time */
+SL_INLINE_IMPL uint64_t sl_sys_time_ns(void)
+{
+    /* PLATFORM TODO: extend monotonic time for your console platform */
+#if SL_SOCK_API_WINSOCK
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((now.QuadPart / freq.QuadPart) * 1000000000ULL + ((now.QuadPart % freq.QuadPart) * 1000000000ULL) / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* wall clock in ns since the unix epoch, the clock kernel receive timestamps are taken on */
+SL_INLINE_IMPL uint64_t sl_sys_time_real_ns(void)
+{
+    /* PLATFORM TODO: extend wall time for your console platform */
+#if SL_SOCK_API_WINSOCK
+    FILETIME ft;
+    GetSystemTimePreciseAsFileTime(&ft);
+    const uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (ticks - 116444736000000000ULL) * 100ULL;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+SL_INLINE_IMPL void sl_sys_sleep_ms(uint32_t ms)
+{
+#if SL_SOCK_API_WINSOCK
+    Sleep(ms);
+#else
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) && errno == EINTR) {
+    }
+#endif
+}
+
+SL_INLINE_IMPL uint32_t sl_sys_cpu_count(void)
+{
+    /* PLATFORM TODO: extend processor count for your console platform */
+#if SL_SOCK_API_WINSOCK
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (uint32_t)count : 1;
+#endif
+}
+
+#if SL_SOCK_API_WINSOCK
+SL_INLINE_IMPL DWORD WINAPI sl_sys_thread_entry(LPVOID arg)
+{
+    sl_sys_thread_t *thread = (sl_sys_thread_t *)arg;
+    thread->fn(thread->arg);
+    return 0;
+}
+#else
+SL_INLINE_IMPL void *sl_sys_thread_entry(void *arg)
+{
+    sl_sys_thread_t *thread = (sl_sys_thread_t *)arg;
+    thread->fn(thread->arg);
+    return NULL;
+}
+#endif
+
+/* thread must stay valid until sl_sys_thread_join returns */
+SL_INLINE_IMPL int sl_sys_thread_start(sl_sys_thread_t *thread, sl_sys_thread_fn fn, void *arg)
+{
+    SL_ASSERT(thread && fn);
+    thread->fn = fn;
+    thread->arg = arg;
+
+    /* PLATFORM TODO: extend thread creation for your console platform */
+#if SL_SOCK_API_WINSOCK
+    thread->handle = CreateThread(NULL, 0, sl_sys_thread_entry, thread, 0, NULL);
+    if (!thread->handle) return SL_ERR;
+#else
+    if (pthread_create(&thread->handle, NULL, sl_sys_thread_entry, thread)) return SL_ERR;
+#endif
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_sys_thread_join(sl_sys_thread_t *thread)
+{
+    SL_ASSERT(thread);
+
+#if SL_SOCK_API_WINSOCK
+    if (WaitForSingleObject(thread->handle, INFINITE) != WAIT_OBJECT_0) return SL_ERR;
+    CloseHandle(thread->handle);
+#else
+    if (pthread_join(thread->handle, NULL)) return SL_ERR;
+#endif
+
+    return SL_OK;
+}
+
+/* pins the calling thread to a single cpu, a no-op where affinity is not supported */
+SL_INLINE_IMPL int sl_sys_thread_affinity_set(uint32_t cpu)
+{
+    /* PLATFORM TODO: extend thread affinity for your console platform */
+#if SL_SOCK_API_WINSOCK
+    if (!SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (cpu % (8 * sizeof(DWORD_PTR))))) return SL_ERR;
+#elif SL_PLATFORM_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) return SL_ERR;
+#else
+    (void)cpu;
+#endif
+
+    return SL_OK;
+}
+
+/*
+ * maps the file at path. writable creates or truncates it to size bytes and shares writes
+ * with the file, otherwise the existing file is mapped read only and size is set from it
+ */
+SL_INLINE_IMPL int sl_sys_map_open(sl_sys_map_t *map, const char *path, size_t size, bool writable)
+{
+    SL_ASSERT(map && path);
+
+    map->base = NULL;
+    map->writable = writable;
+    /* PLATFORM TODO: extend file mapping for your console platform */
+#if SL_SOCK_API_WINSOCK
+    map->mapping = NULL;
+    map->file = CreateFileA(path, writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, NULL, writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (map->file == INVALID_HANDLE_VALUE) return SL_ERR;
+
+    LARGE_INTEGER len;
+    if (writable) {
+        len.QuadPart = (LONGLONG)size;
+    } else if (!GetFileSizeEx(map->file, &len)) {
+        goto cleanup;
+    }
+    map->size = (size_t)len.QuadPart;
+    if (!map->size) goto cleanup;
+
+    map->mapping = CreateFileMappingA(map->file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, (DWORD)(len.QuadPart >> 32), (DWORD)len.QuadPart, NULL);
+    if (!map->mapping) goto cleanup;
+    map->base = (char *)MapViewOfFile(map->mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, map->size);
+    if (!map->base) goto cleanup;
+
+    return SL_OK;
+
+cleanup:
+    if (map->mapping) CloseHandle(map->mapping);
+    CloseHandle(map->file);
+    map->mapping = NULL;
+    map->file = INVALID_HANDLE_VALUE;
+    return SL_ERR;
+#else
+    map->fd = open(path, writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+    if (map->fd < 0) return SL_ERR;
+
+    if (writable) {
+        if (ftruncate(map->fd, (off_t)size)) goto cleanup;
+        map->size = size;
+    } else {
+        struct stat st;
+        if (fstat(map->fd, &st)) goto cleanup;
+        map->size = (size_t)st.st_size;
+    }
+    if (!map->size) goto cleanup;
+
+    void *base = mmap(NULL, map->size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, map->fd, 0);
+    if (base == MAP_FAILED) goto cleanup;
+    map->base = (char *)base;
+
+    return SL_OK;
+
+cleanup:
+    close(map->fd);
+    map->fd = -1;
+    return SL_ERR;
+#endif
+}
+
+/* unmaps the file, a writable one is cut down to the first len bytes */
+SL_INLINE_IMPL int sl_sys_map_close(sl_sys_map_t *map, size_t len)
+{
+    SL_ASSERT(map);
+    if (!map->base) return SL_OK;
+
+    int rv = SL_OK;
+#if SL_SOCK_API_WINSOCK
+    UnmapViewOfFile(map->base);
+    CloseHandle(map->mapping);
+    if (map->writable) {
+        LARGE_INTEGER pos;
+        pos.QuadPart = (LONGLONG)len;
+        if (!SetFilePointerEx(map->file, pos, NULL, FILE_BEGIN) || !SetEndOfFile(map->file)) rv = SL_ERR;
+    }
+    CloseHandle(map->file);
+    map->mapping = NULL;
+    map->file = INVALID_HANDLE_VALUE;
+#else
+    munmap(map->base, map->size);
+    if (map->writable && ftruncate(map->fd, (off_t)len)) rv = SL_ERR;
+    close(map->fd);
+    map->fd = -1;
+#endif
+    map->base = NULL;
+    map->size = 0;
+
+    return rv;
+}
+
 SL_INLINE_IMPL int sl_sys_setup(sl_sys_t *sys)
 {
     SL_ASSERT(sys);
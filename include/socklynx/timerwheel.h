@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_TIMERWHEEL_H
+#define SL_TIMERWHEEL_H
+
+#include "socklynx/common.h"
+#include "socklynx/error.h"
+#include "socklynx/poller.h"
+#include "socklynx/sys.h"
+
+/*
+ * sl_timerwheel_t schedules any number of caller owned sl_timer_t, typically one or two
+ * embedded in each peer's state, on SL_TIMERWHEEL_LEVELS wheels of 64 slots. Level 0 slots
+ * are one tick wide and each level above is 64 times coarser. Slots are circular lists, so
+ * schedule and cancel are O(1) and never allocate. A timer past the top level parks in its
+ * last slot and is placed again when that slot comes around.
+ *
+ * sl_timerwheel_advance moves the clock forward. When it crosses a slot boundary of a higher
+ * level, it moves that slot's timers down a level; due timers go on an expired list, which it
+ * hands back in batches. A bitmap per level lets it skip runs of empty ticks. The same bitmaps
+ * give the next time anything can happen, so sl_timerwheel_poll can hand the poller a wait
+ * that ends at the next deadline instead of a fixed tick.
+ */
+
+#define SL_TIMERWHEEL_LEVELS 4
+#define SL_TIMERWHEEL_BITS 6
+#define SL_TIMERWHEEL_SLOTS (1 << SL_TIMERWHEEL_BITS)
+#define SL_TIMERWHEEL_MASK (SL_TIMERWHEEL_SLOTS - 1)
+#define SL_TIMERWHEEL_SPAN (1ULL << (SL_TIMERWHEEL_BITS * SL_TIMERWHEEL_LEVELS))
+#define SL_TIMERWHEEL_EXPIRED (SL_TIMERWHEEL_LEVELS * SL_TIMERWHEEL_SLOTS)
+#define SL_TIMERWHEEL_TICK_NS_DEFAULT 1000000ULL
+
+typedef enum sl_timerwheel_state_e {
+    SL_TIMERWHEEL_STATE_NEW,
+    SL_TIMERWHEEL_STATE_STARTED,
+    SL_TIMERWHEEL_STATE_STOPPED,
+} sl_timerwheel_state_t;
+
+/* zero before first use, data is the caller's, e.g. a sl_peertable_t handle */
+typedef struct sl_timer_s {
+    struct sl_timer_s *next;
+    struct sl_timer_s *prev;
+    uint64_t expires;
+    uint64_t data;
+    uint32_t slot;
+} sl_timer_t;
+
+/* optionally set tick_ns before sl_timerwheel_setup */
+typedef struct sl_timerwheel_s {
+    uint64_t tick_ns;
+    uint32_t state;
+    uint32_t error;
+    uint64_t base_ns;
+    uint64_t now;
+    uint64_t count;
+    uint64_t occupied[SL_TIMERWHEEL_LEVELS];
+    sl_timer_t *slots;
+} sl_timerwheel_t;
+
+SL_INLINE_IMPL bool sl_timer_pending(sl_timer_t *timer)
+{
+    SL_ASSERT(timer);
+    return timer->next != NULL;
+}
+
+SL_INLINE_IMPL int sl_timerwheel_cleanup(sl_timerwheel_t *wheel)
+{
+    SL_ASSERT(wheel);
+    if (wheel->state != SL_TIMERWHEEL_STATE_STARTED) return SL_OK;
+
+    /* leave no timer pointing into the freed heads */
+    for (uint32_t i = 0; i <= SL_TIMERWHEEL_EXPIRED; i++) {
+        sl_timer_t *head = &wheel->slots[i];
+        for (sl_timer_t *timer = head->next, *next; timer != head; timer = next) {
+            next = timer->next;
+            timer->next = timer->prev = NULL;
+        }
+    }
+    free(wheel->slots);
+    wheel->slots = NULL;
+    wheel->count = 0;
+    wheel->state = SL_TIMERWHEEL_STATE_STOPPED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL int sl_timerwheel_setup(sl_timerwheel_t *wheel)
+{
+    SL_ASSERT(wheel);
+    SL_ASSERT(wheel->state != SL_TIMERWHEEL_STATE_STARTED);
+
+    if (!wheel->tick_ns) wheel->tick_ns = SL_TIMERWHEEL_TICK_NS_DEFAULT;
+    wheel->slots = (sl_timer_t *)malloc((SL_TIMERWHEEL_EXPIRED + 1) * sizeof(*wheel->slots));
+    if (!wheel->slots) {
+        wheel->error = ENOMEM;
+        return SL_ERR;
+    }
+    for (uint32_t i = 0; i <= SL_TIMERWHEEL_EXPIRED; i++) {
+        wheel->slots[i].next = wheel->slots[i].prev = &wheel->slots[i];
+    }
+    memset(wheel->occupied, 0, sizeof(wheel->occupied));
+    wheel->base_ns = sl_sys_time_ns();
+    wheel->now = 0;
+    wheel->count = 0;
+    wheel->error = 0;
+    wheel->state = SL_TIMERWHEEL_STATE_STARTED;
+
+    return SL_OK;
+}
+
+SL_INLINE_IMPL void sl_timerwheel_link(sl_timerwheel_t *wheel, sl_timer_t *timer, uint32_t slot)
+{
+    sl_timer_t *head = &wheel->slots[slot];
+    timer->slot = slot;
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+    if (slot < SL_TIMERWHEEL_EXPIRED) {
+        wheel->occupied[slot >> SL_TIMERWHEEL_BITS] |= 1ULL << (slot & SL_TIMERWHEEL_MASK);
+    }
+}
+
+SL_INLINE_IMPL void sl_timerwheel_unlink(sl_timerwheel_t *wheel, sl_timer_t *timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    const uint32_t slot = timer->slot;
+    if (slot < SL_TIMERWHEEL_EXPIRED && wheel->slots[slot].next == &wheel->slots[slot]) {
+        wheel->occupied[slot >> SL_TIMERWHEEL_BITS] &= ~(1ULL << (slot & SL_TIMERWHEEL_MASK));
+    }
+    timer->next = timer->prev = NULL;
+}
+
+/* files timer by how far off it is from the current tick */
+SL_INLINE_IMPL void sl_timerwheel_place(sl_timerwheel_t *wheel, sl_timer_t *timer)
+{
+    if (timer->expires <= wheel->now) {
+        sl_timerwheel_link(wheel, timer, SL_TIMERWHEEL_EXPIRED);
+        return;
+    }
+
+    uint64_t expires = timer->expires;
+    const uint64_t delta = expires - wheel->now;
+    if (delta >= SL_TIMERWHEEL_SPAN) expires = wheel->now + SL_TIMERWHEEL_SPAN - 1;
+
+    uint32_t level = 0;
+    while (level < SL_TIMERWHEEL_LEVELS - 1 && delta >= 1ULL << (SL_TIMERWHEEL_BITS * (level + 1))) level++;
+    const uint32_t slot = (uint32_t)(expires >> (SL_TIMERWHEEL_BITS * level)) & SL_TIMERWHEEL_MASK;
+    sl_timerwheel_link(wheel, timer, level * SL_TIMERWHEEL_SLOTS + slot);
+}
+
+SL_INLINE_IMPL uint64_t sl_timerwheel_tick(sl_timerwheel_t *wheel, uint64_t time_ns)
+{
+    return time_ns > wheel->base_ns ? (time_ns - wheel->base_ns) / wheel->tick_ns : 0;
+}
+
+SL_INLINE_IMPL void sl_timerwheel_cancel(sl_timerwheel_t *wheel, sl_timer_t *timer)
+{
+    SL_ASSERT(wheel && wheel->state == SL_TIMERWHEEL_STATE_STARTED);
+    SL_ASSERT(timer);
+
+    if (!sl_timer_pending(timer)) return;
+    sl_timerwheel_unlink(wheel, timer);
+    wheel->count--;
+}
+
+/* (re)schedules timer to fire at deadline_ns on the sl_sys_time_ns clock, rounded up to a tick so it never fires early */
+SL_INLINE_IMPL void sl_timerwheel_schedule(sl_timerwheel_t *wheel, sl_timer_t *timer, uint64_t deadline_ns)
+{
+    SL_ASSERT(wheel && wheel->state == SL_TIMERWHEEL_STATE_STARTED);
+    SL_ASSERT(timer);
+
+    sl_timerwheel_cancel(wheel, timer);
+    const uint64_t offset = deadline_ns > wheel->base_ns ? deadline_ns - wheel->base_ns : 0;
+    timer->expires = (offset + wheel->tick_ns - 1) / wheel->tick_ns;
+    sl_timerwheel_place(wheel, timer);
+    wheel->count++;
+}
+
+/* moves every timer of a higher level slot down to where it now belongs */
+SL_INLINE_IMPL void sl_timerwheel_cascade(sl_timerwheel_t *wheel, uint32_t level)
+{
+    const uint32_t slot = level * SL_TIMERWHEEL_SLOTS + ((uint32_t)(wheel->now >> (SL_TIMERWHEEL_BITS * level)) & SL_TIMERWHEEL_MASK);
+    sl_timer_t *head = &wheel->slots[slot];
+    if (head->next == head) return;
+
+    sl_timer_t *timer = head->next;
+    head->prev->next = NULL;
+    head->next = head->prev = head;
+    wheel->occupied[level] &= ~(1ULL << (slot & SL_TIMERWHEEL_MASK));
+    while (timer) {
+        sl_timer_t *next = timer->next;
+        sl_timerwheel_place(wheel, timer);
+        timer = next;
+    }
+}
+
+/*
+ * runs the clock up to now_ns and hands back up to count due timers, which are no longer
+ * scheduled once returned. more than count may be due, call again while it returns count
+ */
+SL_INLINE_IMPL uint32_t sl_timerwheel_advance(sl_timerwheel_t *wheel, uint64_t now_ns, sl_timer_t **expired, uint32_t count)
+{
+    SL_ASSERT(wheel && wheel->state == SL_TIMERWHEEL_STATE_STARTED);
+    SL_ASSERT(expired || !count);
+
+    const uint64_t target = sl_timerwheel_tick(wheel, now_ns);
+    while (wheel->now < target) {
+        if (!wheel->occupied[0] && !wheel->occupied[1] && !wheel->occupied[2] && !wheel->occupied[3]) {
+            wheel->now = target;
+            break;
+        }
+
+        /* inside a level 0 lap, jump straight to the next occupied slot or the end of the lap */
+        uint64_t tick = wheel->now + 1;
+        if (tick & SL_TIMERWHEEL_MASK) {
+            const uint64_t ahead = wheel->occupied[0] >> (tick & SL_TIMERWHEEL_MASK);
+            tick = ahead ? tick + sl_sys_ctz64(ahead) : (tick | SL_TIMERWHEEL_MASK) + 1;
+            if (tick > target) {
+                wheel->now = target;
+                break;
+            }
+        }
+        wheel->now = tick;
+
+        /* on a lap boundary, upper levels hand down first so their timers land below */
+        uint32_t levels = 0;
+        while (levels < SL_TIMERWHEEL_LEVELS - 1 && !(tick & ((1ULL << (SL_TIMERWHEEL_BITS * (levels + 1))) - 1))) levels++;
+        for (uint32_t level = levels; level > 0; level--) {
+            sl_timerwheel_cascade(wheel, level);
+        }
+
+        const uint32_t slot = (uint32_t)(tick & SL_TIMERWHEEL_MASK);
+        sl_timer_t *head = &wheel->slots[slot];
+        if (head->next != head) {
+            sl_timer_t *exp = &wheel->slots[SL_TIMERWHEEL_EXPIRED];
+            head->next->prev = exp->prev;
+            exp->prev->next = head->next;
+            head->prev->next = exp;
+            exp->prev = head->prev;
+            head->next = head->prev = head;
+            wheel->occupied[0] &= ~(1ULL << slot);
+            for (sl_timer_t *timer = exp->next; timer != exp; timer = timer->next) timer->slot = SL_TIMERWHEEL_EXPIRED;
+        }
+    }
+
+    uint32_t n = 0;
+    sl_timer_t *exp = &wheel->slots[SL_TIMERWHEEL_EXPIRED];
+    while (n < count && exp->next != exp) {
+        sl_timer_t *timer = exp->next;
+        sl_timerwheel_unlink(wheel, timer);
+        wheel->count--;
+        expired[n++] = timer;
+    }
+
+    return n;
+}
+
+/*
+ * the earliest time sl_timerwheel_advance could have work, never later than the next expiry.
+ * a timer on an upper level reports when its slot is moved down, which can be early.
+ * 0 when timers are already due, UINT64_MAX when none are scheduled
+ */
+SL_INLINE_IMPL uint64_t sl_timerwheel_deadline(sl_timerwheel_t *wheel)
+{
+    SL_ASSERT(wheel && wheel->state == SL_TIMERWHEEL_STATE_STARTED);
+
+    if (wheel->slots[SL_TIMERWHEEL_EXPIRED].next != &wheel->slots[SL_TIMERWHEEL_EXPIRED]) return 0;
+
+    uint64_t best = UINT64_MAX;
+    for (uint32_t level = 0; level < SL_TIMERWHEEL_LEVELS; level++) {
+        const uint64_t occupied = wheel->occupied[level];
+        if (!occupied) continue;
+
+        /* slots after the current one come first, rotate so they sit at the bottom */
+        const uint32_t shift = SL_TIMERWHEEL_BITS * level;
+        const uint64_t next = (wheel->now >> shift) + 1;
+        const uint32_t rot = (uint32_t)(next & SL_TIMERWHEEL_MASK);
+        const uint64_t rotated = rot ? (occupied >> rot) | (occupied << (SL_TIMERWHEEL_SLOTS - rot)) : occupied;
+        const uint64_t tick = (next + sl_sys_ctz64(rotated)) << shift;
+        if (tick < best) best = tick;
+    }
+    if (best == UINT64_MAX) return UINT64_MAX;
+
+    return wheel->base_ns + best * wheel->tick_ns;
+}
+
+/* milliseconds from now_ns until sl_timerwheel_deadline, rounded up and capped at max_ms, -1 for no cap */
+SL_INLINE_IMPL int32_t sl_timerwheel_timeout_ms(sl_timerwheel_t *wheel, uint64_t now_ns, int32_t max_ms)
+{
+    const uint64_t deadline = sl_timerwheel_deadline(wheel);
+    if (deadline == UINT64_MAX) return max_ms;
+    if (deadline <= now_ns) return 0;
+
+    const uint64_t wait_ms = (deadline - now_ns + 999999ULL) / 1000000ULL;
+    if (max_ms >= 0 && wait_ms > (uint64_t)max_ms) return max_ms;
+    return wait_ms > INT32_MAX ? INT32_MAX : (int32_t)wait_ms;
+}
+
+/* sl_poller_wait that returns no later than the next timer deadline */
+SL_INLINE_IMPL int sl_timerwheel_poll(sl_timerwheel_t *wheel, sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t max_ms)
+{
+    return sl_poller_wait(poller, events, count, sl_timerwheel_timeout_ms(wheel, sl_sys_time_ns(), max_ms));
+}
+
+#endif
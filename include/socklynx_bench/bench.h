@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SL_BENCH_H
+#define SL_BENCH_H
+
+#include "socklynx/socklynx.h"
+#include "socklynx/socklynx_plugin.h"
+
+#define SL_BENCH_PORT_DEFAULT 51443
+#define SL_BENCH_ITERATIONS_DEFAULT 20000
+#define SL_BENCH_REPS_DEFAULT 7
+#define SL_BENCH_SIZE_DEFAULT 64
+#define SL_BENCH_BATCH 32
+/* datagrams sent before draining them, small enough to always fit the default receive buffer */
+#define SL_BENCH_ROUND 64
+
+typedef enum sl_bench_format_e {
+    SL_BENCH_FORMAT_CSV,
+    SL_BENCH_FORMAT_JSON,
+} sl_bench_format_t;
+
+typedef struct sl_bench_s {
+    sl_bench_format_t format;
+    uint64_t iterations;
+    uint32_t reps;
+    int32_t size;
+    uint16_t port;
+    const char *filter;
+    const char *label;
+} sl_bench_t;
+
+/* one socket pair over loopback plus the buffers every case reuses */
+typedef struct sl_bench_case_s {
+    const char *af;
+    const char *mode;
+    const char *api;
+    int32_t batch;
+    bool plugin;
+    sl_sock_t tx;
+    sl_sock_t rx;
+    sl_endpoint_t target;
+    char txmem[2048];
+    char rxmem[SL_BENCH_BATCH][2048];
+    sl_buf_t txbuf;
+    sl_buf_t rxbufs[SL_BENCH_BATCH];
+    sl_endpoint_t endpoints[SL_BENCH_BATCH];
+    sl_msg_t txmsgs[SL_BENCH_BATCH];
+    sl_msg_t rxmsgs[SL_BENCH_BATCH];
+    uint64_t retries;
+} sl_bench_case_t;
+
+#endif
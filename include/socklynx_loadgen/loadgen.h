@@ -23,4 +23,138 @@
 #ifndef SL_LOADGEN_H
 #define SL_LOADGEN_H
 
+#include "socklynx/socklynx.h"
+
+#define SL_LOADGEN_PORT_DEFAULT 51343
+#define SL_LOADGEN_INTERVAL_MS_DEFAULT 1000
+#define SL_LOADGEN_TIMEOUT_MS_DEFAULT 1000
+#define SL_LOADGEN_DRAIN_MS 500
+#define SL_LOADGEN_MAGIC 0x534c4c47
+#define SL_LOADGEN_PAYLOAD_MIN ((int32_t)sizeof(sl_loadgen_header_t))
+#define SL_LOADGEN_PAYLOAD_MAX 1472
+#define SL_LOADGEN_CACHELINE 64
+/* held datagrams per direction per client while impaired */
+#define SL_LOADGEN_IMPAIR_CAPACITY 256
+
+/* log linear buckets, 16 per power of two which keeps every bucket within ~6% of its value */
+#define SL_LOADGEN_HIST_SUB_BITS 4
+#define SL_LOADGEN_HIST_SUB (1 << SL_LOADGEN_HIST_SUB_BITS)
+#define SL_LOADGEN_HIST_BUCKETS ((64 - SL_LOADGEN_HIST_SUB_BITS + 1) * SL_LOADGEN_HIST_SUB)
+
+typedef enum sl_loadgen_mode_e {
+    SL_LOADGEN_MODE_OPEN,
+    SL_LOADGEN_MODE_CLOSED,
+    SL_LOADGEN_MODE_REPLAY,
+} sl_loadgen_mode_t;
+
+typedef enum sl_loadgen_dist_e {
+    SL_LOADGEN_DIST_FIXED,
+    SL_LOADGEN_DIST_UNIFORM,
+    SL_LOADGEN_DIST_IMIX,
+} sl_loadgen_dist_t;
+
+/* leads every datagram, the echo carries it back so rtt needs no per packet state */
+typedef struct sl_loadgen_header_s {
+    uint32_t magic;
+    uint32_t client;
+    uint64_t seq;
+    uint64_t sent_ns;
+} sl_loadgen_header_t;
+
+typedef struct sl_loadgen_hist_s {
+    uint64_t counts[SL_LOADGEN_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+} sl_loadgen_hist_t;
+
+typedef struct sl_loadgen_client_s {
+    sl_sock_t sock;
+    uint32_t id;
+    uint32_t inflight;
+    uint64_t seq;
+    uint64_t progress_ns;
+    sl_impair_t impair_tx;
+    sl_impair_t impair_rx;
+} sl_loadgen_client_t;
+
+/* every worker walks the whole capture and plays the datagrams falling to its clients */
+typedef struct sl_loadgen_replay_s {
+    sl_capture_reader_t reader;
+    sl_capture_packet_t packet;
+    bool pending;
+    uint64_t index;    /* datagrams played so far, picks the client */
+    uint64_t first_ns; /* capture time of the first datagram */
+    uint64_t last_ns;
+    uint64_t count;  /* datagrams in one loop, known once the first ends */
+    uint64_t lap_ns; /* capture time added for each loop through the file */
+} sl_loadgen_replay_t;
+
+struct sl_loadgen_s;
+
+typedef struct sl_loadgen_sample_s {
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t timeouts;
+} sl_loadgen_sample_t;
+
+/*
+ * counters and histogram are written by the worker only. the reporter bumps report_seq, the worker copies
+ * them into the report fields between polls and answers with report_ack, once stopped they are read directly
+ */
+typedef struct sl_loadgen_worker_s {
+    struct sl_loadgen_s *loadgen;
+    sl_sys_thread_t thread;
+    sl_poller_t poller;
+    sl_loadgen_client_t *clients;
+    uint32_t client_count;
+    uint32_t first;
+    uint32_t id;
+    uint32_t error;
+    uint64_t rng;
+    char pad0[SL_LOADGEN_CACHELINE];
+    volatile uint64_t tx_packets;
+    volatile uint64_t tx_bytes;
+    volatile uint64_t rx_packets;
+    volatile uint64_t rx_bytes;
+    volatile uint64_t timeouts;
+    char pad1[SL_LOADGEN_CACHELINE];
+    sl_loadgen_hist_t hist;
+    volatile uint32_t report_seq;
+    volatile uint32_t report_ack;
+    volatile uint32_t stopped;
+    sl_loadgen_sample_t report_sample;
+    sl_loadgen_hist_t report_hist;
+    sl_loadgen_replay_t replay;
+} sl_loadgen_worker_t;
+
+typedef struct sl_loadgen_s {
+    sl_sys_t sys;
+    sl_endpoint_t target;
+    sl_loadgen_mode_t mode;
+    sl_loadgen_dist_t dist;
+    int32_t size_min;
+    int32_t size_max;
+    uint64_t rate;
+    uint32_t clients;
+    uint32_t threads;
+    uint32_t window;
+    uint32_t batch;
+    uint32_t interval_ms;
+    uint32_t duration_s;
+    uint32_t timeout_ms;
+    uint64_t seed;
+    sl_impair_t impair; /* template for every client's two directions */
+    bool impaired;
+    const char *replay_path;
+    double replay_speed; /* multiple of the captured timing, 0 as fast as possible */
+    uint16_t replay_port; /* only datagrams to this port, 0 for all */
+    bool replay_stamp;
+    volatile bool sending;
+    volatile bool running;
+    sl_loadgen_worker_t *workers;
+} sl_loadgen_t;
+
 #endif
@@ -23,4 +23,60 @@
 #ifndef SL_SERVER_H
 #define SL_SERVER_H
 
+#include "socklynx/socklynx.h"
+
+#define SL_SERVER_PORT_DEFAULT 51343
+#define SL_SERVER_INTERVAL_MS_DEFAULT 1000
+#define SL_SERVER_BUF_SIZE 2048
+#define SL_SERVER_GRO_BUF_SIZE 65536
+#define SL_SERVER_CACHELINE 64
+
+typedef enum sl_server_mode_e {
+    SL_SERVER_MODE_ECHO,
+    SL_SERVER_MODE_DISCARD,
+} sl_server_mode_t;
+
+struct sl_server_s;
+
+/* one per receive thread, counters are written by the worker only and sampled by the reporter */
+typedef struct sl_server_worker_s {
+    struct sl_server_s *server;
+    sl_sys_thread_t thread;
+    sl_sock_t sock;
+    sl_poller_t poller;
+    uint32_t id;
+    uint32_t error;
+    char pad0[SL_SERVER_CACHELINE];
+    volatile uint64_t rx_packets;
+    volatile uint64_t rx_bytes;
+    volatile uint64_t tx_packets;
+    volatile uint64_t tx_bytes;
+    volatile uint64_t tx_errors;
+    char pad1[SL_SERVER_CACHELINE];
+} sl_server_worker_t;
+
+typedef struct sl_server_sample_s {
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+} sl_server_sample_t;
+
+typedef struct sl_server_s {
+    sl_sys_t sys;
+    sl_endpoint_t endpoint;
+    sl_server_mode_t mode;
+    uint32_t threads;
+    uint32_t batch;
+    uint32_t interval_ms;
+    uint32_t duration_s;
+    uint32_t pacing_rate;
+    bool gro;
+    bool pin;
+    const char *capture_path;
+    sl_capture_t capture; /* shared by every worker's socket */
+    volatile bool running;
+    sl_server_worker_t *workers;
+} sl_server_t;
+
 #endif
@@ -40,6 +40,69 @@ SL_API int32_t SL_CALL socklynx_socket_nonblocking(sl_sock_t *sock, uint32_t ena
     return sl_sock_blocking_set(sock);
 }
 
+SL_API int32_t SL_CALL socklynx_socket_gso(sl_sock_t *sock, uint32_t enabled)
+{
+    SL_GUARD_NULL(sock);
+    if (enabled) return sl_sock_gso_enable(sock);
+    sl_sock_gso_disable(sock);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_socket_gro(sl_sock_t *sock, uint32_t enabled)
+{
+    SL_GUARD_NULL(sock);
+    if (enabled) return sl_sock_gro_enable(sock);
+    return sl_sock_gro_disable(sock);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_timestamp(sl_sock_t *sock, uint32_t enabled)
+{
+    SL_GUARD_NULL(sock);
+    if (enabled) return sl_sock_timestamp_enable(sock);
+    return sl_sock_timestamp_disable(sock);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_rxq_ovfl(sl_sock_t *sock, uint32_t enabled)
+{
+    SL_GUARD_NULL(sock);
+    if (enabled) return sl_sock_rxq_ovfl_enable(sock);
+    return sl_sock_rxq_ovfl_disable(sock);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_pacing_rate(sl_sock_t *sock, uint32_t bytes_per_sec)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    return sl_sock_pacing_rate_set(sock, bytes_per_sec);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_txtime(sl_sock_t *sock, uint32_t enabled)
+{
+    SL_GUARD_NULL(sock);
+    if (enabled) return sl_sock_txtime_enable(sock);
+    sl_sock_txtime_disable(sock);
+    return SL_OK;
+}
+
+/* NULL for either direction detaches it, the impairments stay the caller's to clean up */
+SL_API int32_t SL_CALL socklynx_socket_impair(sl_sock_t *sock, sl_impair_t *tx, sl_impair_t *rx)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD(tx && tx->state != SL_IMPAIR_STATE_STARTED);
+    SL_GUARD(rx && rx->state != SL_IMPAIR_STATE_STARTED);
+    sl_sock_impair_set(sock, tx, rx);
+    return SL_OK;
+}
+
+/* NULL detaches, the capture stays the caller's to clean up once no socket uses it */
+SL_API int32_t SL_CALL socklynx_socket_capture(sl_sock_t *sock, sl_capture_t *capture)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD(capture && capture->state != SL_CAPTURE_STATE_STARTED);
+    sl_sock_capture_set(sock, capture);
+    return SL_OK;
+}
+
 SL_API int32_t SL_CALL socklynx_socket_open(sl_sock_t *sock)
 {
     SL_GUARD_NULL(sock);
@@ -54,6 +117,34 @@ SL_API int32_t SL_CALL socklynx_socket_close(sl_sock_t *sock)
     return sl_sock_close(sock);
 }
 
+/* a NULL endpoint dissolves the association and returns the socket to bound */
+SL_API int32_t SL_CALL socklynx_socket_connect(sl_sock_t *sock, sl_endpoint_t *endpoint)
+{
+    SL_GUARD_NULL(sock);
+    if (!endpoint) {
+        SL_GUARD(sock->state != SL_SOCK_STATE_OPEN);
+        return sl_sock_disconnect(sock);
+    }
+    SL_GUARD(!sl_sock_is_ready(sock));
+    return sl_sock_connect(sock, endpoint);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_send_connected(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(buf);
+    SL_GUARD(sock->state != SL_SOCK_STATE_OPEN);
+    return sl_sock_send_connected(sock, buf, bufcount);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_recv_connected(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(buf);
+    SL_GUARD(sock->state != SL_SOCK_STATE_OPEN);
+    return sl_sock_recv_connected(sock, buf, bufcount);
+}
+
 SL_API int32_t SL_CALL socklynx_socket_send(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint)
 {
     SL_GUARD_NULL(sock);
@@ -69,3 +160,609 @@ SL_API int32_t SL_CALL socklynx_socket_recv(sl_sock_t *sock, sl_buf_t *buf, int3
     SL_GUARD_NULL(endpoint);
     return sl_sock_recv(sock, buf, bufcount, endpoint);
 }
+
+SL_API int32_t SL_CALL socklynx_socket_recv_timestamped(sl_sock_t *sock, sl_buf_t *buf, int32_t bufcount, sl_endpoint_t *endpoint, uint64_t *timestamp_ns)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(buf);
+    SL_GUARD_NULL(endpoint);
+    return sl_sock_recv_timestamped(sock, buf, bufcount, endpoint, timestamp_ns);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_send_gso(sl_sock_t *sock, sl_buf_t *buf, uint32_t segsize, sl_endpoint_t *endpoint)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(buf);
+    SL_GUARD_NULL(endpoint);
+    SL_GUARD(segsize == 0 || segsize > SL_SOCK_GSO_BYTES_MAX);
+    return sl_sock_send_gso(sock, buf, (uint16_t)segsize, endpoint);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_send_batch(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(msgs);
+    SL_GUARD(msgcount <= 0);
+    return sl_sock_send_batch(sock, msgs, msgcount);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_recv_batch(sl_sock_t *sock, sl_msg_t *msgs, int32_t msgcount)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(msgs);
+    SL_GUARD(msgcount <= 0);
+    return sl_sock_recv_batch(sock, msgs, msgcount);
+}
+
+SL_API int32_t SL_CALL socklynx_socket_stats(sl_sock_t *sock, sl_sock_stats_t *stats)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(stats);
+#if SL_SOCK_STATS
+    *stats = sock->stats;
+    return SL_OK;
+#else
+    sl_sock_error_set(sock, ENOPROTOOPT);
+    return SL_ERR;
+#endif
+}
+
+/* sizes above zero are requested first, both are then overwritten with the effective sizes */
+SL_API int32_t SL_CALL socklynx_socket_bufsize(sl_sock_t *sock, int32_t *rcvbuf, int32_t *sndbuf)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(rcvbuf);
+    SL_GUARD_NULL(sndbuf);
+    if (*rcvbuf > 0) SL_GUARD(sl_sock_rcvbuf_set(sock, *rcvbuf));
+    if (*sndbuf > 0) SL_GUARD(sl_sock_sndbuf_set(sock, *sndbuf));
+    SL_GUARD(sl_sock_rcvbuf_get(sock, rcvbuf));
+    return sl_sock_sndbuf_get(sock, sndbuf);
+}
+
+SL_API int32_t SL_CALL socklynx_autotune_setup(sl_autotune_t *tune)
+{
+    SL_GUARD_NULL(tune);
+    SL_GUARD(tune->state == SL_AUTOTUNE_STATE_STARTED);
+    return sl_autotune_setup(tune);
+}
+
+SL_API int32_t SL_CALL socklynx_autotune_cleanup(sl_autotune_t *tune)
+{
+    SL_GUARD_NULL(tune);
+    return sl_autotune_cleanup(tune);
+}
+
+SL_API int32_t SL_CALL socklynx_autotune_update(sl_autotune_t *tune)
+{
+    SL_GUARD_NULL(tune);
+    SL_GUARD(tune->state != SL_AUTOTUNE_STATE_STARTED);
+    return sl_autotune_update(tune, sl_sys_time_ns());
+}
+
+SL_API int32_t SL_CALL socklynx_poller_setup(sl_poller_t *poller)
+{
+    SL_GUARD_NULL(poller);
+    SL_GUARD(poller->state == SL_POLLER_STATE_STARTED);
+    return sl_poller_setup(poller);
+}
+
+SL_API int32_t SL_CALL socklynx_poller_cleanup(sl_poller_t *poller)
+{
+    SL_GUARD_NULL(poller);
+    return sl_poller_cleanup(poller);
+}
+
+SL_API int32_t SL_CALL socklynx_poller_add(sl_poller_t *poller, sl_sock_t *sock, uint32_t events)
+{
+    SL_GUARD_NULL(poller);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(poller->state != SL_POLLER_STATE_STARTED);
+    return sl_poller_add(poller, sock, events);
+}
+
+SL_API int32_t SL_CALL socklynx_poller_remove(sl_poller_t *poller, sl_sock_t *sock)
+{
+    SL_GUARD_NULL(poller);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(poller->state != SL_POLLER_STATE_STARTED);
+    return sl_poller_remove(poller, sock);
+}
+
+SL_API int32_t SL_CALL socklynx_poller_wait(sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t timeout_ms)
+{
+    SL_GUARD_NULL(poller);
+    SL_GUARD_NULL(events);
+    SL_GUARD(count <= 0);
+    SL_GUARD(poller->state != SL_POLLER_STATE_STARTED);
+    return sl_poller_wait(poller, events, count, timeout_ms);
+}
+
+SL_API int32_t SL_CALL socklynx_bufpool_setup(sl_bufpool_t *pool)
+{
+    SL_GUARD_NULL(pool);
+    SL_GUARD(pool->state == SL_BUFPOOL_STATE_STARTED);
+    return sl_bufpool_setup(pool);
+}
+
+SL_API int32_t SL_CALL socklynx_bufpool_cleanup(sl_bufpool_t *pool)
+{
+    SL_GUARD_NULL(pool);
+    return sl_bufpool_cleanup(pool);
+}
+
+SL_API int32_t SL_CALL socklynx_bufcache_init(sl_bufcache_t *cache, sl_bufpool_t *pool)
+{
+    SL_GUARD_NULL(cache);
+    SL_GUARD_NULL(pool);
+    SL_GUARD(pool->state != SL_BUFPOOL_STATE_STARTED);
+    sl_bufcache_init(cache, pool);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_bufcache_flush(sl_bufcache_t *cache)
+{
+    SL_GUARD_NULL(cache);
+    SL_GUARD_NULL(cache->pool);
+    sl_bufcache_flush(cache);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_bufcache_acquire(sl_bufcache_t *cache, sl_buf_t *buf)
+{
+    SL_GUARD_NULL(cache);
+    SL_GUARD_NULL(cache->pool);
+    SL_GUARD_NULL(buf);
+    return sl_bufcache_acquire(cache, buf);
+}
+
+SL_API int32_t SL_CALL socklynx_bufcache_release(sl_bufcache_t *cache, sl_buf_t *buf)
+{
+    SL_GUARD_NULL(cache);
+    SL_GUARD_NULL(cache->pool);
+    SL_GUARD_NULL(buf);
+    sl_bufpool_t *pool = cache->pool;
+    /* managed callers can hand back anything, so check the buffer really is one of our slots */
+    SL_GUARD(buf->base < pool->arena || buf->base >= pool->arena + (size_t)pool->slotsize * pool->slotcount);
+    SL_GUARD((size_t)(buf->base - pool->arena) % pool->slotsize);
+    sl_bufcache_release(cache, buf);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_channel_setup(sl_channel_t *ch)
+{
+    SL_GUARD_NULL(ch);
+    SL_GUARD(ch->state == SL_CHANNEL_STATE_STARTED);
+    return sl_channel_setup(ch);
+}
+
+SL_API int32_t SL_CALL socklynx_channel_cleanup(sl_channel_t *ch)
+{
+    SL_GUARD_NULL(ch);
+    return sl_channel_cleanup(ch);
+}
+
+SL_API int32_t SL_CALL socklynx_channel_send(sl_channel_t *ch, sl_sock_t *sock, int32_t mode, const void *data, int32_t len)
+{
+    SL_GUARD_NULL(ch);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(!data && len);
+    SL_GUARD(ch->state != SL_CHANNEL_STATE_STARTED);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    SL_GUARD(!ch->endpoint && sock->state != SL_SOCK_STATE_OPEN);
+    return sl_channel_send(ch, sock, (sl_channel_mode_t)mode, data, len, sl_sys_time_ns());
+}
+
+SL_API int32_t SL_CALL socklynx_channel_recv(sl_channel_t *ch, char *data, int32_t len, sl_buf_t *msg, int32_t *mode)
+{
+    SL_GUARD_NULL(ch);
+    SL_GUARD_NULL(data);
+    SL_GUARD_NULL(msg);
+    SL_GUARD(ch->state != SL_CHANNEL_STATE_STARTED);
+
+    sl_channel_mode_t type = SL_CHANNEL_UNRELIABLE;
+    int rv = sl_channel_recv(ch, data, len, sl_sys_time_ns(), msg, &type);
+    if (mode) *mode = (int32_t)type;
+    return rv;
+}
+
+SL_API int32_t SL_CALL socklynx_channel_next(sl_channel_t *ch, sl_buf_t *msg)
+{
+    SL_GUARD_NULL(ch);
+    SL_GUARD_NULL(msg);
+    SL_GUARD(ch->state != SL_CHANNEL_STATE_STARTED);
+    return sl_channel_next(ch, msg);
+}
+
+SL_API int32_t SL_CALL socklynx_channel_update(sl_channel_t *ch, sl_sock_t *sock)
+{
+    SL_GUARD_NULL(ch);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(ch->state != SL_CHANNEL_STATE_STARTED);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    SL_GUARD(!ch->endpoint && sock->state != SL_SOCK_STATE_OPEN);
+    return sl_channel_update(ch, sock, sl_sys_time_ns());
+}
+
+SL_API int32_t SL_CALL socklynx_coalesce_init(sl_coalesce_t *co, char *base, int32_t capacity, sl_endpoint_t *endpoint)
+{
+    SL_GUARD_NULL(co);
+    SL_GUARD_NULL(base);
+    SL_GUARD(capacity <= 0);
+    sl_coalesce_init(co, base, capacity, endpoint);
+    return SL_OK;
+}
+
+SL_API char *SL_CALL socklynx_coalesce_reserve(sl_coalesce_t *co, sl_sock_t *sock, int32_t len)
+{
+    if (!co || !co->frame.base) return NULL;
+    if (!sock || !sl_sock_is_ready(sock)) return NULL;
+    if (!co->endpoint && sock->state != SL_SOCK_STATE_OPEN) return NULL;
+    return sl_coalesce_reserve(co, sock, len);
+}
+
+SL_API int32_t SL_CALL socklynx_coalesce_append(sl_coalesce_t *co, sl_sock_t *sock, const void *data, int32_t len)
+{
+    SL_GUARD_NULL(data);
+    char *dst = socklynx_coalesce_reserve(co, sock, len);
+    SL_GUARD_NULL(dst);
+    memcpy(dst, data, (size_t)len);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_coalesce_flush(sl_coalesce_t *co, sl_sock_t *sock)
+{
+    SL_GUARD_NULL(co);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    SL_GUARD(!co->endpoint && sock->state != SL_SOCK_STATE_OPEN);
+    return sl_coalesce_flush(co, sock);
+}
+
+SL_API int32_t SL_CALL socklynx_coalesce_flush_batch(sl_sock_t *sock, sl_coalesce_t **cos, int32_t count)
+{
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(cos);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    SL_GUARD(count < 0);
+    for (int32_t i = 0; i < count; i++) {
+        SL_GUARD_NULL(cos[i]);
+        SL_GUARD(!cos[i]->endpoint && sock->state != SL_SOCK_STATE_OPEN);
+    }
+    return sl_coalesce_flush_batch(sock, cos, count);
+}
+
+SL_API int32_t SL_CALL socklynx_coalesce_next(char *frame, int32_t len, int32_t *offset, sl_buf_t *msg)
+{
+    SL_GUARD_NULL(frame);
+    SL_GUARD_NULL(offset);
+    SL_GUARD_NULL(msg);
+    return sl_coalesce_next(frame, len, offset, msg);
+}
+
+SL_API int32_t SL_CALL socklynx_fragsend_init(sl_fragsend_t *fs, char *data, int32_t len, sl_endpoint_t *endpoint, uint16_t msg_id, int32_t datagram)
+{
+    SL_GUARD_NULL(fs);
+    SL_GUARD(!data && len);
+    return sl_fragsend_init(fs, data, len, endpoint, msg_id, datagram);
+}
+
+SL_API int32_t SL_CALL socklynx_fragsend_send(sl_fragsend_t *fs, sl_sock_t *sock)
+{
+    SL_GUARD_NULL(fs);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    SL_GUARD(!fs->endpoint && sock->state != SL_SOCK_STATE_OPEN);
+    return sl_fragsend_send(fs, sock);
+}
+
+SL_API int32_t SL_CALL socklynx_fragtable_setup(sl_fragtable_t *table)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD(table->state == SL_FRAGTABLE_STATE_STARTED);
+    return sl_fragtable_setup(table);
+}
+
+SL_API int32_t SL_CALL socklynx_fragtable_cleanup(sl_fragtable_t *table)
+{
+    SL_GUARD_NULL(table);
+    return sl_fragtable_cleanup(table);
+}
+
+SL_API int32_t SL_CALL socklynx_fragtable_recv(sl_fragtable_t *table, sl_endpoint_t *endpoint, const char *data, int32_t len, sl_buf_t *msg)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD_NULL(endpoint);
+    SL_GUARD_NULL(data);
+    SL_GUARD_NULL(msg);
+    SL_GUARD(table->state != SL_FRAGTABLE_STATE_STARTED);
+    return sl_fragtable_recv(table, endpoint, data, len, sl_sys_time_ns(), msg);
+}
+
+SL_API int32_t SL_CALL socklynx_fragtable_expire(sl_fragtable_t *table)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD(table->state != SL_FRAGTABLE_STATE_STARTED);
+    return (int32_t)sl_fragtable_expire(table, sl_sys_time_ns());
+}
+
+SL_API int32_t SL_CALL socklynx_capture_setup(sl_capture_t *capture, const char *path)
+{
+    SL_GUARD_NULL(capture);
+    SL_GUARD_NULL(path);
+    SL_GUARD(capture->state == SL_CAPTURE_STATE_STARTED);
+    return sl_capture_setup(capture, path);
+}
+
+SL_API int32_t SL_CALL socklynx_capture_cleanup(sl_capture_t *capture)
+{
+    SL_GUARD_NULL(capture);
+    return sl_capture_cleanup(capture);
+}
+
+SL_API int32_t SL_CALL socklynx_impair_setup(sl_impair_t *impair)
+{
+    SL_GUARD_NULL(impair);
+    SL_GUARD(impair->state == SL_IMPAIR_STATE_STARTED);
+    return sl_impair_setup(impair);
+}
+
+SL_API int32_t SL_CALL socklynx_impair_cleanup(sl_impair_t *impair)
+{
+    SL_GUARD_NULL(impair);
+    return sl_impair_cleanup(impair);
+}
+
+SL_API int32_t SL_CALL socklynx_impair_flush(sl_impair_t *impair, sl_sock_t *sock)
+{
+    SL_GUARD_NULL(impair);
+    SL_GUARD_NULL(sock);
+    SL_GUARD(impair->state != SL_IMPAIR_STATE_STARTED);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    return sl_impair_flush(impair, sock, sl_sys_time_ns());
+}
+
+SL_API int32_t SL_CALL socklynx_pacer_init(sl_pacer_t *pacer, uint64_t rate, uint32_t burst)
+{
+    SL_GUARD_NULL(pacer);
+    sl_pacer_init(pacer, rate, burst);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_pacer_send_batch(sl_pacer_t *pacer, sl_sock_t *sock, sl_msg_t *msgs, int32_t count)
+{
+    SL_GUARD_NULL(pacer);
+    SL_GUARD_NULL(sock);
+    SL_GUARD_NULL(msgs);
+    SL_GUARD(count <= 0);
+    SL_GUARD(!sl_sock_is_ready(sock));
+    for (int32_t i = 0; i < count && i < SL_SOCK_BATCH_MAX; i++) {
+        SL_GUARD_NULL(msgs[i].buf);
+        SL_GUARD(msgs[i].bufcount <= 0);
+        SL_GUARD(!msgs[i].endpoint && sock->state != SL_SOCK_STATE_OPEN);
+    }
+    return sl_pacer_send_batch(pacer, sock, msgs, count, sl_sys_time_ns());
+}
+
+SL_API int32_t SL_CALL socklynx_peertable_setup(sl_peertable_t *table)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD(table->state == SL_PEERTABLE_STATE_STARTED);
+    return sl_peertable_setup(table);
+}
+
+SL_API int32_t SL_CALL socklynx_peertable_cleanup(sl_peertable_t *table)
+{
+    SL_GUARD_NULL(table);
+    return sl_peertable_cleanup(table);
+}
+
+SL_API int32_t SL_CALL socklynx_peertable_insert(sl_peertable_t *table, sl_endpoint_t *endpoint, uint32_t *handle)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD_NULL(endpoint);
+    SL_GUARD_NULL(handle);
+    SL_GUARD(table->state != SL_PEERTABLE_STATE_STARTED);
+    return sl_peertable_insert(table, endpoint, handle);
+}
+
+SL_API int32_t SL_CALL socklynx_peertable_remove(sl_peertable_t *table, uint32_t handle)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD(table->state != SL_PEERTABLE_STATE_STARTED);
+    return sl_peertable_remove(table, handle);
+}
+
+SL_API uint32_t SL_CALL socklynx_peertable_find(sl_peertable_t *table, sl_endpoint_t *endpoint)
+{
+    if (!table || table->state != SL_PEERTABLE_STATE_STARTED) return SL_PEERTABLE_HANDLE_NONE;
+    if (!endpoint) return SL_PEERTABLE_HANDLE_NONE;
+    return sl_peertable_find(table, endpoint);
+}
+
+SL_API int32_t SL_CALL socklynx_peertable_find_batch(sl_peertable_t *table, sl_msg_t *msgs, int32_t count, uint32_t *handles)
+{
+    SL_GUARD_NULL(table);
+    SL_GUARD_NULL(msgs);
+    SL_GUARD_NULL(handles);
+    SL_GUARD(table->state != SL_PEERTABLE_STATE_STARTED);
+    SL_GUARD(count < 0);
+    for (int32_t i = 0; i < count; i++) {
+        SL_GUARD_NULL(msgs[i].endpoint);
+    }
+    return sl_peertable_find_batch(table, msgs, count, handles);
+}
+
+SL_API void *SL_CALL socklynx_peertable_slot(sl_peertable_t *table, uint32_t handle)
+{
+    if (!table || table->state != SL_PEERTABLE_STATE_STARTED) return NULL;
+    return sl_peertable_slot(table, handle);
+}
+
+SL_API int32_t SL_CALL socklynx_timerwheel_setup(sl_timerwheel_t *wheel)
+{
+    SL_GUARD_NULL(wheel);
+    SL_GUARD(wheel->state == SL_TIMERWHEEL_STATE_STARTED);
+    return sl_timerwheel_setup(wheel);
+}
+
+SL_API int32_t SL_CALL socklynx_timerwheel_cleanup(sl_timerwheel_t *wheel)
+{
+    SL_GUARD_NULL(wheel);
+    return sl_timerwheel_cleanup(wheel);
+}
+
+SL_API int32_t SL_CALL socklynx_timerwheel_schedule(sl_timerwheel_t *wheel, sl_timer_t *timer, uint32_t delay_ms)
+{
+    SL_GUARD_NULL(wheel);
+    SL_GUARD_NULL(timer);
+    SL_GUARD(wheel->state != SL_TIMERWHEEL_STATE_STARTED);
+    sl_timerwheel_schedule(wheel, timer, sl_sys_time_ns() + delay_ms * 1000000ULL);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_timerwheel_cancel(sl_timerwheel_t *wheel, sl_timer_t *timer)
+{
+    SL_GUARD_NULL(wheel);
+    SL_GUARD_NULL(timer);
+    SL_GUARD(wheel->state != SL_TIMERWHEEL_STATE_STARTED);
+    sl_timerwheel_cancel(wheel, timer);
+    return SL_OK;
+}
+
+SL_API int32_t SL_CALL socklynx_timerwheel_advance(sl_timerwheel_t *wheel, sl_timer_t **expired, int32_t count)
+{
+    SL_GUARD_NULL(wheel);
+    SL_GUARD_NULL(expired);
+    SL_GUARD(count <= 0);
+    SL_GUARD(wheel->state != SL_TIMERWHEEL_STATE_STARTED);
+    return (int32_t)sl_timerwheel_advance(wheel, sl_sys_time_ns(), expired, (uint32_t)count);
+}
+
+SL_API int32_t SL_CALL socklynx_timerwheel_poll(sl_timerwheel_t *wheel, sl_poller_t *poller, sl_poll_event_t *events, int32_t count, int32_t max_ms)
+{
+    SL_GUARD_NULL(wheel);
+    SL_GUARD_NULL(poller);
+    SL_GUARD_NULL(events);
+    SL_GUARD(count <= 0);
+    SL_GUARD(wheel->state != SL_TIMERWHEEL_STATE_STARTED);
+    SL_GUARD(poller->state != SL_POLLER_STATE_STARTED);
+    return sl_timerwheel_poll(wheel, poller, events, count, max_ms);
+}
+
+/* the thread and its rings belong to the plugin, managed code maps the rings at the front of the returned struct */
+SL_API sl_iothread_t *SL_CALL socklynx_iothread_start(sl_sock_t *sock, sl_bufpool_t *pool, uint32_t capacity, int32_t wait_ms)
+{
+    if (!sock || !sl_sock_is_ready(sock)) return NULL;
+    if (!pool || pool->state != SL_BUFPOOL_STATE_STARTED) return NULL;
+
+    sl_iothread_t *io = (sl_iothread_t *)calloc(1, sizeof(*io));
+    if (!io) return NULL;
+
+    io->sock = sock;
+    io->pool = pool;
+    io->capacity = capacity;
+    io->wait_ms = wait_ms;
+    if (sl_iothread_start(io)) {
+        free(io);
+        return NULL;
+    }
+
+    return io;
+}
+
+SL_API int32_t SL_CALL socklynx_iothread_stop(sl_iothread_t *io)
+{
+    SL_GUARD_NULL(io);
+    SL_GUARD(sl_iothread_stop(io));
+    free(io);
+    return SL_OK;
+}
+
+static const sl_api_t sl_api = {
+    .version = SL_API_VERSION,
+    .size = sizeof(sl_api_t),
+    .setup = socklynx_setup,
+    .cleanup = socklynx_cleanup,
+    .socket_nonblocking = socklynx_socket_nonblocking,
+    .socket_gso = socklynx_socket_gso,
+    .socket_gro = socklynx_socket_gro,
+    .socket_timestamp = socklynx_socket_timestamp,
+    .socket_rxq_ovfl = socklynx_socket_rxq_ovfl,
+    .socket_pacing_rate = socklynx_socket_pacing_rate,
+    .socket_txtime = socklynx_socket_txtime,
+    .socket_impair = socklynx_socket_impair,
+    .socket_capture = socklynx_socket_capture,
+    .socket_open = socklynx_socket_open,
+    .socket_close = socklynx_socket_close,
+    .socket_connect = socklynx_socket_connect,
+    .socket_send_connected = socklynx_socket_send_connected,
+    .socket_recv_connected = socklynx_socket_recv_connected,
+    .socket_send = socklynx_socket_send,
+    .socket_recv = socklynx_socket_recv,
+    .socket_recv_timestamped = socklynx_socket_recv_timestamped,
+    .socket_send_gso = socklynx_socket_send_gso,
+    .socket_send_batch = socklynx_socket_send_batch,
+    .socket_recv_batch = socklynx_socket_recv_batch,
+    .socket_stats = socklynx_socket_stats,
+    .socket_bufsize = socklynx_socket_bufsize,
+    .autotune_setup = socklynx_autotune_setup,
+    .autotune_cleanup = socklynx_autotune_cleanup,
+    .autotune_update = socklynx_autotune_update,
+    .poller_setup = socklynx_poller_setup,
+    .poller_cleanup = socklynx_poller_cleanup,
+    .poller_add = socklynx_poller_add,
+    .poller_remove = socklynx_poller_remove,
+    .poller_wait = socklynx_poller_wait,
+    .bufpool_setup = socklynx_bufpool_setup,
+    .bufpool_cleanup = socklynx_bufpool_cleanup,
+    .bufcache_init = socklynx_bufcache_init,
+    .bufcache_flush = socklynx_bufcache_flush,
+    .bufcache_acquire = socklynx_bufcache_acquire,
+    .bufcache_release = socklynx_bufcache_release,
+    .channel_setup = socklynx_channel_setup,
+    .channel_cleanup = socklynx_channel_cleanup,
+    .channel_send = socklynx_channel_send,
+    .channel_recv = socklynx_channel_recv,
+    .channel_next = socklynx_channel_next,
+    .channel_update = socklynx_channel_update,
+    .coalesce_init = socklynx_coalesce_init,
+    .coalesce_reserve = socklynx_coalesce_reserve,
+    .coalesce_append = socklynx_coalesce_append,
+    .coalesce_flush = socklynx_coalesce_flush,
+    .coalesce_flush_batch = socklynx_coalesce_flush_batch,
+    .coalesce_next = socklynx_coalesce_next,
+    .fragsend_init = socklynx_fragsend_init,
+    .fragsend_send = socklynx_fragsend_send,
+    .fragtable_setup = socklynx_fragtable_setup,
+    .fragtable_cleanup = socklynx_fragtable_cleanup,
+    .fragtable_recv = socklynx_fragtable_recv,
+    .fragtable_expire = socklynx_fragtable_expire,
+    .capture_setup = socklynx_capture_setup,
+    .capture_cleanup = socklynx_capture_cleanup,
+    .impair_setup = socklynx_impair_setup,
+    .impair_cleanup = socklynx_impair_cleanup,
+    .impair_flush = socklynx_impair_flush,
+    .pacer_init = socklynx_pacer_init,
+    .pacer_send_batch = socklynx_pacer_send_batch,
+    .peertable_setup = socklynx_peertable_setup,
+    .peertable_cleanup = socklynx_peertable_cleanup,
+    .peertable_insert = socklynx_peertable_insert,
+    .peertable_remove = socklynx_peertable_remove,
+    .peertable_find = socklynx_peertable_find,
+    .peertable_find_batch = socklynx_peertable_find_batch,
+    .peertable_slot = socklynx_peertable_slot,
+    .timerwheel_setup = socklynx_timerwheel_setup,
+    .timerwheel_cleanup = socklynx_timerwheel_cleanup,
+    .timerwheel_schedule = socklynx_timerwheel_schedule,
+    .timerwheel_cancel = socklynx_timerwheel_cancel,
+    .timerwheel_advance = socklynx_timerwheel_advance,
+    .timerwheel_poll = socklynx_timerwheel_poll,
+    .iothread_start = socklynx_iothread_start,
+    .iothread_stop = socklynx_iothread_stop,
+};
+
+SL_API const sl_api_t *SL_CALL socklynx_get_api(uint32_t version)
+{
+    if (!version || version > SL_API_VERSION) return NULL;
+    return &sl_api;
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2019 Chris Burns <chris@kitty.city>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "socklynx_bench/bench.h"
+
+#include <stdio.h>
+
+/*
+ * Microbenchmarks for the socket hot path. Each case owns a loopback socket pair and
+ * alternates timed rounds of sends and receives, so neither side ever overruns the socket
+ * buffers. Every case runs a warmup rep and then reports the median and fastest rep as
+ * ns per datagram, one line per case in csv or json lines for diffing across commits.
+ */
+
+static void sl_bench_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -n <count>     datagrams per rep (default %d)\n"
+            "  -r <reps>      timed reps per case, the median is reported (default %d)\n"
+            "  -s <size>      payload bytes (default %d)\n"
+            "  -p <port>      first loopback port to use (default %d)\n"
+            "  -f <format>    csv or json (default csv)\n"
+            "  -F <filter>    only run cases whose id contains this, e.g. send/plugin\n"
+            "  -l <label>     free text copied into every row, e.g. a commit hash, without quotes, backslashes or commas\n",
+            name, SL_BENCH_ITERATIONS_DEFAULT, SL_BENCH_REPS_DEFAULT, SL_BENCH_SIZE_DEFAULT, SL_BENCH_PORT_DEFAULT);
+}
+
+static int sl_bench_args_parse(sl_bench_t *bench, int argc, char **argv)
+{
+    long port = SL_BENCH_PORT_DEFAULT;
+
+    bench->format = SL_BENCH_FORMAT_CSV;
+    bench->iterations = SL_BENCH_ITERATIONS_DEFAULT;
+    bench->reps = SL_BENCH_REPS_DEFAULT;
+    bench->size = SL_BENCH_SIZE_DEFAULT;
+    bench->label = "";
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || !arg[1] || arg[2] || arg[1] == 'h') return SL_ERR;
+        if (++i == argc) return SL_ERR;
+        const char *val = argv[i];
+
+        switch (arg[1]) {
+        case 'n':
+            bench->iterations = strtoull(val, NULL, 10);
+            break;
+        case 'r':
+            bench->reps = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 's':
+            bench->size = (int32_t)strtol(val, NULL, 10);
+            break;
+        case 'p':
+            port = strtol(val, NULL, 10);
+            break;
+        case 'f':
+            if (!strcmp(val, "csv")) {
+                bench->format = SL_BENCH_FORMAT_CSV;
+            } else if (!strcmp(val, "json")) {
+                bench->format = SL_BENCH_FORMAT_JSON;
+            } else {
+                return SL_ERR;
+            }
+            break;
+        case 'F':
+            bench->filter = val;
+            break;
+        case 'l':
+            bench->label = val;
+            break;
+        default:
+            return SL_ERR;
+        }
+    }
+
+    SL_GUARD(port <= 0 || port >= UINT16_MAX);
+    SL_GUARD(bench->iterations < SL_BENCH_ROUND || !bench->reps);
+    SL_GUARD(bench->size <= 0 || bench->size > 1472);
+    /* the label goes into the rows verbatim, anything that would need escaping in csv or json is refused */
+    SL_GUARD(strpbrk(bench->label, "\"\\,"));
+    for (const char *c = bench->label; *c; c++) {
+        SL_GUARD((unsigned char)*c < 0x20 || *c == 0x7f);
+    }
+    bench->port = (uint16_t)port;
+
+    return SL_OK;
+}
+
+static int sl_bench_cmp(const void *a, const void *b)
+{
+    const double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static void sl_bench_header(sl_bench_t *bench)
+{
+    if (bench->format == SL_BENCH_FORMAT_CSV) {
+        printf("label,bench,api,af,mode,batch,size,ops,ns_per_op,min_ns_per_op,retries\n");
+    }
+}
+
+static void sl_bench_emit(sl_bench_t *bench, const char *name, const char *api, const char *af, const char *mode, int32_t batch, uint64_t ops, double *samples, uint64_t retries)
+{
+    qsort(samples, bench->reps, sizeof(*samples), sl_bench_cmp);
+    const double median = samples[bench->reps / 2];
+    const double fastest = samples[0];
+
+    if (bench->format == SL_BENCH_FORMAT_JSON) {
+        printf("{\"label\":\"%s\",\"bench\":\"%s\",\"api\":\"%s\",\"af\":\"%s\",\"mode\":\"%s\",\"batch\":%d,\"size\":%d,"
+               "\"ops\":%llu,\"ns_per_op\":%.2f,\"min_ns_per_op\":%.2f,\"retries\":%llu}\n",
+               bench->label, name, api, af, mode, batch, bench->size, (unsigned long long)ops, median, fastest, (unsigned long long)retries);
+    } else {
+        printf("%s,%s,%s,%s,%s,%d,%d,%llu,%.2f,%.2f,%llu\n",
+               bench->label, name, api, af, mode, batch, bench->size, (unsigned long long)ops, median, fastest, (unsigned long long)retries);
+    }
+    fflush(stdout);
+}
+
+static bool sl_bench_selected(sl_bench_t *bench, const char *name, const char *api, const char *af, const char *mode, int32_t batch)
+{
+    if (!bench->filter) return true;
+
+    char id[128];
+    snprintf(id, sizeof(id), "%s/%s/%s/%s/%d", name, api, af, mode, batch);
+    return (strstr(id, bench->filter) != NULL);
+}
+
+/* sends count datagrams in calls of c->batch, would block is retried and counted */
+static int sl_bench_send(sl_bench_case_t *c, int32_t count)
+{
+    int32_t sent = 0;
+    while (sent < count) {
+        int rv;
+        if (c->batch == 1) {
+            rv = c->plugin ? socklynx_socket_send(&c->tx, &c->txbuf, 1, &c->target) : sl_sock_send(&c->tx, &c->txbuf, 1, &c->target);
+            if (rv >= 0) rv = 1;
+        } else {
+            int32_t n = (count - sent < c->batch) ? count - sent : c->batch;
+            rv = c->plugin ? socklynx_socket_send_batch(&c->tx, c->txmsgs, n) : sl_sock_send_batch(&c->tx, c->txmsgs, n);
+        }
+
+        if (rv < 0) {
+            if (!sl_sys_wouldblock((int)c->tx.error)) return SL_ERR;
+            c->retries++;
+            continue;
+        }
+        sent += rv;
+    }
+
+    return SL_OK;
+}
+
+static int sl_bench_recv(sl_bench_case_t *c, int32_t count)
+{
+    int32_t recvd = 0;
+    while (recvd < count) {
+        int rv;
+        if (c->batch == 1) {
+            rv = c->plugin ? socklynx_socket_recv(&c->rx, &c->rxbufs[0], 1, &c->endpoints[0]) : sl_sock_recv(&c->rx, &c->rxbufs[0], 1, &c->endpoints[0]);
+            if (rv >= 0) rv = 1;
+        } else {
+            int32_t n = (count - recvd < c->batch) ? count - recvd : c->batch;
+            rv = c->plugin ? socklynx_socket_recv_batch(&c->rx, c->rxmsgs, n) : sl_sock_recv_batch(&c->rx, c->rxmsgs, n);
+        }
+
+        if (rv < 0) {
+            if (!sl_sys_wouldblock((int)c->rx.error)) return SL_ERR;
+            c->retries++;
+            continue;
+        }
+        recvd += rv;
+    }
+
+    return SL_OK;
+}
+
+static int sl_bench_case_run(sl_bench_t *bench, sl_bench_case_t *c)
+{
+    const uint64_t rounds = bench->iterations / SL_BENCH_ROUND;
+    const double ops = (double)(rounds * SL_BENCH_ROUND);
+    const bool do_send = sl_bench_selected(bench, "send", c->api, c->af, c->mode, c->batch);
+    const bool do_recv = sl_bench_selected(bench, "recv", c->api, c->af, c->mode, c->batch);
+    if (!do_send && !do_recv) return SL_OK;
+
+    double *send_ns = (double *)calloc(bench->reps, sizeof(*send_ns));
+    double *recv_ns = (double *)calloc(bench->reps, sizeof(*recv_ns));
+    int rv = SL_ERR;
+    if (!send_ns || !recv_ns) goto cleanup;
+
+    c->retries = 0;
+    for (int64_t rep = -1; rep < (int64_t)bench->reps; rep++) {
+        uint64_t send_total = 0, recv_total = 0;
+        for (uint64_t round = 0; round < rounds; round++) {
+            const uint64_t t0 = sl_sys_time_ns();
+            if (sl_bench_send(c, SL_BENCH_ROUND)) goto cleanup;
+            const uint64_t t1 = sl_sys_time_ns();
+            if (sl_bench_recv(c, SL_BENCH_ROUND)) goto cleanup;
+            const uint64_t t2 = sl_sys_time_ns();
+            send_total += t1 - t0;
+            recv_total += t2 - t1;
+        }
+        /* rep -1 is the warmup */
+        if (rep < 0) {
+            c->retries = 0;
+            continue;
+        }
+        send_ns[rep] = (double)send_total / ops;
+        recv_ns[rep] = (double)recv_total / ops;
+    }
+
+    if (do_send) sl_bench_emit(bench, "send", c->api, c->af, c->mode, c->batch, (uint64_t)ops, send_ns, c->retries);
+    if (do_recv) sl_bench_emit(bench, "recv", c->api, c->af, c->mode, c->batch, (uint64_t)ops, recv_ns, c->retries);
+    rv = SL_OK;
+
+cleanup:
+    free(send_ns);
+    free(recv_ns);
+    return rv;
+}
+
+static int sl_bench_case_open(sl_bench_t *bench, sl_bench_case_t *c, bool ipv6, bool nonblocking)
+{
+    const char *addr = ipv6 ? "::1" : "127.0.0.1";
+
+    SL_GUARD(sl_endpoint_parse(&c->rx.endpoint, addr, bench->port));
+    SL_GUARD(sl_endpoint_parse(&c->tx.endpoint, addr, (uint16_t)(bench->port + 1)));
+    c->target = c->rx.endpoint;
+
+    SL_GUARD(sl_sock_create(&c->rx, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    SL_GUARD(sl_sock_bind(&c->rx));
+    SL_GUARD(sl_sock_create(&c->tx, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    SL_GUARD(sl_sock_bind(&c->tx));
+    if (nonblocking) {
+        SL_GUARD(sl_sock_nonblocking_set(&c->rx));
+        SL_GUARD(sl_sock_nonblocking_set(&c->tx));
+    }
+
+    memset(c->txmem, 0xa5, sizeof(c->txmem));
+    c->txbuf.base = c->txmem;
+    c->txbuf.len = (size_t)bench->size;
+    for (int32_t i = 0; i < SL_BENCH_BATCH; i++) {
+        c->txmsgs[i].buf = &c->txbuf;
+        c->txmsgs[i].bufcount = 1;
+        c->txmsgs[i].endpoint = &c->target;
+        c->rxbufs[i].base = c->rxmem[i];
+        c->rxbufs[i].len = sizeof(c->rxmem[i]);
+        c->rxmsgs[i].buf = &c->rxbufs[i];
+        c->rxmsgs[i].bufcount = 1;
+        c->rxmsgs[i].endpoint = &c->endpoints[i];
+    }
+
+    return SL_OK;
+}
+
+static void sl_bench_case_close(sl_bench_case_t *c)
+{
+    if (c->rx.state != SL_SOCK_STATE_NEW && c->rx.state != SL_SOCK_STATE_CLOSED) sl_sock_close(&c->rx);
+    if (c->tx.state != SL_SOCK_STATE_NEW && c->tx.state != SL_SOCK_STATE_CLOSED) sl_sock_close(&c->tx);
+}
+
+/* sl_endpoint_size sits on every send path, the volatile sink keeps the loop honest */
+static void sl_bench_endpoint_size(sl_bench_t *bench)
+{
+    static const char *afs[] = {"ipv4", "ipv6"};
+    static const char *addrs[] = {"127.0.0.1", "::1"};
+    const uint64_t ops = bench->iterations * 100;
+    volatile int sink = 0;
+
+    for (int af = 0; af < 2; af++) {
+        if (!sl_bench_selected(bench, "endpoint_size", "direct", afs[af], "none", 1)) continue;
+
+        sl_endpoint_t endpoint;
+        sl_endpoint_parse(&endpoint, addrs[af], bench->port);
+        sl_endpoint_t *volatile ep = &endpoint;
+
+        double *samples = (double *)calloc(bench->reps, sizeof(*samples));
+        if (!samples) return;
+        for (uint32_t rep = 0; rep < bench->reps; rep++) {
+            const uint64_t t0 = sl_sys_time_ns();
+            for (uint64_t i = 0; i < ops; i++) {
+                sink += sl_endpoint_size(ep);
+            }
+            samples[rep] = (double)(sl_sys_time_ns() - t0) / (double)ops;
+        }
+        sl_bench_emit(bench, "endpoint_size", "direct", afs[af], "none", 1, ops, samples, 0);
+        free(samples);
+    }
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *modes[] = {"blocking", "nonblocking"};
+    static const char *afs[] = {"ipv4", "ipv6"};
+    static const char *apis[] = {"direct", "plugin"};
+    static const int32_t batches[] = {1, SL_BENCH_BATCH};
+    sl_bench_t bench = {0};
+    sl_sys_t sys = {0};
+    int rv = 0;
+
+    if (sl_bench_args_parse(&bench, argc, argv)) {
+        sl_bench_usage(argv[0]);
+        return 1;
+    }
+    if (sl_sys_setup(&sys)) {
+        fprintf(stderr, "network setup failed: %d\n", sl_sys_errno());
+        return 1;
+    }
+
+    sl_bench_header(&bench);
+    sl_bench_endpoint_size(&bench);
+
+    for (int af = 0; af < 2; af++) {
+        for (int mode = 0; mode < 2; mode++) {
+            sl_bench_case_t *c = (sl_bench_case_t *)calloc(1, sizeof(*c));
+            if (!c) return 1;
+
+            c->af = afs[af];
+            c->mode = modes[mode];
+            if (sl_bench_case_open(&bench, c, af == 1, mode == 1)) {
+                /* hosts without ipv6 loopback are common enough to not be fatal */
+                fprintf(stderr, "skipping %s %s: socket setup failed: %u\n", c->af, c->mode, c->rx.error ? c->rx.error : c->tx.error);
+                sl_bench_case_close(c);
+                free(c);
+                continue;
+            }
+
+            for (int api = 0; api < 2; api++) {
+                for (int batch = 0; batch < 2; batch++) {
+                    c->api = apis[api];
+                    c->plugin = (api == 1);
+                    c->batch = batches[batch];
+                    if (sl_bench_case_run(&bench, c)) {
+                        fprintf(stderr, "%s %s %s batch %d failed: %u %u\n", c->api, c->af, c->mode, c->batch, c->tx.error, c->rx.error);
+                        rv = 1;
+                    }
+                }
+            }
+
+            sl_bench_case_close(c);
+            free(c);
+        }
+    }
+
+    sl_sys_cleanup(&sys);
+    return rv;
+}
@@ -22,7 +22,918 @@
 
 #include "socklynx_loadgen/loadgen.h"
 
-int main(void)
+#include <signal.h>
+#include <stdio.h>
+
+/*
+ * UDP traffic generator for driving socklynx_server. Clients are non-blocking sockets on
+ * ephemeral ports, split across threads which each wait on a poller for echoes. Open loop
+ * sends on a fixed schedule whatever comes back, closed loop keeps a window of requests
+ * in flight per client and only sends again once an echo or a timeout retires one.
+ */
+
+static volatile sig_atomic_t sl_loadgen_signaled = 0;
+
+static void sl_loadgen_signal(int sig)
+{
+    (void)sig;
+    sl_loadgen_signaled = 1;
+}
+
+static void sl_loadgen_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -a <addr>      server address (default 127.0.0.1)\n"
+            "  -p <port>      server port (default %d)\n"
+            "  -c <clients>   simulated clients, one socket each (default 1)\n"
+            "  -t <threads>   sending threads, clients are split across them (default min(clients, cpus))\n"
+            "  -m <mode>      open, closed or replay (default open)\n"
+            "  -r <pps>       open loop packet rate across all clients, 0 for as fast as possible (default 0)\n"
+            "  -w <window>    closed loop requests in flight per client (default 1)\n"
+            "  -s <size>      payload bytes: N, MIN-MAX for uniform, or imix (default 64)\n"
+            "  -b <batch>     datagrams per send/recv call, 1 uses single calls (default 1, max %d)\n"
+            "  -d <seconds>   run time (default 10)\n"
+            "  -i <ms>        report interval (default %d)\n"
+            "  -o <ms>        closed loop timeout before a request counts as lost (default %d)\n"
+            "  -S <seed>      size distribution and impairment seed (default 1)\n"
+            "  -L <us>        impaired latency added each way (default 0)\n"
+            "  -J <us>        impaired jitter on top of the latency each way (default 0)\n"
+            "  -l <percent>   impaired loss each way (default 0)\n"
+            "  -D <percent>   impaired duplication each way (default 0)\n"
+            "  -R <percent>   impaired reordering each way (default 0)\n"
+            "  -P <file>      replay the UDP payloads of a pcap or pcapng capture, spread over the clients\n"
+            "  -T <speed>     replay at this multiple of the captured timing, 0 for as fast as possible (default 1)\n"
+            "  -f <port>      replay only the datagrams sent to this port (default all)\n"
+            "  -H <0|1>       replay with the rtt header over the start of each payload, to time echoes (default 0)\n",
+            name, SL_LOADGEN_PORT_DEFAULT, SL_SOCK_BATCH_MAX, SL_LOADGEN_INTERVAL_MS_DEFAULT, SL_LOADGEN_TIMEOUT_MS_DEFAULT);
+}
+
+static int sl_loadgen_size_parse(sl_loadgen_t *loadgen, const char *val)
+{
+    char *end;
+
+    if (!strcmp(val, "imix")) {
+        loadgen->dist = SL_LOADGEN_DIST_IMIX;
+        return SL_OK;
+    }
+
+    loadgen->size_min = (int32_t)strtol(val, &end, 10);
+    loadgen->size_max = loadgen->size_min;
+    loadgen->dist = SL_LOADGEN_DIST_FIXED;
+    if (*end == '-') {
+        loadgen->size_max = (int32_t)strtol(end + 1, &end, 10);
+        loadgen->dist = SL_LOADGEN_DIST_UNIFORM;
+    }
+    SL_GUARD(*end);
+    SL_GUARD(loadgen->size_min < SL_LOADGEN_PAYLOAD_MIN || loadgen->size_max > SL_LOADGEN_PAYLOAD_MAX);
+    SL_GUARD(loadgen->size_min > loadgen->size_max);
+
+    return SL_OK;
+}
+
+static int sl_loadgen_ppm_parse(sl_loadgen_t *loadgen, const char *val, uint32_t *ppm)
+{
+    char *end;
+    double percent = strtod(val, &end);
+    SL_GUARD(*end || percent < 0.0 || percent > 100.0);
+
+    *ppm = (uint32_t)(percent * (SL_IMPAIR_PPM / 100) + 0.5);
+    loadgen->impaired = true;
+    return SL_OK;
+}
+
+static int sl_loadgen_args_parse(sl_loadgen_t *loadgen, int argc, char **argv)
+{
+    const char *addr = "127.0.0.1";
+    long port = SL_LOADGEN_PORT_DEFAULT;
+    long replay_port = 0;
+    bool threads_set = false;
+
+    loadgen->mode = SL_LOADGEN_MODE_OPEN;
+    loadgen->dist = SL_LOADGEN_DIST_FIXED;
+    loadgen->size_min = 64;
+    loadgen->size_max = 64;
+    loadgen->clients = 1;
+    loadgen->window = 1;
+    loadgen->batch = 1;
+    loadgen->duration_s = 10;
+    loadgen->interval_ms = SL_LOADGEN_INTERVAL_MS_DEFAULT;
+    loadgen->timeout_ms = SL_LOADGEN_TIMEOUT_MS_DEFAULT;
+    loadgen->seed = 1;
+    loadgen->replay_speed = 1.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || !arg[1] || arg[2] || arg[1] == 'h') return SL_ERR;
+        if (++i == argc) return SL_ERR;
+        const char *val = argv[i];
+
+        switch (arg[1]) {
+        case 'a':
+            addr = val;
+            break;
+        case 'p':
+            port = strtol(val, NULL, 10);
+            break;
+        case 'c':
+            loadgen->clients = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 't':
+            loadgen->threads = (uint32_t)strtoul(val, NULL, 10);
+            threads_set = true;
+            break;
+        case 'm':
+            if (!strcmp(val, "open")) {
+                loadgen->mode = SL_LOADGEN_MODE_OPEN;
+            } else if (!strcmp(val, "closed")) {
+                loadgen->mode = SL_LOADGEN_MODE_CLOSED;
+            } else if (!strcmp(val, "replay")) {
+                loadgen->mode = SL_LOADGEN_MODE_REPLAY;
+            } else {
+                return SL_ERR;
+            }
+            break;
+        case 'r':
+            loadgen->rate = strtoull(val, NULL, 10);
+            break;
+        case 'w':
+            loadgen->window = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 's':
+            SL_GUARD(sl_loadgen_size_parse(loadgen, val));
+            break;
+        case 'b':
+            loadgen->batch = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'd':
+            loadgen->duration_s = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'i':
+            loadgen->interval_ms = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'o':
+            loadgen->timeout_ms = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'S':
+            loadgen->seed = strtoull(val, NULL, 10);
+            break;
+        case 'L':
+            loadgen->impair.latency_us = (uint32_t)strtoul(val, NULL, 10);
+            loadgen->impaired = true;
+            break;
+        case 'J':
+            loadgen->impair.jitter_us = (uint32_t)strtoul(val, NULL, 10);
+            loadgen->impaired = true;
+            break;
+        case 'l':
+            SL_GUARD(sl_loadgen_ppm_parse(loadgen, val, &loadgen->impair.loss_ppm));
+            break;
+        case 'D':
+            SL_GUARD(sl_loadgen_ppm_parse(loadgen, val, &loadgen->impair.duplicate_ppm));
+            break;
+        case 'R':
+            SL_GUARD(sl_loadgen_ppm_parse(loadgen, val, &loadgen->impair.reorder_ppm));
+            break;
+        case 'P':
+            loadgen->replay_path = val;
+            break;
+        case 'T':
+            loadgen->replay_speed = strtod(val, NULL);
+            break;
+        case 'f':
+            replay_port = strtol(val, NULL, 10);
+            break;
+        case 'H':
+            loadgen->replay_stamp = strtol(val, NULL, 10) != 0;
+            break;
+        default:
+            return SL_ERR;
+        }
+    }
+
+    if (!threads_set) {
+        loadgen->threads = sl_sys_cpu_count();
+        if (loadgen->threads > loadgen->clients) loadgen->threads = loadgen->clients;
+    }
+
+    SL_GUARD(port <= 0 || port > UINT16_MAX);
+    SL_GUARD(!loadgen->clients || !loadgen->threads || loadgen->threads > loadgen->clients);
+    SL_GUARD(!loadgen->window || !loadgen->interval_ms || !loadgen->duration_s || !loadgen->timeout_ms);
+    SL_GUARD(!loadgen->batch || loadgen->batch > SL_SOCK_BATCH_MAX);
+    SL_GUARD((loadgen->mode == SL_LOADGEN_MODE_REPLAY) != (loadgen->replay_path != NULL));
+    SL_GUARD(loadgen->replay_speed < 0.0 || replay_port < 0 || replay_port > UINT16_MAX);
+    loadgen->replay_port = (uint16_t)replay_port;
+    SL_GUARD(sl_endpoint_parse(&loadgen->target, addr, (uint16_t)port));
+
+    return SL_OK;
+}
+
+/* xorshift64*, plenty for picking packet sizes and cheap enough for the send path */
+static uint64_t sl_loadgen_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int32_t sl_loadgen_size_next(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker)
+{
+    switch (loadgen->dist) {
+    case SL_LOADGEN_DIST_UNIFORM:
+        return loadgen->size_min + (int32_t)(sl_loadgen_rand(&worker->rng) % (uint64_t)(loadgen->size_max - loadgen->size_min + 1));
+    case SL_LOADGEN_DIST_IMIX: {
+        /* 7:4:1 of 64, 576 and 1500 byte ipv4 packets, less the ip and udp headers */
+        uint64_t r = sl_loadgen_rand(&worker->rng) % 12;
+        if (r < 7) return 36;
+        if (r < 11) return 548;
+        return 1472;
+    }
+    default:
+        return loadgen->size_min;
+    }
+}
+
+/* index of the highest set bit, value must be non zero */
+static uint32_t sl_loadgen_log2(uint64_t value)
+{
+#if SL_C_GCC || SL_C_CLANG
+    return 63 - (uint32_t)__builtin_clzll(value);
+#else
+    uint32_t mag = 0;
+    while (mag < 63 && (value >> (mag + 1))) mag++;
+    return mag;
+#endif
+}
+
+static uint32_t sl_loadgen_hist_index(uint64_t value)
+{
+    if (value < SL_LOADGEN_HIST_SUB) return (uint32_t)value;
+
+    uint32_t mag = sl_loadgen_log2(value);
+    return (mag - SL_LOADGEN_HIST_SUB_BITS + 1) * SL_LOADGEN_HIST_SUB + (uint32_t)((value >> (mag - SL_LOADGEN_HIST_SUB_BITS)) & (SL_LOADGEN_HIST_SUB - 1));
+}
+
+static uint64_t sl_loadgen_hist_value(uint32_t index)
+{
+    if (index < 2 * SL_LOADGEN_HIST_SUB) return index;
+
+    uint32_t mag = index / SL_LOADGEN_HIST_SUB + SL_LOADGEN_HIST_SUB_BITS - 1;
+    return (uint64_t)(SL_LOADGEN_HIST_SUB + index % SL_LOADGEN_HIST_SUB) << (mag - SL_LOADGEN_HIST_SUB_BITS);
+}
+
+static void sl_loadgen_hist_add(sl_loadgen_hist_t *hist, uint64_t value)
+{
+    hist->counts[sl_loadgen_hist_index(value)]++;
+    if (!hist->count || value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+    hist->count++;
+}
+
+/* lower bound of the bucket holding the given percentile, clamped to what was actually seen */
+static uint64_t sl_loadgen_hist_percentile(sl_loadgen_hist_t *hist, double percentile)
+{
+    if (!hist->count) return 0;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)hist->count);
+    if (rank >= hist->count) rank = hist->count - 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < SL_LOADGEN_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen > rank) {
+            uint64_t value = sl_loadgen_hist_value(i);
+            if (value < hist->min) value = hist->min;
+            if (value > hist->max) value = hist->max;
+            return value;
+        }
+    }
+
+    return hist->max;
+}
+
+static void sl_loadgen_hist_merge(sl_loadgen_hist_t *dst, sl_loadgen_hist_t *src)
+{
+    for (uint32_t i = 0; i < SL_LOADGEN_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    if (src->count && (!dst->count || src->min < dst->min)) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    dst->count += src->count;
+}
+
+static void sl_loadgen_packet_fill(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, sl_loadgen_client_t *client, sl_buf_t *buf, uint64_t now_ns)
+{
+    sl_loadgen_header_t header;
+    header.magic = SL_LOADGEN_MAGIC;
+    header.client = client->id;
+    header.seq = client->seq++;
+    header.sent_ns = now_ns;
+    memcpy(buf->base, &header, sizeof(header));
+    buf->len = (size_t)sl_loadgen_size_next(loadgen, worker);
+}
+
+/* hands count filled datagrams to the client's socket, returns how many went out */
+static int32_t sl_loadgen_send_msgs(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, sl_loadgen_client_t *client, sl_msg_t *msgs, int32_t count)
+{
+    int32_t sent = 0;
+
+    if (loadgen->batch == 1) {
+        if ((msgs[0].len = sl_sock_send_connected(&client->sock, msgs[0].buf, 1)) >= 0) sent = 1;
+    } else {
+        sent = sl_sock_send_batch(&client->sock, msgs, count);
+        if (sent < 0) sent = 0;
+    }
+
+    for (int32_t i = 0; i < sent; i++) {
+        worker->tx_bytes += (uint64_t)msgs[i].len;
+    }
+    worker->tx_packets += (uint64_t)sent;
+
+    return sent;
+}
+
+/* sends up to count datagrams from one client, returns how many went out */
+static int32_t sl_loadgen_send(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, sl_loadgen_client_t *client, char *mem, int32_t count)
+{
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+    const uint64_t now_ns = sl_sys_time_ns();
+    int32_t sent = 0;
+
+    if (count > (int32_t)loadgen->batch) count = (int32_t)loadgen->batch;
+    for (int32_t i = 0; i < count; i++) {
+        bufs[i].base = mem + SL_LOADGEN_PAYLOAD_MAX * i;
+        sl_loadgen_packet_fill(loadgen, worker, client, &bufs[i], now_ns);
+        msgs[i].buf = &bufs[i];
+        msgs[i].bufcount = 1;
+        msgs[i].endpoint = NULL;
+        msgs[i].len = 0;
+        msgs[i].segsize = 0;
+    }
+
+    sent = sl_loadgen_send_msgs(loadgen, worker, client, msgs, count);
+
+    /* sequence numbers of datagrams which did not go out are reused */
+    client->seq -= (uint64_t)(count - sent);
+
+    return sent;
+}
+
+static void sl_loadgen_recv(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, sl_loadgen_client_t *client, char *mem)
+{
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_endpoint_t endpoints[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+    const int32_t batch = (int32_t)loadgen->batch;
+
+    /* edge triggered, so drain until the socket would block again */
+    for (;;) {
+        for (int32_t i = 0; i < batch; i++) {
+            bufs[i].base = mem + SL_LOADGEN_PAYLOAD_MAX * i;
+            bufs[i].len = SL_LOADGEN_PAYLOAD_MAX;
+            msgs[i].buf = &bufs[i];
+            msgs[i].bufcount = 1;
+            msgs[i].endpoint = &endpoints[i];
+            msgs[i].segsize = 0;
+        }
+
+        int count;
+        if (batch == 1) {
+            count = ((msgs[0].len = sl_sock_recv(&client->sock, &bufs[0], 1, &endpoints[0])) < 0) ? SL_ERR : 1;
+        } else {
+            count = sl_sock_recv_batch(&client->sock, msgs, batch);
+        }
+        if (count < 0) {
+            if (client->sock.flags & SL_SOCK_FLAG_WOULDBLOCK_READ) return;
+            /* icmp port unreachable while the server is not up yet, keep going */
+            if (sl_sys_unreachable((int)client->sock.error)) continue;
+            worker->error = client->sock.error;
+            return;
+        }
+
+        const uint64_t now_ns = sl_sys_time_ns();
+        for (int32_t i = 0; i < count; i++) {
+            sl_loadgen_header_t header = {0};
+            if (msgs[i].len >= SL_LOADGEN_PAYLOAD_MIN) memcpy(&header, bufs[i].base, sizeof(header));
+            /* replayed payloads come back as they went, counted but only timed when stamped */
+            const bool untimed = loadgen->mode == SL_LOADGEN_MODE_REPLAY && !loadgen->replay_stamp;
+            if (untimed || header.magic != SL_LOADGEN_MAGIC || header.client != client->id) {
+                if (loadgen->mode == SL_LOADGEN_MODE_REPLAY) {
+                    worker->rx_packets++;
+                    worker->rx_bytes += (uint64_t)msgs[i].len;
+                }
+                continue;
+            }
+
+            worker->rx_packets++;
+            worker->rx_bytes += (uint64_t)msgs[i].len;
+            sl_loadgen_hist_add(&worker->hist, now_ns - header.sent_ns);
+            if (client->inflight) client->inflight--;
+            client->progress_ns = now_ns;
+        }
+    }
+}
+
+/*
+ * moves on to the next datagram to play, looping back to the start of the capture at its end.
+ * the next lap starts a mean gap after the last datagram, a lone datagram plays once a second
+ */
+static int sl_loadgen_replay_next(sl_loadgen_t *loadgen, sl_loadgen_replay_t *replay)
+{
+    sl_capture_packet_t *packet = &replay->packet;
+    bool rewound = false;
+
+    for (;;) {
+        if (sl_capture_reader_next(&replay->reader, packet)) {
+            SL_GUARD(rewound || !replay->index);
+            if (!replay->count) replay->count = replay->index;
+            const uint64_t span = replay->last_ns - replay->first_ns;
+            replay->lap_ns += (replay->count > 1) ? span + span / (replay->count - 1) : 1000000000ULL;
+            sl_capture_reader_rewind(&replay->reader);
+            rewound = true;
+            continue;
+        }
+        /* past one unfragmented datagram, the capture was taken with offloads on */
+        if (packet->wirelen > SL_LOADGEN_PAYLOAD_MAX) continue;
+        if (loadgen->replay_port && ntohs(packet->dst.addr4.port) != loadgen->replay_port) continue;
+        if (!replay->count && packet->timestamp_ns > replay->last_ns) replay->last_ns = packet->timestamp_ns;
+        replay->pending = true;
+        return SL_OK;
+    }
+}
+
+static int sl_loadgen_replay_open(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker)
+{
+    sl_loadgen_replay_t *replay = &worker->replay;
+
+    SL_GUARD(sl_capture_reader_open(&replay->reader, loadgen->replay_path));
+    replay->index = 0;
+    replay->count = 0;
+    replay->lap_ns = 0;
+    replay->first_ns = replay->last_ns = 0;
+    SL_GUARD(sl_loadgen_replay_next(loadgen, replay));
+    replay->first_ns = replay->last_ns = replay->packet.timestamp_ns;
+
+    return SL_OK;
+}
+
+/*
+ * sends the datagrams of the capture which are due and fall to this worker's clients, a run of
+ * them for the same client goes out as one batch. returns the poll timeout until the next one
+ */
+static int32_t sl_loadgen_replay(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, char *mem, uint64_t start_ns, uint64_t now_ns)
+{
+    sl_loadgen_replay_t *replay = &worker->replay;
+    sl_capture_packet_t *packet = &replay->packet;
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+    sl_loadgen_client_t *client = NULL;
+    int32_t count = 0, wait_ms = 0;
+
+    while (replay->pending || !sl_loadgen_replay_next(loadgen, replay)) {
+        if (loadgen->replay_speed > 0) {
+            const uint64_t offset_ns = replay->lap_ns + (packet->timestamp_ns > replay->first_ns ? packet->timestamp_ns - replay->first_ns : 0);
+            const uint64_t due_ns = start_ns + (uint64_t)((double)offset_ns / loadgen->replay_speed);
+            if (due_ns > now_ns) {
+                wait_ms = (int32_t)((due_ns - now_ns) / 1000000ULL);
+                break;
+            }
+        }
+
+        const uint64_t owner = replay->index % loadgen->clients;
+        if (owner < worker->first || owner >= worker->first + worker->client_count) {
+            replay->pending = false;
+            replay->index++;
+            continue;
+        }
+        sl_loadgen_client_t *next = &worker->clients[owner - worker->first];
+        if (count && (next != client || count == (int32_t)loadgen->batch)) break;
+        client = next;
+
+        /* straight from the mapping unless the payload needs padding out or stamping */
+        sl_buf_t *buf = &bufs[count];
+        buf->len = (size_t)packet->wirelen;
+        const bool stamp = loadgen->replay_stamp && packet->wirelen >= SL_LOADGEN_PAYLOAD_MIN;
+        if (packet->len == packet->wirelen && !stamp) {
+            buf->base = (char *)packet->payload;
+        } else {
+            buf->base = mem + SL_LOADGEN_PAYLOAD_MAX * count;
+            memcpy(buf->base, packet->payload, (size_t)packet->len);
+            memset(buf->base + packet->len, 0, (size_t)(packet->wirelen - packet->len));
+            if (stamp) {
+                sl_loadgen_header_t header;
+                header.magic = SL_LOADGEN_MAGIC;
+                header.client = client->id;
+                header.seq = client->seq++;
+                header.sent_ns = now_ns;
+                memcpy(buf->base, &header, sizeof(header));
+            }
+        }
+        msgs[count].buf = buf;
+        msgs[count].bufcount = 1;
+        msgs[count].endpoint = NULL;
+        msgs[count].len = 0;
+        msgs[count].segsize = 0;
+        count++;
+
+        replay->pending = false;
+        replay->index++;
+    }
+
+    /* like the open loop, a full socket buffer skips the datagrams instead of bursting later */
+    if (count) sl_loadgen_send_msgs(loadgen, worker, client, msgs, count);
+
+    return wait_ms < 10 ? wait_ms : 10;
+}
+
+/*
+ * releases the impaired datagrams that are due in both directions and returns the poll timeout
+ * cut short to the next one still held, a held echo raises no poll event of its own
+ */
+static int32_t sl_loadgen_impair_pump(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, char *mem, int32_t wait_ms)
+{
+    const uint64_t now_ns = sl_sys_time_ns();
+    uint64_t deadline = UINT64_MAX;
+
+    for (uint32_t i = 0; i < worker->client_count; i++) {
+        sl_loadgen_client_t *client = &worker->clients[i];
+        sl_impair_flush(&client->impair_tx, &client->sock, now_ns);
+        if (sl_impair_deadline(&client->impair_rx) <= now_ns) sl_loadgen_recv(loadgen, worker, client, mem);
+        if (sl_impair_deadline(&client->impair_tx) < deadline) deadline = sl_impair_deadline(&client->impair_tx);
+        if (sl_impair_deadline(&client->impair_rx) < deadline) deadline = sl_impair_deadline(&client->impair_rx);
+    }
+
+    if (deadline == UINT64_MAX) return wait_ms;
+    /* rounded up, waking early would only spin */
+    uint64_t until_ms = deadline > now_ns ? (deadline - now_ns + 999999ULL) / 1000000ULL : 0;
+    return until_ms < (uint64_t)wait_ms ? (int32_t)until_ms : wait_ms;
+}
+
+/* hands the reporter a consistent copy of the counters and histogram for its request seq */
+static void sl_loadgen_worker_publish(sl_loadgen_worker_t *worker, uint32_t seq)
+{
+    worker->report_sample.tx_packets = worker->tx_packets;
+    worker->report_sample.tx_bytes = worker->tx_bytes;
+    worker->report_sample.rx_packets = worker->rx_packets;
+    worker->report_sample.rx_bytes = worker->rx_bytes;
+    worker->report_sample.timeouts = worker->timeouts;
+    worker->report_hist = worker->hist;
+    sl_sys_atomic_store32(&worker->report_ack, seq);
+}
+
+static void sl_loadgen_worker_run(void *arg)
+{
+    sl_loadgen_worker_t *worker = (sl_loadgen_worker_t *)arg;
+    sl_loadgen_t *loadgen = worker->loadgen;
+    const uint64_t timeout_ns = (uint64_t)loadgen->timeout_ms * 1000000ULL;
+    /* each thread carries the share of the rate matching its share of the clients */
+    const double rate = (double)loadgen->rate * worker->client_count / loadgen->clients;
+    sl_poll_event_t events[SL_SOCK_BATCH_MAX];
+    uint64_t scheduled = 0;
+    uint32_t next = 0;
+
+    char *txmem = (char *)malloc(SL_LOADGEN_PAYLOAD_MAX * (size_t)loadgen->batch);
+    char *rxmem = (char *)malloc(SL_LOADGEN_PAYLOAD_MAX * (size_t)loadgen->batch);
+    if (!txmem || !rxmem) {
+        worker->error = ENOMEM;
+        goto cleanup;
+    }
+    for (size_t i = 0; i < SL_LOADGEN_PAYLOAD_MAX * (size_t)loadgen->batch; i++) {
+        txmem[i] = (char)(i * 31);
+    }
+
+    const uint64_t start_ns = sl_sys_time_ns();
+    while (loadgen->running) {
+        uint64_t now_ns = sl_sys_time_ns();
+        int32_t wait_ms = 10;
+
+        if (loadgen->sending && loadgen->mode == SL_LOADGEN_MODE_REPLAY) {
+            wait_ms = sl_loadgen_replay(loadgen, worker, txmem, start_ns, now_ns);
+        } else if (loadgen->sending && loadgen->mode == SL_LOADGEN_MODE_OPEN) {
+            uint64_t due = (uint64_t)loadgen->batch;
+            wait_ms = 0;
+            if (rate > 0) {
+                uint64_t target = (uint64_t)((double)(now_ns - start_ns) * rate / 1e9);
+                due = (target > scheduled) ? target - scheduled : 0;
+                if (due > loadgen->batch) due = loadgen->batch;
+                if (!due) {
+                    uint64_t next_ns = start_ns + (uint64_t)((double)(scheduled + 1) * 1e9 / rate);
+                    wait_ms = (int32_t)((next_ns - now_ns) / 1000000ULL);
+                    /* low rates still wake up often enough to answer a report */
+                    if (wait_ms > 10) wait_ms = 10;
+                }
+            }
+            if (due) {
+                /* a full socket buffer skips its slot instead of bursting later, the schedule stays fixed */
+                sl_loadgen_send(loadgen, worker, &worker->clients[next++ % worker->client_count], txmem, (int32_t)due);
+                scheduled += due;
+            }
+        } else if (loadgen->sending) {
+            wait_ms = 1;
+            for (uint32_t i = 0; i < worker->client_count; i++) {
+                sl_loadgen_client_t *client = &worker->clients[i];
+                if (client->inflight && now_ns - client->progress_ns > timeout_ns) {
+                    worker->timeouts += client->inflight;
+                    client->inflight = 0;
+                }
+                while (client->inflight < loadgen->window) {
+                    int32_t sent = sl_loadgen_send(loadgen, worker, client, txmem, (int32_t)(loadgen->window - client->inflight));
+                    if (!sent) break;
+                    if (!client->inflight) client->progress_ns = now_ns;
+                    client->inflight += (uint32_t)sent;
+                }
+            }
+        }
+
+        if (loadgen->impaired) wait_ms = sl_loadgen_impair_pump(loadgen, worker, rxmem, wait_ms);
+
+        int rv = sl_poller_wait(&worker->poller, events, SL_SOCK_BATCH_MAX, wait_ms);
+        if (rv < 0) {
+            worker->error = worker->poller.error;
+            break;
+        }
+        for (int i = 0; i < rv; i++) {
+            /* the socket is the first member of its client */
+            sl_loadgen_recv(loadgen, worker, (sl_loadgen_client_t *)events[i].sock, rxmem);
+        }
+
+        const uint32_t seq = sl_sys_atomic_load32(&worker->report_seq);
+        if (seq != worker->report_ack) sl_loadgen_worker_publish(worker, seq);
+    }
+
+cleanup:
+    free(txmem);
+    free(rxmem);
+    sl_sys_atomic_store32(&worker->stopped, 1);
+}
+
+static int sl_loadgen_worker_open(sl_loadgen_t *loadgen, sl_loadgen_worker_t *worker, uint32_t first)
 {
-    return 0;
+    sl_endpoint_t local;
+    SL_GUARD(sl_endpoint_parse(&local, sl_endpoint_is_ipv6(&loadgen->target) ? "::" : "0.0.0.0", 0));
+
+    worker->rng = loadgen->seed + worker->id * 0x9E3779B97F4A7C15ULL;
+    if (!worker->rng) worker->rng = 1;
+
+    worker->clients = (sl_loadgen_client_t *)calloc(worker->client_count, sizeof(*worker->clients));
+    SL_GUARD_NULL(worker->clients);
+
+    worker->poller.capacity = worker->client_count;
+    SL_GUARD(sl_poller_setup(&worker->poller));
+
+    for (uint32_t i = 0; i < worker->client_count; i++) {
+        sl_loadgen_client_t *client = &worker->clients[i];
+        client->id = first + i;
+        client->sock.endpoint = local;
+        SL_GUARD(sl_sock_create(&client->sock, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        SL_GUARD(sl_sock_bind(&client->sock));
+        /* every client talks to the one target, connecting skips the route lookup per send */
+        SL_GUARD(sl_sock_connect(&client->sock, &loadgen->target));
+        SL_GUARD(sl_sock_nonblocking_set(&client->sock));
+        SL_GUARD(sl_poller_add(&worker->poller, &client->sock, SL_POLL_EVENT_READ));
+        if (loadgen->impaired) {
+            /* a seed per client and direction, so a rerun with the same -S meets the same network */
+            client->impair_tx = loadgen->impair;
+            client->impair_tx.seed = loadgen->seed + (2 * (uint64_t)client->id + 1) * 0x9E3779B97F4A7C15ULL;
+            client->impair_tx.capacity = SL_LOADGEN_IMPAIR_CAPACITY;
+            client->impair_tx.slotsize = SL_LOADGEN_PAYLOAD_MAX;
+            client->impair_rx = client->impair_tx;
+            client->impair_rx.seed += 0x9E3779B97F4A7C15ULL;
+            SL_GUARD(sl_impair_setup(&client->impair_tx));
+            SL_GUARD(sl_impair_setup(&client->impair_rx));
+            sl_sock_impair_set(&client->sock, &client->impair_tx, &client->impair_rx);
+        }
+    }
+
+    return SL_OK;
+}
+
+static void sl_loadgen_sample(sl_loadgen_t *loadgen, sl_loadgen_sample_t *sample, sl_loadgen_hist_t *hist)
+{
+    memset(sample, 0, sizeof(*sample));
+    memset(hist, 0, sizeof(*hist));
+    /* ask every worker first so they copy out in parallel */
+    for (uint32_t i = 0; i < loadgen->threads; i++) {
+        sl_loadgen_worker_t *worker = &loadgen->workers[i];
+        sl_sys_atomic_store32(&worker->report_seq, worker->report_seq + 1);
+    }
+    for (uint32_t i = 0; i < loadgen->threads; i++) {
+        sl_loadgen_worker_t *worker = &loadgen->workers[i];
+        const uint32_t seq = worker->report_seq;
+        while (sl_sys_atomic_load32(&worker->report_ack) != seq) {
+            /* an exited worker no longer answers, its counters are final and safe to copy from here */
+            if (sl_sys_atomic_load32(&worker->stopped)) {
+                sl_loadgen_worker_publish(worker, seq);
+                break;
+            }
+            sl_sys_sleep_ms(1);
+        }
+        sample->tx_packets += worker->report_sample.tx_packets;
+        sample->tx_bytes += worker->report_sample.tx_bytes;
+        sample->rx_packets += worker->report_sample.rx_packets;
+        sample->rx_bytes += worker->report_sample.rx_bytes;
+        sample->timeouts += worker->report_sample.timeouts;
+        sl_loadgen_hist_merge(hist, &worker->report_hist);
+    }
+}
+
+static double sl_loadgen_loss(sl_loadgen_sample_t *sample)
+{
+    if (!sample->tx_packets || sample->rx_packets >= sample->tx_packets) return 0.0;
+    return 100.0 * (double)(sample->tx_packets - sample->rx_packets) / (double)sample->tx_packets;
+}
+
+/* rates come from the difference to the previous sample, rtt percentiles from the histogram difference */
+static void sl_loadgen_report(sl_loadgen_t *loadgen, sl_loadgen_sample_t *prev, sl_loadgen_hist_t *prev_hist, sl_loadgen_hist_t *hist, uint64_t elapsed_ns)
+{
+    sl_loadgen_sample_t sample;
+    sl_loadgen_sample(loadgen, &sample, hist);
+
+    sl_loadgen_hist_t *interval = prev_hist;
+    for (uint32_t i = 0; i < SL_LOADGEN_HIST_BUCKETS; i++) {
+        interval->counts[i] = hist->counts[i] - prev_hist->counts[i];
+    }
+    interval->count = hist->count - prev_hist->count;
+    interval->min = hist->min;
+    interval->max = hist->max;
+
+    sl_loadgen_sample_t delta;
+    delta.tx_packets = sample.tx_packets - prev->tx_packets;
+    delta.tx_bytes = sample.tx_bytes - prev->tx_bytes;
+    delta.rx_packets = sample.rx_packets - prev->rx_packets;
+    delta.rx_bytes = sample.rx_bytes - prev->rx_bytes;
+
+    const double secs = (double)elapsed_ns / 1e9;
+    printf("tx %10.0f pps %8.3f Gbps | rx %10.0f pps %8.3f Gbps | loss %6.2f%% | rtt p50 %8.1f us p99 %8.1f us\n",
+           (double)delta.tx_packets / secs,
+           (double)delta.tx_bytes * 8 / secs / 1e9,
+           (double)delta.rx_packets / secs,
+           (double)delta.rx_bytes * 8 / secs / 1e9,
+           sl_loadgen_loss(&delta),
+           (double)sl_loadgen_hist_percentile(interval, 50.0) / 1e3,
+           (double)sl_loadgen_hist_percentile(interval, 99.0) / 1e3);
+    fflush(stdout);
+
+    *prev = sample;
+    *prev_hist = *hist;
+}
+
+static void sl_loadgen_summary(sl_loadgen_t *loadgen, uint64_t elapsed_ns, sl_loadgen_hist_t *hist)
+{
+    static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+    sl_loadgen_sample_t sample;
+    sl_loadgen_sample(loadgen, &sample, hist);
+
+    const double secs = (double)elapsed_ns / 1e9;
+    printf("\n%llu sent, %llu received, %.3f%% loss", (unsigned long long)sample.tx_packets, (unsigned long long)sample.rx_packets, sl_loadgen_loss(&sample));
+    if (loadgen->mode == SL_LOADGEN_MODE_CLOSED) printf(", %llu timeouts", (unsigned long long)sample.timeouts);
+    printf("\ntx %.0f pps %.3f Gbps, rx %.0f pps %.3f Gbps over %.2f s (udp payload)\n",
+           (double)sample.tx_packets / secs, (double)sample.tx_bytes * 8 / secs / 1e9,
+           (double)sample.rx_packets / secs, (double)sample.rx_bytes * 8 / secs / 1e9, secs);
+    if (!hist->count) return;
+
+    printf("rtt us: min %.1f", (double)hist->min / 1e3);
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        printf(" p%g %.1f", percentiles[i], (double)sl_loadgen_hist_percentile(hist, percentiles[i]) / 1e3);
+    }
+    printf(" max %.1f\n", (double)hist->max / 1e3);
+
+    /* the histogram folded to powers of two for a readable shape */
+    uint64_t folded[64] = {0}, peak = 0;
+    for (uint32_t i = 0; i < SL_LOADGEN_HIST_BUCKETS; i++) {
+        if (!hist->counts[i]) continue;
+        uint32_t mag = i ? sl_loadgen_log2(sl_loadgen_hist_value(i)) : 0;
+        folded[mag] += hist->counts[i];
+        if (folded[mag] > peak) peak = folded[mag];
+    }
+    for (uint32_t mag = 0; mag < 64; mag++) {
+        if (!folded[mag]) continue;
+        char bar[41];
+        size_t len = (size_t)(40 * folded[mag] / peak);
+        memset(bar, '#', len);
+        bar[len] = '\0';
+        printf("  %10.1f us - %10.1f us %10llu %s\n", (double)(1ULL << mag) / 1e3, (double)(2ULL << mag) / 1e3, (unsigned long long)folded[mag], bar);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    sl_loadgen_t loadgen = {0};
+    sl_loadgen_sample_t prev = {0};
+    sl_loadgen_hist_t *hists = NULL;
+    uint64_t start_ns = 0, stop_ns = 0, report_ns;
+    uint32_t started = 0;
+    int rv = 1;
+
+    if (sl_loadgen_args_parse(&loadgen, argc, argv)) {
+        sl_loadgen_usage(argv[0]);
+        return 1;
+    }
+
+    if (sl_sys_setup(&loadgen.sys)) {
+        fprintf(stderr, "network setup failed: %d\n", sl_sys_errno());
+        return 1;
+    }
+
+    /* previous and current merged histograms for the interval reports */
+    hists = (sl_loadgen_hist_t *)calloc(2, sizeof(*hists));
+    loadgen.workers = (sl_loadgen_worker_t *)calloc(loadgen.threads, sizeof(*loadgen.workers));
+    if (!hists || !loadgen.workers) goto cleanup;
+
+    for (uint32_t i = 0, first = 0; i < loadgen.threads; i++) {
+        sl_loadgen_worker_t *worker = &loadgen.workers[i];
+        worker->loadgen = &loadgen;
+        worker->id = i;
+        worker->client_count = (uint32_t)((uint64_t)(i + 1) * loadgen.clients / loadgen.threads) - first;
+        worker->first = first;
+        if (sl_loadgen_worker_open(&loadgen, worker, first)) {
+            fprintf(stderr, "worker %u: client setup failed: %d\n", i, sl_sys_errno());
+            goto cleanup;
+        }
+        if (loadgen.mode == SL_LOADGEN_MODE_REPLAY && sl_loadgen_replay_open(&loadgen, worker)) {
+            fprintf(stderr, "worker %u: no UDP datagrams to replay in %s\n", i, loadgen.replay_path);
+            goto cleanup;
+        }
+        first += worker->client_count;
+    }
+
+    signal(SIGINT, sl_loadgen_signal);
+    signal(SIGTERM, sl_loadgen_signal);
+
+    loadgen.sending = true;
+    loadgen.running = true;
+    start_ns = sl_sys_time_ns();
+    for (; started < loadgen.threads; started++) {
+        if (sl_sys_thread_start(&loadgen.workers[started].thread, sl_loadgen_worker_run, &loadgen.workers[started])) {
+            fprintf(stderr, "worker %u: thread start failed\n", started);
+            goto cleanup;
+        }
+    }
+
+    if (loadgen.mode == SL_LOADGEN_MODE_REPLAY) {
+        printf("socklynx_loadgen: %u clients on %u threads, replaying %s", loadgen.clients, loadgen.threads, loadgen.replay_path);
+        if (loadgen.replay_speed > 0) printf(" at %gx", loadgen.replay_speed);
+        if (loadgen.replay_port) printf(" to port %u", loadgen.replay_port);
+    } else {
+        printf("socklynx_loadgen: %u clients on %u threads, %s loop", loadgen.clients, loadgen.threads, loadgen.mode == SL_LOADGEN_MODE_OPEN ? "open" : "closed");
+    }
+    if (loadgen.mode == SL_LOADGEN_MODE_OPEN && loadgen.rate) printf(" at %llu pps", (unsigned long long)loadgen.rate);
+    if (loadgen.mode == SL_LOADGEN_MODE_CLOSED) printf(" window %u", loadgen.window);
+    printf(", batch %u", loadgen.batch);
+    if (loadgen.impaired) {
+        printf(", impaired %u+%u us %.2f%% loss %.2f%% dup %.2f%% reorder each way", loadgen.impair.latency_us, loadgen.impair.jitter_us, (double)loadgen.impair.loss_ppm / (SL_IMPAIR_PPM / 100),
+               (double)loadgen.impair.duplicate_ppm / (SL_IMPAIR_PPM / 100), (double)loadgen.impair.reorder_ppm / (SL_IMPAIR_PPM / 100));
+    }
+    printf("\n");
+    fflush(stdout);
+
+    report_ns = start_ns;
+    while (!sl_loadgen_signaled) {
+        sl_sys_sleep_ms(loadgen.interval_ms);
+        const uint64_t now_ns = sl_sys_time_ns();
+        sl_loadgen_report(&loadgen, &prev, &hists[0], &hists[1], now_ns - report_ns);
+        report_ns = now_ns;
+        if (now_ns - start_ns >= (uint64_t)loadgen.duration_s * 1000000000ULL) break;
+    }
+
+    /* a signal can end the run before the first report */
+    stop_ns = sl_sys_time_ns();
+
+    /* let the last echoes land before counting what never came back */
+    loadgen.sending = false;
+    sl_sys_sleep_ms(SL_LOADGEN_DRAIN_MS);
+    rv = 0;
+
+cleanup:
+    loadgen.sending = false;
+    loadgen.running = false;
+    for (uint32_t i = 0; i < started; i++) {
+        sl_sys_thread_join(&loadgen.workers[i].thread);
+        if (loadgen.workers[i].error) {
+            fprintf(stderr, "worker %u: exited with error %u\n", i, loadgen.workers[i].error);
+            rv = 1;
+        }
+    }
+    if (!rv) sl_loadgen_summary(&loadgen, stop_ns - start_ns, &hists[1]);
+
+    for (uint32_t i = 0; loadgen.workers && i < loadgen.threads; i++) {
+        sl_loadgen_worker_t *worker = &loadgen.workers[i];
+        sl_poller_cleanup(&worker->poller);
+        sl_capture_reader_close(&worker->replay.reader);
+        for (uint32_t c = 0; worker->clients && c < worker->client_count; c++) {
+            if (worker->clients[c].sock.state != SL_SOCK_STATE_NEW) sl_sock_close(&worker->clients[c].sock);
+            sl_impair_cleanup(&worker->clients[c].impair_tx);
+            sl_impair_cleanup(&worker->clients[c].impair_rx);
+        }
+        free(worker->clients);
+    }
+    free(loadgen.workers);
+    free(hists);
+    sl_sys_cleanup(&loadgen.sys);
+
+    return rv;
 }
@@ -22,7 +22,364 @@
 
 #include "socklynx_server/server.h"
 
-int main(void)
+#include <signal.h>
+#include <stdio.h>
+
+/*
+ * Reference multi-core UDP server: one SO_REUSEPORT socket and receive thread per core,
+ * all bound to the same endpoint so the kernel spreads flows across them. Each worker
+ * waits on its own poller and drains with batched receive, then echoes or discards.
+ */
+
+static volatile sig_atomic_t sl_server_signaled = 0;
+
+static void sl_server_signal(int sig)
+{
+    (void)sig;
+    sl_server_signaled = 1;
+}
+
+static void sl_server_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -a <addr>      address to bind (default 0.0.0.0)\n"
+            "  -p <port>      port to bind (default %d)\n"
+            "  -t <threads>   receive threads, one socket each (default cpu count)\n"
+            "  -m <mode>      echo or discard (default echo)\n"
+            "  -b <batch>     datagrams per batched receive, 1 to %d (default %d)\n"
+            "  -i <ms>        throughput report interval (default %d)\n"
+            "  -d <seconds>   run for this long then exit (default until interrupted)\n"
+            "  -r <bytes/s>   cap each socket's send rate, paced out by the fq qdisc (SO_MAX_PACING_RATE)\n"
+            "  -C <file>      capture every datagram sent and received to a pcap file, up to %d MB\n"
+            "  -g             enable receive coalescing (UDP_GRO)\n"
+            "  -c             pin each thread to a cpu\n",
+            name, SL_SERVER_PORT_DEFAULT, SL_SOCK_BATCH_MAX, SL_SOCK_BATCH_MAX, SL_SERVER_INTERVAL_MS_DEFAULT,
+            SL_CAPTURE_SIZE_DEFAULT / (1024 * 1024));
+}
+
+static int sl_server_args_parse(sl_server_t *server, int argc, char **argv)
+{
+    const char *addr = "0.0.0.0";
+    long port = SL_SERVER_PORT_DEFAULT;
+
+    server->mode = SL_SERVER_MODE_ECHO;
+    server->threads = sl_sys_cpu_count();
+    server->batch = SL_SOCK_BATCH_MAX;
+    server->interval_ms = SL_SERVER_INTERVAL_MS_DEFAULT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || !arg[1] || arg[2]) return SL_ERR;
+
+        switch (arg[1]) {
+        case 'g':
+            server->gro = true;
+            continue;
+        case 'c':
+            server->pin = true;
+            continue;
+        case 'h':
+            return SL_ERR;
+        default:
+            break;
+        }
+
+        if (++i == argc) return SL_ERR;
+        const char *val = argv[i];
+        switch (arg[1]) {
+        case 'a':
+            addr = val;
+            break;
+        case 'p':
+            port = strtol(val, NULL, 10);
+            break;
+        case 't':
+            server->threads = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'm':
+            if (!strcmp(val, "echo")) {
+                server->mode = SL_SERVER_MODE_ECHO;
+            } else if (!strcmp(val, "discard")) {
+                server->mode = SL_SERVER_MODE_DISCARD;
+            } else {
+                return SL_ERR;
+            }
+            break;
+        case 'b':
+            server->batch = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'i':
+            server->interval_ms = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'd':
+            server->duration_s = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'r':
+            server->pacing_rate = (uint32_t)strtoul(val, NULL, 10);
+            break;
+        case 'C':
+            server->capture_path = val;
+            break;
+        default:
+            return SL_ERR;
+        }
+    }
+
+    SL_GUARD(port <= 0 || port > UINT16_MAX);
+    SL_GUARD(!server->threads || !server->interval_ms);
+    SL_GUARD(!server->batch || server->batch > SL_SOCK_BATCH_MAX);
+    SL_GUARD(sl_endpoint_parse(&server->endpoint, addr, (uint16_t)port));
+
+    return SL_OK;
+}
+
+static void sl_server_echo(sl_server_worker_t *worker, sl_msg_t *msgs, int32_t count)
+{
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_msg_t txmsgs[SL_SOCK_BATCH_MAX];
+    int32_t txcount = 0;
+
+    for (int32_t i = 0; i < count; i++) {
+        /* a coalesced datagram goes back out as the same segments it arrived in */
+        if (msgs[i].segsize < msgs[i].len) {
+            sl_buf_t buf = {.base = msgs[i].buf->base, .len = (size_t)msgs[i].len};
+            int bytes_sent = sl_sock_send_gso(&worker->sock, &buf, (uint16_t)msgs[i].segsize, msgs[i].endpoint);
+            if (bytes_sent > 0) {
+                worker->tx_bytes += (uint64_t)bytes_sent;
+                worker->tx_packets += (uint64_t)((bytes_sent + msgs[i].segsize - 1) / msgs[i].segsize);
+            }
+            if (bytes_sent < msgs[i].len) worker->tx_errors += (uint64_t)sl_msg_segment_count(&msgs[i]);
+            continue;
+        }
+
+        bufs[txcount].base = msgs[i].buf->base;
+        bufs[txcount].len = (size_t)msgs[i].len;
+        txmsgs[txcount].buf = &bufs[txcount];
+        txmsgs[txcount].bufcount = 1;
+        txmsgs[txcount].endpoint = msgs[i].endpoint;
+        txmsgs[txcount].len = 0;
+        txmsgs[txcount].segsize = 0;
+        txcount++;
+    }
+
+    int32_t offset = 0;
+    while (offset < txcount) {
+        int sent = sl_sock_send_batch(&worker->sock, txmsgs + offset, txcount - offset);
+        if (sent < 0) {
+            /* a full send buffer drops the rest of the batch rather than stalling receive */
+            worker->tx_errors += (uint64_t)(txcount - offset);
+            break;
+        }
+        for (int32_t i = offset; i < offset + sent; i++) {
+            worker->tx_bytes += (uint64_t)txmsgs[i].len;
+        }
+        worker->tx_packets += (uint64_t)sent;
+        offset += sent;
+    }
+}
+
+static void sl_server_worker_run(void *arg)
+{
+    sl_server_worker_t *worker = (sl_server_worker_t *)arg;
+    sl_server_t *server = worker->server;
+    const size_t bufsize = server->gro ? SL_SERVER_GRO_BUF_SIZE : SL_SERVER_BUF_SIZE;
+    const int32_t batch = (int32_t)server->batch;
+
+    if (server->pin && sl_sys_thread_affinity_set(worker->id)) {
+        fprintf(stderr, "worker %u: could not pin to cpu\n", worker->id);
+    }
+
+    char *mem = (char *)malloc(bufsize * (size_t)batch);
+    if (!mem) {
+        worker->error = ENOMEM;
+        return;
+    }
+
+    sl_buf_t bufs[SL_SOCK_BATCH_MAX];
+    sl_endpoint_t endpoints[SL_SOCK_BATCH_MAX];
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX];
+    sl_poll_event_t event;
+
+    while (server->running) {
+        int rv = sl_poller_wait(&worker->poller, &event, 1, 100);
+        if (rv < 0) {
+            worker->error = worker->poller.error;
+            break;
+        }
+        if (!rv) continue;
+
+        /* edge triggered, so drain until the socket would block again */
+        while (server->running) {
+            for (int32_t i = 0; i < batch; i++) {
+                bufs[i].base = mem + bufsize * (size_t)i;
+                bufs[i].len = bufsize;
+                msgs[i].buf = &bufs[i];
+                msgs[i].bufcount = 1;
+                msgs[i].endpoint = &endpoints[i];
+                msgs[i].len = 0;
+                msgs[i].segsize = 0;
+            }
+
+            int count = sl_sock_recv_batch(&worker->sock, msgs, batch);
+            if (count < 0) {
+                if (worker->sock.flags & SL_SOCK_FLAG_WOULDBLOCK_READ) break;
+                /* icmp errors from a departed peer surface here, they are not fatal to the socket */
+                if (sl_sys_unreachable((int)worker->sock.error)) continue;
+                worker->error = worker->sock.error;
+                break;
+            }
+
+            for (int32_t i = 0; i < count; i++) {
+                worker->rx_bytes += (uint64_t)msgs[i].len;
+                worker->rx_packets += (uint64_t)sl_msg_segment_count(&msgs[i]);
+            }
+
+            if (server->mode == SL_SERVER_MODE_ECHO) sl_server_echo(worker, msgs, count);
+        }
+    }
+
+    free(mem);
+}
+
+static int sl_server_worker_open(sl_server_t *server, sl_server_worker_t *worker)
+{
+    sl_sock_t *sock = &worker->sock;
+    sock->endpoint = server->endpoint;
+
+    SL_GUARD(sl_sock_create(sock, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    if (server->threads > 1) SL_GUARD(sl_sock_reuseport_set(sock));
+    SL_GUARD(sl_sock_bind(sock));
+    SL_GUARD(sl_sock_nonblocking_set(sock));
+    if (server->gro) SL_GUARD(sl_sock_gro_enable(sock));
+    if (server->mode == SL_SERVER_MODE_ECHO) sl_sock_gso_enable(sock);
+    if (server->pacing_rate) SL_GUARD(sl_sock_pacing_rate_set(sock, server->pacing_rate));
+    if (server->capture_path) sl_sock_capture_set(sock, &server->capture);
+
+    worker->poller.capacity = 1;
+    SL_GUARD(sl_poller_setup(&worker->poller));
+    SL_GUARD(sl_poller_add(&worker->poller, sock, SL_POLL_EVENT_READ));
+
+    return SL_OK;
+}
+
+/* worker counters are cumulative, rates come from the difference to the previous sample */
+static void sl_server_report(sl_server_t *server, uint64_t *last, sl_server_sample_t *prev, uint64_t elapsed_ns)
 {
-    return 0;
+    sl_server_sample_t sample = {0};
+    uint64_t tx_errors = 0;
+    uint64_t busiest = 0, idlest = UINT64_MAX;
+
+    for (uint32_t i = 0; i < server->threads; i++) {
+        sl_server_worker_t *worker = &server->workers[i];
+        uint64_t packets = worker->rx_packets;
+        uint64_t delta = packets - last[i];
+        last[i] = packets;
+        if (delta > busiest) busiest = delta;
+        if (delta < idlest) idlest = delta;
+
+        sample.rx_packets += packets;
+        sample.rx_bytes += worker->rx_bytes;
+        sample.tx_packets += worker->tx_packets;
+        sample.tx_bytes += worker->tx_bytes;
+        tx_errors += worker->tx_errors;
+    }
+
+    const double secs = (double)elapsed_ns / 1e9;
+    printf("rx %10.0f pps %8.3f Gbps | tx %10.0f pps %8.3f Gbps | tx drop %llu | thread min/max %llu/%llu\n",
+           (double)(sample.rx_packets - prev->rx_packets) / secs,
+           (double)(sample.rx_bytes - prev->rx_bytes) * 8 / secs / 1e9,
+           (double)(sample.tx_packets - prev->tx_packets) / secs,
+           (double)(sample.tx_bytes - prev->tx_bytes) * 8 / secs / 1e9,
+           (unsigned long long)tx_errors,
+           (unsigned long long)idlest,
+           (unsigned long long)busiest);
+    fflush(stdout);
+
+    *prev = sample;
+}
+
+int main(int argc, char **argv)
+{
+    sl_server_t server = {0};
+    sl_server_sample_t prev = {0};
+    uint64_t *last = NULL;
+    uint32_t started = 0;
+    int rv = 1;
+
+    if (sl_server_args_parse(&server, argc, argv)) {
+        sl_server_usage(argv[0]);
+        return 1;
+    }
+
+    if (sl_sys_setup(&server.sys)) {
+        fprintf(stderr, "network setup failed: %d\n", sl_sys_errno());
+        return 1;
+    }
+
+    server.workers = (sl_server_worker_t *)calloc(server.threads, sizeof(*server.workers));
+    last = (uint64_t *)calloc(server.threads, sizeof(*last));
+    if (!server.workers || !last) goto cleanup;
+
+    if (server.capture_path && sl_capture_setup(&server.capture, server.capture_path)) {
+        fprintf(stderr, "capture setup failed: %u\n", server.capture.error);
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < server.threads; i++) {
+        sl_server_worker_t *worker = &server.workers[i];
+        worker->server = &server;
+        worker->id = i;
+        if (sl_server_worker_open(&server, worker)) {
+            fprintf(stderr, "worker %u: socket setup failed: %u %u\n", i, worker->sock.error, worker->poller.error);
+            goto cleanup;
+        }
+    }
+
+    signal(SIGINT, sl_server_signal);
+    signal(SIGTERM, sl_server_signal);
+
+    server.running = true;
+    for (; started < server.threads; started++) {
+        if (sl_sys_thread_start(&server.workers[started].thread, sl_server_worker_run, &server.workers[started])) {
+            fprintf(stderr, "worker %u: thread start failed\n", started);
+            goto cleanup;
+        }
+    }
+
+    printf("socklynx_server: %u threads, %s mode, batch %u%s\n", server.threads,
+           server.mode == SL_SERVER_MODE_ECHO ? "echo" : "discard", server.batch, server.gro ? ", gro" : "");
+    fflush(stdout);
+
+    const uint64_t start_ns = sl_sys_time_ns();
+    uint64_t report_ns = start_ns;
+    while (!sl_server_signaled) {
+        sl_sys_sleep_ms(server.interval_ms);
+        const uint64_t now_ns = sl_sys_time_ns();
+        sl_server_report(&server, last, &prev, now_ns - report_ns);
+        report_ns = now_ns;
+        if (server.duration_s && now_ns - start_ns >= (uint64_t)server.duration_s * 1000000000ULL) break;
+    }
+    rv = 0;
+
+cleanup:
+    server.running = false;
+    for (uint32_t i = 0; i < started; i++) {
+        sl_sys_thread_join(&server.workers[i].thread);
+        if (server.workers[i].error) {
+            fprintf(stderr, "worker %u: exited with error %u\n", i, server.workers[i].error);
+            rv = 1;
+        }
+    }
+    for (uint32_t i = 0; server.workers && i < server.threads; i++) {
+        sl_poller_cleanup(&server.workers[i].poller);
+        if (server.workers[i].sock.state != SL_SOCK_STATE_NEW) sl_sock_close(&server.workers[i].sock);
+    }
+    if (server.capture.dropped) fprintf(stderr, "capture full, %llu datagrams not written\n", (unsigned long long)server.capture.dropped);
+    sl_capture_cleanup(&server.capture);
+    free(server.workers);
+    free(last);
+    sl_sys_cleanup(&server.sys);
+
+    return rv;
 }
@@ -29,7 +29,7 @@ static const uint16_t listen_port = 51343;
 
 SL_TEST_CASE_BEGIN(sl_udp_setup)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
     ASSERT_TRUE(SL_SYS_STATE_STARTED == ctx.state);
@@ -44,7 +44,7 @@ SL_TEST_CASE_END(sl_udp_setup);
 
 SL_TEST_CASE_BEGIN(sl_udp_doublesetup)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
     ASSERT_TRUE(SL_SYS_STATE_STARTED == ctx.state);
@@ -64,7 +64,7 @@ SL_TEST_CASE_END(sl_udp_doublesetup);
 
 SL_TEST_CASE_BEGIN(sl_udp_cleanup)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
     ASSERT_TRUE(SL_SYS_STATE_STOPPED == ctx.state);
@@ -74,7 +74,7 @@ SL_TEST_CASE_END(sl_udp_cleanup);
 
 SL_TEST_CASE_BEGIN(sl_udp_doublecleanup)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
     ASSERT_TRUE(SL_SYS_STATE_STOPPED == ctx.state);
@@ -87,7 +87,7 @@ SL_TEST_CASE_END(sl_udp_doublecleanup);
 
 SL_TEST_CASE_BEGIN(sl_udp_setupcleanup)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
     ASSERT_TRUE(SL_SYS_STATE_STARTED == ctx.state);
@@ -102,7 +102,7 @@ SL_TEST_CASE_END(sl_udp_setupcleanup);
 
 SL_TEST_CASE_BEGIN(sl_udp_doublesetupcleanup)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
     ASSERT_TRUE(SL_SYS_STATE_STARTED == ctx.state);
@@ -125,7 +125,7 @@ SL_TEST_CASE_END(sl_udp_doublesetupcleanup);
 
 SL_TEST_CASE_BEGIN(sl_udp_newsocket)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
 
@@ -158,7 +158,7 @@ SL_TEST_CASE_END(sl_udp_newsocket);
 
 SL_TEST_CASE_BEGIN(sl_udp_socketopenclose)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
 
@@ -192,7 +192,7 @@ SL_TEST_CASE_END(sl_udp_socketopenclose);
 
 SL_TEST_CASE_BEGIN(sl_udp_socketsetblocking)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
 
@@ -216,4 +216,703 @@ SL_TEST_CASE_BEGIN(sl_udp_socketsetblocking)
     ASSERT_SUCCESS(sl_sock_close(&sock));
     ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
 
-SL_TEST_CASE_END(sl_udp_socketsetblocking);
\ No newline at end of file
+SL_TEST_CASE_END(sl_udp_socketsetblocking);
+
+SL_TEST_CASE_BEGIN(sl_bufpool_acquirerelease)
+
+    sl_bufpool_t pool = {0};
+    pool.slotcount = 100;
+    ASSERT_SUCCESS(sl_bufpool_setup(&pool));
+    ASSERT_TRUE(SL_BUFPOOL_STATE_STARTED == pool.state);
+    ASSERT_TRUE(1536 == pool.slotsize);
+    ASSERT_TRUE(100 == pool.free_count);
+
+    sl_buf_t buf;
+    ASSERT_SUCCESS(sl_bufpool_acquire(&pool, &buf));
+    ASSERT_TRUE(pool.arena == buf.base);
+    ASSERT_TRUE(pool.slotsize == buf.len);
+    sl_bufpool_release(&pool, &buf);
+    ASSERT_TRUE(100 == pool.free_count);
+
+    /* drain the whole pool through a cache, every slot distinct and cache line aligned */
+    sl_bufcache_t cache;
+    sl_bufcache_init(&cache, &pool);
+    sl_buf_t bufs[100];
+    for (int i = 0; i < 100; i++)
+    {
+        ASSERT_SUCCESS(sl_bufcache_acquire(&cache, &bufs[i]));
+        ASSERT_TRUE(0 == ((uintptr_t)bufs[i].base % SL_SYS_CACHELINE));
+        memset(bufs[i].base, i, bufs[i].len);
+    }
+    ASSERT_TRUE(SL_ERR == sl_bufcache_acquire(&cache, &buf));
+    ASSERT_TRUE(0 == pool.free_count);
+    for (int i = 0; i < 100; i++)
+    {
+        ASSERT_TRUE(i == bufs[i].base[0] && i == bufs[i].base[bufs[i].len - 1]);
+    }
+
+    for (int i = 0; i < 100; i++)
+    {
+        sl_bufcache_release(&cache, &bufs[i]);
+        ASSERT_TRUE(cache.count <= SL_BUFCACHE_SIZE);
+    }
+    ASSERT_TRUE(100 == pool.free_count + cache.count);
+    sl_bufcache_flush(&cache);
+    ASSERT_TRUE(100 == pool.free_count);
+
+    ASSERT_SUCCESS(sl_bufpool_cleanup(&pool));
+    ASSERT_TRUE(SL_BUFPOOL_STATE_STOPPED == pool.state);
+
+SL_TEST_CASE_END(sl_bufpool_acquirerelease)
+
+
+typedef struct bufpool_worker_s {
+    sl_sys_thread_t thread;
+    sl_bufpool_t *pool;
+    uint8_t id;
+    int failures;
+} bufpool_worker_t;
+
+static void bufpool_worker_run(void *arg)
+{
+    bufpool_worker_t *worker = (bufpool_worker_t *)arg;
+    sl_bufcache_t cache;
+    sl_buf_t bufs[24];
+
+    sl_bufcache_init(&cache, worker->pool);
+    for (int round = 0; round < 2000; round++)
+    {
+        int held = 0;
+        for (; held < 24; held++)
+        {
+            if (sl_bufcache_acquire(&cache, &bufs[held])) break;
+            bufs[held].base[0] = (char)worker->id;
+        }
+        for (int i = 0; i < held; i++)
+        {
+            if (bufs[i].base[0] != (char)worker->id) worker->failures++;
+            sl_bufcache_release(&cache, &bufs[i]);
+        }
+    }
+    sl_bufcache_flush(&cache);
+}
+
+SL_TEST_CASE_BEGIN(sl_bufpool_threaded)
+
+    sl_bufpool_t pool = {0};
+    pool.slotcount = 96;
+    pool.slotsize = 256;
+    ASSERT_SUCCESS(sl_bufpool_setup(&pool));
+
+    /* more demand than slots, so caches keep trading through the shared stack */
+    bufpool_worker_t workers[4];
+    for (int i = 0; i < 4; i++)
+    {
+        workers[i].pool = &pool;
+        workers[i].id = (uint8_t)(i + 1);
+        workers[i].failures = 0;
+        ASSERT_SUCCESS(sl_sys_thread_start(&workers[i].thread, bufpool_worker_run, &workers[i]));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_SUCCESS(sl_sys_thread_join(&workers[i].thread));
+        ASSERT_TRUE(0 == workers[i].failures);
+    }
+    ASSERT_TRUE(96 == pool.free_count);
+
+    ASSERT_SUCCESS(sl_bufpool_cleanup(&pool));
+
+SL_TEST_CASE_END(sl_bufpool_threaded)
+
+
+SL_TEST_CASE_BEGIN(sl_peertable_insertfind)
+
+    const uint32_t peer_count = 200000;
+
+    sl_peertable_t table = {0};
+    table.capacity = peer_count;
+    table.slotsize = 40;
+    ASSERT_SUCCESS(sl_peertable_setup(&table));
+    ASSERT_TRUE(SL_PEERTABLE_STATE_STARTED == table.state);
+    ASSERT_TRUE(64 == table.slotsize);
+    ASSERT_TRUE(table.mask + 1 >= 2 * peer_count);
+
+    /* half v4 on one port, half v6 sharing an address, so both key layouts collide on some fields */
+    sl_endpoint_t *endpoints = (sl_endpoint_t *)calloc(peer_count, sizeof(*endpoints));
+    uint32_t *handles = (uint32_t *)malloc(peer_count * sizeof(*handles));
+    ASSERT_NOT_NULL(endpoints);
+    ASSERT_NOT_NULL(handles);
+    for (uint32_t i = 0; i < peer_count; i++)
+    {
+        if (i & 1)
+        {
+            sl_endpoint_af_set(&endpoints[i], SL_SOCK_AF_IPV6);
+            endpoints[i].addr6.addr[0] = 0xfd;
+            memcpy(endpoints[i].addr6.addr + 12, &i, sizeof(i));
+            endpoints[i].addr6.port = (uint16_t)i;
+        }
+        else
+        {
+            sl_endpoint_af_set(&endpoints[i], SL_SOCK_AF_IPV4);
+            endpoints[i].addr4.addr = i;
+            endpoints[i].addr4.port = listen_port;
+        }
+        ASSERT_TRUE(SL_PEERTABLE_HANDLE_NONE == sl_peertable_find(&table, &endpoints[i]));
+        ASSERT_SUCCESS(sl_peertable_insert(&table, &endpoints[i], &handles[i]));
+        ASSERT_TRUE(SL_PEERTABLE_HANDLE_NONE != handles[i]);
+        uint32_t *slot = (uint32_t *)sl_peertable_slot(&table, handles[i]);
+        ASSERT_NOT_NULL(slot);
+        ASSERT_TRUE(0 == ((uintptr_t)slot % SL_SYS_CACHELINE));
+        ASSERT_TRUE(0 == slot[0]);
+        slot[0] = i;
+    }
+    ASSERT_TRUE(peer_count == table.count);
+
+    /* full, and a repeat insert hands back the existing peer */
+    uint32_t handle;
+    sl_endpoint_t stranger;
+    ASSERT_SUCCESS(sl_endpoint_parse(&stranger, "192.0.2.1", 9));
+    ASSERT_TRUE(SL_ERR == sl_peertable_insert(&table, &stranger, &handle));
+    ASSERT_TRUE(ENOSPC == table.error);
+    ASSERT_TRUE(SL_ERR == sl_peertable_insert(&table, &endpoints[7], &handle));
+    ASSERT_TRUE(EEXIST == table.error);
+    ASSERT_TRUE(handles[7] == handle);
+
+    /* flowinfo and v4 padding are not part of the key */
+    sl_endpoint_t alias = endpoints[7];
+    alias.addr6.flowinfo = 0x12345;
+    ASSERT_TRUE(handles[7] == sl_peertable_find(&table, &alias));
+    alias = endpoints[8];
+    alias.addr4.pad[0] = 1;
+    ASSERT_TRUE(handles[8] == sl_peertable_find(&table, &alias));
+
+    /* drop every third peer, the rest stay reachable through their probe runs */
+    for (uint32_t i = 0; i < peer_count; i += 3)
+    {
+        ASSERT_SUCCESS(sl_peertable_remove(&table, handles[i]));
+        ASSERT_NULL(sl_peertable_slot(&table, handles[i]));
+    }
+    ASSERT_TRUE(SL_ERR == sl_peertable_remove(&table, handles[0]));
+    ASSERT_TRUE(ENOENT == table.error);
+    for (uint32_t i = 0; i < peer_count; i++)
+    {
+        uint32_t found = sl_peertable_find(&table, &endpoints[i]);
+        if (i % 3 == 0)
+        {
+            ASSERT_TRUE(SL_PEERTABLE_HANDLE_NONE == found);
+            continue;
+        }
+        ASSERT_TRUE(handles[i] == found);
+        ASSERT_TRUE(i == *(uint32_t *)sl_peertable_slot(&table, found));
+        ASSERT_TRUE(sl_endpoint_equal(&endpoints[i], sl_peertable_endpoint(&table, found)));
+    }
+
+    /* a freed slot comes back under a new generation, the old handle stays dead */
+    ASSERT_SUCCESS(sl_peertable_insert(&table, &stranger, &handle));
+    ASSERT_TRUE((handle & SL_PEERTABLE_INDEX_MASK) == (handles[peer_count - 1 - (peer_count - 1) % 3] & SL_PEERTABLE_INDEX_MASK));
+    ASSERT_TRUE(handle != handles[peer_count - 1 - (peer_count - 1) % 3]);
+    ASSERT_TRUE(0 == *(uint32_t *)sl_peertable_slot(&table, handle));
+
+    /* a recv batch worth of senders, known and unknown mixed */
+    sl_msg_t msgs[SL_SOCK_BATCH_MAX + 6];
+    uint32_t batch[SL_SOCK_BATCH_MAX + 6];
+    int32_t expected = 0;
+    for (int32_t i = 0; i < SL_SOCK_BATCH_MAX + 6; i++)
+    {
+        msgs[i].endpoint = &endpoints[i * 977];
+        if ((i * 977) % 3) expected++;
+    }
+    msgs[5].endpoint = &stranger;
+    if ((5 * 977) % 3 == 0) expected++;
+    ASSERT_TRUE(expected == sl_peertable_find_batch(&table, msgs, SL_SOCK_BATCH_MAX + 6, batch));
+    for (int32_t i = 0; i < SL_SOCK_BATCH_MAX + 6; i++)
+    {
+        ASSERT_TRUE(sl_peertable_find(&table, msgs[i].endpoint) == batch[i]);
+    }
+    ASSERT_TRUE(handle == batch[5]);
+
+    free(endpoints);
+    free(handles);
+    ASSERT_SUCCESS(sl_peertable_cleanup(&table));
+    ASSERT_TRUE(SL_PEERTABLE_STATE_STOPPED == table.state);
+
+SL_TEST_CASE_END(sl_peertable_insertfind)
+
+SL_TEST_CASE_BEGIN(sl_timerwheel_expiry)
+
+    const uint32_t timer_count = 100000;
+
+    sl_timerwheel_t wheel = {0};
+    ASSERT_SUCCESS(sl_timerwheel_setup(&wheel));
+    ASSERT_TRUE(SL_TIMERWHEEL_STATE_STARTED == wheel.state);
+    ASSERT_TRUE(SL_TIMERWHEEL_TICK_NS_DEFAULT == wheel.tick_ns);
+    ASSERT_TRUE(UINT64_MAX == sl_timerwheel_deadline(&wheel));
+    ASSERT_TRUE(250 == sl_timerwheel_timeout_ms(&wheel, wheel.base_ns, 250));
+
+    /* deadlines on every level and past the top one, data carries the deadline to check against */
+    sl_timer_t *timers = (sl_timer_t *)calloc(timer_count, sizeof(*timers));
+    ASSERT_NOT_NULL(timers);
+    const uint64_t tick = wheel.tick_ns;
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < timer_count; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        const uint64_t ticks = (uint64_t)(seed >> (i % 4 * 2 + 5)) % (SL_TIMERWHEEL_SPAN * 2);
+        timers[i].data = wheel.base_ns + ticks * tick + (i & 1 ? tick / 2 : 0);
+        sl_timerwheel_schedule(&wheel, &timers[i], timers[i].data);
+        ASSERT_TRUE(sl_timer_pending(&timers[i]));
+    }
+    ASSERT_TRUE(timer_count == wheel.count);
+
+    /* cancel every fifth, reschedule every seventh, both before any time passes */
+    uint32_t cancelled = 0;
+    for (uint32_t i = 0; i < timer_count; i += 5)
+    {
+        sl_timerwheel_cancel(&wheel, &timers[i]);
+        ASSERT_FALSE(sl_timer_pending(&timers[i]));
+        cancelled++;
+    }
+    sl_timerwheel_cancel(&wheel, &timers[0]);
+    for (uint32_t i = 1; i < timer_count; i += 7)
+    {
+        if (i % 5 == 0) continue;
+        timers[i].data = wheel.base_ns + (i % 3000 + 1) * tick;
+        sl_timerwheel_schedule(&wheel, &timers[i], timers[i].data);
+    }
+    ASSERT_TRUE(timer_count - cancelled == wheel.count);
+
+    /* uneven steps, each timer fires on the first advance at or past its deadline */
+    sl_timer_t *expired[64];
+    uint32_t fired = 0;
+    uint64_t prev_ns = wheel.base_ns;
+    uint64_t now_ns = wheel.base_ns;
+    while (wheel.count)
+    {
+        const uint64_t deadline = sl_timerwheel_deadline(&wheel);
+        ASSERT_TRUE(deadline > prev_ns);
+        seed = seed * 1664525 + 1013904223;
+        now_ns += (seed % 4 ? seed % 40 + 1 : seed % 50000 + 1) * tick;
+        uint32_t n;
+        bool first = true;
+        while ((n = sl_timerwheel_advance(&wheel, now_ns, expired, 64)))
+        {
+            if (first) ASSERT_TRUE(deadline <= now_ns);
+            first = false;
+            for (uint32_t i = 0; i < n; i++)
+            {
+                ASSERT_FALSE(sl_timer_pending(expired[i]));
+                ASSERT_TRUE(expired[i]->data <= now_ns);
+                ASSERT_TRUE(expired[i]->data + tick > prev_ns);
+                fired++;
+            }
+        }
+        prev_ns = now_ns;
+    }
+    ASSERT_TRUE(timer_count - cancelled == fired);
+    ASSERT_TRUE(UINT64_MAX == sl_timerwheel_deadline(&wheel));
+
+    /* due timers come back in batches, and one scheduled in the past is due straight away */
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        sl_timerwheel_schedule(&wheel, &timers[i], now_ns + tick * 3);
+    }
+    sl_timerwheel_schedule(&wheel, &timers[100], now_ns - tick * 10);
+    ASSERT_TRUE(0 == sl_timerwheel_deadline(&wheel));
+    ASSERT_TRUE(0 == sl_timerwheel_timeout_ms(&wheel, now_ns, 250));
+    ASSERT_TRUE(1 == sl_timerwheel_advance(&wheel, now_ns, expired, 64));
+    ASSERT_TRUE(&timers[100] == expired[0]);
+    ASSERT_TRUE(now_ns + tick * 3 == sl_timerwheel_deadline(&wheel));
+    ASSERT_TRUE(3 == sl_timerwheel_timeout_ms(&wheel, now_ns, 250));
+    ASSERT_TRUE(4 == sl_timerwheel_timeout_ms(&wheel, now_ns - 1, 250));
+    ASSERT_TRUE(2 == sl_timerwheel_timeout_ms(&wheel, now_ns, 2));
+    ASSERT_TRUE(64 == sl_timerwheel_advance(&wheel, now_ns + tick * 3, expired, 64));
+    ASSERT_TRUE(36 == sl_timerwheel_advance(&wheel, now_ns + tick * 3, expired, 64));
+    ASSERT_TRUE(0 == wheel.count);
+
+    free(timers);
+    ASSERT_SUCCESS(sl_timerwheel_cleanup(&wheel));
+    ASSERT_TRUE(SL_TIMERWHEEL_STATE_STOPPED == wheel.state);
+
+    /* the poller sleeps until the next deadline instead of its cap, on a fresh wheel as the one above ran ahead of the clock */
+    ASSERT_SUCCESS(sl_timerwheel_setup(&wheel));
+    sl_timer_t timer = {0};
+    sl_sys_t ctx = {0};
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+    sl_poller_t poller = {0};
+    poller.capacity = 1;
+    ASSERT_SUCCESS(sl_poller_setup(&poller));
+    sl_poll_event_t events[4];
+    const uint64_t start_ns = sl_sys_time_ns();
+    sl_timerwheel_schedule(&wheel, &timer, start_ns + 30000000ULL);
+    ASSERT_TRUE(0 == sl_timerwheel_poll(&wheel, &poller, events, 4, 5000));
+    const uint64_t elapsed_ns = sl_sys_time_ns() - start_ns;
+    ASSERT_TRUE(elapsed_ns >= 30000000ULL - tick);
+    ASSERT_TRUE(elapsed_ns < 2000000000ULL);
+    ASSERT_TRUE(1 == sl_timerwheel_advance(&wheel, sl_sys_time_ns() + tick, expired, 64));
+    ASSERT_SUCCESS(sl_poller_cleanup(&poller));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+    ASSERT_SUCCESS(sl_timerwheel_cleanup(&wheel));
+
+SL_TEST_CASE_END(sl_timerwheel_expiry)
+
+SL_TEST_CASE_BEGIN(sl_pacer_tokenbucket)
+
+    const uint64_t ms = 1000000ULL;
+    const uint64_t start_ns = 1000 * ms;
+
+    /* 1 MB/s is a millisecond per 1000 bytes on the wire, the default burst goes out back to back */
+    sl_pacer_t pacer;
+    sl_pacer_init(&pacer, 1000000, 0);
+    ASSERT_TRUE(SL_PACER_BURST_DEFAULT * ms / 1000 == pacer.burst_ns);
+    const uint64_t bytes = 1000 - SL_PACER_OVERHEAD;
+    sl_buf_t buf = {.base = NULL, .len = bytes};
+    sl_msg_t msg = {.buf = &buf, .bufcount = 1};
+    ASSERT_TRUE(1000 == sl_pacer_msg_bytes(&msg));
+
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(start_ns == sl_pacer_launch(&pacer, 1000, start_ns));
+    }
+    ASSERT_TRUE(start_ns + ms / 5 == sl_pacer_deadline(&pacer));
+    for (uint64_t i = 0; i < 10; i++)
+    {
+        ASSERT_TRUE(start_ns + ms / 5 + i * ms == sl_pacer_launch(&pacer, 1000, start_ns));
+    }
+
+    /* caught up with the clock, each datagram leaves as its slot comes round */
+    uint64_t now_ns = start_ns + 10 * ms + ms / 5;
+    ASSERT_TRUE(now_ns == sl_pacer_launch(&pacer, 1000, now_ns));
+    ASSERT_TRUE(now_ns + ms == sl_pacer_launch(&pacer, 1000, now_ns));
+
+    /* a quiet spell earns back one burst, not more */
+    now_ns += 1000 * ms;
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(now_ns == sl_pacer_launch(&pacer, 1000, now_ns));
+    }
+    ASSERT_TRUE(now_ns < sl_pacer_launch(&pacer, 1000, now_ns));
+
+    /* no rate, no pacing */
+    sl_pacer_init(&pacer, 0, 0);
+    for (int i = 0; i < 100; i++)
+    {
+        ASSERT_TRUE(now_ns == sl_pacer_launch(&pacer, 1500, now_ns));
+    }
+    ASSERT_TRUE(0 == sl_pacer_deadline(&pacer));
+
+SL_TEST_CASE_END(sl_pacer_tokenbucket)
+
+
+/* appends a pcapng block around body, padded to 4 bytes, and returns the new end */
+static size_t pcapng_block(uint8_t *dst, size_t at, uint32_t type, const void *body, size_t len)
+{
+    const uint32_t block_len = (uint32_t)(12 + ((len + 3) & ~(size_t)3));
+    memcpy(dst + at, &type, 4);
+    memcpy(dst + at + 4, &block_len, 4);
+    memset(dst + at + 8, 0, block_len - 12);
+    memcpy(dst + at + 8, body, len);
+    memcpy(dst + at + block_len - 4, &block_len, 4);
+    return at + block_len;
+}
+
+SL_TEST_CASE_BEGIN(sl_capture_readpcapng)
+
+    /* a vlan tagged ipv4 datagram, a tcp segment and an ipv6 datagram over ethernet */
+    uint8_t frame4[18 + 20 + 8 + 5] = {0};
+    frame4[12] = 0x81;
+    frame4[16] = 0x08;
+    uint8_t *ip4 = frame4 + 18;
+    ip4[0] = 0x45;
+    ip4[9] = 17;
+    ip4[12] = 10, ip4[15] = 1;
+    ip4[16] = 10, ip4[19] = 2;
+    uint8_t *udp4 = ip4 + 20;
+    udp4[0] = 0x30, udp4[1] = 0x39;
+    udp4[2] = 0xc8, udp4[3] = 0x8f;
+    udp4[5] = 8 + 5;
+    memcpy(udp4 + 8, "hello", 5);
+
+    uint8_t frame_tcp[14 + 20 + 20] = {0};
+    frame_tcp[12] = 0x08;
+    frame_tcp[14] = 0x45;
+    frame_tcp[14 + 9] = 6;
+
+    uint8_t frame6[14 + 40 + 8 + 3] = {0};
+    frame6[12] = 0x86, frame6[13] = 0xdd;
+    uint8_t *ip6 = frame6 + 14;
+    ip6[0] = 0x60;
+    ip6[6] = 17;
+    ip6[23] = 1;
+    ip6[39] = 2;
+    uint8_t *udp6 = ip6 + 40;
+    udp6[1] = 53, udp6[3] = 54;
+    udp6[5] = 8 + 3;
+    memcpy(udp6 + 8, "abc", 3);
+
+    uint8_t file[512];
+    size_t len = 0;
+    uint8_t shb[16] = {0};
+    const uint32_t bom = SL_CAPTURE_PCAPNG_BOM;
+    memcpy(shb, &bom, 4);
+    shb[4] = 1;
+    memset(shb + 8, 0xff, 8);
+    len = pcapng_block(file, len, SL_CAPTURE_PCAPNG_SHB, shb, sizeof(shb));
+
+    /* ethernet with if_tsresol 3, timestamps in milliseconds */
+    uint8_t idb[20] = {0};
+    idb[0] = SL_CAPTURE_LINKTYPE_ETHERNET;
+    const uint16_t opt[2] = {SL_CAPTURE_PCAPNG_TSRESOL, 1};
+    memcpy(idb + 8, opt, 4);
+    idb[12] = 3;
+    len = pcapng_block(file, len, SL_CAPTURE_PCAPNG_IDB, idb, sizeof(idb));
+
+    uint8_t epb[20 + sizeof(frame_tcp)];
+    const uint32_t epb4[5] = {0, 0, 1500, sizeof(frame4), sizeof(frame4)};
+    memcpy(epb, epb4, 20);
+    memcpy(epb + 20, frame4, sizeof(frame4));
+    len = pcapng_block(file, len, SL_CAPTURE_PCAPNG_EPB, epb, 20 + sizeof(frame4));
+    const uint32_t epb_tcp[5] = {0, 0, 1600, sizeof(frame_tcp), sizeof(frame_tcp)};
+    memcpy(epb, epb_tcp, 20);
+    memcpy(epb + 20, frame_tcp, sizeof(frame_tcp));
+    len = pcapng_block(file, len, SL_CAPTURE_PCAPNG_EPB, epb, 20 + sizeof(frame_tcp));
+
+    uint8_t spb[4 + sizeof(frame6)];
+    const uint32_t spb_len = sizeof(frame6);
+    memcpy(spb, &spb_len, 4);
+    memcpy(spb + 4, frame6, sizeof(frame6));
+    len = pcapng_block(file, len, SL_CAPTURE_PCAPNG_SPB, spb, 4 + sizeof(frame6));
+
+    const char *path = "sl_capture_readpcapng.pcapng";
+    FILE *fp = fopen(path, "wb");
+    ASSERT_NOT_NULL(fp);
+    ASSERT_TRUE(len == fwrite(file, 1, len, fp));
+    fclose(fp);
+
+    sl_capture_reader_t reader = {0};
+    sl_capture_packet_t packet;
+    ASSERT_SUCCESS(sl_capture_reader_open(&reader, path));
+    ASSERT_TRUE(reader.pcapng);
+
+    ASSERT_SUCCESS(sl_capture_reader_next(&reader, &packet));
+    ASSERT_TRUE(packet.len == 5 && packet.wirelen == 5);
+    ASSERT_SUCCESS(memcmp(packet.payload, "hello", 5));
+    ASSERT_TRUE(packet.timestamp_ns == 1500000000ULL);
+    ASSERT_TRUE(sl_endpoint_is_ipv4(&packet.src));
+    ASSERT_TRUE(ntohs(packet.src.addr4.port) == 12345 && ntohs(packet.dst.addr4.port) == 51343);
+    ASSERT_TRUE(ntohl(packet.src.addr4.addr) == 0x0a000001 && ntohl(packet.dst.addr4.addr) == 0x0a000002);
+
+    /* the tcp segment is skipped, the simple packet block keeps the last timestamp */
+    ASSERT_SUCCESS(sl_capture_reader_next(&reader, &packet));
+    ASSERT_TRUE(reader.skipped == 1);
+    ASSERT_TRUE(packet.len == 3);
+    ASSERT_SUCCESS(memcmp(packet.payload, "abc", 3));
+    ASSERT_TRUE(packet.timestamp_ns == 1600000000ULL);
+    ASSERT_TRUE(sl_endpoint_is_ipv6(&packet.src));
+    ASSERT_TRUE(ntohs(packet.src.addr6.port) == 53 && packet.dst.addr6.addr[15] == 2);
+
+    ASSERT_TRUE(SL_ERR == sl_capture_reader_next(&reader, &packet));
+    sl_capture_reader_rewind(&reader);
+    ASSERT_SUCCESS(sl_capture_reader_next(&reader, &packet));
+    ASSERT_TRUE(packet.len == 5);
+    ASSERT_SUCCESS(sl_capture_reader_close(&reader));
+    remove(path);
+
+    /* anything else is refused */
+    fp = fopen(path, "wb");
+    ASSERT_NOT_NULL(fp);
+    ASSERT_TRUE(len - 4 == fwrite(file + 4, 1, len - 4, fp));
+    fclose(fp);
+    ASSERT_TRUE(SL_ERR == sl_capture_reader_open(&reader, path));
+    ASSERT_TRUE(reader.error == EINVAL);
+    remove(path);
+
+SL_TEST_CASE_END(sl_capture_readpcapng)
+
+static int fragment_make(char *dst, uint16_t msg_id, uint16_t index, uint16_t count, int32_t fragsize, int32_t len)
+{
+    sl_frag_header_write(dst, msg_id, index, count, fragsize);
+    for (int32_t i = 0; i < len; i++)
+    {
+        dst[SL_FRAG_HEADER_SIZE + i] = (char)(msg_id + index * fragsize + i);
+    }
+    return SL_FRAG_HEADER_SIZE + len;
+}
+
+SL_TEST_CASE_BEGIN(sl_fragtable_reassemble)
+
+    sl_bufpool_t pool = {0};
+    pool.slotcount = 4;
+    pool.slotsize = 1024;
+    ASSERT_SUCCESS(sl_bufpool_setup(&pool));
+
+    sl_fragtable_t table = {0};
+    table.pool = &pool;
+    table.capacity = SL_FRAG_PROBE;
+    table.timeout_ms = 10;
+    ASSERT_SUCCESS(sl_fragtable_setup(&table));
+    ASSERT_TRUE(SL_FRAG_PROBE - 1 == table.mask);
+
+    sl_endpoint_t peer_a, peer_b;
+    ASSERT_SUCCESS(sl_endpoint_parse(&peer_a, "192.0.2.1", 4000));
+    ASSERT_SUCCESS(sl_endpoint_parse(&peer_b, "2001:db8::1", 4000));
+
+    /* out of order with a duplicate, the message completes on its last missing fragment */
+    char frag[SL_FRAG_HEADER_SIZE + 300];
+    sl_buf_t msg;
+    uint64_t now_ns = 1000000000ULL;
+    ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 7, 2, 3, 300, 50), now_ns, &msg));
+    ASSERT_TRUE(1 == table.active);
+    ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 7, 0, 3, 300, 300), now_ns, &msg));
+    ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 7, 0, 3, 300, 300), now_ns, &msg));
+    ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_b, frag, fragment_make(frag, 7, 1, 3, 300, 300), now_ns, &msg));
+    ASSERT_TRUE(2 == table.active);
+    ASSERT_TRUE(1 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 7, 1, 3, 300, 300), now_ns, &msg));
+    ASSERT_TRUE(650 == msg.len);
+    for (int32_t i = 0; i < 650; i++)
+    {
+        ASSERT_TRUE((char)(7 + i) == msg.base[i]);
+    }
+    ASSERT_TRUE(1 == table.active);
+    sl_bufpool_release(&pool, &msg);
+
+    /* single fragment messages go straight to a slot */
+    ASSERT_TRUE(1 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 8, 0, 1, 300, 20), now_ns, &msg));
+    ASSERT_TRUE(20 == msg.len);
+    sl_bufpool_release(&pool, &msg);
+
+    /* malformed: short, index past count, inner fragment not full size, larger than a slot, changed layout */
+    ASSERT_TRUE(SL_ERR == sl_fragtable_recv(&table, &peer_a, frag, 3, now_ns, &msg));
+    ASSERT_TRUE(EINVAL == table.error);
+    ASSERT_TRUE(SL_ERR == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 9, 3, 3, 300, 10), now_ns, &msg));
+    ASSERT_TRUE(SL_ERR == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 9, 0, 3, 300, 299), now_ns, &msg));
+    ASSERT_TRUE(SL_ERR == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 9, 0, 5, 300, 300), now_ns, &msg));
+    ASSERT_TRUE(SL_ERR == sl_fragtable_recv(&table, &peer_b, frag, fragment_make(frag, 7, 0, 4, 200, 200), now_ns, &msg));
+    ASSERT_TRUE(5 == table.dropped);
+
+    /* a flood of new messages is capped by the pool, then expires and frees every slot */
+    for (uint16_t id = 100; id < 200; id++)
+    {
+        ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, id, 0, 2, 300, 300), now_ns, &msg));
+    }
+    ASSERT_TRUE(4 == table.active);
+    ASSERT_TRUE(0 == pool.free_count);
+    ASSERT_TRUE(0 == sl_fragtable_expire(&table, now_ns + 5000000ULL));
+    ASSERT_TRUE(4 == sl_fragtable_expire(&table, now_ns + 10000000ULL));
+    ASSERT_TRUE(0 == table.active);
+    ASSERT_TRUE(4 == pool.free_count);
+
+    /* with the pool dry, a timed out entry in the probe window hands over its slot */
+    ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 300, 0, 2, 300, 300), now_ns, &msg));
+    for (uint16_t id = 301; id < 400 && pool.free_count; id++)
+    {
+        sl_fragtable_recv(&table, &peer_b, frag, fragment_make(frag, id, 0, 2, 300, 300), now_ns, &msg);
+    }
+    now_ns += 20000000ULL;
+    uint64_t expired = table.expired;
+    ASSERT_TRUE(0 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 301, 0, 2, 300, 300), now_ns, &msg));
+    ASSERT_TRUE(expired + 1 == table.expired);
+    ASSERT_TRUE(1 == sl_fragtable_recv(&table, &peer_a, frag, fragment_make(frag, 301, 1, 2, 300, 1), now_ns, &msg));
+    ASSERT_TRUE(301 == msg.len);
+    sl_bufpool_release(&pool, &msg);
+
+    ASSERT_SUCCESS(sl_fragtable_cleanup(&table));
+    ASSERT_TRUE(SL_FRAGTABLE_STATE_STOPPED == table.state);
+    ASSERT_TRUE(4 == pool.free_count);
+    ASSERT_SUCCESS(sl_bufpool_cleanup(&pool));
+
+SL_TEST_CASE_END(sl_fragtable_reassemble)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketautotune)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+
+    sl_sock_t sock = {0};
+    sock.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock));
+
+    /* small enough to sit under every default cap, the kernel reports at least what was asked */
+    int32_t rcvbuf = 0, sndbuf = 0;
+    ASSERT_SUCCESS(sl_sock_rcvbuf_set(&sock, 48 * 1024));
+    ASSERT_SUCCESS(sl_sock_sndbuf_set(&sock, 40 * 1024));
+    ASSERT_SUCCESS(sl_sock_rcvbuf_get(&sock, &rcvbuf));
+    ASSERT_SUCCESS(sl_sock_sndbuf_get(&sock, &sndbuf));
+    ASSERT_TRUE(rcvbuf >= 48 * 1024);
+    ASSERT_TRUE(sndbuf >= 40 * 1024);
+
+    sl_autotune_t tune = {0};
+    tune.sock = &sock;
+    tune.rcvbuf_min = 16 * 1024;
+    tune.rcvbuf_max = 64 * 1024;
+    tune.sndbuf_min = 16 * 1024;
+    tune.sndbuf_max = 64 * 1024;
+    tune.interval_ms = 10;
+    ASSERT_SUCCESS(sl_autotune_setup(&tune));
+    ASSERT_TRUE(SL_AUTOTUNE_STATE_STARTED == tune.state);
+    ASSERT_TRUE(sock.flags & SL_SOCK_FLAG_RXQ_OVFL);
+    ASSERT_TRUE(16 * 1024 == tune.rcvbuf_request);
+    ASSERT_TRUE(tune.rcvbuf >= 16 * 1024 && tune.rcvbuf < rcvbuf);
+    const int32_t rcvbuf_min = tune.rcvbuf, sndbuf_min = tune.sndbuf;
+
+    /* drops and would blocks are fed in through the stats the receive and send paths keep */
+    uint64_t now_ns = tune.last_ns;
+    ASSERT_TRUE(0 == sl_autotune_update(&tune, now_ns + 1000000ULL));
+    sock.stats.rx_dropped += 3;
+    ASSERT_TRUE(0 == sl_autotune_update(&tune, now_ns + 1000000ULL));
+    now_ns += 10000000ULL;
+    ASSERT_TRUE(1 == sl_autotune_update(&tune, now_ns));
+    ASSERT_TRUE(32 * 1024 == tune.rcvbuf_request);
+    ASSERT_TRUE(16 * 1024 == tune.sndbuf_request);
+    ASSERT_TRUE(tune.rcvbuf > rcvbuf_min);
+    ASSERT_TRUE(tune.sndbuf == sndbuf_min);
+
+    /* growth stops at the max */
+    for (int i = 0; i < 3; i++)
+    {
+        sock.stats.rx_dropped++;
+        sock.stats.tx_wouldblock++;
+        now_ns += 10000000ULL;
+        sl_autotune_update(&tune, now_ns);
+    }
+    ASSERT_TRUE(64 * 1024 == tune.rcvbuf_request);
+    ASSERT_TRUE(64 * 1024 == tune.sndbuf_request);
+    ASSERT_TRUE(tune.sndbuf > sndbuf_min);
+
+    /* a quiet socket gives back a quarter at a time down to the min */
+    uint32_t adjustments = tune.adjustments;
+    for (int i = 0; i < SL_AUTOTUNE_QUIET_INTERVALS; i++)
+    {
+        now_ns += 10000000ULL;
+        ASSERT_TRUE(tune.adjustments == adjustments);
+        sl_autotune_update(&tune, now_ns);
+    }
+    ASSERT_TRUE(tune.adjustments == adjustments + 1);
+    ASSERT_TRUE(48 * 1024 == tune.rcvbuf_request);
+    ASSERT_TRUE(48 * 1024 == tune.sndbuf_request);
+    for (int i = 0; i < 10 * SL_AUTOTUNE_QUIET_INTERVALS; i++)
+    {
+        now_ns += 10000000ULL;
+        sl_autotune_update(&tune, now_ns);
+    }
+    ASSERT_TRUE(16 * 1024 == tune.rcvbuf_request);
+    ASSERT_TRUE(rcvbuf_min == tune.rcvbuf);
+
+    ASSERT_SUCCESS(sl_autotune_cleanup(&tune));
+    ASSERT_TRUE(SL_AUTOTUNE_STATE_STOPPED == tune.state);
+
+    tune.rcvbuf_min = 128 * 1024;
+    ASSERT_TRUE(SL_ERR == sl_autotune_setup(&tune));
+    ASSERT_TRUE(EINVAL == tune.error);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketautotune)
@@ -33,7 +33,7 @@ static const uint16_t listen_port = 51343;
 
 SL_TEST_CASE_BEGIN(sl_udp_socketsendrecv_blocking)
 
-    sl_sys_t ctx;
+    sl_sys_t ctx = {0};
 
     ASSERT_SUCCESS(sl_sys_setup(&ctx));
 
@@ -117,4 +117,1984 @@ SL_TEST_CASE_BEGIN(sl_udp_socketsendrecv_blocking)
     ASSERT_SUCCESS(sl_sock_close(&sock_client));
     ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
 
-SL_TEST_CASE_END(sl_udp_socketsendrecv_blocking)
\ No newline at end of file
+SL_TEST_CASE_END(sl_udp_socketsendrecv_blocking)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketrecvbatch_blocking)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    /* server side endpoint, socket and one recv slot more than we will send */
+    sl_endpoint_t ep_server;
+    ep_server.addr4 = loopback;
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint = ep_server;
+
+    char mem_server[4][mem_server_len];
+    sl_buf_t buf_server_recv[4];
+    sl_endpoint_t ep_server_recv[4];
+    sl_msg_t msg_server_recv[4];
+    for (int i = 0; i < 4; i++)
+    {
+        buf_server_recv[i].base = &mem_server[i][0];
+        buf_server_recv[i].len = mem_server_len;
+        msg_server_recv[i].buf = &buf_server_recv[i];
+        msg_server_recv[i].bufcount = 1;
+        msg_server_recv[i].endpoint = &ep_server_recv[i];
+        msg_server_recv[i].len = 0;
+    }
+
+    /* client side endpoint, socket and three payloads of differing length */
+    sl_endpoint_t ep_client;
+    loopback.port += 1;
+    ep_client.addr4 = loopback;
+
+    sl_sock_t sock_client = {0};
+    sock_client.endpoint = ep_client;
+
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0xb7 * (i >> 8);
+    }
+
+    sl_buf_t buf_client_send;
+    buf_client_send.base = &pl_client[0];
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    for (int i = 1; i <= 3; i++)
+    {
+        buf_client_send.len = pl_client_len / i;
+        ASSERT_TRUE((int)buf_client_send.len == sl_sock_send(&sock_client, &buf_client_send, 1, &ep_server));
+    }
+
+    ASSERT_TRUE(3 == sl_sock_recv_batch(&sock_server, msg_server_recv, 4));
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(pl_client_len / (i + 1) == msg_server_recv[i].len);
+        ASSERT_SUCCESS(memcmp(pl_client, mem_server[i], msg_server_recv[i].len));
+        ASSERT_TRUE(ep_client.addr4.port == ep_server_recv[i].addr4.port);
+        ASSERT_TRUE(ep_client.addr4.addr == ep_server_recv[i].addr4.addr);
+    }
+    ASSERT_TRUE(0 == msg_server_recv[3].len);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketrecvbatch_blocking)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketsendbatch_blocking)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    /* two server sockets so every message in the batch carries its own endpoint */
+    sl_endpoint_t ep_server[2];
+    sl_sock_t sock_server[2] = {{0}};
+    char mem_server[4][mem_server_len];
+    sl_buf_t buf_server_recv[4];
+    sl_endpoint_t ep_server_recv[4];
+    sl_msg_t msg_server_recv[4];
+    for (int i = 0; i < 4; i++)
+    {
+        buf_server_recv[i].base = &mem_server[i][0];
+        buf_server_recv[i].len = mem_server_len;
+        msg_server_recv[i].buf = &buf_server_recv[i];
+        msg_server_recv[i].bufcount = 1;
+        msg_server_recv[i].endpoint = &ep_server_recv[i];
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        ep_server[i].addr4 = loopback;
+        sock_server[i].endpoint = ep_server[i];
+        ASSERT_SUCCESS(sl_sock_create(&sock_server[i], SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_server[i]));
+        loopback.port += 1;
+    }
+
+    /* client sends a header + payload iovec pair to alternating servers */
+    sl_endpoint_t ep_client;
+    ep_client.addr4 = loopback;
+
+    sl_sock_t sock_client = {0};
+    sock_client.endpoint = ep_client;
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    char hdr_client[4] = {'s', 'l', 0, 0};
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0xb7 * (i >> 8);
+    }
+
+    sl_buf_t buf_client_send[3][2];
+    sl_msg_t msg_client_send[3];
+    for (int i = 0; i < 3; i++)
+    {
+        buf_client_send[i][0].base = &hdr_client[0];
+        buf_client_send[i][0].len = sizeof(hdr_client);
+        buf_client_send[i][1].base = &pl_client[0];
+        buf_client_send[i][1].len = pl_client_len - i;
+        msg_client_send[i].buf = &buf_client_send[i][0];
+        msg_client_send[i].bufcount = 2;
+        msg_client_send[i].endpoint = &ep_server[i & 1];
+        msg_client_send[i].len = 0;
+    }
+
+    ASSERT_TRUE(3 == sl_sock_send_batch(&sock_client, msg_client_send, 3));
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE((int)sizeof(hdr_client) + pl_client_len - i == msg_client_send[i].len);
+    }
+
+    ASSERT_TRUE(2 == sl_sock_recv_batch(&sock_server[0], &msg_server_recv[0], 3));
+    ASSERT_TRUE(1 == sl_sock_recv_batch(&sock_server[1], &msg_server_recv[2], 2));
+    ASSERT_TRUE(msg_client_send[0].len == msg_server_recv[0].len);
+    ASSERT_TRUE(msg_client_send[2].len == msg_server_recv[1].len);
+    ASSERT_TRUE(msg_client_send[1].len == msg_server_recv[2].len);
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_SUCCESS(memcmp(hdr_client, mem_server[i], sizeof(hdr_client)));
+        ASSERT_SUCCESS(memcmp(pl_client, mem_server[i] + sizeof(hdr_client), msg_server_recv[i].len - sizeof(hdr_client)));
+        ASSERT_TRUE(ep_client.addr4.port == ep_server_recv[i].addr4.port);
+    }
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server[0]));
+    ASSERT_SUCCESS(sl_sock_close(&sock_server[1]));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketsendbatch_blocking)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketsendgso_blocking)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    /* server side receives each segment as its own datagram */
+    sl_endpoint_t ep_server;
+    ep_server.addr4 = loopback;
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint = ep_server;
+
+    char mem_server[8][mem_server_len];
+    sl_buf_t buf_server_recv[8];
+    sl_endpoint_t ep_server_recv[8];
+    sl_msg_t msg_server_recv[8];
+    for (int i = 0; i < 8; i++)
+    {
+        buf_server_recv[i].base = &mem_server[i][0];
+        buf_server_recv[i].len = mem_server_len;
+        msg_server_recv[i].buf = &buf_server_recv[i];
+        msg_server_recv[i].bufcount = 1;
+        msg_server_recv[i].endpoint = &ep_server_recv[i];
+    }
+
+    /* client side sends one large buffer which is split into 5 full segments and a short tail */
+    sl_endpoint_t ep_client;
+    loopback.port += 1;
+    ep_client.addr4 = loopback;
+
+    sl_sock_t sock_client = {0};
+    sock_client.endpoint = ep_client;
+
+    const uint16_t segsize = 1000;
+    char pl_client[5500];
+    for (int i = 0; i < (int)sizeof(pl_client); i++)
+    {
+        pl_client[i] = i ^ 0xb7 * (i >> 8);
+    }
+
+    sl_buf_t buf_client_send;
+    buf_client_send.base = &pl_client[0];
+    buf_client_send.len = sizeof(pl_client);
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    /* first pass with offload if the kernel has it, second pass with manual segmentation */
+    if (!sl_sock_gso_enable(&sock_client)) ASSERT_TRUE(SL_SOCK_FLAG_GSO & sock_client.flags);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        ASSERT_TRUE((int)sizeof(pl_client) == sl_sock_send_gso(&sock_client, &buf_client_send, segsize, &ep_server));
+
+        int msgs_recv = 0;
+        while (msgs_recv < 6)
+        {
+            int rv = sl_sock_recv_batch(&sock_server, &msg_server_recv[msgs_recv], 8 - msgs_recv);
+            ASSERT_TRUE(rv > 0);
+            msgs_recv += rv;
+        }
+        ASSERT_TRUE(6 == msgs_recv);
+
+        for (int i = 0; i < 6; i++)
+        {
+            ASSERT_TRUE((i < 5 ? segsize : 500) == msg_server_recv[i].len);
+            ASSERT_SUCCESS(memcmp(&pl_client[i * segsize], mem_server[i], msg_server_recv[i].len));
+        }
+
+        sl_sock_gso_disable(&sock_client);
+        ASSERT_FALSE(SL_SOCK_FLAG_GSO & sock_client.flags);
+    }
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketsendgso_blocking)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketsendgso_oversized)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_endpoint_t ep_server;
+    ep_server.addr4 = loopback;
+
+    sl_endpoint_t ep_client;
+    loopback.port += 1;
+    ep_client.addr4 = loopback;
+
+    sl_sock_t sock_client = {0};
+    sock_client.endpoint = ep_client;
+
+    /* segments past the largest datagram are refused up front, with and without the offload */
+    const size_t len = 70000;
+    char *pl_client = (char *)calloc(1, len);
+    ASSERT_TRUE(pl_client != NULL);
+
+    sl_buf_t buf_client_send;
+    buf_client_send.base = pl_client;
+    buf_client_send.len = len;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+    sl_sock_gso_enable(&sock_client);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        ASSERT_TRUE(SL_ERR == sl_sock_send_gso(&sock_client, &buf_client_send, SL_SOCK_GSO_BYTES_MAX + 1, &ep_server));
+        ASSERT_TRUE(EMSGSIZE == sock_client.error);
+        ASSERT_TRUE(SL_ERR == sl_sock_send_gso(&sock_client, &buf_client_send, UINT16_MAX, &ep_server));
+        ASSERT_TRUE(EMSGSIZE == sock_client.error);
+        sl_sock_gso_disable(&sock_client);
+    }
+
+    free(pl_client);
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketsendgso_oversized)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketrecvgro_blocking)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    /* server side receives into buffers large enough for a full coalesced run */
+    sl_endpoint_t ep_server;
+    ep_server.addr4 = loopback;
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint = ep_server;
+
+    static char mem_server[8][SL_SOCK_GSO_BYTES_MAX];
+    sl_buf_t buf_server_recv[8];
+    sl_endpoint_t ep_server_recv[8];
+    sl_msg_t msg_server_recv[8];
+    for (int i = 0; i < 8; i++)
+    {
+        buf_server_recv[i].base = &mem_server[i][0];
+        buf_server_recv[i].len = SL_SOCK_GSO_BYTES_MAX;
+        msg_server_recv[i].buf = &buf_server_recv[i];
+        msg_server_recv[i].bufcount = 1;
+        msg_server_recv[i].endpoint = &ep_server_recv[i];
+    }
+
+    /* client side sends 5 full segments and a short tail */
+    sl_endpoint_t ep_client;
+    loopback.port += 1;
+    ep_client.addr4 = loopback;
+
+    sl_sock_t sock_client = {0};
+    sock_client.endpoint = ep_client;
+
+    const uint16_t segsize = 1000;
+    char pl_client[5500];
+    for (int i = 0; i < (int)sizeof(pl_client); i++)
+    {
+        pl_client[i] = i ^ 0xb7 * (i >> 8);
+    }
+
+    sl_buf_t buf_client_send;
+    buf_client_send.base = &pl_client[0];
+    buf_client_send.len = sizeof(pl_client);
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    if (!sl_sock_gro_enable(&sock_server)) ASSERT_TRUE(SL_SOCK_FLAG_GRO & sock_server.flags);
+    sl_sock_gso_enable(&sock_client);
+
+    ASSERT_TRUE((int)sizeof(pl_client) == sl_sock_send_gso(&sock_client, &buf_client_send, segsize, &ep_server));
+
+    /* whether or not the kernel coalesced, walking the segments must give back the original datagrams */
+    int segs_recv = 0;
+    int bytes_recv = 0;
+    while (segs_recv < 6)
+    {
+        int rv = sl_sock_recv_batch(&sock_server, msg_server_recv, 8);
+        ASSERT_TRUE(rv > 0);
+        for (int i = 0; i < rv; i++)
+        {
+            sl_msg_t *msg = &msg_server_recv[i];
+            for (int32_t seg = 0; seg < sl_msg_segment_count(msg); seg++, segs_recv++)
+            {
+                int32_t offset = seg * msg->segsize;
+                int32_t seglen = (msg->len - offset < msg->segsize) ? msg->len - offset : msg->segsize;
+                ASSERT_TRUE((segs_recv < 5 ? segsize : 500) == seglen);
+                ASSERT_SUCCESS(memcmp(&pl_client[segs_recv * segsize], buf_server_recv[i].base + offset, seglen));
+                bytes_recv += seglen;
+            }
+        }
+    }
+    ASSERT_TRUE(6 == segs_recv);
+    ASSERT_TRUE((int)sizeof(pl_client) == bytes_recv);
+
+#if SL_SOCK_STATS
+    /* the single datagram receive loses the boundaries but still counts every segment */
+    ASSERT_TRUE(6 == sock_server.stats.rx_packets);
+    ASSERT_TRUE((int)sizeof(pl_client) == sl_sock_send_gso(&sock_client, &buf_client_send, segsize, &ep_server));
+    bytes_recv = 0;
+    while (bytes_recv < (int)sizeof(pl_client))
+    {
+        int rv = sl_sock_recv(&sock_server, &buf_server_recv[0], 1, &ep_server_recv[0]);
+        ASSERT_TRUE(rv > 0);
+        bytes_recv += rv;
+    }
+    ASSERT_TRUE(12 == sock_server.stats.rx_packets);
+#endif
+
+    ASSERT_SUCCESS(sl_sock_gro_disable(&sock_server));
+    ASSERT_FALSE(SL_SOCK_FLAG_GRO & sock_server.flags);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketrecvgro_blocking)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_ringsendrecv)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    /* the kernel lets go of a ring's sockets after sl_ring_cleanup returns, so every pass binds fresh ports */
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = 0;
+    loopback.addr = 127 | (1 << 24);
+
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0xb7 * (i >> 8);
+    }
+
+    /* first pass on io_uring when the kernel has it, second pass forced onto the synchronous fallback */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        sl_sock_t sock_server = {0};
+        sock_server.endpoint.addr4 = loopback;
+        sl_sock_t sock_client = {0};
+        sock_client.endpoint.addr4 = loopback;
+
+        ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+        ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+        sl_endpoint_t ep_server = sock_server.endpoint;
+        sl_endpoint_t ep_client = sock_client.endpoint;
+        ASSERT_TRUE(ep_server.addr4.port && ep_client.addr4.port && ep_server.addr4.port != ep_client.addr4.port);
+
+        sl_ring_t ring = {0};
+        ring.entries = 8;
+        ring.bufcount = 12;
+        ring.bufsize = mem_server_len;
+        ring.flags = pass ? SL_RING_FLAG_FALLBACK : 0;
+        ASSERT_SUCCESS(sl_ring_setup(&ring));
+        ASSERT_TRUE(SL_RING_STATE_STARTED == ring.state);
+        ASSERT_TRUE(16 == ring.bufcount);
+
+        int handle = sl_ring_recv(&ring, &sock_server, 42);
+        ASSERT_TRUE(handle >= 0);
+
+        sl_buf_t buf_client_send;
+        int slot = sl_ring_send_buf_get(&ring, &buf_client_send);
+        ASSERT_TRUE(slot >= 0);
+        ASSERT_TRUE(mem_server_len == buf_client_send.len);
+        memcpy(buf_client_send.base, pl_client, pl_client_len);
+        ASSERT_SUCCESS(sl_ring_send(&ring, &sock_client, slot, pl_client_len, &ep_server, 7));
+
+        bool sent = false, recvd = false;
+        sl_ring_cqe_t cqes[4];
+        for (int tries = 0; tries < 100 && !(sent && recvd); tries++)
+        {
+            int rv = sl_ring_complete(&ring, cqes, 4, 100);
+            ASSERT_TRUE(rv >= 0);
+            for (int i = 0; i < rv; i++)
+            {
+                if (SL_RING_OP_SEND == cqes[i].op)
+                {
+                    ASSERT_TRUE(7 == cqes[i].user_data);
+                    ASSERT_TRUE(&sock_client == cqes[i].sock);
+                    ASSERT_TRUE(pl_client_len == cqes[i].res);
+                    sent = true;
+                }
+                else
+                {
+                    ASSERT_TRUE(SL_RING_OP_RECV == cqes[i].op);
+                    ASSERT_TRUE(42 == cqes[i].user_data);
+                    ASSERT_TRUE(&sock_server == cqes[i].sock);
+                    ASSERT_TRUE(pl_client_len == cqes[i].res);
+                    ASSERT_TRUE(pl_client_len == (int)cqes[i].buf.len);
+                    ASSERT_SUCCESS(memcmp(pl_client, cqes[i].buf.base, pl_client_len));
+                    ASSERT_TRUE(ep_client.addr4.port == cqes[i].endpoint.addr4.port);
+                    ASSERT_TRUE(ep_client.addr4.addr == cqes[i].endpoint.addr4.addr);
+                    sl_ring_buf_release(&ring, cqes[i].bufid);
+                    recvd = true;
+                }
+            }
+        }
+        ASSERT_TRUE(sent && recvd);
+        ASSERT_TRUE(ring.entries == ring.send_free_count);
+        ASSERT_TRUE(ring.bufcount == ring.buf_avail);
+
+        ASSERT_SUCCESS(sl_ring_recv_cancel(&ring, handle));
+        ASSERT_SUCCESS(sl_ring_cleanup(&ring));
+        ASSERT_TRUE(SL_RING_STATE_STOPPED == ring.state);
+
+        ASSERT_SUCCESS(sl_sock_close(&sock_server));
+        ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    }
+
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_ringsendrecv)
+
+SL_TEST_CASE_BEGIN(sl_udp_ringrxqovfl)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = 0;
+    loopback.addr = 127 | (1 << 24);
+
+    char pl_client[mem_client_len] = {0};
+    sl_buf_t buf_client = {.len = mem_client_len, .base = pl_client};
+    const int sent = 64;
+
+    /* both backends keep the counters sl_sock_send and sl_sock_recv keep, the drop count included */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        sl_sock_t sock_server = {0};
+        sock_server.endpoint.addr4 = loopback;
+        sl_sock_t sock_client = {0};
+        sock_client.endpoint.addr4 = loopback;
+
+        ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+        ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+        sl_endpoint_t ep_server = sock_server.endpoint;
+        ASSERT_SUCCESS(sl_sock_rxq_ovfl_enable(&sock_server));
+        int rcvbuf = 1;
+        ASSERT_SUCCESS(setsockopt(sl_sock_fd_get(&sock_server), SOL_SOCKET, SO_RCVBUF, (const char *)&rcvbuf, sizeof(rcvbuf)));
+
+        sl_ring_t ring = {0};
+        ring.entries = 8;
+        ring.bufcount = 16;
+        ring.bufsize = 2048;
+        ring.flags = pass ? SL_RING_FLAG_FALLBACK : 0;
+        ASSERT_SUCCESS(sl_ring_setup(&ring));
+
+        for (int i = 0; i < sent; i++)
+        {
+            ASSERT_TRUE(mem_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+        }
+        int handle = sl_ring_recv(&ring, &sock_server, 42);
+        ASSERT_TRUE(handle >= 0);
+
+        sl_ring_cqe_t cqes[4];
+        int recvd = 0, rv;
+        while ((rv = sl_ring_complete(&ring, cqes, 4, 50)) > 0)
+        {
+            for (int i = 0; i < rv; i++)
+            {
+                ASSERT_TRUE(SL_RING_OP_RECV == cqes[i].op);
+                ASSERT_TRUE(mem_client_len == cqes[i].res);
+                sl_ring_buf_release(&ring, cqes[i].bufid);
+                recvd++;
+            }
+        }
+        ASSERT_TRUE(rv == 0);
+        ASSERT_TRUE(recvd > 0 && recvd < sent);
+
+        /* the drops arrive with the next datagram, sent through the ring this time */
+        sl_buf_t buf_send;
+        int slot = sl_ring_send_buf_get(&ring, &buf_send);
+        ASSERT_TRUE(slot >= 0);
+        memcpy(buf_send.base, pl_client, mem_client_len);
+        ASSERT_SUCCESS(sl_ring_send(&ring, &sock_client, slot, mem_client_len, &ep_server, 7));
+        bool sent_last = false, recvd_last = false;
+        for (int tries = 0; tries < 100 && !(sent_last && recvd_last); tries++)
+        {
+            ASSERT_TRUE((rv = sl_ring_complete(&ring, cqes, 4, 100)) >= 0);
+            for (int i = 0; i < rv; i++)
+            {
+                ASSERT_TRUE(mem_client_len == cqes[i].res);
+                if (SL_RING_OP_SEND == cqes[i].op)
+                {
+                    sent_last = true;
+                    continue;
+                }
+                sl_ring_buf_release(&ring, cqes[i].bufid);
+                recvd_last = true;
+                recvd++;
+            }
+        }
+        ASSERT_TRUE(sent_last && recvd_last);
+        ASSERT_TRUE((uint64_t)(sent + 1 - recvd) == sl_sock_rx_dropped(&sock_server));
+        ASSERT_TRUE((uint64_t)recvd == sock_server.stats.rx_packets);
+        ASSERT_TRUE((uint64_t)recvd * mem_client_len == sock_server.stats.rx_bytes);
+        ASSERT_TRUE(mem_client_len == sock_server.stats.rx_max);
+        ASSERT_TRUE((uint64_t)(sent + 1) == sock_client.stats.tx_packets);
+        ASSERT_TRUE((uint64_t)(sent + 1) * mem_client_len == sock_client.stats.tx_bytes);
+
+        ASSERT_SUCCESS(sl_ring_recv_cancel(&ring, handle));
+        ASSERT_SUCCESS(sl_ring_cleanup(&ring));
+        ASSERT_SUCCESS(sl_sock_close(&sock_server));
+        ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    }
+
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_ringrxqovfl)
+
+SL_TEST_CASE_BEGIN(sl_udp_ringimpaircapture)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = 0;
+    loopback.addr = 127 | (1 << 24);
+
+    const char *path = "sl_udp_ringimpaircapture.pcap";
+    const uint32_t value = 42;
+
+    /* each send is copied on the way out, each copy is held on the way in, and the capture sees all four */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        sl_sock_t sock_server = {0};
+        sock_server.endpoint.addr4 = loopback;
+        sl_sock_t sock_client = {0};
+        sock_client.endpoint.addr4 = loopback;
+
+        ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+        ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+        ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+        sl_endpoint_t ep_server = sock_server.endpoint;
+
+        sl_capture_t capture = {.size = 1024 * 1024};
+        ASSERT_SUCCESS(sl_capture_setup(&capture, path));
+        sl_sock_capture_set(&sock_client, &capture);
+        sl_sock_capture_set(&sock_server, &capture);
+        sl_impair_t tx = {.seed = 7, .duplicate_ppm = SL_IMPAIR_PPM};
+        sl_impair_t rx = {.seed = 7, .latency_us = 20000};
+        ASSERT_SUCCESS(sl_impair_setup(&tx));
+        ASSERT_SUCCESS(sl_impair_setup(&rx));
+        sl_sock_impair_set(&sock_client, &tx, NULL);
+        sl_sock_impair_set(&sock_server, NULL, &rx);
+
+        sl_ring_t ring = {0};
+        ring.entries = 8;
+        ring.bufcount = 16;
+        ring.bufsize = mem_server_len;
+        ring.flags = pass ? SL_RING_FLAG_FALLBACK : 0;
+        ASSERT_SUCCESS(sl_ring_setup(&ring));
+
+        int handle = sl_ring_recv(&ring, &sock_server, 42);
+        ASSERT_TRUE(handle >= 0);
+        sl_buf_t buf_send;
+        int slot = sl_ring_send_buf_get(&ring, &buf_send);
+        ASSERT_TRUE(slot >= 0);
+        memcpy(buf_send.base, &value, sizeof(value));
+        const uint64_t sent_ns = sl_sys_time_ns();
+        ASSERT_SUCCESS(sl_ring_send(&ring, &sock_client, slot, sizeof(value), &ep_server, 7));
+
+        int sends = 0, recvs = 0;
+        sl_ring_cqe_t cqes[4];
+        for (int tries = 0; tries < 100 && !(sends == 1 && recvs == 2); tries++)
+        {
+            int rv = sl_ring_complete(&ring, cqes, 4, 100);
+            ASSERT_TRUE(rv >= 0);
+            for (int i = 0; i < rv; i++)
+            {
+                ASSERT_TRUE((int)sizeof(value) == cqes[i].res);
+                if (SL_RING_OP_SEND == cqes[i].op)
+                {
+                    ASSERT_TRUE(7 == cqes[i].user_data);
+                    sends++;
+                    continue;
+                }
+                ASSERT_TRUE(42 == cqes[i].user_data);
+                ASSERT_TRUE(&sock_server == cqes[i].sock);
+                ASSERT_SUCCESS(memcmp(cqes[i].buf.base, &value, sizeof(value)));
+                ASSERT_TRUE(sl_endpoint_equal(&cqes[i].endpoint, &sock_client.endpoint));
+                ASSERT_TRUE(sl_sys_time_ns() - sent_ns >= 20000000ULL);
+                sl_ring_buf_release(&ring, cqes[i].bufid);
+                recvs++;
+            }
+        }
+        ASSERT_TRUE(sends == 1 && recvs == 2);
+        ASSERT_TRUE(1 == tx.duplicated && 0 == rx.count);
+        ASSERT_TRUE(2 == sock_client.stats.tx_packets);
+        ASSERT_TRUE(2 == sock_server.stats.rx_packets);
+        ASSERT_TRUE(ring.entries == ring.send_free_count);
+        ASSERT_TRUE(ring.bufcount == ring.buf_avail);
+
+        ASSERT_SUCCESS(sl_ring_recv_cancel(&ring, handle));
+        ASSERT_SUCCESS(sl_ring_cleanup(&ring));
+        sl_sock_impair_set(&sock_client, NULL, NULL);
+        sl_sock_impair_set(&sock_server, NULL, NULL);
+        ASSERT_SUCCESS(sl_impair_cleanup(&tx));
+        ASSERT_SUCCESS(sl_impair_cleanup(&rx));
+        sl_sock_capture_set(&sock_client, NULL);
+        sl_sock_capture_set(&sock_server, NULL);
+        ASSERT_TRUE(!capture.dropped);
+        ASSERT_SUCCESS(sl_capture_cleanup(&capture));
+
+        sl_capture_reader_t reader = {0};
+        sl_capture_packet_t packet;
+        int count = 0;
+        ASSERT_SUCCESS(sl_capture_reader_open(&reader, path));
+        while (!sl_capture_reader_next(&reader, &packet))
+        {
+            ASSERT_TRUE((int32_t)sizeof(value) == packet.len);
+            ASSERT_TRUE(packet.src.addr4.port == sock_client.endpoint.addr4.port && packet.dst.addr4.port == ep_server.addr4.port);
+            count++;
+        }
+        ASSERT_TRUE(4 == count);
+        ASSERT_SUCCESS(sl_capture_reader_close(&reader));
+        remove(path);
+
+        ASSERT_SUCCESS(sl_sock_close(&sock_server));
+        ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    }
+
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_ringimpaircapture)
+
+SL_TEST_CASE_BEGIN(sl_udp_pollerwait)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    sl_poller_t poller = {0};
+    poller.capacity = 4;
+    ASSERT_SUCCESS(sl_poller_setup(&poller));
+    ASSERT_TRUE(SL_POLLER_STATE_STARTED == poller.state);
+    ASSERT_SUCCESS(sl_poller_add(&poller, &sock_server, SL_POLL_EVENT_READ));
+    ASSERT_TRUE(1 == poller.count);
+
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+
+    /* drain to would block, the flag marks the socket as waiting on the poller */
+    ASSERT_TRUE(SL_ERR == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    ASSERT_TRUE(sl_sys_wouldblock((int)sock_server.error));
+    ASSERT_TRUE(sock_server.flags & SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    sl_poll_event_t events[4];
+    ASSERT_TRUE(0 == sl_poller_wait(&poller, events, 4, 0));
+
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0x5d * (i >> 8);
+    }
+    sl_buf_t buf_client = {.len = pl_client_len, .base = pl_client};
+    ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+
+    ASSERT_TRUE(1 == sl_poller_wait(&poller, events, 4, 1000));
+    ASSERT_TRUE(&sock_server == events[0].sock);
+    ASSERT_TRUE(events[0].events & SL_POLL_EVENT_READ);
+    ASSERT_FALSE(sock_server.flags & SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    ASSERT_TRUE(pl_client_len == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    ASSERT_SUCCESS(memcmp(pl_client, mem_server, pl_client_len));
+    ASSERT_TRUE(SL_ERR == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    ASSERT_TRUE(sock_server.flags & SL_SOCK_FLAG_WOULDBLOCK_READ);
+
+    ASSERT_SUCCESS(sl_poller_remove(&poller, &sock_server));
+    ASSERT_TRUE(0 == poller.count);
+    ASSERT_TRUE(SL_ERR == sl_poller_remove(&poller, &sock_server));
+    ASSERT_SUCCESS(sl_poller_cleanup(&poller));
+    ASSERT_TRUE(SL_POLLER_STATE_STOPPED == poller.state);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_pollerwait)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_iothread)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_client = sock_client.endpoint;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    sl_bufpool_t pool = {0};
+    pool.slotcount = 256;
+    ASSERT_SUCCESS(sl_bufpool_setup(&pool));
+
+    sl_iothread_t io = {0};
+    io.sock = &sock_server;
+    io.pool = &pool;
+    io.capacity = 64;
+    ASSERT_SUCCESS(sl_iothread_start(&io));
+    ASSERT_TRUE(SL_IOTHREAD_STATE_STARTED == io.state);
+
+    /* more datagrams than the rx ring holds, so the owner has to keep recycling */
+    const int count = 200;
+    char pl_client[pl_client_len];
+    sl_buf_t buf_client = {.len = pl_client_len, .base = pl_client};
+    for (int i = 0; i < count; i++)
+    {
+        memset(pl_client, i, pl_client_len);
+        ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+        if (i % 32 == 31) sl_sys_sleep_ms(5);
+    }
+
+    sl_packet_t packet;
+    int recvd = 0;
+    for (int tries = 0; tries < 2000 && recvd < count; tries++)
+    {
+        while (recvd < count && !sl_iothread_recv(&io, &packet))
+        {
+            ASSERT_TRUE(pl_client_len == packet.len);
+            ASSERT_TRUE((char)recvd == packet.buf.base[0] && (char)recvd == packet.buf.base[pl_client_len - 1]);
+            ASSERT_TRUE(ep_client.addr4.port == packet.endpoint.addr4.port);
+            ASSERT_SUCCESS(sl_iothread_recycle(&io, &packet));
+            recvd++;
+        }
+        sl_sys_sleep_ms(1);
+    }
+    ASSERT_TRUE(count == recvd);
+
+    /* send back through the free and tx rings */
+    for (int sent = 0, tries = 0; sent < 8 && tries < 1000; tries++)
+    {
+        if (sl_iothread_buf_get(&io, &packet))
+        {
+            sl_sys_sleep_ms(1);
+            continue;
+        }
+        ASSERT_TRUE(pool.slotsize == packet.buf.len);
+        memset(packet.buf.base, 0x40 + sent, pl_client_len);
+        packet.len = pl_client_len;
+        packet.endpoint = ep_client;
+        ASSERT_SUCCESS(sl_iothread_send(&io, &packet));
+        sent++;
+    }
+
+    char mem_client[mem_server_len];
+    sl_buf_t buf_client_recv = {.len = mem_server_len, .base = mem_client};
+    sl_endpoint_t ep_recv;
+    for (int i = 0; i < 8; i++)
+    {
+        ASSERT_TRUE(pl_client_len == sl_sock_recv(&sock_client, &buf_client_recv, 1, &ep_recv));
+        ASSERT_TRUE(0x40 + i == mem_client[0]);
+    }
+
+    ASSERT_SUCCESS(sl_iothread_stop(&io));
+    ASSERT_TRUE(SL_IOTHREAD_STATE_STOPPED == io.state);
+    ASSERT_TRUE(0 == io.error);
+    ASSERT_TRUE((uint64_t)count == io.rx_packets);
+    ASSERT_TRUE(8 == io.tx_packets);
+    ASSERT_TRUE(pool.slotcount == pool.free_count);
+
+    ASSERT_SUCCESS(sl_bufpool_cleanup(&pool));
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_iothread)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketstats)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    char mem_server[4][mem_server_len];
+    sl_buf_t buf_server[4];
+    sl_endpoint_t ep_recv[4];
+    sl_msg_t msg_server[4];
+    for (int i = 0; i < 4; i++)
+    {
+        buf_server[i].base = &mem_server[i][0];
+        buf_server[i].len = mem_server_len;
+        msg_server[i].buf = &buf_server[i];
+        msg_server[i].bufcount = 1;
+        msg_server[i].endpoint = &ep_recv[i];
+    }
+
+    ASSERT_TRUE(SL_ERR == sl_sock_recv(&sock_server, &buf_server[0], 1, &ep_recv[0]));
+
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0x3c * (i >> 8);
+    }
+
+    /* one single send and a batch of two smaller datagrams */
+    sl_buf_t buf_client[3];
+    sl_msg_t msg_client[2];
+    for (int i = 0; i < 3; i++)
+    {
+        buf_client[i].base = &pl_client[0];
+        buf_client[i].len = pl_client_len - i * 16;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        msg_client[i].buf = &buf_client[i + 1];
+        msg_client[i].bufcount = 1;
+        msg_client[i].endpoint = &ep_server;
+    }
+    ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_client, &buf_client[0], 1, &ep_server));
+    ASSERT_TRUE(2 == sl_sock_send_batch(&sock_client, msg_client, 2));
+
+    /* larger than any udp payload, refused locally */
+    static char pl_oversize[65536];
+    sl_buf_t buf_oversize = {.len = sizeof(pl_oversize), .base = pl_oversize};
+    ASSERT_TRUE(SL_ERR == sl_sock_send(&sock_client, &buf_oversize, 1, &ep_server));
+
+    int32_t msgs_recv = 0;
+    for (int tries = 0; msgs_recv < 3 && tries < 1000; tries++)
+    {
+        int rv = sl_sock_recv_batch(&sock_server, &msg_server[msgs_recv], 4 - msgs_recv);
+        if (rv > 0) msgs_recv += rv;
+    }
+    ASSERT_TRUE(3 == msgs_recv);
+
+#if SL_SOCK_STATS
+    const uint64_t bytes_sent = 3 * pl_client_len - 48;
+    ASSERT_TRUE(3 == sock_client.stats.tx_packets);
+    ASSERT_TRUE(bytes_sent == sock_client.stats.tx_bytes);
+    ASSERT_TRUE(pl_client_len == sock_client.stats.tx_max);
+    ASSERT_TRUE(1 == sock_client.stats.err_msgsize);
+    ASSERT_TRUE(0 == sock_client.stats.tx_partial);
+    ASSERT_TRUE(0 == sock_client.stats.rx_packets);
+
+    sl_sock_stats_t stats = sock_server.stats;
+    ASSERT_TRUE(3 == stats.rx_packets);
+    ASSERT_TRUE(bytes_sent == stats.rx_bytes);
+    ASSERT_TRUE(pl_client_len == stats.rx_max);
+    ASSERT_TRUE(stats.rx_wouldblock >= 1);
+    ASSERT_TRUE(0 == stats.tx_packets);
+    ASSERT_TRUE(0 == stats.err_other);
+#endif
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketstats)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketrecvtimestamp)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+    ASSERT_SUCCESS(sl_sock_timestamp_enable(&sock_server));
+    ASSERT_TRUE(sock_server.flags & SL_SOCK_FLAG_TIMESTAMP);
+
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0x6e * (i >> 8);
+    }
+    sl_buf_t buf_client = {.len = pl_client_len, .base = pl_client};
+
+    char mem_server[3][mem_server_len];
+    sl_buf_t buf_server[3];
+    sl_endpoint_t ep_recv[3];
+    sl_msg_t msg_server[3];
+    for (int i = 0; i < 3; i++)
+    {
+        buf_server[i].base = &mem_server[i][0];
+        buf_server[i].len = mem_server_len;
+        msg_server[i].buf = &buf_server[i];
+        msg_server[i].bufcount = 1;
+        msg_server[i].endpoint = &ep_recv[i];
+    }
+
+    /* the kernel stamps on arrival, so the stamps fall between the first send and the receive */
+    const uint64_t sent_ns = sl_sys_time_real_ns();
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    }
+
+    uint64_t timestamp_ns = 0;
+    ASSERT_TRUE(pl_client_len == sl_sock_recv_timestamped(&sock_server, &buf_server[0], 1, &ep_recv[0], &timestamp_ns));
+    ASSERT_TRUE(2 == sl_sock_recv_batch(&sock_server, &msg_server[1], 2));
+    const uint64_t recv_ns = sl_sys_time_real_ns();
+
+    /* the realtime clock is not monotonic, allow a little slew */
+    const uint64_t slack_ns = 1000000000ULL;
+    ASSERT_TRUE(timestamp_ns + slack_ns >= sent_ns && timestamp_ns <= recv_ns + slack_ns);
+    for (int i = 1; i < 3; i++)
+    {
+        ASSERT_TRUE(msg_server[i].timestamp_ns + slack_ns >= sent_ns && msg_server[i].timestamp_ns <= recv_ns + slack_ns);
+    }
+    ASSERT_TRUE(msg_server[1].timestamp_ns >= timestamp_ns);
+    ASSERT_TRUE(msg_server[2].timestamp_ns >= msg_server[1].timestamp_ns);
+
+    ASSERT_SUCCESS(sl_sock_timestamp_disable(&sock_server));
+    ASSERT_FALSE(sock_server.flags & SL_SOCK_FLAG_TIMESTAMP);
+    ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    ASSERT_TRUE(1 == sl_sock_recv_batch(&sock_server, &msg_server[0], 1));
+    ASSERT_TRUE(0 == msg_server[0].timestamp_ns);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketrecvtimestamp)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketrxqovfl)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+    ASSERT_SUCCESS(sl_sock_rxq_ovfl_enable(&sock_server));
+    ASSERT_TRUE(sock_server.flags & SL_SOCK_FLAG_RXQ_OVFL);
+
+    /* the smallest receive queue fits a handful of datagrams, loopback drops the rest */
+    int rcvbuf = 1;
+    ASSERT_SUCCESS(setsockopt(sl_sock_fd_get(&sock_server), SOL_SOCKET, SO_RCVBUF, (const char *)&rcvbuf, sizeof(rcvbuf)));
+
+    char pl_client[mem_client_len] = {0};
+    sl_buf_t buf_client = {.len = mem_client_len, .base = pl_client};
+    const int sent = 64;
+    for (int i = 0; i < sent; i++)
+    {
+        ASSERT_TRUE(mem_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    }
+
+    char mem_server[4][mem_server_len];
+    sl_buf_t buf_server[4];
+    sl_endpoint_t ep_recv[4];
+    sl_msg_t msg_server[4];
+    for (int i = 0; i < 4; i++)
+    {
+        buf_server[i].base = &mem_server[i][0];
+        buf_server[i].len = mem_server_len;
+        msg_server[i].buf = &buf_server[i];
+        msg_server[i].bufcount = 1;
+        msg_server[i].endpoint = &ep_recv[i];
+    }
+
+    /* every datagram is either queued or counted as dropped */
+    int recvd = 0;
+    ASSERT_TRUE(mem_client_len == sl_sock_recv(&sock_server, &buf_server[0], 1, &ep_recv[0]));
+    recvd++;
+    int rv;
+    while ((rv = sl_sock_recv_batch(&sock_server, msg_server, 4)) > 0)
+    {
+        recvd += rv;
+    }
+    ASSERT_TRUE(sl_sys_wouldblock((int)sock_server.error));
+    ASSERT_TRUE(recvd < sent);
+
+    /* a datagram carries the count as of when it was queued, so the drops arrive with the next one */
+    ASSERT_TRUE(mem_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    ASSERT_TRUE(1 == sl_sock_recv_batch(&sock_server, msg_server, 4));
+    ASSERT_TRUE((uint64_t)(sent - recvd) == sl_sock_rx_dropped(&sock_server));
+
+    /* and on the single receive path */
+    for (int i = 0; i < sent; i++)
+    {
+        ASSERT_TRUE(mem_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    }
+    while ((rv = sl_sock_recv_batch(&sock_server, msg_server, 4)) > 0)
+    {
+        recvd += rv;
+    }
+    ASSERT_TRUE(mem_client_len == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    ASSERT_TRUE(mem_client_len == sl_sock_recv(&sock_server, &buf_server[0], 1, &ep_recv[0]));
+    ASSERT_TRUE((uint64_t)(2 * sent - recvd) == sl_sock_rx_dropped(&sock_server));
+
+    ASSERT_SUCCESS(sl_sock_rxq_ovfl_disable(&sock_server));
+    ASSERT_FALSE(sock_server.flags & SL_SOCK_FLAG_RXQ_OVFL);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketrxqovfl)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_socketconnect)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    /* server, connected client, and a stray sender the client should never hear from */
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_client = sock_client.endpoint;
+
+    sl_sock_t sock_stray = {0};
+    loopback.port += 1;
+    sock_stray.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_client));
+    ASSERT_SUCCESS(sl_sock_create(&sock_stray, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_stray));
+
+    ASSERT_SUCCESS(sl_sock_connect(&sock_client, &ep_server));
+    ASSERT_TRUE(SL_SOCK_STATE_OPEN == sock_client.state);
+    ASSERT_TRUE(SL_SOCK_DIR_OUTGOING == sock_client.dir);
+
+    char pl_client[pl_client_len];
+    for (int i = 0; i < pl_client_len; i++)
+    {
+        pl_client[i] = i ^ 0x29 * (i >> 8);
+    }
+    sl_buf_t buf_client = {.len = pl_client_len, .base = pl_client};
+    char mem_client[mem_client_len];
+    sl_buf_t buf_client_recv = {.len = mem_client_len, .base = mem_client};
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+
+    ASSERT_TRUE(pl_client_len == sl_sock_send_connected(&sock_client, &buf_client, 1));
+    ASSERT_TRUE(pl_client_len == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    ASSERT_SUCCESS(memcmp(pl_client, mem_server, pl_client_len));
+    ASSERT_TRUE(ep_client.addr4.port == ep_recv.addr4.port);
+
+    /* the stray datagram is dropped by the kernel, only the server's reply arrives */
+    sl_buf_t buf_stray = {.len = pl_client_len - 1, .base = pl_client};
+    ASSERT_TRUE(pl_client_len - 1 == sl_sock_send(&sock_stray, &buf_stray, 1, &ep_client));
+    ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_server, &buf_client, 1, &ep_client));
+    int rv;
+    for (int tries = 0; (rv = sl_sock_recv_connected(&sock_client, &buf_client_recv, 1)) < 0 && tries < 1000; tries++)
+    {
+        sl_sys_sleep_ms(1);
+    }
+    ASSERT_TRUE(pl_client_len == rv);
+    ASSERT_TRUE(SL_ERR == sl_sock_recv_connected(&sock_client, &buf_client_recv, 1));
+    ASSERT_TRUE(sl_sys_wouldblock((int)sock_client.error));
+
+    /* batches on a connected socket may leave every endpoint NULL */
+    sl_msg_t msg_client[2];
+    for (int i = 0; i < 2; i++)
+    {
+        msg_client[i].buf = &buf_client;
+        msg_client[i].bufcount = 1;
+        msg_client[i].endpoint = NULL;
+    }
+    ASSERT_TRUE(2 == sl_sock_send_batch(&sock_client, msg_client, 2));
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_TRUE(pl_client_len == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+        ASSERT_TRUE(ep_client.addr4.port == ep_recv.addr4.port);
+    }
+
+    /* disconnected, the client hears from anyone again */
+    ASSERT_SUCCESS(sl_sock_disconnect(&sock_client));
+    ASSERT_TRUE(SL_SOCK_STATE_BOUND == sock_client.state);
+    ASSERT_TRUE(pl_client_len == sl_sock_send(&sock_stray, &buf_client, 1, &ep_client));
+    for (int tries = 0; (rv = sl_sock_recv(&sock_client, &buf_client_recv, 1, &ep_recv)) < 0 && tries < 1000; tries++)
+    {
+        sl_sys_sleep_ms(1);
+    }
+    ASSERT_TRUE(pl_client_len == rv);
+    ASSERT_TRUE(sock_stray.endpoint.addr4.port == ep_recv.addr4.port);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sock_close(&sock_stray));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_socketconnect)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_coalescesendrecv)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    char frame_client[SL_COALESCE_FRAME_DEFAULT];
+    sl_coalesce_t co = {0};
+    sl_coalesce_init(&co, frame_client, SL_COALESCE_FRAME_DEFAULT, &ep_server);
+
+    /* chatty game traffic, 20 to 80 bytes a message with the odd one past the one byte prefix */
+    const int msg_count = 200;
+    char pl_msg[256];
+    for (int i = 0; i < 256; i++)
+    {
+        pl_msg[i] = (char)(i ^ 0x5a);
+    }
+    int total = 0;
+    for (int i = 0; i < msg_count; i++)
+    {
+        int len = i % 50 == 49 ? 200 : 20 + (i * 7) % 61;
+        pl_msg[0] = (char)i;
+        ASSERT_SUCCESS(sl_coalesce_append(&co, &sock_client, pl_msg, len));
+        ASSERT_TRUE(co.len <= SL_COALESCE_FRAME_DEFAULT);
+        total += len;
+    }
+    ASSERT_TRUE(co.count > 0);
+    ASSERT_TRUE(0 < sl_coalesce_flush(&co, &sock_client));
+    ASSERT_TRUE(0 == co.len && 0 == co.count);
+    ASSERT_TRUE(0 == sl_coalesce_flush(&co, &sock_client));
+
+    ASSERT_NULL(sl_coalesce_reserve(&co, &sock_client, SL_COALESCE_FRAME_DEFAULT));
+    ASSERT_TRUE(EMSGSIZE == sock_client.error);
+
+    /* the server splits each frame back in order, every message a view into the receive buffer */
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+    int frames = 0, msgs = 0, received = 0;
+    while (msgs < msg_count)
+    {
+        int rv = sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv);
+        ASSERT_TRUE(rv > 0 && rv <= SL_COALESCE_FRAME_DEFAULT);
+        frames++;
+
+        sl_buf_t msg;
+        int32_t offset = 0;
+        while (1 == sl_coalesce_next(mem_server, rv, &offset, &msg))
+        {
+            int len = msgs % 50 == 49 ? 200 : 20 + (msgs * 7) % 61;
+            ASSERT_TRUE(len == (int)msg.len);
+            ASSERT_TRUE(msg.base > mem_server && msg.base + msg.len <= mem_server + rv);
+            ASSERT_TRUE((char)msgs == msg.base[0]);
+            ASSERT_SUCCESS(memcmp(pl_msg + 1, msg.base + 1, msg.len - 1));
+            received += (int)msg.len;
+            msgs++;
+        }
+        ASSERT_TRUE(offset == rv);
+    }
+    ASSERT_TRUE(msg_count == msgs);
+    ASSERT_TRUE(total == received);
+    ASSERT_TRUE(frames * 10 <= msg_count);
+
+    /* a prefix running past the end of the frame is rejected */
+    sl_buf_t msg;
+    int32_t offset = 0;
+    char frame_bad[3] = {1, 'a', (char)0x85};
+    ASSERT_TRUE(1 == sl_coalesce_next(frame_bad, 3, &offset, &msg));
+    ASSERT_TRUE(SL_ERR == sl_coalesce_next(frame_bad, 3, &offset, &msg));
+
+    /* one flush call per tick for many peers, here three coalescers and an idle one */
+    char frame_peers[4][SL_COALESCE_FRAME_DEFAULT];
+    sl_coalesce_t co_peers[4];
+    sl_coalesce_t *co_ptrs[4];
+    for (int i = 0; i < 4; i++)
+    {
+        sl_coalesce_init(&co_peers[i], frame_peers[i], SL_COALESCE_FRAME_DEFAULT, &ep_server);
+        co_ptrs[i] = &co_peers[i];
+        if (i == 2) continue;
+        pl_msg[0] = (char)i;
+        ASSERT_SUCCESS(sl_coalesce_append(&co_peers[i], &sock_client, pl_msg, 40));
+        ASSERT_SUCCESS(sl_coalesce_append(&co_peers[i], &sock_client, pl_msg, 30));
+    }
+    ASSERT_TRUE(3 == sl_coalesce_flush_batch(&sock_client, co_ptrs, 4));
+    ASSERT_TRUE(0 == sl_coalesce_flush_batch(&sock_client, co_ptrs, 4));
+    for (int i = 0; i < 4; i++)
+    {
+        if (i == 2) continue;
+        ASSERT_TRUE(72 == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+        offset = 0;
+        ASSERT_TRUE(1 == sl_coalesce_next(mem_server, 72, &offset, &msg));
+        ASSERT_TRUE(40 == msg.len && (char)i == msg.base[0]);
+        ASSERT_TRUE(1 == sl_coalesce_next(mem_server, 72, &offset, &msg));
+        ASSERT_TRUE(30 == msg.len);
+        ASSERT_TRUE(0 == sl_coalesce_next(mem_server, 72, &offset, &msg));
+    }
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_coalescesendrecv)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_fragmentsendrecv)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    sl_bufpool_t pool = {0};
+    pool.slotcount = 2;
+    pool.slotsize = 64 * 1024;
+    ASSERT_SUCCESS(sl_bufpool_setup(&pool));
+
+    sl_fragtable_t table = {0};
+    table.pool = &pool;
+    table.capacity = 64;
+    ASSERT_SUCCESS(sl_fragtable_setup(&table));
+
+    /* more fragments than one sendmmsg batch takes */
+    const int32_t pl_len = 41000;
+    char *pl = (char *)malloc(pl_len);
+    ASSERT_NOT_NULL(pl);
+    for (int32_t i = 0; i < pl_len; i++)
+    {
+        pl[i] = (char)(i * 31 + (i >> 9));
+    }
+
+    sl_fragsend_t fs;
+    ASSERT_SUCCESS(sl_fragsend_init(&fs, pl, pl_len, &ep_server, 0x1234, 600));
+    ASSERT_TRUE(70 == fs.count);
+    ASSERT_TRUE(0 == sl_fragsend_send(&fs, &sock_client));
+    ASSERT_TRUE(70 == fs.next);
+
+    sl_fragsend_t fs_huge;
+    ASSERT_TRUE(SL_ERR == sl_fragsend_init(&fs_huge, pl, pl_len, &ep_server, 1, 100));
+
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+    sl_buf_t msg = {0};
+    int rv = 0;
+    for (int i = 0; i < 70; i++)
+    {
+        int len = sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv);
+        ASSERT_TRUE(len > SL_FRAG_HEADER_SIZE && len <= 600);
+        rv = sl_fragtable_recv(&table, &ep_recv, mem_server, len, sl_sys_time_ns(), &msg);
+        ASSERT_TRUE(i == 69 ? 1 == rv : 0 == rv);
+    }
+    ASSERT_TRUE(pl_len == (int32_t)msg.len);
+    ASSERT_SUCCESS(memcmp(pl, msg.base, pl_len));
+    ASSERT_TRUE(0 == table.active && 0 == table.dropped);
+    sl_bufpool_release(&pool, &msg);
+
+    free(pl);
+    ASSERT_SUCCESS(sl_fragtable_cleanup(&table));
+    ASSERT_SUCCESS(sl_bufpool_cleanup(&pool));
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_fragmentsendrecv)
+
+
+SL_TEST_CASE_BEGIN(sl_udp_channelsendrecv)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_client = sock_client.endpoint;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_client));
+
+    sl_channel_t ch_client = {0};
+    ch_client.endpoint = &ep_server;
+    ch_client.slotsize = 256;
+    ASSERT_SUCCESS(sl_channel_setup(&ch_client));
+    sl_channel_t ch_server = {0};
+    ch_server.endpoint = &ep_client;
+    ch_server.slotsize = 256;
+    ASSERT_SUCCESS(sl_channel_setup(&ch_server));
+
+    char pl[256];
+    memset(pl, 0x3c, sizeof(pl));
+    ASSERT_TRUE(SL_ERR == sl_channel_send(&ch_client, &sock_client, SL_CHANNEL_RELIABLE, pl, 257, 0));
+    ASSERT_TRUE(EMSGSIZE == ch_client.error);
+
+    /*
+     * a hundred reliable messages, three times the window, over a wire that loses every third
+     * datagram and delivers the rest of each round in reverse
+     */
+    const int msg_count = 100;
+    char mem[mem_server_len];
+    sl_buf_t buf_recv = {.len = mem_server_len, .base = mem};
+    sl_endpoint_t ep_recv;
+    char wire[64][300];
+    int wire_len[64];
+    sl_buf_t msg;
+    sl_channel_mode_t mode;
+    int queued = 0, delivered = 0, datagrams = 0, rounds = 0;
+    uint64_t now_ns = 1000000000ULL;
+    while (delivered < msg_count || ch_client.send_pending)
+    {
+        ASSERT_TRUE(++rounds < 200);
+        for (; queued < msg_count; queued++)
+        {
+            memcpy(pl, &queued, sizeof(queued));
+            if (sl_channel_send(&ch_client, &sock_client, SL_CHANNEL_RELIABLE, pl, 16 + queued % 50, now_ns)) break;
+        }
+        if (queued < msg_count) ASSERT_TRUE(ENOBUFS == ch_client.error);
+
+        int n = 0, len;
+        while (n < 64 && (len = sl_sock_recv(&sock_server, &buf_recv, 1, &ep_recv)) >= 0)
+        {
+            if (datagrams++ % 3 == 0) continue;
+            memcpy(wire[n], mem, (size_t)len);
+            wire_len[n++] = len;
+        }
+        for (int i = n - 1; i >= 0; i--)
+        {
+            int rv = sl_channel_recv(&ch_server, wire[i], wire_len[i], now_ns, &msg, &mode);
+            ASSERT_TRUE(rv >= 0);
+            while (rv == 1)
+            {
+                int id;
+                memcpy(&id, msg.base, sizeof(id));
+                ASSERT_TRUE(SL_CHANNEL_RELIABLE == mode);
+                ASSERT_TRUE(delivered == id);
+                ASSERT_TRUE(16 + id % 50 == (int)msg.len);
+                delivered++;
+                rv = sl_channel_next(&ch_server, &msg);
+            }
+        }
+
+        /* acks go back on a perfect wire, then time moves on so losses are resent */
+        ASSERT_TRUE(sl_channel_update(&ch_server, &sock_server, now_ns) >= 0);
+        while ((len = sl_sock_recv(&sock_client, &buf_recv, 1, &ep_recv)) >= 0)
+        {
+            ASSERT_TRUE(0 == sl_channel_recv(&ch_client, mem, len, now_ns, &msg, &mode));
+            ASSERT_TRUE(SL_CHANNEL_ACK == mode);
+        }
+        now_ns += 50000000ULL;
+        ASSERT_TRUE(sl_channel_update(&ch_client, &sock_client, now_ns) >= 0);
+    }
+    ASSERT_TRUE(msg_count == delivered);
+    ASSERT_TRUE(ch_client.resends > 0);
+    ASSERT_TRUE(ch_client.flags & SL_CHANNEL_FLAG_RTT_VALID);
+    ASSERT_TRUE(ch_client.rto_ns >= SL_CHANNEL_RTO_MIN_NS && ch_client.rto_ns <= SL_CHANNEL_RTO_MAX_NS);
+
+    ASSERT_TRUE(ch_client.send_base == ch_client.send_seq);
+    ASSERT_TRUE(UINT64_MAX == sl_channel_deadline(&ch_client));
+
+    /* sequenced drops anything older than what it already handed over, unreliable drops nothing */
+    for (int i = 0; i < 3; i++)
+    {
+        pl[0] = (char)i;
+        ASSERT_SUCCESS(sl_channel_send(&ch_client, &sock_client, SL_CHANNEL_SEQUENCED, pl, 8, now_ns));
+    }
+    ASSERT_SUCCESS(sl_channel_send(&ch_client, &sock_client, SL_CHANNEL_UNRELIABLE, pl, 4, now_ns));
+    int n = 0, len;
+    while (n < 4)
+    {
+        if ((len = sl_sock_recv(&sock_server, &buf_recv, 1, &ep_recv)) < 0)
+        {
+            sl_sys_sleep_ms(1);
+            continue;
+        }
+        memcpy(wire[n], mem, (size_t)len);
+        wire_len[n++] = len;
+    }
+    ASSERT_TRUE(1 == sl_channel_recv(&ch_server, wire[1], wire_len[1], now_ns, &msg, &mode));
+    ASSERT_TRUE(SL_CHANNEL_SEQUENCED == mode && 1 == msg.base[0] && msg.base == wire[1] + SL_CHANNEL_HEADER_SIZE);
+    ASSERT_TRUE(0 == sl_channel_recv(&ch_server, wire[0], wire_len[0], now_ns, &msg, &mode));
+    ASSERT_TRUE(1 == sl_channel_recv(&ch_server, wire[2], wire_len[2], now_ns, &msg, &mode));
+    ASSERT_TRUE(2 == msg.base[0]);
+    ASSERT_TRUE(1 == sl_channel_recv(&ch_server, wire[3], wire_len[3], now_ns, &msg, &mode));
+    ASSERT_TRUE(SL_CHANNEL_UNRELIABLE == mode && 4 == msg.len);
+    ASSERT_TRUE(1 == sl_channel_recv(&ch_server, wire[3], wire_len[3], now_ns, &msg, &mode));
+
+    wire[0][0] = 0x44;
+    ASSERT_TRUE(SL_ERR == sl_channel_recv(&ch_server, wire[0], wire_len[0], now_ns, &msg, &mode));
+    ASSERT_TRUE(SL_ERR == sl_channel_recv(&ch_server, wire[0], SL_CHANNEL_HEADER_SIZE - 1, now_ns, &msg, &mode));
+
+    ASSERT_SUCCESS(sl_channel_cleanup(&ch_client));
+    ASSERT_SUCCESS(sl_channel_cleanup(&ch_server));
+    ASSERT_TRUE(SL_CHANNEL_STATE_STOPPED == ch_server.state);
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_channelsendrecv)
+
+SL_TEST_CASE_BEGIN(sl_udp_pacedsend)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    /* the kernel cap takes any rate, lifting it again is 0 */
+    ASSERT_SUCCESS(sl_sock_pacing_rate_set(&sock_client, 125000));
+    ASSERT_SUCCESS(sl_sock_pacing_rate_set(&sock_client, 0));
+
+    /* a snapshot of 60 datagrams at 1 MB/s, a millisecond each once the burst is spent */
+    const int32_t msg_count = 60;
+    char pl_msg[1000 - SL_PACER_OVERHEAD];
+    sl_buf_t bufs[60];
+    sl_msg_t msgs[60];
+    for (int32_t i = 0; i < msg_count; i++)
+    {
+        bufs[i].base = pl_msg;
+        bufs[i].len = sizeof(pl_msg);
+        msgs[i].buf = &bufs[i];
+        msgs[i].bufcount = 1;
+        msgs[i].endpoint = &ep_server;
+    }
+    memset(pl_msg, 0x5a, sizeof(pl_msg));
+
+    sl_pacer_t pacer;
+    sl_pacer_init(&pacer, 1000000, 0);
+    const uint64_t start_ns = sl_sys_time_ns();
+    int32_t sent = 0, calls = 0;
+    while (sent < msg_count)
+    {
+        int rv = sl_pacer_send_batch(&pacer, &sock_client, msgs + sent, msg_count - sent, sl_sys_time_ns());
+        ASSERT_TRUE(rv >= 0);
+        if (!rv) sl_sys_sleep_ms(1);
+        sent += rv;
+        calls++;
+    }
+    const uint64_t elapsed_ns = sl_sys_time_ns() - start_ns;
+    ASSERT_TRUE(elapsed_ns >= (uint64_t)(msg_count - 6) * 1000000ULL);
+    ASSERT_TRUE(calls > 10);
+
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+    for (int32_t i = 0; i < msg_count; i++)
+    {
+        ASSERT_TRUE((int)sizeof(pl_msg) == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    }
+
+    /* with launch times the whole snapshot goes to the kernel in one call */
+    if (!sl_sock_txtime_enable(&sock_client))
+    {
+        ASSERT_TRUE(sock_client.flags & SL_SOCK_FLAG_TXTIME);
+        sl_pacer_init(&pacer, 1000000, 0);
+        ASSERT_TRUE(msg_count == sl_pacer_send_batch(&pacer, &sock_client, msgs, msg_count, sl_sys_time_ns()));
+        for (int32_t i = 0; i < msg_count; i++)
+        {
+            ASSERT_TRUE((int)sizeof(pl_msg) == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+        }
+
+        /* past the horizon the rest waits for a later call */
+        sl_pacer_init(&pacer, 100000, 0);
+        int rv = sl_pacer_send_batch(&pacer, &sock_client, msgs, msg_count, sl_sys_time_ns());
+        ASSERT_TRUE(rv > 0 && rv < msg_count);
+        sl_sock_txtime_disable(&sock_client);
+        ASSERT_FALSE(sock_client.flags & SL_SOCK_FLAG_TXTIME);
+    }
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_pacedsend)
+
+SL_TEST_CASE_BEGIN(sl_udp_impairsendrecv)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_nonblocking_set(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+
+    /* the same seed twice must lose, copy and reorder the same datagrams */
+    const uint32_t msg_count = 200;
+    uint8_t seen[2][200];
+    uint64_t fates[2][3];
+    for (int run = 0; run < 2; run++)
+    {
+        sl_impair_t tx = {.seed = 7, .latency_us = 2000, .jitter_us = 1000};
+        tx.loss_ppm = tx.duplicate_ppm = tx.reorder_ppm = SL_IMPAIR_PPM / 10;
+        ASSERT_SUCCESS(sl_impair_setup(&tx));
+        sl_sock_impair_set(&sock_client, &tx, NULL);
+
+        const uint64_t start_ns = sl_sys_time_ns();
+        for (uint32_t i = 0; i < msg_count; i++)
+        {
+            sl_buf_t buf = {.len = sizeof(i), .base = (char *)&i};
+            ASSERT_TRUE((int)sizeof(i) == sl_sock_send(&sock_client, &buf, 1, &ep_server));
+        }
+        /* reordered ones went out with the sends, the rest wait at least the latency */
+        ASSERT_TRUE(tx.lost && tx.duplicated && tx.reordered);
+        ASSERT_TRUE(sl_impair_deadline(&tx) >= start_ns + 2000000ULL);
+        while (tx.count)
+        {
+            sl_sys_sleep_ms(1);
+            sl_impair_flush(&tx, &sock_client, sl_sys_time_ns());
+        }
+        sl_sys_sleep_ms(10);
+
+        memset(seen[run], 0, sizeof(seen[run]));
+        uint32_t received = 0, index;
+        while (sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv) == (int)sizeof(index))
+        {
+            memcpy(&index, mem_server, sizeof(index));
+            ASSERT_TRUE(index < msg_count);
+            seen[run][index]++;
+            received++;
+        }
+        ASSERT_TRUE(received == msg_count - tx.lost + tx.duplicated);
+        fates[run][0] = tx.lost;
+        fates[run][1] = tx.duplicated;
+        fates[run][2] = tx.reordered;
+
+        sl_sock_impair_set(&sock_client, NULL, NULL);
+        ASSERT_SUCCESS(sl_impair_cleanup(&tx));
+    }
+    ASSERT_SUCCESS(memcmp(fates[0], fates[1], sizeof(fates[0])));
+    ASSERT_SUCCESS(memcmp(seen[0], seen[1], sizeof(seen[0])));
+
+    /* launch times carry through the impairment, each datagram is due at its own plus the latency */
+    if (!sl_sock_txtime_enable(&sock_client))
+    {
+        sl_impair_t paced = {.seed = 3, .latency_us = 1000};
+        ASSERT_SUCCESS(sl_impair_setup(&paced));
+        sl_sock_impair_set(&sock_client, &paced, NULL);
+
+        uint32_t values[2] = {1, 2};
+        sl_buf_t bufs_paced[2];
+        sl_msg_t msgs_paced[2];
+        for (int i = 0; i < 2; i++)
+        {
+            bufs_paced[i].base = (char *)&values[i];
+            bufs_paced[i].len = sizeof(values[i]);
+            msgs_paced[i].buf = &bufs_paced[i];
+            msgs_paced[i].bufcount = 1;
+            msgs_paced[i].endpoint = &ep_server;
+        }
+        const uint64_t launch_ns = sl_sys_time_ns() + 50000000ULL;
+        const uint64_t launches[2] = {launch_ns, launch_ns + 20000000ULL};
+        ASSERT_TRUE(2 == sl_sock_send_batch_txtime(&sock_client, msgs_paced, 2, launches));
+        ASSERT_TRUE(2 == paced.count);
+        ASSERT_TRUE(launch_ns + 1000000ULL == sl_impair_deadline(&paced));
+        ASSERT_TRUE(1 == sl_impair_flush(&paced, &sock_client, launch_ns + 1000000ULL));
+        ASSERT_TRUE(launches[1] + 1000000ULL == sl_impair_deadline(&paced));
+        ASSERT_TRUE(1 == sl_impair_flush(&paced, &sock_client, UINT64_MAX));
+
+        sl_sock_txtime_disable(&sock_client);
+        sl_sock_impair_set(&sock_client, NULL, NULL);
+        ASSERT_SUCCESS(sl_impair_cleanup(&paced));
+        while (sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv) == (int)sizeof(uint32_t)) {}
+    }
+
+    /* a held receive would block, even though the kernel already has the datagram */
+    sl_impair_t rx = {.seed = 7, .latency_us = 20000};
+    ASSERT_SUCCESS(sl_impair_setup(&rx));
+    sl_sock_impair_set(&sock_server, NULL, &rx);
+
+    uint32_t value = 42;
+    sl_buf_t buf_client = {.len = sizeof(value), .base = (char *)&value};
+    const uint64_t sent_ns = sl_sys_time_ns();
+    ASSERT_TRUE((int)sizeof(value) == sl_sock_send(&sock_client, &buf_client, 1, &ep_server));
+    sl_sys_sleep_ms(1);
+    ASSERT_TRUE(SL_ERR == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    ASSERT_TRUE(sock_server.flags & SL_SOCK_FLAG_WOULDBLOCK_READ);
+    ASSERT_TRUE(rx.count == 1);
+    while (sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv) < 0)
+    {
+        ASSERT_TRUE(sock_server.flags & SL_SOCK_FLAG_WOULDBLOCK_READ);
+        sl_sys_sleep_ms(1);
+    }
+    ASSERT_TRUE(sl_sys_time_ns() - sent_ns >= 20000000ULL);
+    ASSERT_TRUE(sl_endpoint_equal(&ep_recv, &sock_client.endpoint));
+    ASSERT_SUCCESS(memcmp(mem_server, &value, sizeof(value)));
+
+    sl_sock_impair_set(&sock_server, NULL, NULL);
+    ASSERT_SUCCESS(sl_impair_cleanup(&rx));
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_impairsendrecv)
+
+SL_TEST_CASE_BEGIN(sl_udp_capturereplay)
+
+    sl_sys_t ctx = {0};
+
+    ASSERT_SUCCESS(sl_sys_setup(&ctx));
+
+    sl_sockaddr4_t loopback = {0};
+    loopback.af = ctx.af_inet;
+    loopback.port = listen_port;
+    loopback.addr = 127 | (1 << 24);
+
+    sl_sock_t sock_server = {0};
+    sock_server.endpoint.addr4 = loopback;
+    sl_endpoint_t ep_server = sock_server.endpoint;
+
+    sl_sock_t sock_client = {0};
+    loopback.port += 1;
+    sock_client.endpoint.addr4 = loopback;
+
+    ASSERT_SUCCESS(sl_sock_create(&sock_server, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_server));
+    ASSERT_SUCCESS(sl_sock_create(&sock_client, SL_SOCK_TYPE_DGRAM, SL_SOCK_PROTO_UDP));
+    ASSERT_SUCCESS(sl_sock_bind(&sock_client));
+
+    /* one capture shared by both ends, three single sends then a batch of two */
+    const char *path = "sl_udp_capturereplay.pcap";
+    sl_capture_t capture = {.size = 1024 * 1024};
+    ASSERT_SUCCESS(sl_capture_setup(&capture, path));
+    sl_sock_capture_set(&sock_client, &capture);
+    sl_sock_capture_set(&sock_server, &capture);
+
+    char pl_client[100];
+    for (int i = 0; i < (int)sizeof(pl_client); i++) pl_client[i] = (char)(i * 7);
+    const int32_t lens[5] = {10, 0, 100, 30, 40};
+    sl_buf_t bufs[5];
+    sl_msg_t msgs[5];
+    for (int i = 0; i < 5; i++)
+    {
+        bufs[i].base = pl_client;
+        bufs[i].len = lens[i];
+        msgs[i].buf = &bufs[i];
+        msgs[i].bufcount = 1;
+        msgs[i].endpoint = &ep_server;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(lens[i] == sl_sock_send(&sock_client, &bufs[i], 1, &ep_server));
+    }
+    ASSERT_TRUE(2 == sl_sock_send_batch(&sock_client, &msgs[3], 2));
+
+    char mem_server[mem_server_len];
+    sl_buf_t buf_server = {.len = mem_server_len, .base = mem_server};
+    sl_endpoint_t ep_recv = {0};
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(lens[i] == sl_sock_recv(&sock_server, &buf_server, 1, &ep_recv));
+    }
+    sl_sock_capture_set(&sock_client, NULL);
+    sl_sock_capture_set(&sock_server, NULL);
+    ASSERT_TRUE(!capture.dropped);
+    ASSERT_SUCCESS(sl_capture_cleanup(&capture));
+
+    /* each datagram shows up twice, sent by the client and received by the server */
+    sl_capture_reader_t reader = {0};
+    sl_capture_packet_t packet;
+    ASSERT_SUCCESS(sl_capture_reader_open(&reader, path));
+    for (int lap = 0; lap < 2; lap++)
+    {
+        int32_t seen[5] = {0}, count = 0;
+        uint64_t last_ns = 0;
+        while (!sl_capture_reader_next(&reader, &packet))
+        {
+            int32_t index = 0;
+            while (index < 5 && (lens[index] != packet.len || seen[index] == 2)) index++;
+            ASSERT_TRUE(index < 5);
+            seen[index]++;
+            count++;
+            ASSERT_TRUE(packet.wirelen == packet.len);
+            ASSERT_SUCCESS(memcmp(packet.payload, pl_client, (size_t)packet.len));
+            ASSERT_TRUE(sl_endpoint_is_ipv4(&packet.src) && sl_endpoint_is_ipv4(&packet.dst));
+            ASSERT_TRUE(packet.src.addr4.port == sock_client.endpoint.addr4.port && packet.dst.addr4.port == ep_server.addr4.port);
+            ASSERT_TRUE(packet.src.addr4.addr == loopback.addr && packet.dst.addr4.addr == loopback.addr);
+            ASSERT_TRUE(packet.timestamp_ns >= last_ns);
+            last_ns = packet.timestamp_ns;
+        }
+        ASSERT_TRUE(count == 10 && !reader.skipped);
+        sl_capture_reader_rewind(&reader);
+    }
+    ASSERT_SUCCESS(sl_capture_reader_close(&reader));
+
+    /* a full file keeps the records which fit whole and counts the rest */
+    capture.size = sizeof(sl_capture_file_header_t) + sizeof(sl_capture_record_header_t) + SL_CAPTURE_IP4_HEADER + SL_CAPTURE_UDP_HEADER + 10;
+    ASSERT_SUCCESS(sl_capture_setup(&capture, path));
+    sl_sock_capture_set(&sock_client, &capture);
+    ASSERT_TRUE(10 == sl_sock_send(&sock_client, &bufs[0], 1, &ep_server));
+    ASSERT_TRUE(10 == sl_sock_send(&sock_client, &bufs[0], 1, &ep_server));
+    sl_sock_capture_set(&sock_client, NULL);
+    ASSERT_TRUE(capture.dropped == 1);
+    ASSERT_SUCCESS(sl_capture_cleanup(&capture));
+
+    ASSERT_SUCCESS(sl_capture_reader_open(&reader, path));
+    ASSERT_SUCCESS(sl_capture_reader_next(&reader, &packet));
+    ASSERT_TRUE(packet.len == 10);
+    ASSERT_TRUE(SL_ERR == sl_capture_reader_next(&reader, &packet));
+    ASSERT_SUCCESS(sl_capture_reader_close(&reader));
+    remove(path);
+
+    ASSERT_SUCCESS(sl_sock_close(&sock_server));
+    ASSERT_SUCCESS(sl_sock_close(&sock_client));
+    ASSERT_SUCCESS(sl_sys_cleanup(&ctx));
+
+SL_TEST_CASE_END(sl_udp_capturereplay)